@@ -376,18 +376,32 @@ OF_APPLICATION_DELEGATE(TableGenerator)
 		}
 	}
 
-	/* Write titlecasePage%u if it does NOT match uppercasePage%u */
+	/*
+	 * Write titlecasePage%u if it does NOT match uppercasePage%u or
+	 * lowercasePage%u
+	 */
 	for (of_unichar_t i = 0; i < 0x110000; i += 0x100) {
 		bool isEmpty = true;
 
 		for (of_unichar_t j = i; j < i + 0x100; j++) {
 			if (_titlecaseTable[j] != 0) {
-				isEmpty = !memcmp(_uppercaseTable + i,
-				    _titlecaseTable + i,
-				    256 * sizeof(of_unichar_t));
 				_titlecaseTableSize = i >> 8;
-				_titlecaseTableUsed[_titlecaseTableSize] =
-				    (isEmpty ? 2 : 1);
+
+				if (_uppercaseTableUsed[i >> 8] &&
+				    memcmp(_uppercaseTable + i,
+				    _titlecaseTable + i,
+				    256 * sizeof(of_unichar_t)) == 0)
+					_titlecaseTableUsed[i >> 8] = 2;
+				else if (_lowercaseTableUsed[i >> 8] &&
+				    memcmp(_lowercaseTable + i,
+				    _titlecaseTable + i,
+				    256 * sizeof(of_unichar_t)) == 0)
+					_titlecaseTableUsed[i >> 8] = 3;
+				else {
+					_titlecaseTableUsed[i >> 8] = 1;
+					isEmpty = false;
+				}
+
 				break;
 			}
 		}
@@ -417,18 +431,32 @@ OF_APPLICATION_DELEGATE(TableGenerator)
 		}
 	}
 
-	/* Write casefoldingPage%u if it does NOT match lowercasePage%u */
+	/*
+	 * Write casefoldingPage%u if it does NOT match lowercasePage%u or
+	 * uppercasePage%u
+	 */
 	for (of_unichar_t i = 0; i < 0x110000; i += 0x100) {
 		bool isEmpty = true;
 
 		for (of_unichar_t j = i; j < i + 0x100; j++) {
 			if (_casefoldingTable[j] != 0) {
-				isEmpty = !memcmp(_lowercaseTable + i,
-				    _casefoldingTable + i,
-				    256 * sizeof(of_unichar_t));
 				_casefoldingTableSize = i >> 8;
-				_casefoldingTableUsed[_casefoldingTableSize] =
-				    (isEmpty ? 2 : 1);
+
+				if (_lowercaseTableUsed[i >> 8] &&
+				    memcmp(_lowercaseTable + i,
+				    _casefoldingTable + i,
+				    256 * sizeof(of_unichar_t)) == 0)
+					_casefoldingTableUsed[i >> 8] = 2;
+				else if (_uppercaseTableUsed[i >> 8] &&
+				    memcmp(_uppercaseTable + i,
+				    _casefoldingTable + i,
+				    256 * sizeof(of_unichar_t)) == 0)
+					_casefoldingTableUsed[i >> 8] = 3;
+				else {
+					_casefoldingTableUsed[i >> 8] = 1;
+					isEmpty = false;
+				}
+
 				break;
 			}
 		}
@@ -644,6 +672,9 @@ OF_APPLICATION_DELEGATE(TableGenerator)
 		else if (_titlecaseTableUsed[i] == 2)
 			[file writeString: [OFString stringWithFormat:
 			    @"uppercasePage%u", i]];
+		else if (_titlecaseTableUsed[i] == 3)
+			[file writeString: [OFString stringWithFormat:
+			    @"lowercasePage%u", i]];
 		else
 			[file writeString: @"emptyPage"];
 
@@ -669,6 +700,9 @@ OF_APPLICATION_DELEGATE(TableGenerator)
 		else if (_casefoldingTableUsed[i] == 2)
 			[file writeString: [OFString stringWithFormat:
 			    @"lowercasePage%u", i]];
+		else if (_casefoldingTableUsed[i] == 3)
+			[file writeString: [OFString stringWithFormat:
+			    @"uppercasePage%u", i]];
 		else
 			[file writeString: @"emptyPage"];
 
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFObject.h"
+#import "OFASN1Value.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+@class OFData;
+@class OFMutableData;
+
+/*!
+ * @class OFASN1DERElement OFASN1DERElement.h ObjFW/OFASN1DERElement.h
+ *
+ * @brief A class for lazily accessing ASN.1 values in DER representation.
+ *
+ * In contrast to @ref OFData::ASN1DERValue, this does not decode the whole
+ * tree of values up front. Instead, the lengths of all values are validated
+ * once when the element is created, and the elements of constructed values as
+ * well as the decoded values are only created when they are accessed. All
+ * elements refer to the data they were created from instead of copying it.
+ */
+@interface OFASN1DERElement: OFObject
+{
+	OFData *_data;
+	size_t _offset, _headerLength, _contentsLength;
+	unsigned char _tag;
+	size_t _depthLimit;
+	OFMutableData *_Nullable _elementOffsets;
+	id _Nullable _value;
+}
+
+/*!
+ * @brief The tag class of the element's type.
+ */
+@property (readonly, nonatomic) of_asn1_tag_class_t tagClass;
+
+/*!
+ * @brief The tag number of the element's type.
+ */
+@property (readonly, nonatomic) of_asn1_tag_number_t tagNumber;
+
+/*!
+ * @brief Whether the element is of a constructed type.
+ */
+@property (readonly, nonatomic, getter=isConstructed) bool constructed;
+
+/*!
+ * @brief The DER-encoded contents octets of the element.
+ */
+@property (readonly, nonatomic) OFData *DEREncodedContents;
+
+/*!
+ * @brief The complete DER representation of the element, including the
+ *	  identifier and length octets.
+ */
+@property (readonly, nonatomic) OFData *DERRepresentation;
+
+/*!
+ * @brief The number of elements contained in the element.
+ *
+ * This is 0 if the element is not of a constructed type.
+ */
+@property (readonly, nonatomic) size_t count;
+
+/*!
+ * @brief The element decoded as an object.
+ *
+ * This is the same object as @ref OFData::ASN1DERValue returns for the DER
+ * representation of the element, which means that accessing it decodes the
+ * element including all elements it contains.
+ */
+@property (readonly, nonatomic) id value;
+
+/*!
+ * @brief Creates a new element from the specified DER representation.
+ *
+ * @param DERRepresentation The DER representation of exactly one value
+ * @return A new, autoreleased OFASN1DERElement
+ */
++ (instancetype)elementWithDERRepresentation: (OFData *)DERRepresentation;
+
+/*!
+ * @brief Creates a new element from the specified DER representation.
+ *
+ * @param DERRepresentation The DER representation of exactly one value
+ * @param depthLimit The maximum depth of nested constructed values that is
+ *		     accepted (defaults to 32 if not specified, 0 means no
+ *		     limit (insecure!))
+ * @return A new, autoreleased OFASN1DERElement
+ */
++ (instancetype)elementWithDERRepresentation: (OFData *)DERRepresentation
+				  depthLimit: (size_t)depthLimit;
+
+- (instancetype)init OF_UNAVAILABLE;
+
+/*!
+ * @brief Initializes an already allocated element with the specified DER
+ *	  representation.
+ *
+ * @param DERRepresentation The DER representation of exactly one value
+ * @return An initialized OFASN1DERElement
+ */
+- (instancetype)initWithDERRepresentation: (OFData *)DERRepresentation;
+
+/*!
+ * @brief Initializes an already allocated element with the specified DER
+ *	  representation.
+ *
+ * @param DERRepresentation The DER representation of exactly one value
+ * @param depthLimit The maximum depth of nested constructed values that is
+ *		     accepted (defaults to 32 if not specified, 0 means no
+ *		     limit (insecure!))
+ * @return An initialized OFASN1DERElement
+ */
+- (instancetype)initWithDERRepresentation: (OFData *)DERRepresentation
+			       depthLimit: (size_t)depthLimit;
+
+/*!
+ * @brief Returns the element at the specified index of the constructed
+ *	  element.
+ *
+ * @param index The index of the element to return
+ * @return The element at the specified index
+ */
+- (OFASN1DERElement *)elementAtIndex: (size_t)index;
+@end
+
+OF_ASSUME_NONNULL_END
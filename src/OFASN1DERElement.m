@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "OFASN1DERElement.h"
+#import "OFData.h"
+#import "OFData+ASN1DERValue.h"
+#import "OFData+ASN1DERValue+Private.h"
+#import "OFString.h"
+
+#import "OFInvalidArgumentException.h"
+#import "OFInvalidFormatException.h"
+#import "OFOutOfRangeException.h"
+
+enum {
+	ASN1_TAG_CONSTRUCTED_MASK = 0x20
+};
+
+@interface OFASN1DERElement ()
+- (instancetype)of_initWithData: (OFData *)data
+			 offset: (size_t)offset
+		     depthLimit: (size_t)depthLimit OF_METHOD_FAMILY(init);
+- (void)of_findElements;
+@end
+
+/*
+ * Validates the value at the start of items and all values it contains
+ * without creating any objects and returns the length of its DER
+ * representation. This checks the same as -[OFData ASN1DERValue] does for the
+ * structure, but also descends into all other constructed values.
+ */
+static size_t
+validate(const unsigned char *items, size_t count, size_t depthLimit)
+{
+	unsigned char tag;
+	size_t contentsLength, headerLength;
+	const unsigned char *contents, *previous = NULL;
+	size_t previousLength = 0;
+
+	headerLength = of_asn1_der_parse_header(items, count, &tag,
+	    &contentsLength);
+	contents = items + headerLength;
+
+	switch (tag & ~ASN1_TAG_CONSTRUCTED_MASK) {
+	case OF_ASN1_TAG_NUMBER_NULL:
+		if (tag & ASN1_TAG_CONSTRUCTED_MASK || contentsLength != 0)
+			@throw [OFInvalidFormatException exception];
+		break;
+	case OF_ASN1_TAG_NUMBER_SEQUENCE:
+	case OF_ASN1_TAG_NUMBER_SET:
+		if (!(tag & ASN1_TAG_CONSTRUCTED_MASK))
+			@throw [OFInvalidFormatException exception];
+		break;
+	}
+
+	if (!(tag & ASN1_TAG_CONSTRUCTED_MASK))
+		return headerLength + contentsLength;
+
+	if (--depthLimit == 0)
+		@throw [OFOutOfRangeException exception];
+
+	while (contentsLength > 0) {
+		size_t length = validate(contents, contentsLength, depthLimit);
+
+		/* The elements of a set need to be sorted in DER */
+		if ((tag & ~ASN1_TAG_CONSTRUCTED_MASK) ==
+		    OF_ASN1_TAG_NUMBER_SET && previous != NULL) {
+			size_t minLength = (length < previousLength
+			    ? length : previousLength);
+			int comparison = memcmp(contents, previous, minLength);
+
+			if (comparison < 0 ||
+			    (comparison == 0 && length <= previousLength))
+				@throw [OFInvalidFormatException exception];
+		}
+
+		previous = contents;
+		previousLength = length;
+
+		contents += length;
+		contentsLength -= length;
+	}
+
+	return (size_t)(contents - items);
+}
+
+@implementation OFASN1DERElement
++ (instancetype)elementWithDERRepresentation: (OFData *)DERRepresentation
+{
+	return [[[self alloc]
+	    initWithDERRepresentation: DERRepresentation] autorelease];
+}
+
++ (instancetype)elementWithDERRepresentation: (OFData *)DERRepresentation
+				  depthLimit: (size_t)depthLimit
+{
+	return [[[self alloc] initWithDERRepresentation: DERRepresentation
+					     depthLimit: depthLimit]
+	    autorelease];
+}
+
+- (instancetype)init
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithDERRepresentation: (OFData *)DERRepresentation
+{
+	return [self initWithDERRepresentation: DERRepresentation
+				    depthLimit: 32];
+}
+
+- (instancetype)initWithDERRepresentation: (OFData *)DERRepresentation
+			       depthLimit: (size_t)depthLimit
+{
+	self = [super init];
+
+	@try {
+		size_t count = [DERRepresentation count];
+
+		if ([DERRepresentation itemSize] != 1)
+			@throw [OFInvalidArgumentException exception];
+
+		/* Validate everything once so accessing elements can't fail */
+		if (validate([DERRepresentation items], count, depthLimit) !=
+		    count)
+			@throw [OFInvalidFormatException exception];
+
+		_data = [DERRepresentation copy];
+		_depthLimit = depthLimit;
+		_headerLength = of_asn1_der_parse_header([_data items], count,
+		    &_tag, &_contentsLength);
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (instancetype)of_initWithData: (OFData *)data
+			 offset: (size_t)offset
+		     depthLimit: (size_t)depthLimit
+{
+	self = [super init];
+
+	@try {
+		const unsigned char *items = [data items];
+
+		_data = [data retain];
+		_offset = offset;
+		_depthLimit = depthLimit;
+		_headerLength = of_asn1_der_parse_header(items + offset,
+		    [data count] - offset, &_tag, &_contentsLength);
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_data release];
+	[_elementOffsets release];
+	[_value release];
+
+	[super dealloc];
+}
+
+- (of_asn1_tag_class_t)tagClass
+{
+	return _tag >> 6;
+}
+
+- (of_asn1_tag_number_t)tagNumber
+{
+	return _tag & 0x1F;
+}
+
+- (bool)isConstructed
+{
+	return (_tag & ASN1_TAG_CONSTRUCTED_MASK);
+}
+
+- (OFData *)DEREncodedContents
+{
+	return [_data subdataWithRange:
+	    of_range(_offset + _headerLength, _contentsLength)];
+}
+
+- (OFData *)DERRepresentation
+{
+	return [_data subdataWithRange:
+	    of_range(_offset, _headerLength + _contentsLength)];
+}
+
+- (void)of_findElements
+{
+	const unsigned char *items;
+	size_t offset, end;
+
+	if (_elementOffsets != nil)
+		return;
+
+	_elementOffsets = [[OFMutableData alloc]
+	    initWithItemSize: sizeof(size_t)];
+
+	if (!(_tag & ASN1_TAG_CONSTRUCTED_MASK))
+		return;
+
+	items = [_data items];
+	offset = _offset + _headerLength;
+	end = offset + _contentsLength;
+
+	while (offset < end) {
+		unsigned char tag;
+		size_t contentsLength;
+
+		[_elementOffsets addItem: &offset];
+
+		offset += of_asn1_der_parse_header(items + offset,
+		    end - offset, &tag, &contentsLength);
+		offset += contentsLength;
+	}
+}
+
+- (size_t)count
+{
+	[self of_findElements];
+
+	return [_elementOffsets count];
+}
+
+- (OFASN1DERElement *)elementAtIndex: (size_t)idx
+{
+	size_t offset;
+
+	[self of_findElements];
+
+	offset = *(size_t *)[_elementOffsets itemAtIndex: idx];
+
+	return [[[OFASN1DERElement alloc]
+	    of_initWithData: _data
+		     offset: offset
+		 depthLimit: _depthLimit - 1] autorelease];
+}
+
+- (id)value
+{
+	if (_value == nil)
+		_value = [[[self DERRepresentation]
+		    ASN1DERValueWithDepthLimit: _depthLimit] retain];
+
+	return _value;
+}
+
+- (bool)isEqual: (id)object
+{
+	OFASN1DERElement *element;
+
+	if (![object isKindOfClass: [OFASN1DERElement class]])
+		return false;
+
+	element = object;
+
+	return [[element DERRepresentation] isEqual: [self DERRepresentation]];
+}
+
+- (uint32_t)hash
+{
+	return [[self DERRepresentation] hash];
+}
+
+- (OFString *)description
+{
+	return [OFString stringWithFormat:
+	    @"<OFASN1DERElement:\n"
+	    @"\tTag class = %x\n"
+	    @"\tTag number = %x\n"
+	    @"\tConstructed = %u\n"
+	    @"\tDER-encoded contents = %@\n"
+	    @">",
+	    [self tagClass], [self tagNumber], [self isConstructed],
+	    [[self DEREncodedContents] description]];
+}
+@end
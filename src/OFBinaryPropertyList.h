@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFObject.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+@class OFData;
+@class OFString;
+
+/*!
+ * @class OFBinaryPropertyList \
+ *	  OFBinaryPropertyList.h ObjFW/OFBinaryPropertyList.h
+ *
+ * @brief A binary property list (bplist00) that only decodes the objects that
+ *	  are accessed.
+ *
+ * Binary property lists store an offset table with the position of every
+ * object, which allows jumping to any object directly. Objects are only
+ * decoded when they are looked up, for example using @ref valueForKeyPath:,
+ * and every object is decoded at most once.
+ *
+ * Data objects are returned as subdata of the property list's data and thus
+ * are not copied.
+ *
+ * @ref dataWithRootValue: can be used to create a binary property list.
+ */
+@interface OFBinaryPropertyList: OFObject
+{
+	OFData *_data;
+	size_t _depthLimit;
+	uint8_t _offsetSize, _referenceSize;
+	size_t _objectsCount, _topObject, _offsetTableOffset;
+	id _Nullable *_objects;
+}
+
+/*!
+ * @brief The data of the property list.
+ */
+@property (readonly, nonatomic) OFData *data;
+
+/*!
+ * @brief The top-level object of the property list.
+ *
+ * This decodes the whole property list.
+ */
+@property (readonly, nonatomic) id rootValue;
+
+/*!
+ * @brief Creates a new binary property list with the specified data.
+ *
+ * @param data The data of the property list. It needs to have an item size of
+ *	       1.
+ * @return A new, autoreleased OFBinaryPropertyList
+ */
++ (instancetype)propertyListWithData: (OFData *)data;
+
+/*!
+ * @brief Creates a new binary property list with the specified data.
+ *
+ * @param data The data of the property list. It needs to have an item size of
+ *	       1.
+ * @param depthLimit The maximum depth of nested objects that is decoded. 0
+ *		     means unlimited (insecure!).
+ * @return A new, autoreleased OFBinaryPropertyList
+ */
++ (instancetype)propertyListWithData: (OFData *)data
+			  depthLimit: (size_t)depthLimit;
+
+/*!
+ * @brief Creates the binary property list representation of the specified
+ *	  object.
+ *
+ * Supported are OFString, OFData, OFDate, OFNumber, OFNull, OFArray,
+ * OFDictionary with string keys and OFSet.
+ *
+ * @param rootValue The top-level object of the property list
+ * @return The binary property list representation of the object
+ */
++ (OFData *)dataWithRootValue: (id)rootValue;
+
+- (instancetype)init OF_UNAVAILABLE;
+
+/*!
+ * @brief Initializes an already allocated binary property list with the
+ *	  specified data.
+ *
+ * @param data The data of the property list. It needs to have an item size of
+ *	       1.
+ * @return An initialized OFBinaryPropertyList
+ */
+- (instancetype)initWithData: (OFData *)data;
+
+/*!
+ * @brief Initializes an already allocated binary property list with the
+ *	  specified data.
+ *
+ * Only the header and the trailer of the property list are checked here,
+ * objects are validated when they are decoded.
+ *
+ * @param data The data of the property list. It needs to have an item size of
+ *	       1.
+ * @param depthLimit The maximum depth of nested objects that is decoded. 0
+ *		     means unlimited (insecure!).
+ * @return An initialized OFBinaryPropertyList
+ */
+- (instancetype)initWithData: (OFData *)data
+		  depthLimit: (size_t)depthLimit OF_DESIGNATED_INITIALIZER;
+
+/*!
+ * @brief Returns the value for the specified key path.
+ *
+ * The components of the key path are separated by dots. For dictionaries, a
+ * component selects the object for that key. For arrays, a component needs to
+ * be a decimal index.
+ *
+ * Only the keys of the dictionaries on the path and the returned value are
+ * decoded.
+ *
+ * @param keyPath The key path of the value to return
+ * @return The value for the specified key path or `nil` if there is no such
+ *	   value
+ */
+- (nullable id)valueForKeyPath: (OFString *)keyPath;
+@end
+
+OF_ASSUME_NONNULL_END
@@ -0,0 +1,729 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "OFBinaryPropertyList.h"
+#import "OFArray.h"
+#import "OFData.h"
+#import "OFDate.h"
+#import "OFDictionary.h"
+#import "OFNull.h"
+#import "OFNumber.h"
+#import "OFSecureData.h"
+#import "OFSet.h"
+#import "OFString.h"
+
+#import "OFInvalidArgumentException.h"
+#import "OFInvalidFormatException.h"
+#import "OFOutOfRangeException.h"
+
+#import "swar.h"
+
+/* Seconds between 1970-01-01 and 2001-01-01, the epoch of binary plists */
+#define DATE_OFFSET 978307200
+
+/* magic, then 6 unused bytes, 2 sizes and 3 64 bit integers as trailer */
+#define HEADER_LENGTH 8
+#define TRAILER_LENGTH 32
+
+@interface OFBinaryPropertyList ()
+- (size_t)of_offsetOfObject: (uint64_t)reference;
+- (size_t)of_countAtOffset: (size_t *)offset
+		  itemSize: (size_t)itemSize;
+- (uint64_t)of_referenceAtOffset: (size_t)offset;
+- (id)of_objectForReference: (uint64_t)reference
+		      depth: (size_t)depth;
+- (id)of_parseObjectAtOffset: (size_t)offset
+		       depth: (size_t)depth;
+@end
+
+static uint64_t
+readUInt(const unsigned char *buffer, size_t size)
+{
+	uint64_t value = 0;
+
+	for (size_t i = 0; i < size; i++)
+		value = (value << 8) | buffer[i];
+
+	return value;
+}
+
+static void
+writeUInt(OFMutableData *data, uint64_t value, size_t size)
+{
+	unsigned char buffer[8];
+
+	for (size_t i = size; i > 0; i--) {
+		buffer[i - 1] = (unsigned char)value;
+		value >>= 8;
+	}
+
+	[data addItems: buffer
+		 count: size];
+}
+
+static uint8_t
+sizeForUInt(uint64_t value)
+{
+	if (value <= UINT8_MAX)
+		return 1;
+	if (value <= UINT16_MAX)
+		return 2;
+	if (value <= UINT32_MAX)
+		return 4;
+
+	return 8;
+}
+
+static void
+writeInteger(OFMutableData *data, uint64_t value)
+{
+	uint8_t size = sizeForUInt(value);
+	/* The size is stored as log2 */
+	unsigned char marker = 0x10 |
+	    (size == 1 ? 0 : (size == 2 ? 1 : (size == 4 ? 2 : 3)));
+
+	[data addItem: &marker];
+	writeUInt(data, value, size);
+}
+
+static void
+writeMarker(OFMutableData *data, unsigned char type, size_t count)
+{
+	unsigned char marker = type | (count < 0x0F ? count : 0x0F);
+
+	[data addItem: &marker];
+
+	if (count >= 0x0F)
+		writeInteger(data, count);
+}
+
+static void
+writeDouble(OFMutableData *data, unsigned char marker, double value)
+{
+	[data addItem: &marker];
+	value = OF_BSWAP_DOUBLE_IF_LE(value);
+	[data addItems: &value
+		 count: sizeof(value)];
+}
+
+/*
+ * Collects all objects in depth-first order, which is the order in which they
+ * are written, and the number of objects in the subtree of each object. As
+ * the children of a container directly follow it, this is all that is needed
+ * to calculate the references to them.
+ */
+static void
+collectObjects(id object, OFMutableArray *objects, OFMutableData *subtreeSizes)
+{
+	size_t idx = [objects count], subtreeSize = 0;
+
+	[objects addObject: object];
+	[subtreeSizes addItem: &subtreeSize];
+
+	if ([object isKindOfClass: [OFArray class]] ||
+	    [object isKindOfClass: [OFSet class]]) {
+		for (id child in object)
+			collectObjects(child, objects, subtreeSizes);
+	} else if ([object isKindOfClass: [OFDictionary class]]) {
+		void *pool = objc_autoreleasePoolPush();
+		OFEnumerator *enumerator;
+		id child;
+
+		enumerator = [object keyEnumerator];
+		while ((child = [enumerator nextObject]) != nil) {
+			if (![child isKindOfClass: [OFString class]])
+				@throw [OFInvalidArgumentException exception];
+
+			collectObjects(child, objects, subtreeSizes);
+		}
+
+		enumerator = [object objectEnumerator];
+		while ((child = [enumerator nextObject]) != nil)
+			collectObjects(child, objects, subtreeSizes);
+
+		objc_autoreleasePoolPop(pool);
+	}
+
+	subtreeSize = [objects count] - idx;
+	memcpy([subtreeSizes itemAtIndex: idx], &subtreeSize,
+	    sizeof(subtreeSize));
+}
+
+static void
+writeReferences(OFMutableData *data, size_t idx, size_t count,
+    const size_t *subtreeSizes, uint8_t referenceSize)
+{
+	size_t reference = idx + 1;
+
+	for (size_t i = 0; i < count; i++) {
+		writeUInt(data, reference, referenceSize);
+		reference += subtreeSizes[reference];
+	}
+}
+
+static void
+writeObject(OFMutableData *data, id object, size_t idx,
+    const size_t *subtreeSizes, uint8_t referenceSize)
+{
+	if ([object isKindOfClass: [OFString class]]) {
+		const char *UTF8String = [object UTF8String];
+		size_t UTF8StringLength = [object UTF8StringLength];
+
+		if (of_swar_ascii_length(UTF8String, UTF8StringLength) ==
+		    UTF8StringLength) {
+			writeMarker(data, 0x50, UTF8StringLength);
+			[data addItems: UTF8String
+				 count: UTF8StringLength];
+		} else {
+			size_t length = [object UTF16StringLength];
+
+			writeMarker(data, 0x60, length);
+			[data addItems: [object UTF16StringWithByteOrder:
+					    OF_BYTE_ORDER_BIG_ENDIAN]
+				 count: length * sizeof(of_char16_t)];
+		}
+	} else if ([object isKindOfClass: [OFData class]] &&
+	    ![object isKindOfClass: [OFSecureData class]]) {
+		if ([object itemSize] != 1)
+			@throw [OFInvalidArgumentException exception];
+
+		writeMarker(data, 0x40, [object count]);
+		[data addItems: [object items]
+			 count: [object count]];
+	} else if ([object isKindOfClass: [OFDate class]]) {
+		writeDouble(data, 0x33,
+		    [object timeIntervalSince1970] - DATE_OFFSET);
+	} else if ([object isKindOfClass: [OFNumber class]]) {
+		of_number_type_t type = [object type];
+		unsigned char marker;
+
+		if (type == OF_NUMBER_TYPE_BOOL) {
+			marker = ([object boolValue] ? 0x09 : 0x08);
+			[data addItem: &marker];
+		} else if (type & OF_NUMBER_TYPE_FLOAT)
+			writeDouble(data, 0x23, [object doubleValue]);
+		else if ((type & OF_NUMBER_TYPE_SIGNED) &&
+		    [object intMaxValue] < 0) {
+			marker = 0x13;
+			[data addItem: &marker];
+			writeUInt(data, (uint64_t)[object intMaxValue], 8);
+		} else {
+			uintmax_t value = [object uIntMaxValue];
+
+			/* 8 byte integers are signed, larger ones need 16 */
+			if (value > INT64_MAX) {
+				marker = 0x14;
+				[data addItem: &marker];
+				writeUInt(data, 0, 8);
+				writeUInt(data, value, 8);
+			} else
+				writeInteger(data, value);
+		}
+	} else if ([object isKindOfClass: [OFNull class]]) {
+		unsigned char marker = 0x00;
+
+		[data addItem: &marker];
+	} else if ([object isKindOfClass: [OFArray class]]) {
+		writeMarker(data, 0xA0, [object count]);
+		writeReferences(data, idx, [object count], subtreeSizes,
+		    referenceSize);
+	} else if ([object isKindOfClass: [OFSet class]]) {
+		writeMarker(data, 0xC0, [object count]);
+		writeReferences(data, idx, [object count], subtreeSizes,
+		    referenceSize);
+	} else if ([object isKindOfClass: [OFDictionary class]]) {
+		/* Keys and objects directly follow each other */
+		writeMarker(data, 0xD0, [object count]);
+		writeReferences(data, idx, 2 * [object count], subtreeSizes,
+		    referenceSize);
+	} else
+		@throw [OFInvalidArgumentException exception];
+}
+
+@implementation OFBinaryPropertyList
+@synthesize data = _data;
+
++ (instancetype)propertyListWithData: (OFData *)data
+{
+	return [[[self alloc] initWithData: data] autorelease];
+}
+
++ (instancetype)propertyListWithData: (OFData *)data
+			  depthLimit: (size_t)depthLimit
+{
+	return [[[self alloc] initWithData: data
+				depthLimit: depthLimit] autorelease];
+}
+
++ (OFData *)dataWithRootValue: (id)rootValue
+{
+	OFMutableData *data = [OFMutableData data];
+	void *pool = objc_autoreleasePoolPush();
+	OFMutableArray *objects = [OFMutableArray array];
+	OFMutableData *subtreeSizes =
+	    [OFMutableData dataWithItemSize: sizeof(size_t)];
+	OFMutableData *offsets =
+	    [OFMutableData dataWithItemSize: sizeof(size_t)];
+	const size_t *sizes;
+	size_t count, idx, offsetTableOffset;
+	uint8_t referenceSize, offsetSize;
+
+	collectObjects(rootValue, objects, subtreeSizes);
+
+	count = [objects count];
+	sizes = [subtreeSizes items];
+	referenceSize = sizeForUInt(count - 1);
+
+	[data addItems: "bplist00"
+		 count: HEADER_LENGTH];
+
+	idx = 0;
+	for (id object in objects) {
+		size_t offset = [data count];
+
+		[offsets addItem: &offset];
+		writeObject(data, object, idx++, sizes, referenceSize);
+	}
+
+	offsetTableOffset = [data count];
+	offsetSize = sizeForUInt(offsetTableOffset);
+
+	for (size_t i = 0; i < count; i++)
+		writeUInt(data, *(size_t *)[offsets itemAtIndex: i],
+		    offsetSize);
+
+	writeUInt(data, 0, 6);
+	[data addItem: &offsetSize];
+	[data addItem: &referenceSize];
+	writeUInt(data, count, 8);
+	writeUInt(data, 0, 8);
+	writeUInt(data, offsetTableOffset, 8);
+
+	objc_autoreleasePoolPop(pool);
+
+	[data makeImmutable];
+
+	return data;
+}
+
+- (instancetype)init
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithData: (OFData *)data
+{
+	return [self initWithData: data
+		       depthLimit: 32];
+}
+
+- (instancetype)initWithData: (OFData *)data
+		  depthLimit: (size_t)depthLimit
+{
+	self = [super init];
+
+	@try {
+		const unsigned char *items, *trailer;
+		size_t count;
+		uint64_t objectsCount, topObject, offsetTableOffset;
+
+		if ([data itemSize] != 1)
+			@throw [OFInvalidArgumentException exception];
+
+		/* Mutable data needs to be copied, as subdata refers to it */
+		_data = [data copy];
+		_depthLimit = depthLimit;
+
+		items = [_data items];
+		count = [_data count];
+
+		if (count < HEADER_LENGTH + TRAILER_LENGTH ||
+		    memcmp(items, "bplist00", HEADER_LENGTH) != 0)
+			@throw [OFInvalidFormatException exception];
+
+		trailer = items + count - TRAILER_LENGTH;
+		_offsetSize = trailer[6];
+		_referenceSize = trailer[7];
+		objectsCount = readUInt(trailer + 8, 8);
+		topObject = readUInt(trailer + 16, 8);
+		offsetTableOffset = readUInt(trailer + 24, 8);
+
+		if (_offsetSize < 1 || _offsetSize > 8 ||
+		    _referenceSize < 1 || _referenceSize > 8 ||
+		    objectsCount == 0 || topObject >= objectsCount ||
+		    offsetTableOffset < HEADER_LENGTH ||
+		    offsetTableOffset > count - TRAILER_LENGTH ||
+		    (count - TRAILER_LENGTH - offsetTableOffset) /
+		    _offsetSize < objectsCount)
+			@throw [OFInvalidFormatException exception];
+
+		_objectsCount = (size_t)objectsCount;
+		_topObject = (size_t)topObject;
+		_offsetTableOffset = (size_t)offsetTableOffset;
+
+		_objects = [self allocZeroedMemoryWithSize: sizeof(id)
+						     count: _objectsCount];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	if (_objects != NULL)
+		for (size_t i = 0; i < _objectsCount; i++)
+			[_objects[i] release];
+
+	[_data release];
+
+	[super dealloc];
+}
+
+- (size_t)of_offsetOfObject: (uint64_t)reference
+{
+	uint64_t offset;
+
+	if (reference >= _objectsCount)
+		@throw [OFInvalidFormatException exception];
+
+	offset = readUInt((const unsigned char *)[_data items] +
+	    _offsetTableOffset + (size_t)reference * _offsetSize, _offsetSize);
+
+	/* Objects need to be between the header and the offset table */
+	if (offset < HEADER_LENGTH || offset >= _offsetTableOffset)
+		@throw [OFInvalidFormatException exception];
+
+	return (size_t)offset;
+}
+
+/*
+ * Returns the count encoded in the marker at the offset and advances the
+ * offset past the marker. It is also checked that count items of the
+ * specified size follow.
+ */
+- (size_t)of_countAtOffset: (size_t *)offset
+		  itemSize: (size_t)itemSize
+{
+	const unsigned char *items = [_data items];
+	uint64_t count = items[(*offset)++] & 0x0F;
+
+	if (count == 0x0F) {
+		size_t size;
+
+		if (*offset >= _offsetTableOffset ||
+		    (items[*offset] & 0xF0) != 0x10)
+			@throw [OFInvalidFormatException exception];
+
+		size = (size_t)1 << (items[*offset] & 0x0F);
+
+		if (size > 8 || _offsetTableOffset - *offset - 1 < size)
+			@throw [OFInvalidFormatException exception];
+
+		count = readUInt(items + *offset + 1, size);
+		*offset += 1 + size;
+	}
+
+	if (count > (_offsetTableOffset - *offset) / itemSize)
+		@throw [OFInvalidFormatException exception];
+
+	return (size_t)count;
+}
+
+- (uint64_t)of_referenceAtOffset: (size_t)offset
+{
+	return readUInt((const unsigned char *)[_data items] + offset,
+	    _referenceSize);
+}
+
+- (id)of_objectForReference: (uint64_t)reference
+		      depth: (size_t)depth
+{
+	id object;
+
+	if (reference >= _objectsCount)
+		@throw [OFInvalidFormatException exception];
+
+	if (_objects[reference] != nil)
+		return _objects[reference];
+
+	object = [self
+	    of_parseObjectAtOffset: [self of_offsetOfObject: reference]
+			     depth: depth];
+
+	/* A reference can occur again within the object */
+	if (_objects[reference] == nil)
+		_objects[reference] = [object retain];
+
+	return object;
+}
+
+- (id)of_parseObjectAtOffset: (size_t)offset
+		       depth: (size_t)depth
+{
+	const unsigned char *items = [_data items];
+	unsigned char marker = items[offset];
+	size_t count, size;
+	union {
+		unsigned char u8[8];
+		float f;
+		double d;
+	} real;
+	of_char16_t *buffer;
+	OFString *string;
+	id container;
+	void *pool;
+
+	switch (marker >> 4) {
+	case 0x0:
+		switch (marker) {
+		case 0x00:
+			return [OFNull null];
+		case 0x08:
+			return [OFNumber numberWithBool: false];
+		case 0x09:
+			return [OFNumber numberWithBool: true];
+		}
+
+		@throw [OFInvalidFormatException exception];
+	case 0x1:
+		size = (size_t)1 << (marker & 0x0F);
+
+		if (size > 16 || _offsetTableOffset - offset - 1 < size)
+			@throw [OFInvalidFormatException exception];
+
+		/* 16 byte integers are only used for large unsigned ones */
+		if (size == 16) {
+			if (readUInt(items + offset + 1, 8) != 0)
+				@throw [OFOutOfRangeException exception];
+
+			return [OFNumber numberWithUInt64:
+			    readUInt(items + offset + 9, 8)];
+		}
+
+		return [OFNumber numberWithIntMax:
+		    (int64_t)readUInt(items + offset + 1, size)];
+	case 0x2:
+		size = (size_t)1 << (marker & 0x0F);
+
+		if ((size != 4 && size != 8) ||
+		    _offsetTableOffset - offset - 1 < size)
+			@throw [OFInvalidFormatException exception];
+
+		memcpy(real.u8, items + offset + 1, size);
+
+		if (size == 4)
+			return [OFNumber numberWithDouble:
+			    OF_BSWAP_FLOAT_IF_LE(real.f)];
+
+		return [OFNumber numberWithDouble:
+		    OF_BSWAP_DOUBLE_IF_LE(real.d)];
+	case 0x3:
+		if (marker != 0x33 || _offsetTableOffset - offset - 1 < 8)
+			@throw [OFInvalidFormatException exception];
+
+		memcpy(real.u8, items + offset + 1, 8);
+
+		return [OFDate dateWithTimeIntervalSince1970:
+		    OF_BSWAP_DOUBLE_IF_LE(real.d) + DATE_OFFSET];
+	case 0x4:
+		count = [self of_countAtOffset: &offset
+				      itemSize: 1];
+
+		return [_data subdataWithRange: of_range(offset, count)];
+	case 0x5:
+		count = [self of_countAtOffset: &offset
+				      itemSize: 1];
+
+		return [OFString
+		    stringWithCString: (const char *)items + offset
+			     encoding: OF_STRING_ENCODING_ASCII
+			       length: count];
+	case 0x6:
+		count = [self of_countAtOffset: &offset
+				      itemSize: sizeof(of_char16_t)];
+
+		/* The string is not necessarily aligned */
+		buffer = [self allocMemoryWithSize: sizeof(of_char16_t)
+					     count: count];
+		@try {
+			memcpy(buffer, items + offset,
+			    count * sizeof(of_char16_t));
+
+			string = [OFString
+			    stringWithUTF16String: buffer
+					   length: count
+					byteOrder: OF_BYTE_ORDER_BIG_ENDIAN];
+		} @finally {
+			[self freeMemory: buffer];
+		}
+
+		return string;
+	case 0xA:
+	case 0xC:
+		if (_depthLimit != 0 && depth >= _depthLimit)
+			@throw [OFOutOfRangeException exception];
+
+		count = [self of_countAtOffset: &offset
+				      itemSize: _referenceSize];
+
+		container = ((marker >> 4) == 0xA
+		    ? (id)[OFMutableArray arrayWithCapacity: count]
+		    : (id)[OFMutableSet setWithCapacity: count]);
+		pool = objc_autoreleasePoolPush();
+
+		for (size_t i = 0; i < count; i++) {
+			uint64_t reference = [self of_referenceAtOffset:
+			    offset + i * _referenceSize];
+
+			[container addObject:
+			    [self of_objectForReference: reference
+						  depth: depth + 1]];
+		}
+
+		[container makeImmutable];
+
+		objc_autoreleasePoolPop(pool);
+
+		return container;
+	case 0xD:
+		if (_depthLimit != 0 && depth >= _depthLimit)
+			@throw [OFOutOfRangeException exception];
+
+		count = [self of_countAtOffset: &offset
+				      itemSize: 2 * _referenceSize];
+
+		container = [OFMutableDictionary dictionaryWithCapacity: count];
+		pool = objc_autoreleasePoolPush();
+
+		for (size_t i = 0; i < count; i++) {
+			uint64_t keyReference = [self of_referenceAtOffset:
+			    offset + i * _referenceSize];
+			uint64_t objectReference = [self of_referenceAtOffset:
+			    offset + (count + i) * _referenceSize];
+			id key = [self of_objectForReference: keyReference
+						       depth: depth + 1];
+			id object = [self of_objectForReference: objectReference
+							  depth: depth + 1];
+
+			if (![key isKindOfClass: [OFString class]])
+				@throw [OFInvalidFormatException exception];
+
+			[container setObject: object
+				      forKey: key];
+		}
+
+		[container makeImmutable];
+
+		objc_autoreleasePoolPop(pool);
+
+		return container;
+	}
+
+	@throw [OFInvalidFormatException exception];
+}
+
+- (id)rootValue
+{
+	return [self of_objectForReference: _topObject
+				     depth: 0];
+}
+
+- (id)valueForKeyPath: (OFString *)keyPath
+{
+	const unsigned char *items = [_data items];
+	void *pool = objc_autoreleasePoolPush();
+	uint64_t reference = _topObject;
+	id ret;
+
+	for (OFString *component in
+	    [keyPath componentsSeparatedByString: @"."]) {
+		size_t offset = [self of_offsetOfObject: reference];
+		unsigned char type = items[offset] >> 4;
+		size_t count;
+
+		if (type == 0xD) {
+			count = [self of_countAtOffset: &offset
+					      itemSize: 2 * _referenceSize];
+
+			reference = _objectsCount;
+			for (size_t i = 0; i < count; i++) {
+				uint64_t keyReference =
+				    [self of_referenceAtOffset:
+				    offset + i * _referenceSize];
+				id key = [self
+				    of_objectForReference: keyReference
+						    depth: 0];
+
+				if ([key isEqual: component]) {
+					reference = [self of_referenceAtOffset:
+					    offset + (count + i) *
+					    _referenceSize];
+					break;
+				}
+			}
+		} else if (type == 0xA) {
+			const char *cString = [component UTF8String];
+			size_t length = [component UTF8StringLength];
+			size_t element = 0;
+
+			count = [self of_countAtOffset: &offset
+					      itemSize: _referenceSize];
+
+			if (length == 0) {
+				objc_autoreleasePoolPop(pool);
+				return nil;
+			}
+
+			for (size_t i = 0; i < length; i++) {
+				if (cString[i] < '0' || cString[i] > '9' ||
+				    element > (SIZE_MAX - 9) / 10) {
+					objc_autoreleasePoolPop(pool);
+					return nil;
+				}
+
+				element = element * 10 + (cString[i] - '0');
+			}
+
+			if (element < count)
+				reference = [self of_referenceAtOffset:
+				    offset + element * _referenceSize];
+			else
+				reference = _objectsCount;
+		} else
+			reference = _objectsCount;
+
+		if (reference >= _objectsCount) {
+			objc_autoreleasePoolPop(pool);
+			return nil;
+		}
+	}
+
+	ret = [[self of_objectForReference: reference
+				     depth: 0] retain];
+
+	objc_autoreleasePoolPop(pool);
+
+	return [ret autorelease];
+}
+@end
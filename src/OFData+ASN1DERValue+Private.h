@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFData+ASN1DERValue.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Parses the identifier and length octets at the start of items and returns
+ * their length. Makes sure that the contents octets are not truncated.
+ */
+extern size_t of_asn1_der_parse_header(const unsigned char *items,
+    size_t count, unsigned char *tag, size_t *contentsLength);
+#ifdef __cplusplus
+}
+#endif
+
+OF_ASSUME_NONNULL_END
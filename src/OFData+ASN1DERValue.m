@@ -18,6 +18,7 @@
 #include "config.h"
 
 #import "OFData+ASN1DERValue.h"
+#import "OFData+ASN1DERValue+Private.h"
 #import "OFASN1BitString.h"
 #import "OFASN1Boolean.h"
 #import "OFASN1Enumerated.h"
@@ -111,25 +112,21 @@ parseSet(OFData *contents, size_t depthLimit)
 	return ret;
 }
 
-static size_t
-parseObject(OFData *self, id *object, size_t depthLimit)
+size_t
+of_asn1_der_parse_header(const unsigned char *items, size_t count,
+    unsigned char *tag, size_t *contentsLength)
 {
-	const unsigned char *items = [self items];
-	size_t count = [self count];
-	unsigned char tag;
-	size_t contentsLength, bytesConsumed = 0;
-	Class valueClass;
-	OFData *contents;
+	size_t bytesConsumed = 0;
 
 	if (count < 2)
 		@throw [OFTruncatedDataException exception];
 
-	tag = *items++;
-	contentsLength = *items++;
+	*tag = *items++;
+	*contentsLength = *items++;
 	bytesConsumed += 2;
 
-	if (contentsLength > 127) {
-		uint_fast8_t lengthLength = contentsLength & 0x7F;
+	if (*contentsLength > 127) {
+		uint_fast8_t lengthLength = *contentsLength & 0x7F;
 
 		if (lengthLength > sizeof(size_t))
 			@throw [OFOutOfRangeException exception];
@@ -142,20 +139,34 @@ parseObject(OFData *self, id *object, size_t depthLimit)
 		    (lengthLength >= 2 && items[0] == 0))
 			@throw [OFInvalidFormatException exception];
 
-		contentsLength = 0;
+		*contentsLength = 0;
 
 		for (uint_fast8_t i = 0; i < lengthLength; i++)
-			contentsLength = (contentsLength << 8) | *items++;
+			*contentsLength = (*contentsLength << 8) | *items++;
 
 		bytesConsumed += lengthLength;
 
-		if (contentsLength <= 127)
+		if (*contentsLength <= 127)
 			@throw [OFInvalidFormatException exception];
 	}
 
-	if (count - bytesConsumed < contentsLength)
+	if (count - bytesConsumed < *contentsLength)
 		@throw [OFTruncatedDataException exception];
 
+	return bytesConsumed;
+}
+
+static size_t
+parseObject(OFData *self, id *object, size_t depthLimit)
+{
+	unsigned char tag;
+	size_t contentsLength, bytesConsumed;
+	Class valueClass;
+	OFData *contents;
+
+	bytesConsumed = of_asn1_der_parse_header([self items], [self count],
+	    &tag, &contentsLength);
+
 	contents = [self subdataWithRange:
 	    of_range(bytesConsumed, contentsLength)];
 	bytesConsumed += contentsLength;
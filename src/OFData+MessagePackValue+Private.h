@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFData+MessagePackValue.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Parses a single object and returns the number of bytes it took. If source is
+ * not nil, buffer must point into it and bin and ext payloads are returned as
+ * subdata of source instead of being copied.
+ */
+extern size_t of_message_pack_parse_object(const unsigned char *buffer,
+    size_t length, id _Nullable *_Nonnull object, size_t depthLimit,
+    OFData *_Nullable source);
+#ifdef __cplusplus
+}
+#endif
+
+OF_ASSUME_NONNULL_END
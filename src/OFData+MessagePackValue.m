@@ -20,6 +20,7 @@
 #include <string.h>
 
 #import "OFData+MessagePackValue.h"
+#import "OFData+MessagePackValue+Private.h"
 #import "OFArray.h"
 #import "OFDate.h"
 #import "OFDictionary.h"
@@ -36,7 +37,7 @@
 int _OFData_MessagePackValue_reference;
 
 static size_t parseObject(const unsigned char *buffer, size_t length,
-    id *object, size_t depthLimit);
+    id *object, size_t depthLimit, OFData *source);
 
 static uint16_t
 readUInt16(const unsigned char *buffer)
@@ -62,7 +63,7 @@ readUInt64(const unsigned char *buffer)
 
 static size_t
 parseArray(const unsigned char *buffer, size_t length, id *object, size_t count,
-    size_t depthLimit)
+    size_t depthLimit, OFData *source)
 {
 	void *pool;
 	size_t pos = 0;
@@ -83,7 +84,7 @@ parseArray(const unsigned char *buffer, size_t length, id *object, size_t count,
 		pool = objc_autoreleasePoolPush();
 
 		pos += parseObject(buffer + pos, length - pos, &child,
-		    depthLimit);
+		    depthLimit, source);
 
 		[*object addObject: child];
 
@@ -95,7 +96,7 @@ parseArray(const unsigned char *buffer, size_t length, id *object, size_t count,
 
 static size_t
 parseTable(const unsigned char *buffer, size_t length, id *object, size_t count,
-    size_t depthLimit)
+    size_t depthLimit, OFData *source)
 {
 	void *pool;
 	size_t pos = 0;
@@ -116,9 +117,9 @@ parseTable(const unsigned char *buffer, size_t length, id *object, size_t count,
 		pool = objc_autoreleasePoolPush();
 
 		pos += parseObject(buffer + pos, length - pos, &key,
-		    depthLimit);
+		    depthLimit, source);
 		pos += parseObject(buffer + pos, length - pos, &value,
-		    depthLimit);
+		    depthLimit, source);
 
 		[*object setObject: value
 			    forKey: key];
@@ -129,6 +130,17 @@ parseTable(const unsigned char *buffer, size_t length, id *object, size_t count,
 	return pos;
 }
 
+static OFData *
+createData(const unsigned char *buffer, size_t count, OFData *source)
+{
+	if (source != nil)
+		return [source subdataWithRange: of_range(
+		    buffer - (const unsigned char *)[source items], count)];
+
+	return [OFData dataWithItems: buffer
+			       count: count];
+}
+
 static OFDate *
 createDate(OFData *data)
 {
@@ -183,10 +195,9 @@ createExtension(int8_t type, OFData *data)
 
 static size_t
 parseObject(const unsigned char *buffer, size_t length, id *object,
-    size_t depthLimit)
+    size_t depthLimit, OFData *source)
 {
 	size_t count;
-	OFData *data;
 
 	if (length < 1)
 		@throw [OFTruncatedDataException exception];
@@ -219,12 +230,12 @@ parseObject(const unsigned char *buffer, size_t length, id *object,
 	/* fixarray */
 	if ((buffer[0] & 0xF0) == 0x90)
 		return parseArray(buffer + 1, length - 1, object,
-		    buffer[0] & 0xF, depthLimit) + 1;
+		    buffer[0] & 0xF, depthLimit, source) + 1;
 
 	/* fixmap */
 	if ((buffer[0] & 0xF0) == 0x80)
 		return parseTable(buffer + 1, length - 1, object,
-		    buffer[0] & 0xF, depthLimit) + 1;
+		    buffer[0] & 0xF, depthLimit, source) + 1;
 
 	/* Prefix byte */
 	switch (buffer[0]) {
@@ -328,8 +339,7 @@ parseObject(const unsigned char *buffer, size_t length, id *object,
 		if (length < count + 2)
 			@throw [OFTruncatedDataException exception];
 
-		*object = [OFData dataWithItems: buffer + 2
-					  count: count];
+		*object = createData(buffer + 2, count, source);
 
 		return count + 2;
 	case 0xC5: /* bin 16 */
@@ -341,8 +351,7 @@ parseObject(const unsigned char *buffer, size_t length, id *object,
 		if (length < count + 3)
 			@throw [OFTruncatedDataException exception];
 
-		*object = [OFData dataWithItems: buffer + 3
-					  count: count];
+		*object = createData(buffer + 3, count, source);
 
 		return count + 3;
 	case 0xC6: /* bin 32 */
@@ -354,8 +363,7 @@ parseObject(const unsigned char *buffer, size_t length, id *object,
 		if (length < count + 5)
 			@throw [OFTruncatedDataException exception];
 
-		*object = [OFData dataWithItems: buffer + 5
-					  count: count];
+		*object = createData(buffer + 5, count, source);
 
 		return count + 5;
 	/* Extensions */
@@ -368,13 +376,8 @@ parseObject(const unsigned char *buffer, size_t length, id *object,
 		if (length < count + 3)
 			@throw [OFTruncatedDataException exception];
 
-		data = [[OFData alloc] initWithItems: buffer + 3
-					       count: count];
-		@try {
-			*object = createExtension(buffer[2], data);
-		} @finally {
-			[data release];
-		}
+		*object = createExtension(buffer[2],
+		    createData(buffer + 3, count, source));
 
 		return count + 3;
 	case 0xC8: /* ext 16 */
@@ -386,13 +389,8 @@ parseObject(const unsigned char *buffer, size_t length, id *object,
 		if (length < count + 4)
 			@throw [OFTruncatedDataException exception];
 
-		data = [[OFData alloc] initWithItems: buffer + 4
-					       count: count];
-		@try {
-			*object = createExtension(buffer[3], data);
-		} @finally {
-			[data release];
-		}
+		*object = createExtension(buffer[3],
+		    createData(buffer + 4, count, source));
 
 		return count + 4;
 	case 0xC9: /* ext 32 */
@@ -404,78 +402,48 @@ parseObject(const unsigned char *buffer, size_t length, id *object,
 		if (length < count + 6)
 			@throw [OFTruncatedDataException exception];
 
-		data = [[OFData alloc] initWithItems: buffer + 6
-					       count: count];
-		@try {
-			*object = createExtension(buffer[5], data);
-		} @finally {
-			[data release];
-		}
+		*object = createExtension(buffer[5],
+		    createData(buffer + 6, count, source));
 
 		return count + 6;
 	case 0xD4: /* fixext 1 */
 		if (length < 3)
 			@throw [OFTruncatedDataException exception];
 
-		data = [[OFData alloc] initWithItems: buffer + 2
-					       count: 1];
-		@try {
-			*object = createExtension(buffer[1], data);
-		} @finally {
-			[data release];
-		}
+		*object = createExtension(buffer[1],
+		    createData(buffer + 2, 1, source));
 
 		return 3;
 	case 0xD5: /* fixext 2 */
 		if (length < 4)
 			@throw [OFTruncatedDataException exception];
 
-		data = [[OFData alloc] initWithItems: buffer + 2
-					       count: 2];
-		@try {
-			*object = createExtension(buffer[1], data);
-		} @finally {
-			[data release];
-		}
+		*object = createExtension(buffer[1],
+		    createData(buffer + 2, 2, source));
 
 		return 4;
 	case 0xD6: /* fixext 4 */
 		if (length < 6)
 			@throw [OFTruncatedDataException exception];
 
-		data = [[OFData alloc] initWithItems: buffer + 2
-					       count: 4];
-		@try {
-			*object = createExtension(buffer[1], data);
-		} @finally {
-			[data release];
-		}
+		*object = createExtension(buffer[1],
+		    createData(buffer + 2, 4, source));
 
 		return 6;
 	case 0xD7: /* fixext 8 */
 		if (length < 10)
 			@throw [OFTruncatedDataException exception];
 
-		data = [[OFData alloc] initWithItems: buffer + 2
-					       count: 8];
-		@try {
-			*object = createExtension(buffer[1], data);
-		} @finally {
-			[data release];
-		}
+		*object = createExtension(buffer[1],
+		    createData(buffer + 2, 8, source));
 
 		return 10;
 	case 0xD8: /* fixext 16 */
 		if (length < 18)
 			@throw [OFTruncatedDataException exception];
 
-		data = [[OFData alloc] initWithItems: buffer + 2
-					       count: 16];
-		@try {
-			*object = createExtension(buffer[1], data);
-		} @finally {
-			[data release];
-		}
+		*object = createExtension(buffer[1],
+		    createData(buffer + 2, 16, source));
 
 		return 18;
 	/* Strings */
@@ -524,31 +492,38 @@ parseObject(const unsigned char *buffer, size_t length, id *object,
 			@throw [OFTruncatedDataException exception];
 
 		return parseArray(buffer + 3, length - 3, object,
-		    readUInt16(buffer + 1), depthLimit) + 3;
+		    readUInt16(buffer + 1), depthLimit, source) + 3;
 	case 0xDD: /* array 32 */
 		if (length < 5)
 			@throw [OFTruncatedDataException exception];
 
 		return parseArray(buffer + 5, length - 5, object,
-		    readUInt32(buffer + 1), depthLimit) + 5;
+		    readUInt32(buffer + 1), depthLimit, source) + 5;
 	/* Maps */
 	case 0xDE: /* map 16 */
 		if (length < 3)
 			@throw [OFTruncatedDataException exception];
 
 		return parseTable(buffer + 3, length - 3, object,
-		    readUInt16(buffer + 1), depthLimit) + 3;
+		    readUInt16(buffer + 1), depthLimit, source) + 3;
 	case 0xDF: /* map 32 */
 		if (length < 5)
 			@throw [OFTruncatedDataException exception];
 
 		return parseTable(buffer + 5, length - 5, object,
-		    readUInt32(buffer + 1), depthLimit) + 5;
+		    readUInt32(buffer + 1), depthLimit, source) + 5;
 	default:
 		@throw [OFInvalidFormatException exception];
 	}
 }
 
+size_t
+of_message_pack_parse_object(const unsigned char *buffer, size_t length,
+    id *object, size_t depthLimit, OFData *source)
+{
+	return parseObject(buffer, length, object, depthLimit, source);
+}
+
 @implementation OFData (MessagePackValue)
 - (id)messagePackValue
 {
@@ -564,7 +539,7 @@ parseObject(const unsigned char *buffer, size_t length, id *object,
 	if ([self itemSize] != 1)
 		@throw [OFInvalidArgumentException exception];
 
-	if (parseObject([self items], count, &object, depthLimit) != count)
+	if (parseObject([self items], count, &object, depthLimit, nil) != count)
 		@throw [OFInvalidFormatException exception];
 
 	[object retain];
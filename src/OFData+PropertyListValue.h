@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFData.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern int _OFData_PropertyListValue_reference;
+#ifdef __cplusplus
+}
+#endif
+
+@interface OFData (PropertyListValue)
+/*!
+ * @brief The data interpreted as a property list and parsed as an object.
+ *
+ * Both binary (bplist00) and XML property lists are supported. XML property
+ * lists need to be encoded in UTF-8.
+ *
+ * To only decode some objects of a binary property list, use
+ * @ref OFBinaryPropertyList instead.
+ */
+@property (readonly, nonatomic) id propertyListValue;
+@end
+
+OF_ASSUME_NONNULL_END
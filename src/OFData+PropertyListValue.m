@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "OFData+PropertyListValue.h"
+#import "OFBinaryPropertyList.h"
+#import "OFString.h"
+#import "OFString+PropertyListValue.h"
+
+#import "OFInvalidArgumentException.h"
+
+int _OFData_PropertyListValue_reference;
+
+@implementation OFData (PropertyListValue)
+- (id)propertyListValue
+{
+	void *pool = objc_autoreleasePoolPush();
+	id ret;
+
+	if (_itemSize != 1)
+		@throw [OFInvalidArgumentException exception];
+
+	if (_count >= 8 && memcmp(_items, "bplist00", 8) == 0)
+		ret = [[OFBinaryPropertyList propertyListWithData: self]
+		    rootValue];
+	else
+		ret = [[OFString stringWithUTF8String: (const char *)_items
+					       length: _count]
+		    propertyListValue];
+
+	[ret retain];
+
+	objc_autoreleasePoolPop(pool);
+
+	return [ret autorelease];
+}
+@end
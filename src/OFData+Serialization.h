@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFData.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern int _OFData_Serialization_reference;
+#ifdef __cplusplus
+}
+#endif
+
+@interface OFData (Serialization)
+/*!
+ * @brief The data interpreted as binary serialization and parsed as an
+ *	  object.
+ *
+ * The data needs to be created by @ref OFObject::dataBySerializing or
+ * @ref OFObject::writeBinarySerializationToStream: and have an item size of 1.
+ */
+@property (readonly, nonatomic) id objectByDeserializing;
+@end
+
+OF_ASSUME_NONNULL_END
@@ -328,3 +328,5 @@ OF_ASSUME_NONNULL_END
 #import "OFData+ASN1DERValue.h"
 #import "OFData+CryptoHashing.h"
 #import "OFData+MessagePackValue.h"
+#import "OFData+PropertyListValue.h"
+#import "OFData+Serialization.h"
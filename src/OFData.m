@@ -51,6 +51,8 @@ _references_to_categories_of_OFData(void)
 	_OFData_ASN1DERValue_reference = 1;
 	_OFData_CryptoHashing_reference = 1;
 	_OFData_MessagePackValue_reference = 1;
+	_OFData_PropertyListValue_reference = 1;
+	_OFData_Serialization_reference = 1;
 }
 
 @implementation OFData
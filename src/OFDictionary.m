@@ -739,6 +739,18 @@ static OFCharacterSet *URLQueryPartAllowedCharacterSet = nil;
 	size_t i, count = [self count];
 	id key, object;
 
+	if (options & OF_JSON_REPRESENTATION_SORTED) {
+		OFArray *keys = [[self allKeys] sortedArray];
+		OFMutableArray *objects =
+		    [OFMutableArray arrayWithCapacity: count];
+
+		for (key in keys)
+			[objects addObject: [self objectForKey: key]];
+
+		keyEnumerator = [keys objectEnumerator];
+		objectEnumerator = [objects objectEnumerator];
+	}
+
 	if (options & OF_JSON_REPRESENTATION_PRETTY) {
 		OFMutableString *indentation = [OFMutableString string];
 
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFEnumerator.h"
+#import "OFURLHandler.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+@class OFMutableArray OF_GENERIC(ObjectType);
+@class OFString;
+@class OFURL;
+
+/*!
+ * @class OFDirectoryEnumerator \
+ *	  OFDirectoryEnumerator.h ObjFW/OFDirectoryEnumerator.h
+ *
+ * @brief A class which lazily enumerates the contents of a directory and all
+ *	  of its subdirectories.
+ *
+ * The entries are returned as paths relative to the enumerated directory. A
+ * directory is returned before its contents. Symbolic links to directories are
+ * not followed.
+ *
+ * Only one directory per level is read at a time, so this is suitable for
+ * walking directories with a large number of entries. On Linux, the entries
+ * are read from the kernel in batches and the type of an entry is known
+ * without retrieving its attributes on most file systems.
+ *
+ * Use @ref OFFileManager::enumeratorAtPath: or
+ * @ref OFFileManager::enumeratorAtURL: to create an OFDirectoryEnumerator.
+ */
+@interface OFDirectoryEnumerator: OFEnumerator
+{
+	OFURL *_URL;
+	OFMutableArray *_directories;
+	id _Nullable _currentDirectory;
+	OFString *_Nullable _currentName, *_Nullable _currentPath;
+	of_file_type_t _Nullable _currentEntryType;
+	of_file_attributes_t _Nullable _currentEntryAttributes;
+	bool _skipDescendants;
+}
+
+/*!
+ * @brief The URL of the enumerated directory.
+ */
+@property (readonly, nonatomic) OFURL *URL;
+
+/*!
+ * @brief The URL of the entry returned by the last call to @ref nextObject.
+ */
+@property OF_NULLABLE_PROPERTY (readonly, nonatomic) OFURL *currentEntryURL;
+
+/*!
+ * @brief The type of the entry returned by the last call to @ref nextObject.
+ *
+ * This only retrieves the attributes of the entry if the type could not be
+ * determined while reading the directory.
+ */
+@property OF_NULLABLE_PROPERTY (readonly, nonatomic)
+    of_file_type_t currentEntryType;
+
+/*!
+ * @brief The attributes of the entry returned by the last call to
+ *	  @ref nextObject.
+ *
+ * The attributes are retrieved when this is accessed for the first time
+ * after @ref nextObject.
+ */
+@property OF_NULLABLE_PROPERTY (readonly, nonatomic)
+    of_file_attributes_t currentEntryAttributes;
+
+/*!
+ * @brief The level of the entry returned by the last call to
+ *	  @ref nextObject, starting with 1 for the entries of the enumerated
+ *	  directory.
+ */
+@property (readonly, nonatomic) size_t level;
+
+- (instancetype)init OF_UNAVAILABLE;
+
+/*!
+ * @brief Initializes an already allocated OFDirectoryEnumerator to enumerate
+ *	  the directory at the specified URL.
+ *
+ * @param URL The URL of the directory to enumerate
+ * @return An initialized OFDirectoryEnumerator
+ */
+- (instancetype)initWithURL: (OFURL *)URL OF_DESIGNATED_INITIALIZER;
+
+/*!
+ * @brief Returns the path of the next entry relative to the enumerated
+ *	  directory or `nil` if there are no more entries.
+ *
+ * @return The relative path of the next entry or `nil` if there are no more
+ *	   entries
+ */
+- (nullable OFString *)nextObject;
+
+/*!
+ * @brief Skips the contents of the directory returned by the last call to
+ *	  @ref nextObject.
+ */
+- (void)skipDescendants;
+@end
+
+OF_ASSUME_NONNULL_END
@@ -0,0 +1,424 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_DIRENT_H
+# include <dirent.h>
+#endif
+#ifdef HAVE_FCNTL_H
+# include <fcntl.h>
+#endif
+#include "unistd_wrapper.h"
+
+#import "platform.h"
+
+#import "OFDirectoryEnumerator.h"
+#import "OFArray.h"
+#import "OFFileManager.h"
+#import "OFLocale.h"
+#import "OFString.h"
+#import "OFURL.h"
+
+#import "OFInvalidArgumentException.h"
+#import "OFOpenItemFailedException.h"
+#import "OFOutOfMemoryException.h"
+#import "OFReadFailedException.h"
+
+#if defined(OF_LINUX) && defined(HAVE_DIRENT_H) && defined(HAVE_FCNTL_H) && \
+    defined(DT_DIR)
+# include <sys/syscall.h>
+# define USE_GETDENTS
+#endif
+
+#ifndef O_CLOEXEC
+# define O_CLOEXEC 0
+#endif
+
+#define GETDENTS_BUFFER_SIZE 32768
+
+#ifdef USE_GETDENTS
+struct linux_dirent64 {
+	uint64_t d_ino;
+	int64_t d_off;
+	unsigned short d_reclen;
+	unsigned char d_type;
+	char d_name[];
+};
+#endif
+
+@interface OFDirectoryEnumerator_Directory: OFObject
+{
+@public
+	OFURL *_URL;
+	OFString *_path;
+	size_t _level;
+#ifdef USE_GETDENTS
+	int _fd;
+	char *_buffer;
+	size_t _bufferLength, _bufferOffset;
+#endif
+	OFArray OF_GENERIC(OFString *) *_names;
+	size_t _namesIndex;
+}
+
+- (instancetype)initWithURL: (OFURL *)URL
+		       path: (OFString *)path
+		      level: (size_t)level
+		     parent: (OFDirectoryEnumerator_Directory *)parent
+		       name: (OFString *)name;
+- (OFString *)nextNameWithType: (of_file_type_t *)type;
+@end
+
+@interface OFDirectoryEnumerator ()
+- (void)of_resetCurrentEntry;
+@end
+
+#ifdef USE_GETDENTS
+static of_file_type_t
+typeForDType(unsigned char type)
+{
+	switch (type) {
+	case DT_REG:
+		return of_file_type_regular;
+	case DT_DIR:
+		return of_file_type_directory;
+	case DT_LNK:
+		return of_file_type_symbolic_link;
+	case DT_FIFO:
+		return of_file_type_fifo;
+	case DT_CHR:
+		return of_file_type_character_special;
+	case DT_BLK:
+		return of_file_type_block_special;
+	case DT_SOCK:
+		return of_file_type_socket;
+	default:
+		/* Not all file systems provide the type. */
+		return nil;
+	}
+}
+#endif
+
+@implementation OFDirectoryEnumerator_Directory
+- (instancetype)initWithURL: (OFURL *)URL
+		       path: (OFString *)path
+		      level: (size_t)level
+		     parent: (OFDirectoryEnumerator_Directory *)parent
+		       name: (OFString *)name
+{
+	self = [super init];
+
+	@try {
+#ifdef USE_GETDENTS
+		bool useGetdents;
+
+		_fd = -1;
+#endif
+
+		_URL = [URL copy];
+		_path = [path copy];
+		_level = level;
+
+#ifdef USE_GETDENTS
+		if (parent != nil)
+			useGetdents = (parent->_fd != -1);
+		else
+			useGetdents = [[URL scheme] isEqual: @"file"];
+
+		if (useGetdents) {
+			of_string_encoding_t encoding = [OFLocale encoding];
+
+			/*
+			 * Subdirectories are opened relative to their parent,
+			 * so that the kernel does not need to resolve the
+			 * whole path again.
+			 */
+			if (parent != nil)
+				_fd = openat(parent->_fd,
+				    [name cStringWithEncoding: encoding],
+				    O_RDONLY | O_DIRECTORY | O_NOFOLLOW |
+				    O_CLOEXEC);
+			else
+				_fd = open([[URL fileSystemRepresentation]
+				    cStringWithEncoding: encoding],
+				    O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+			if (_fd == -1)
+				@throw [OFOpenItemFailedException
+				    exceptionWithURL: URL
+						mode: nil
+					       errNo: errno];
+
+			if ((_buffer = malloc(GETDENTS_BUFFER_SIZE)) == NULL)
+				@throw [OFOutOfMemoryException
+				    exceptionWithRequestedSize:
+				    GETDENTS_BUFFER_SIZE];
+		} else
+#endif
+			_names = [[[OFFileManager defaultManager]
+			    contentsOfDirectoryAtURL: URL] retain];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+#ifdef USE_GETDENTS
+	if (_fd != -1)
+		close(_fd);
+
+	free(_buffer);
+#endif
+
+	[_URL release];
+	[_path release];
+	[_names release];
+
+	[super dealloc];
+}
+
+- (OFString *)nextNameWithType: (of_file_type_t *)type
+{
+#ifdef USE_GETDENTS
+	if (_fd != -1) {
+		for (;;) {
+			struct linux_dirent64 *entry;
+
+			if (_bufferOffset >= _bufferLength) {
+				long ret = syscall(SYS_getdents64, _fd,
+				    _buffer, GETDENTS_BUFFER_SIZE);
+
+				if (ret < 0)
+					@throw [OFReadFailedException
+					    exceptionWithObject: self
+						requestedLength: 0
+							  errNo: errno];
+
+				if (ret == 0)
+					return nil;
+
+				_bufferLength = (size_t)ret;
+				_bufferOffset = 0;
+			}
+
+			entry = (struct linux_dirent64 *)(void *)
+			    (_buffer + _bufferOffset);
+			_bufferOffset += entry->d_reclen;
+
+			if (strcmp(entry->d_name, ".") == 0 ||
+			    strcmp(entry->d_name, "..") == 0)
+				continue;
+
+			*type = typeForDType(entry->d_type);
+
+			return [OFString
+			    stringWithCString: entry->d_name
+				     encoding: [OFLocale encoding]];
+		}
+	}
+#endif
+
+	if (_namesIndex >= [_names count])
+		return nil;
+
+	*type = nil;
+
+	return [_names objectAtIndex: _namesIndex++];
+}
+@end
+
+@implementation OFDirectoryEnumerator
+@synthesize URL = _URL;
+
+- (instancetype)init
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithURL: (OFURL *)URL
+{
+	self = [super init];
+
+	@try {
+		if (URL == nil)
+			@throw [OFInvalidArgumentException exception];
+
+		_URL = [URL copy];
+		_directories = [[OFMutableArray alloc] init];
+
+		[self reset];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[self of_resetCurrentEntry];
+
+	[_URL release];
+	[_directories release];
+
+	[super dealloc];
+}
+
+- (void)of_resetCurrentEntry
+{
+	[_currentDirectory release];
+	_currentDirectory = nil;
+	[_currentName release];
+	_currentName = nil;
+	[_currentPath release];
+	_currentPath = nil;
+	[_currentEntryType release];
+	_currentEntryType = nil;
+	[_currentEntryAttributes release];
+	_currentEntryAttributes = nil;
+	_skipDescendants = false;
+}
+
+- (OFString *)nextObject
+{
+	if (_currentDirectory != nil && !_skipDescendants &&
+	    [[self currentEntryType] isEqual: of_file_type_directory]) {
+		OFDirectoryEnumerator_Directory *directory =
+		    [[OFDirectoryEnumerator_Directory alloc]
+		    initWithURL: [self currentEntryURL]
+			   path: _currentPath
+			  level: [self level] + 1
+			 parent: _currentDirectory
+			   name: _currentName];
+
+		@try {
+			[_directories addObject: directory];
+		} @finally {
+			[directory release];
+		}
+	}
+
+	[self of_resetCurrentEntry];
+
+	while ([_directories count] > 0) {
+		OFDirectoryEnumerator_Directory *directory =
+		    [_directories lastObject];
+		of_file_type_t type;
+		OFString *name = [directory nextNameWithType: &type];
+
+		if (name == nil) {
+			[_directories removeLastObject];
+			continue;
+		}
+
+		_currentDirectory = [directory retain];
+		_currentName = [name copy];
+		_currentEntryType = [type retain];
+
+		if (directory->_path != nil)
+			_currentPath = [[directory->_path
+			    stringByAppendingPathComponent: name] retain];
+		else
+			_currentPath = [name copy];
+
+		return [[_currentPath retain] autorelease];
+	}
+
+	return nil;
+}
+
+- (OFURL *)currentEntryURL
+{
+	OFDirectoryEnumerator_Directory *directory = _currentDirectory;
+
+	if (directory == nil)
+		return nil;
+
+	/* Avoid retrieving the attributes if the type is already known. */
+	if (_currentEntryType != nil) {
+		bool isDirectory =
+		    [_currentEntryType isEqual: of_file_type_directory];
+
+		return [directory->_URL
+		    URLByAppendingPathComponent: _currentName
+				    isDirectory: isDirectory];
+	}
+
+	return [directory->_URL URLByAppendingPathComponent: _currentName];
+}
+
+- (of_file_type_t)currentEntryType
+{
+	if (_currentEntryType == nil && _currentDirectory != nil)
+		_currentEntryType =
+		    [[[self currentEntryAttributes] fileType] retain];
+
+	return _currentEntryType;
+}
+
+- (of_file_attributes_t)currentEntryAttributes
+{
+	if (_currentEntryAttributes == nil && _currentDirectory != nil)
+		_currentEntryAttributes = [[[OFFileManager defaultManager]
+		    attributesOfItemAtURL: [self currentEntryURL]] retain];
+
+	return _currentEntryAttributes;
+}
+
+- (size_t)level
+{
+	OFDirectoryEnumerator_Directory *directory = _currentDirectory;
+
+	return (directory != nil ? directory->_level : 0);
+}
+
+- (void)skipDescendants
+{
+	_skipDescendants = true;
+}
+
+- (void)reset
+{
+	OFDirectoryEnumerator_Directory *directory;
+
+	[self of_resetCurrentEntry];
+	[_directories removeAllObjects];
+
+	directory = [[OFDirectoryEnumerator_Directory alloc]
+	    initWithURL: _URL
+		   path: nil
+		  level: 1
+		 parent: nil
+		   name: nil];
+
+	@try {
+		[_directories addObject: directory];
+	} @finally {
+		[directory release];
+	}
+}
+@end
@@ -30,6 +30,7 @@
 #endif
 
 #import "OFFile.h"
+#import "OFStream+Private.h"
 #import "OFLocale.h"
 #import "OFString.h"
 #import "OFURL.h"
@@ -485,6 +486,30 @@ parseMode(const char *mode, bool *append)
 	return (size_t)bytesWritten;
 }
 
+#if defined(HAVE_WRITEV) && !defined(OF_WINDOWS) && !defined(OF_AMIGAOS)
+- (size_t)lowlevelWriteBuffers: (const of_stream_buffer_t *)buffers
+			 count: (size_t)count
+{
+	SEL selector = @selector(lowlevelWriteBuffer:length:);
+
+	/*
+	 * Subclasses that override lowlevelWriteBuffer:length:, e.g. to
+	 * encrypt the data, need it to be called for every buffer.
+	 */
+	if ([self methodForSelector: selector] !=
+	    [OFFile instanceMethodForSelector: selector])
+		return [super lowlevelWriteBuffers: buffers
+					     count: count];
+
+	if (_handle == OF_INVALID_FILE_HANDLE)
+		@throw [OFNotOpenException exceptionWithObject: self];
+
+	return [self of_writeBuffers: buffers
+			       count: count
+		    toFileDescriptor: _handle];
+}
+#endif
+
 - (of_offset_t)lowlevelSeekToOffset: (of_offset_t)offset
 			     whence: (int)whence
 {
@@ -556,6 +581,29 @@ parseMode(const char *mode, bool *append)
 {
 	return _handle;
 }
+
+- (int)of_fileDescriptorForZeroCopyReading
+{
+	SEL selector = @selector(lowlevelReadIntoBuffer:length:);
+
+	/* Subclasses might modify the data, e.g. to decrypt it */
+	if ([self methodForSelector: selector] !=
+	    [OFFile instanceMethodForSelector: selector])
+		return -1;
+
+	return _handle;
+}
+
+- (int)of_fileDescriptorForZeroCopyWriting
+{
+	SEL selector = @selector(lowlevelWriteBuffer:length:);
+
+	if ([self methodForSelector: selector] !=
+	    [OFFile instanceMethodForSelector: selector])
+		return -1;
+
+	return _handle;
+}
 #endif
 
 - (void)close
@@ -35,8 +35,44 @@ OF_ASSUME_NONNULL_BEGIN
 
 @class OFArray OF_GENERIC(ObjectType);
 @class OFDate;
+@class OFDirectoryEnumerator;
+@class OFFileManager;
 @class OFURL;
 
+/*!
+ * @protocol OFFileManagerDelegate OFFileManager.h ObjFW/OFFileManager.h
+ *
+ * @brief A delegate for OFFileManager.
+ */
+@protocol OFFileManagerDelegate <OFObject>
+@optional
+/*!
+ * @brief A callback which is called when data of a file has been copied while
+ *	  copying an item.
+ *
+ * @note When a directory is copied, the files in it are copied in parallel
+ *	 and this callback is called from the threads copying them. The calls
+ *	 are serialized, so this is never called concurrently for the same copy
+ *	 operation.
+ *
+ * @param fileManager The file manager copying the file
+ * @param bytesCopied The number of bytes of the file which have been copied so
+ *		      far
+ * @param source The URL of the file being copied
+ * @param destination The URL the file is being copied to
+ * @param totalBytesCopied The number of bytes which have been copied so far
+ *			   by the entire copy operation
+ * @param bytesPerSecond The average throughput of the entire copy operation so
+ *			 far in bytes per second
+ */
+- (void)fileManager: (OFFileManager *)fileManager
+       didCopyBytes: (uintmax_t)bytesCopied
+	ofItemAtURL: (OFURL *)source
+	      toURL: (OFURL *)destination
+   totalBytesCopied: (uintmax_t)totalBytesCopied
+     bytesPerSecond: (double)bytesPerSecond;
+@end
+
 /*!
  * @class OFFileManager OFFileManager.h ObjFW/OFFileManager.h
  *
@@ -44,10 +80,23 @@ OF_ASSUME_NONNULL_BEGIN
  *	  directories, deleting files, renaming files, etc.
  */
 @interface OFFileManager: OFObject
+{
+	OFObject <OFFileManagerDelegate> *_Nullable _delegate;
+}
+
 #ifdef OF_HAVE_CLASS_PROPERTIES
 @property (class, readonly, nonatomic) OFFileManager *defaultManager;
 #endif
 
+/*!
+ * @brief The delegate of the file manager.
+ *
+ * @note As the file manager is shared, you must only set a delegate if you
+ *	 know nobody else is using the file manager at the same time!
+ */
+@property OF_NULLABLE_PROPERTY (assign, nonatomic)
+    OFObject <OFFileManagerDelegate> *delegate;
+
 /*!
  * @brief The path of the current working directory.
  */
@@ -187,6 +236,30 @@ OF_ASSUME_NONNULL_BEGIN
  */
 - (OFArray OF_GENERIC(OFString *) *)contentsOfDirectoryAtURL: (OFURL *)URL;
 
+/*!
+ * @brief Returns an enumerator which lazily enumerates the items in the
+ *	  specified directory and all of its subdirectories.
+ *
+ * Unlike @ref contentsOfDirectoryAtPath:, this does not read all items at
+ * once and does not retrieve the attributes of an item unless requested.
+ *
+ * @param path The path to the directory whose items should be enumerated
+ * @return An enumerator for the items in the specified directory
+ */
+- (OFDirectoryEnumerator *)enumeratorAtPath: (OFString *)path;
+
+/*!
+ * @brief Returns an enumerator which lazily enumerates the items in the
+ *	  specified directory and all of its subdirectories.
+ *
+ * Unlike @ref contentsOfDirectoryAtURL:, this does not read all items at
+ * once and does not retrieve the attributes of an item unless requested.
+ *
+ * @param URL The URL to the directory whose items should be enumerated
+ * @return An enumerator for the items in the specified directory
+ */
+- (OFDirectoryEnumerator *)enumeratorAtURL: (OFURL *)URL;
+
 /*!
  * @brief Changes the current working directory.
  *
@@ -227,6 +300,11 @@ OF_ASSUME_NONNULL_BEGIN
  * if a directory is copied and an item already exists in the destination
  * directory.
  *
+ * Regular files are copied inside the kernel or cloned if the OS and file
+ * system support it. If a directory is copied, the files in it are copied in
+ * parallel if threads are available. The progress is reported to the
+ * @ref delegate.
+ *
  * @param source The file, directory or symbolic link to copy
  * @param destination The destination URL
  */
@@ -27,9 +27,15 @@
 # include <sys/syslimits.h>
 #endif
 
+#if defined(OF_LINUX) && defined(HAVE_LINUX_FS_H) && defined(HAVE_SYS_IOCTL_H)
+# include <sys/ioctl.h>
+# include <linux/fs.h>
+#endif
+
 #import "OFArray.h"
 #import "OFDate.h"
 #import "OFDictionary.h"
+#import "OFDirectoryEnumerator.h"
 #import "OFFile.h"
 #import "OFFileManager.h"
 #import "OFLocale.h"
@@ -38,6 +44,11 @@
 #import "OFSystemInfo.h"
 #import "OFURL.h"
 #import "OFURLHandler.h"
+#ifdef OF_HAVE_THREADS
+# import "OFMutex.h"
+# import "OFThreadPool.h"
+# import "OFTriple.h"
+#endif
 
 #import "OFChangeCurrentDirectoryPathFailedException.h"
 #import "OFCopyItemFailedException.h"
@@ -46,7 +57,6 @@
 #import "OFInitializationFailedException.h"
 #import "OFInvalidArgumentException.h"
 #import "OFMoveItemFailedException.h"
-#import "OFOutOfMemoryException.h"
 #import "OFOutOfRangeException.h"
 #import "OFRemoveItemFailedException.h"
 #import "OFRetrieveItemAttributesFailedException.h"
@@ -69,9 +79,45 @@
 # include <proto/locale.h>
 #endif
 
+#define COPY_CHUNK_SIZE (1024 * 1024)
+
 @interface OFFileManager_default: OFFileManager
 @end
 
+@interface OFFileManager_CopyOperation: OFObject
+{
+@public
+	OFFileManager *_fileManager;
+	OFObject <OFFileManagerDelegate> *_delegate;
+	OFDate *_startDate;
+	uintmax_t _totalBytesCopied;
+#ifdef OF_HAVE_THREADS
+	OFThreadPool *_threadPool;
+	OFMutex *_mutex;
+	id _exception;
+#endif
+}
+
+- (instancetype)initWithFileManager: (OFFileManager *)fileManager;
+- (void)didCopyLength: (uintmax_t)length
+	  bytesCopied: (uintmax_t)bytesCopied
+	  ofItemAtURL: (OFURL *)source
+		toURL: (OFURL *)destination;
+#ifdef OF_HAVE_THREADS
+- (void)copyFile: (OFTriple *)file;
+#endif
+@end
+
+@interface OFFileManager ()
+- (void)of_copyItemAtURL: (OFURL *)source
+		   toURL: (OFURL *)destination
+	       operation: (OFFileManager_CopyOperation *)operation;
+- (void)of_copyFileAtURL: (OFURL *)source
+		   toURL: (OFURL *)destination
+	      attributes: (of_file_attributes_t)attributes
+	       operation: (OFFileManager_CopyOperation *)operation;
+@end
+
 #ifdef OF_AMIGAOS4
 extern struct ExecIFace *IExec;
 static struct Library *DOSBase = NULL;
@@ -99,7 +145,123 @@ OF_DESTRUCTOR()
 }
 #endif
 
+static bool
+cloneFile(OFStream *source, OFStream *destination)
+{
+#ifdef FICLONE
+	/* Lets the file system share the data if it supports reflinks. */
+	if (![source isKindOfClass: [OFFile class]] ||
+	    ![destination isKindOfClass: [OFFile class]])
+		return false;
+
+	return (ioctl([(OFFile *)destination fileDescriptorForWriting], FICLONE,
+	    [(OFFile *)source fileDescriptorForReading]) == 0);
+#else
+	return false;
+#endif
+}
+
+@implementation OFFileManager_CopyOperation
+- (instancetype)initWithFileManager: (OFFileManager *)fileManager
+{
+	self = [super init];
+
+	@try {
+		_fileManager = [fileManager retain];
+		_delegate = [fileManager delegate];
+		_startDate = [[OFDate alloc] init];
+#ifdef OF_HAVE_THREADS
+		_mutex = [[OFMutex alloc] init];
+#endif
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_fileManager release];
+	[_startDate release];
+#ifdef OF_HAVE_THREADS
+	[_threadPool release];
+	[_mutex release];
+	[_exception release];
+#endif
+
+	[super dealloc];
+}
+
+- (void)didCopyLength: (uintmax_t)length
+	  bytesCopied: (uintmax_t)bytesCopied
+	  ofItemAtURL: (OFURL *)source
+		toURL: (OFURL *)destination
+{
+#ifdef OF_HAVE_THREADS
+	[_mutex lock];
+	@try {
+#endif
+		of_time_interval_t elapsed;
+		double bytesPerSecond = 0;
+
+		_totalBytesCopied += length;
+
+		if (![_delegate respondsToSelector: @selector(fileManager:
+		    didCopyBytes:ofItemAtURL:toURL:totalBytesCopied:
+		    bytesPerSecond:)])
+			return;
+
+		if ((elapsed = -[_startDate timeIntervalSinceNow]) > 0)
+			bytesPerSecond = _totalBytesCopied / elapsed;
+
+		[_delegate fileManager: _fileManager
+			  didCopyBytes: bytesCopied
+			   ofItemAtURL: source
+				 toURL: destination
+		      totalBytesCopied: _totalBytesCopied
+			bytesPerSecond: bytesPerSecond];
+#ifdef OF_HAVE_THREADS
+	} @finally {
+		[_mutex unlock];
+	}
+#endif
+}
+
+#ifdef OF_HAVE_THREADS
+- (void)copyFile: (OFTriple *)file
+{
+	void *pool = objc_autoreleasePoolPush();
+
+	@try {
+		bool failed;
+
+		[_mutex lock];
+		failed = (_exception != nil);
+		[_mutex unlock];
+
+		/* Don't start copying more files after one failed. */
+		if (!failed)
+			[_fileManager of_copyFileAtURL: [file firstObject]
+						 toURL: [file secondObject]
+					    attributes: [file thirdObject]
+					     operation: self];
+	} @catch (id e) {
+		[_mutex lock];
+		if (_exception == nil)
+			_exception = [e retain];
+		[_mutex unlock];
+	}
+
+	objc_autoreleasePoolPop(pool);
+}
+#endif
+@end
+
 @implementation OFFileManager
+@synthesize delegate = _delegate;
+
 + (void)initialize
 {
 	if (self != [OFFileManager class])
@@ -410,6 +572,25 @@ OF_DESTRUCTOR()
 	return [ret autorelease];
 }
 
+- (OFDirectoryEnumerator *)enumeratorAtURL: (OFURL *)URL
+{
+	return [[[OFDirectoryEnumerator alloc] initWithURL: URL] autorelease];
+}
+
+- (OFDirectoryEnumerator *)enumeratorAtPath: (OFString *)path
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFDirectoryEnumerator *ret;
+
+	ret = [self enumeratorAtURL: [OFURL fileURLWithPath: path]];
+
+	[ret retain];
+
+	objc_autoreleasePoolPop(pool);
+
+	return [ret autorelease];
+}
+
 - (void)changeCurrentDirectoryPath: (OFString *)path
 {
 	if (path == nil)
@@ -485,15 +666,43 @@ OF_DESTRUCTOR()
 		toURL: (OFURL *)destination
 {
 	void *pool;
-	OFURLHandler *URLHandler;
-	of_file_attributes_t attributes;
-	of_file_type_t type;
+	OFFileManager_CopyOperation *operation;
 
 	if (source == nil || destination == nil)
 		@throw [OFInvalidArgumentException exception];
 
 	pool = objc_autoreleasePoolPush();
 
+	operation = [[[OFFileManager_CopyOperation alloc]
+	    initWithFileManager: self] autorelease];
+
+	@try {
+		[self of_copyItemAtURL: source
+				 toURL: destination
+			     operation: operation];
+	} @finally {
+#ifdef OF_HAVE_THREADS
+		[operation->_threadPool waitUntilDone];
+#endif
+	}
+
+#ifdef OF_HAVE_THREADS
+	if (operation->_exception != nil)
+		@throw [[operation->_exception retain] autorelease];
+#endif
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (void)of_copyItemAtURL: (OFURL *)source
+		   toURL: (OFURL *)destination
+	       operation: (OFFileManager_CopyOperation *)operation
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFURLHandler *URLHandler;
+	of_file_attributes_t attributes;
+	of_file_type_t type;
+
 	if ((URLHandler = [OFURLHandler handlerForURL: source]) == nil)
 		@throw [OFUnsupportedProtocolException
 		    exceptionWithURL: source];
@@ -554,6 +763,16 @@ OF_DESTRUCTOR()
 			@throw e;
 		}
 
+#ifdef OF_HAVE_THREADS
+		/*
+		 * The directory structure is created by the calling thread,
+		 * while the files are copied in parallel.
+		 */
+		if (operation->_threadPool == nil &&
+		    [OFSystemInfo numberOfCPUs] > 1)
+			operation->_threadPool = [[OFThreadPool alloc] init];
+#endif
+
 		for (OFString *item in contents) {
 			void *pool2 = objc_autoreleasePoolPush();
 			OFURL *sourceURL, *destinationURL;
@@ -563,69 +782,30 @@ OF_DESTRUCTOR()
 			destinationURL =
 			    [destination URLByAppendingPathComponent: item];
 
-			[self copyItemAtURL: sourceURL
-				      toURL: destinationURL];
+			[self of_copyItemAtURL: sourceURL
+					 toURL: destinationURL
+				     operation: operation];
 
 			objc_autoreleasePoolPop(pool2);
 		}
 	} else if ([type isEqual: of_file_type_regular]) {
-		size_t pageSize = [OFSystemInfo pageSize];
-		OFStream *sourceStream = nil;
-		OFStream *destinationStream = nil;
-		char *buffer;
-
-		if ((buffer = malloc(pageSize)) == NULL)
-			@throw [OFOutOfMemoryException
-			    exceptionWithRequestedSize: pageSize];
-
-		@try {
-			sourceStream = [[OFURLHandler handlerForURL: source]
-			    openItemAtURL: source
-				     mode: @"r"];
-			destinationStream = [[OFURLHandler handlerForURL:
-			    destination] openItemAtURL: destination
-						  mode: @"w"];
-
-			while (![sourceStream isAtEndOfStream]) {
-				size_t length;
-
-				length = [sourceStream
-				    readIntoBuffer: buffer
-					    length: pageSize];
-				[destinationStream writeBuffer: buffer
-							length: length];
-			}
-
-#ifdef OF_FILE_MANAGER_SUPPORTS_PERMISSIONS
-			of_file_attribute_key_t key =
-			    of_file_attribute_key_posix_permissions;
-			OFNumber *permissions = [attributes objectForKey: key];
-			of_file_attributes_t destinationAttributes =
-			    [OFDictionary dictionaryWithObject: permissions
-							forKey: key];
-
-			[self setAttributes: destinationAttributes
-				ofItemAtURL: destination];
+#ifdef OF_HAVE_THREADS
+		if (operation->_threadPool != nil) {
+			OFTriple *file = [OFTriple
+			    tripleWithFirstObject: source
+				     secondObject: destination
+				      thirdObject: attributes];
+
+			[operation->_threadPool
+			    dispatchWithTarget: operation
+				      selector: @selector(copyFile:)
+					object: file];
+		} else
 #endif
-		} @catch (id e) {
-			/*
-			 * Only convert exceptions to OFCopyItemFailedException
-			 * that have an errNo property. This covers all I/O
-			 * related exceptions from the operations used to copy
-			 * an item, all others should be left as is.
-			 */
-			if ([e respondsToSelector: @selector(errNo)])
-				@throw [OFCopyItemFailedException
-				    exceptionWithSourceURL: source
-					    destinationURL: destination
-						     errNo: [e errNo]];
-
-			@throw e;
-		} @finally {
-			[sourceStream close];
-			[destinationStream close];
-			free(buffer);
-		}
+			[self of_copyFileAtURL: source
+					 toURL: destination
+				    attributes: attributes
+				     operation: operation];
 #ifdef OF_FILE_MANAGER_SUPPORTS_SYMLINKS
 	} else if ([type isEqual: of_file_type_symbolic_link]) {
 		@try {
@@ -659,6 +839,84 @@ OF_DESTRUCTOR()
 	objc_autoreleasePoolPop(pool);
 }
 
+- (void)of_copyFileAtURL: (OFURL *)source
+		   toURL: (OFURL *)destination
+	      attributes: (of_file_attributes_t)attributes
+	       operation: (OFFileManager_CopyOperation *)operation
+{
+	OFStream *sourceStream = nil;
+	OFStream *destinationStream = nil;
+
+	@try {
+		uintmax_t bytesCopied = 0;
+
+		sourceStream = [[OFURLHandler handlerForURL: source]
+		    openItemAtURL: source
+			     mode: @"r"];
+		destinationStream = [[OFURLHandler handlerForURL:
+		    destination] openItemAtURL: destination
+					  mode: @"w"];
+
+		if (cloneFile(sourceStream, destinationStream)) {
+			bytesCopied = [attributes fileSize];
+
+			[operation didCopyLength: bytesCopied
+				     bytesCopied: bytesCopied
+				     ofItemAtURL: source
+					   toURL: destination];
+		} else {
+			/*
+			 * This moves the data inside the kernel if both
+			 * streams are files.
+			 */
+			while (![sourceStream isAtEndOfStream]) {
+				size_t length = [destinationStream
+				    writeFromStream: sourceStream
+					     length: COPY_CHUNK_SIZE];
+
+				if (length == 0)
+					continue;
+
+				bytesCopied += length;
+
+				[operation didCopyLength: length
+					     bytesCopied: bytesCopied
+					     ofItemAtURL: source
+						   toURL: destination];
+			}
+		}
+
+#ifdef OF_FILE_MANAGER_SUPPORTS_PERMISSIONS
+		of_file_attribute_key_t key =
+		    of_file_attribute_key_posix_permissions;
+		OFNumber *permissions = [attributes objectForKey: key];
+		of_file_attributes_t destinationAttributes =
+		    [OFDictionary dictionaryWithObject: permissions
+						forKey: key];
+
+		[self setAttributes: destinationAttributes
+			ofItemAtURL: destination];
+#endif
+	} @catch (id e) {
+		/*
+		 * Only convert exceptions to OFCopyItemFailedException that
+		 * have an errNo property. This covers all I/O related
+		 * exceptions from the operations used to copy an item, all
+		 * others should be left as is.
+		 */
+		if ([e respondsToSelector: @selector(errNo)])
+			@throw [OFCopyItemFailedException
+			    exceptionWithSourceURL: source
+				    destinationURL: destination
+					     errNo: [e errNo]];
+
+		@throw e;
+	} @finally {
+		[sourceStream close];
+		[destinationStream close];
+	}
+}
+
 - (void)moveItemAtPath: (OFString *)source
 		toPath: (OFString *)destination
 {
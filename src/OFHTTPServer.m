@@ -27,6 +27,7 @@
 #import "OFHTTPRequest.h"
 #import "OFHTTPResponse.h"
 #import "OFNumber.h"
+#import "OFStream+Private.h"
 #import "OFTCPSocket.h"
 #import "OFTLSSocket.h"
 #import "OFTimer.h"
@@ -250,16 +251,16 @@ normalizedKey(OFString *key)
 	[super dealloc];
 }
 
-- (void)of_sendHeaders
+- (OFString *)of_headersString
 {
-	void *pool = objc_autoreleasePoolPush();
+	OFMutableString *ret = [OFMutableString string];
 	OFMutableDictionary OF_GENERIC(OFString *, OFString *) *headers;
 	OFEnumerator *keyEnumerator, *valueEnumerator;
 	OFString *key, *value;
 
-	[_socket writeFormat: @"HTTP/%@ %d %s\r\n",
-			      [self protocolVersionString], _statusCode,
-			      statusCodeToString(_statusCode)];
+	[ret appendFormat: @"HTTP/%@ %d %s\r\n",
+			   [self protocolVersionString], _statusCode,
+			   statusCodeToString(_statusCode)];
 
 	headers = [[_headers mutableCopy] autorelease];
 
@@ -283,42 +284,104 @@ normalizedKey(OFString *key)
 	valueEnumerator = [headers objectEnumerator];
 	while ((key = [keyEnumerator nextObject]) != nil &&
 	    (value = [valueEnumerator nextObject]) != nil)
-		[_socket writeFormat: @"%@: %@\r\n", key, value];
+		[ret appendFormat: @"%@: %@\r\n", key, value];
 
-	[_socket writeString: @"\r\n"];
+	[ret appendString: @"\r\n"];
 
-	_headersSent = true;
 	_chunked = [[headers objectForKey: @"Transfer-Encoding"]
 	    isEqual: @"chunked"];
 
+	return ret;
+}
+
+/*
+ * Writes the headers if they have not been sent yet, followed by the
+ * specified buffers and the chunk framing, using a single vectored write.
+ * With a length of 0, this writes the last chunk.
+ */
+- (void)of_writeBuffers: (const of_stream_buffer_t *)buffers
+		  count: (size_t)count
+		 length: (size_t)length
+{
+	void *pool = objc_autoreleasePoolPush();
+	of_stream_buffer_t *all;
+	size_t allCount = 0;
+
+	all = [self allocMemoryWithSize: sizeof(*all)
+				  count: count + 3];
+	@try {
+		if (!_headersSent) {
+			OFString *headers = [self of_headersString];
+
+			all[allCount].buffer = [headers UTF8String];
+			all[allCount].length = [headers UTF8StringLength];
+			allCount++;
+		}
+
+		if (_chunked) {
+			OFString *chunkHeader =
+			    [OFString stringWithFormat: @"%zx\r\n", length];
+
+			all[allCount].buffer = [chunkHeader UTF8String];
+			all[allCount].length = [chunkHeader UTF8StringLength];
+			allCount++;
+		}
+
+		if (count > 0) {
+			memcpy(all + allCount, buffers,
+			    count * sizeof(*buffers));
+			allCount += count;
+		}
+
+		if (_chunked) {
+			all[allCount].buffer = "\r\n";
+			all[allCount].length = 2;
+			allCount++;
+		}
+
+		[_socket writeBuffers: all
+				count: allCount];
+	} @finally {
+		[self freeMemory: all];
+	}
+
+	_headersSent = true;
+
 	objc_autoreleasePoolPop(pool);
 }
 
 - (size_t)lowlevelWriteBuffer: (const void *)buffer
 		       length: (size_t)length
+{
+	of_stream_buffer_t buffers[1];
+
+	buffers[0].buffer = buffer;
+	buffers[0].length = length;
+
+	return [self lowlevelWriteBuffers: buffers
+				    count: 1];
+}
+
+- (size_t)lowlevelWriteBuffers: (const of_stream_buffer_t *)buffers
+			 count: (size_t)count
 {
 	/* TODO: Use non-blocking writes */
 
-	void *pool;
+	size_t length = 0;
 
 	if (_socket == nil)
 		@throw [OFNotOpenException exceptionWithObject: self];
 
-	if (!_headersSent)
-		[self of_sendHeaders];
-
-	if (!_chunked)
-		return [_socket writeBuffer: buffer
-				     length: length];
+	for (size_t i = 0; i < count; i++)
+		length += buffers[i].length;
 
-	pool = objc_autoreleasePoolPush();
-	[_socket writeString: [OFString stringWithFormat: @"%zx\r\n", length]];
-	objc_autoreleasePoolPop(pool);
+	/* A chunk of length 0 would end the response */
+	if (length == 0)
+		return 0;
 
-	[_socket writeBuffer: buffer
-		      length: length];
-	[_socket writeBuffer: "\r\n"
-		      length: 2];
+	[self of_writeBuffers: buffers
+			count: count
+		       length: length];
 
 	return length;
 }
@@ -329,12 +392,11 @@ normalizedKey(OFString *key)
 		@throw [OFNotOpenException exceptionWithObject: self];
 
 	@try {
-		if (!_headersSent)
-			[self of_sendHeaders];
-
-		if (_chunked)
-			[_socket writeBuffer: "0\r\n\r\n"
-				      length: 5];
+		/* Sends the headers and the last chunk if necessary */
+		if (!_headersSent || _chunked)
+			[self of_writeBuffers: NULL
+					count: 0
+				       length: 0];
 	} @catch (OFWriteFailedException *e) {
 		id <OFHTTPServerDelegate> delegate = [_server delegate];
 
@@ -359,6 +421,36 @@ normalizedKey(OFString *key)
 
 	return [_socket fileDescriptorForWriting];
 }
+
+- (int)of_fileDescriptorForZeroCopyWriting
+{
+	if (_socket == nil)
+		return -1;
+
+	/* Chunks need to be framed, so the data can't bypass the response */
+	if (_headersSent) {
+		if (_chunked)
+			return -1;
+	} else if ([[_headers objectForKey: @"Transfer-Encoding"]
+	    isEqual: @"chunked"])
+		return -1;
+
+	return [_socket of_fileDescriptorForZeroCopyWriting];
+}
+
+- (void)of_prepareForZeroCopyWriting
+{
+	void *pool;
+
+	/* The headers need to be sent before the data bypassing them */
+	if (_headersSent)
+		return;
+
+	pool = objc_autoreleasePoolPush();
+	[_socket writeString: [self of_headersString]];
+	_headersSent = true;
+	objc_autoreleasePoolPop(pool);
+}
 @end
 
 @implementation OFHTTPServer_Connection
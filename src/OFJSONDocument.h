@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFObject.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+@class OFData;
+@class OFMutableData;
+@class OFString;
+
+/*!
+ * @class OFJSONDocument OFJSONDocument.h ObjFW/OFJSONDocument.h
+ *
+ * @brief A JSON document that only decodes the values that are accessed.
+ *
+ * When a document is created, the data is scanned once to build an index of
+ * all values in it, without creating any objects. Values are only decoded
+ * when they are looked up, for example using @ref valueForKeyPath:. This is
+ * useful if only a few values of a large document are needed.
+ *
+ * Strings that contain no escape sequences are returned as views into the
+ * data of the document instead of being copied. As the data is not terminated
+ * after such a string, @ref OFString::UTF8String and
+ * @ref OFString::cStringWithEncoding: with UTF-8 create a terminated copy of
+ * the string the first time they are called. Comparing the string using
+ * @ref OFObject::isEqual: and accessing single characters does not copy it.
+ *
+ * In contrast to @ref OFString::JSONValue, only standard JSON as defined by
+ * RFC 8259 is accepted: Numbers are checked against the JSON grammar, and
+ * strings may neither contain unescaped control characters nor escape
+ * sequences other than those defined by JSON. If an object contains duplicate
+ * keys, the last value is used, both by @ref valueForKeyPath: and by
+ * @ref rootValue.
+ */
+@interface OFJSONDocument: OFObject
+{
+	OFData *_data;
+	OFMutableData *_tape;
+}
+
+/*!
+ * @brief The data of the document.
+ */
+@property (readonly, nonatomic) OFData *data;
+
+/*!
+ * @brief The top-level value of the document.
+ *
+ * This decodes the whole document.
+ */
+@property (readonly, nonatomic) id rootValue;
+
+/*!
+ * @brief Creates a new JSON document with the specified data.
+ *
+ * @param data The data of the document. It needs to have an item size of 1.
+ * @return A new, autoreleased OFJSONDocument
+ */
++ (instancetype)documentWithData: (OFData *)data;
+
+/*!
+ * @brief Creates a new JSON document with the specified data.
+ *
+ * @param data The data of the document. It needs to have an item size of 1.
+ * @param depthLimit The maximum depth the document may have. 0 means
+ *		     unlimited (insecure!).
+ * @return A new, autoreleased OFJSONDocument
+ */
++ (instancetype)documentWithData: (OFData *)data
+		      depthLimit: (size_t)depthLimit;
+
+- (instancetype)init OF_UNAVAILABLE;
+
+/*!
+ * @brief Initializes an already allocated JSON document with the specified
+ *	  data.
+ *
+ * @param data The data of the document. It needs to have an item size of 1.
+ * @return An initialized OFJSONDocument
+ */
+- (instancetype)initWithData: (OFData *)data;
+
+/*!
+ * @brief Initializes an already allocated JSON document with the specified
+ *	  data.
+ *
+ * @param data The data of the document. It needs to have an item size of 1.
+ * @param depthLimit The maximum depth the document may have. 0 means
+ *		     unlimited (insecure!).
+ * @return An initialized OFJSONDocument
+ */
+- (instancetype)initWithData: (OFData *)data
+		  depthLimit: (size_t)depthLimit OF_DESIGNATED_INITIALIZER;
+
+/*!
+ * @brief Returns the value for the specified key path.
+ *
+ * The components of the key path are separated by dots. For objects, a
+ * component selects the member with that key. For arrays, a component needs
+ * to be a decimal index.
+ *
+ * Only the returned value is decoded, all other values are skipped.
+ *
+ * @param keyPath The key path of the value to return
+ * @return The value for the specified key path or `nil` if there is no such
+ *	   value
+ */
+- (nullable id)valueForKeyPath: (OFString *)keyPath;
+@end
+
+OF_ASSUME_NONNULL_END
@@ -0,0 +1,734 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "OFJSONDocument.h"
+#import "OFString+JSONValue+Private.h"
+#import "OFString_UTF8.h"
+#import "OFArray.h"
+#import "OFData.h"
+#import "OFDictionary.h"
+#import "OFNull.h"
+#import "OFNumber.h"
+
+#import "OFInvalidArgumentException.h"
+#import "OFInvalidEncodingException.h"
+#import "OFInvalidJSONException.h"
+#import "OFOutOfRangeException.h"
+
+#import "swar.h"
+
+enum entry_type {
+	ENTRY_TYPE_OBJECT,
+	ENTRY_TYPE_ARRAY,
+	ENTRY_TYPE_STRING,
+	ENTRY_TYPE_ESCAPED_STRING,
+	ENTRY_TYPE_NUMBER,
+	ENTRY_TYPE_TRUE,
+	ENTRY_TYPE_FALSE,
+	ENTRY_TYPE_NULL
+};
+
+/*
+ * The tape has one entry per value (and per key) in document order. The
+ * children of a container directly follow it, with keys and values
+ * alternating for objects, and next is the index of the entry following the
+ * value including all its children, which allows skipping whole values.
+ */
+struct entry {
+	size_t start, end, next;
+	enum entry_type type;
+};
+
+enum scan_state {
+	SCAN_STATE_EXPECT_VALUE,
+	SCAN_STATE_EXPECT_VALUE_OR_END,
+	SCAN_STATE_EXPECT_KEY,
+	SCAN_STATE_EXPECT_KEY_OR_END,
+	SCAN_STATE_EXPECT_COLON,
+	SCAN_STATE_EXPECT_COMMA_OR_END,
+	SCAN_STATE_EXPECT_END_OF_DATA
+};
+
+/* A string that is a view into the data of an OFJSONDocument. */
+@interface OFString_JSONView: OFString
+{
+	OFData *_data;
+	const char *_cString;
+	size_t _cStringLength, _length;
+	bool _isUTF8;
+	char *_UTF8String;
+}
+
+- (instancetype)initWithData: (OFData *)data
+		     cString: (const char *)cString
+		      length: (size_t)length;
+@end
+
+@interface OFJSONDocument ()
+- (id)of_valueAtIndex: (size_t)idx;
+- (size_t)of_indexForKey: (OFString *)key
+		inObject: (size_t)idx;
+@end
+
+static OF_INLINE bool
+isWhitespace(char c)
+{
+	return (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+}
+
+static size_t
+lineForPosition(const char *data, size_t position)
+{
+	size_t line = 1;
+
+	for (size_t i = 0; i < position; i++)
+		if (data[i] == '\n')
+			line++;
+
+	return line;
+}
+
+static void OF_NO_RETURN_FUNC
+throwInvalidJSONException(const char *data, size_t position)
+{
+	@throw [OFInvalidJSONException
+	    exceptionWithString: nil
+			   line: lineForPosition(data, position)];
+}
+
+/*
+ * Returns the position of the quote ending the string that starts at i, the
+ * position of the first character that is not allowed in a string or length
+ * if the string is not terminated. Runs without quotes, backslashes or control
+ * characters are skipped a word at a time.
+ */
+static size_t
+scanString(const char *data, size_t i, size_t length, bool *escaped)
+{
+	while (i < length) {
+		while (i + sizeof(uintptr_t) <= length) {
+			uintptr_t word = of_swar_load(data + i);
+
+			if ((of_swar_byte_mask(word, '"') |
+			    of_swar_byte_mask(word, '\\')) != 0 ||
+			    of_swar_has_less(word, 0x20))
+				break;
+
+			i += sizeof(uintptr_t);
+		}
+
+		if (i >= length)
+			break;
+
+		if (data[i] == '"' || (unsigned char)data[i] < 0x20)
+			return i;
+
+		if (data[i] == '\\') {
+			if (i + 1 >= length || data[i + 1] == '\0' ||
+			    strchr("\"\\/bfnrtu", data[i + 1]) == NULL)
+				return i;
+
+			*escaped = true;
+			i += 2;
+		} else
+			i++;
+	}
+
+	return length;
+}
+
+/* Returns whether the token is a number as defined by RFC 8259. */
+static bool
+isValidNumber(const char *data, size_t length)
+{
+	size_t i = 0;
+
+	if (i < length && data[i] == '-')
+		i++;
+
+	if (i >= length)
+		return false;
+
+	if (data[i] == '0')
+		i++;
+	else if (data[i] >= '1' && data[i] <= '9')
+		while (i < length && data[i] >= '0' && data[i] <= '9')
+			i++;
+	else
+		return false;
+
+	if (i < length && data[i] == '.') {
+		size_t start = ++i;
+
+		while (i < length && data[i] >= '0' && data[i] <= '9')
+			i++;
+
+		if (i == start)
+			return false;
+	}
+
+	if (i < length && (data[i] == 'e' || data[i] == 'E')) {
+		size_t start;
+
+		i++;
+
+		if (i < length && (data[i] == '+' || data[i] == '-'))
+			i++;
+
+		start = i;
+		while (i < length && data[i] >= '0' && data[i] <= '9')
+			i++;
+
+		if (i == start)
+			return false;
+	}
+
+	return (i == length);
+}
+
+static void
+buildTape(const char *data, size_t length, OFMutableData *tape,
+    size_t depthLimit)
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFMutableData *stack =
+	    [OFMutableData dataWithItemSize: sizeof(size_t)];
+	enum scan_state state = SCAN_STATE_EXPECT_VALUE;
+	size_t i;
+
+	for (i = 0; i < length; i++) {
+		struct entry entry;
+		bool isKey;
+		char c = data[i];
+
+		if (isWhitespace(c))
+			continue;
+
+		if (((state == SCAN_STATE_EXPECT_VALUE_OR_END ||
+		    state == SCAN_STATE_EXPECT_COMMA_OR_END) && c == ']') ||
+		    ((state == SCAN_STATE_EXPECT_KEY_OR_END ||
+		    state == SCAN_STATE_EXPECT_COMMA_OR_END) && c == '}')) {
+			struct entry *container = [tape itemAtIndex:
+			    *(size_t *)[stack lastItem]];
+
+			if ((container->type == ENTRY_TYPE_ARRAY) != (c == ']'))
+				throwInvalidJSONException(data, i);
+
+			container->end = i + 1;
+			container->next = [tape count];
+			[stack removeLastItem];
+
+			state = ([stack count] > 0
+			    ? SCAN_STATE_EXPECT_COMMA_OR_END
+			    : SCAN_STATE_EXPECT_END_OF_DATA);
+			continue;
+		}
+
+		switch (state) {
+		case SCAN_STATE_EXPECT_COLON:
+			if (c != ':')
+				throwInvalidJSONException(data, i);
+
+			state = SCAN_STATE_EXPECT_VALUE;
+			continue;
+		case SCAN_STATE_EXPECT_COMMA_OR_END:
+			if (c != ',')
+				throwInvalidJSONException(data, i);
+
+			if (((struct entry *)[tape itemAtIndex:
+			    *(size_t *)[stack lastItem]])->type ==
+			    ENTRY_TYPE_OBJECT)
+				state = SCAN_STATE_EXPECT_KEY;
+			else
+				state = SCAN_STATE_EXPECT_VALUE;
+			continue;
+		case SCAN_STATE_EXPECT_END_OF_DATA:
+			throwInvalidJSONException(data, i);
+		case SCAN_STATE_EXPECT_KEY:
+		case SCAN_STATE_EXPECT_KEY_OR_END:
+			if (c != '"')
+				throwInvalidJSONException(data, i);
+
+			isKey = true;
+			break;
+		default:
+			isKey = false;
+			break;
+		}
+
+		entry.start = i;
+		entry.next = [tape count] + 1;
+
+		switch (c) {
+		case '"':;
+			bool escaped = false;
+			size_t end = scanString(data, i + 1, length, &escaped);
+
+			if (end >= length)
+				throwInvalidJSONException(data, i);
+			if (data[end] != '"')
+				throwInvalidJSONException(data, end);
+
+			entry.type = (escaped
+			    ? ENTRY_TYPE_ESCAPED_STRING : ENTRY_TYPE_STRING);
+			entry.end = end + 1;
+			i = end;
+			break;
+		case '{':
+		case '[':;
+			size_t idx = [tape count];
+
+			if (depthLimit != 0 && [stack count] + 1 >= depthLimit)
+				throwInvalidJSONException(data, i);
+
+			entry.type = (c == '{'
+			    ? ENTRY_TYPE_OBJECT : ENTRY_TYPE_ARRAY);
+			entry.end = 0;
+
+			[tape addItem: &entry];
+			[stack addItem: &idx];
+
+			state = (c == '{' ? SCAN_STATE_EXPECT_KEY_OR_END
+			    : SCAN_STATE_EXPECT_VALUE_OR_END);
+			continue;
+		default:
+			entry.end = i;
+			while (entry.end < length &&
+			    !isWhitespace(data[entry.end]) &&
+			    data[entry.end] != ',' && data[entry.end] != ']' &&
+			    data[entry.end] != '}')
+				entry.end++;
+
+			if (entry.end - i == 4 &&
+			    memcmp(data + i, "true", 4) == 0)
+				entry.type = ENTRY_TYPE_TRUE;
+			else if (entry.end - i == 5 &&
+			    memcmp(data + i, "false", 5) == 0)
+				entry.type = ENTRY_TYPE_FALSE;
+			else if (entry.end - i == 4 &&
+			    memcmp(data + i, "null", 4) == 0)
+				entry.type = ENTRY_TYPE_NULL;
+			else if (isValidNumber(data + i, entry.end - i))
+				entry.type = ENTRY_TYPE_NUMBER;
+			else
+				throwInvalidJSONException(data, i);
+
+			i = entry.end - 1;
+			break;
+		}
+
+		[tape addItem: &entry];
+
+		if (isKey)
+			state = SCAN_STATE_EXPECT_COLON;
+		else if ([stack count] > 0)
+			state = SCAN_STATE_EXPECT_COMMA_OR_END;
+		else
+			state = SCAN_STATE_EXPECT_END_OF_DATA;
+	}
+
+	if (state != SCAN_STATE_EXPECT_END_OF_DATA)
+		throwInvalidJSONException(data, length);
+
+	objc_autoreleasePoolPop(pool);
+}
+
+@implementation OFString_JSONView
+- (instancetype)initWithData: (OFData *)data
+		     cString: (const char *)cString
+		      length: (size_t)length
+{
+	self = [super init];
+
+	@try {
+		switch (of_string_utf8_check(cString, length, &_length)) {
+		case 1:
+			_isUTF8 = true;
+			break;
+		case -1:
+			@throw [OFInvalidEncodingException exception];
+		}
+
+		_data = [data retain];
+		_cString = cString;
+		_cStringLength = length;
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_data release];
+
+	[super dealloc];
+}
+
+- (size_t)length
+{
+	return _length;
+}
+
+- (of_unichar_t)characterAtIndex: (size_t)idx
+{
+	of_unichar_t character;
+
+	if (idx >= _length)
+		@throw [OFOutOfRangeException exception];
+
+	if (!_isUTF8)
+		return _cString[idx];
+
+	idx = of_string_utf8_get_position(_cString, idx, _cStringLength);
+
+	if (of_string_utf8_decode(_cString + idx, _cStringLength - idx,
+	    &character) <= 0)
+		@throw [OFInvalidEncodingException exception];
+
+	return character;
+}
+
+- (void)getCharacters: (of_unichar_t *)buffer
+	      inRange: (of_range_t)range
+{
+	size_t position;
+
+	if (range.length > SIZE_MAX - range.location ||
+	    range.location + range.length > _length)
+		@throw [OFOutOfRangeException exception];
+
+	if (!_isUTF8) {
+		for (size_t i = 0; i < range.length; i++)
+			buffer[i] = (unsigned char)_cString[range.location + i];
+
+		return;
+	}
+
+	position = of_string_utf8_get_position(_cString, range.location,
+	    _cStringLength);
+
+	for (size_t i = 0; i < range.length; i++) {
+		ssize_t length = of_string_utf8_decode(_cString + position,
+		    _cStringLength - position, buffer + i);
+
+		if (length <= 0)
+			@throw [OFInvalidEncodingException exception];
+
+		position += length;
+	}
+}
+
+- (const char *)UTF8String
+{
+	/* The data is not terminated, so a copy is needed */
+	if (_UTF8String == NULL) {
+		_UTF8String = [self allocMemoryWithSize: _cStringLength + 1];
+		memcpy(_UTF8String, _cString, _cStringLength);
+		_UTF8String[_cStringLength] = '\0';
+	}
+
+	return _UTF8String;
+}
+
+- (size_t)UTF8StringLength
+{
+	return _cStringLength;
+}
+
+- (const char *)cStringWithEncoding: (of_string_encoding_t)encoding
+{
+	if (encoding == OF_STRING_ENCODING_UTF_8)
+		return [self UTF8String];
+
+	return [super cStringWithEncoding: encoding];
+}
+
+- (size_t)cStringLengthWithEncoding: (of_string_encoding_t)encoding
+{
+	if (encoding == OF_STRING_ENCODING_UTF_8)
+		return _cStringLength;
+
+	return [super cStringLengthWithEncoding: encoding];
+}
+
+- (bool)isEqual: (id)object
+{
+	OFString *otherString;
+
+	if (object == self)
+		return true;
+
+	if (![object isKindOfClass: [OFString class]])
+		return false;
+
+	otherString = object;
+
+	if ([otherString UTF8StringLength] != _cStringLength)
+		return false;
+
+	/* Avoid the copy -[UTF8String] needs if both strings are views */
+	if ([otherString isKindOfClass: [OFString_JSONView class]])
+		return (memcmp(_cString,
+		    ((OFString_JSONView *)otherString)->_cString,
+		    _cStringLength) == 0);
+
+	return (memcmp(_cString, [otherString UTF8String],
+	    _cStringLength) == 0);
+}
+@end
+
+@implementation OFJSONDocument
+@synthesize data = _data;
+
++ (instancetype)documentWithData: (OFData *)data
+{
+	return [[[self alloc] initWithData: data] autorelease];
+}
+
++ (instancetype)documentWithData: (OFData *)data
+		      depthLimit: (size_t)depthLimit
+{
+	return [[[self alloc] initWithData: data
+				depthLimit: depthLimit] autorelease];
+}
+
+- (instancetype)init
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithData: (OFData *)data
+{
+	return [self initWithData: data
+		       depthLimit: 32];
+}
+
+- (instancetype)initWithData: (OFData *)data
+		  depthLimit: (size_t)depthLimit
+{
+	self = [super init];
+
+	@try {
+		if ([data itemSize] != 1)
+			@throw [OFInvalidArgumentException exception];
+
+		/* Mutable data needs to be copied, as strings refer to it */
+		_data = [data copy];
+		_tape = [[OFMutableData alloc]
+		    initWithItemSize: sizeof(struct entry)];
+
+		buildTape([_data items], [_data count], _tape, depthLimit);
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_data release];
+	[_tape release];
+
+	[super dealloc];
+}
+
+- (id)of_valueAtIndex: (size_t)idx
+{
+	const struct entry *entry = [_tape itemAtIndex: idx];
+	const char *data = [_data items];
+	size_t dataLength = [_data count];
+	const char *pointer, *stop;
+	char *copy;
+	size_t line = 1;
+	id ret;
+
+	switch (entry->type) {
+	case ENTRY_TYPE_OBJECT:;
+		OFMutableDictionary *dictionary =
+		    [OFMutableDictionary dictionary];
+
+		for (size_t i = idx + 1; i < entry->next;) {
+			const struct entry *value = [_tape itemAtIndex: i + 1];
+
+			[dictionary setObject: [self of_valueAtIndex: i + 1]
+				       forKey: [self of_valueAtIndex: i]];
+
+			i = value->next;
+		}
+
+		[dictionary makeImmutable];
+
+		return dictionary;
+	case ENTRY_TYPE_ARRAY:;
+		OFMutableArray *array = [OFMutableArray array];
+
+		for (size_t i = idx + 1; i < entry->next;
+		    i = ((const struct entry *)[_tape itemAtIndex: i])->next)
+			[array addObject: [self of_valueAtIndex: i]];
+
+		[array makeImmutable];
+
+		return array;
+	case ENTRY_TYPE_STRING:
+		return [[[OFString_JSONView alloc]
+		    initWithData: _data
+			 cString: data + entry->start + 1
+			  length: entry->end - entry->start - 2] autorelease];
+	case ENTRY_TYPE_TRUE:
+		return [OFNumber numberWithBool: true];
+	case ENTRY_TYPE_FALSE:
+		return [OFNumber numberWithBool: false];
+	case ENTRY_TYPE_NULL:
+		return [OFNull null];
+	default:
+		break;
+	}
+
+	/*
+	 * Escaped strings and numbers are decoded with the same functions as
+	 * -[OFString JSONValue], which need a character after the token.
+	 */
+	if (entry->end < dataLength) {
+		pointer = data + entry->start;
+		stop = data + dataLength;
+		copy = NULL;
+	} else {
+		size_t length = entry->end - entry->start;
+
+		copy = [self allocMemoryWithSize: length + 1];
+		memcpy(copy, data + entry->start, length);
+		copy[length] = ' ';
+
+		pointer = copy;
+		stop = copy + length + 1;
+	}
+
+	@try {
+		if (entry->type == ENTRY_TYPE_ESCAPED_STRING)
+			ret = of_json_parse_string(&pointer, stop, &line);
+		else
+			ret = of_json_parse_number(&pointer, stop, &line);
+	} @finally {
+		[self freeMemory: copy];
+	}
+
+	if (ret == nil)
+		throwInvalidJSONException(data, entry->start);
+
+	return ret;
+}
+
+- (size_t)of_indexForKey: (OFString *)key
+		inObject: (size_t)idx
+{
+	const struct entry *object = [_tape itemAtIndex: idx];
+	const char *data = [_data items];
+	const char *UTF8String = [key UTF8String];
+	size_t UTF8StringLength = [key UTF8StringLength];
+	size_t ret = OF_NOT_FOUND;
+
+	/*
+	 * Keep looking after a match, as the last one of duplicate keys wins,
+	 * just like for -[rootValue] and -[OFString JSONValue].
+	 */
+	for (size_t i = idx + 1; i < object->next;) {
+		const struct entry *entry = [_tape itemAtIndex: i];
+
+		if (entry->type == ENTRY_TYPE_STRING) {
+			if (entry->end - entry->start - 2 == UTF8StringLength &&
+			    memcmp(data + entry->start + 1, UTF8String,
+			    UTF8StringLength) == 0)
+				ret = i + 1;
+		} else if ([[self of_valueAtIndex: i] isEqual: key])
+			ret = i + 1;
+
+		i = ((const struct entry *)[_tape itemAtIndex: i + 1])->next;
+	}
+
+	return ret;
+}
+
+- (id)rootValue
+{
+	return [self of_valueAtIndex: 0];
+}
+
+- (id)valueForKeyPath: (OFString *)keyPath
+{
+	void *pool = objc_autoreleasePoolPush();
+	size_t idx = 0;
+	id ret;
+
+	for (OFString *component in
+	    [keyPath componentsSeparatedByString: @"."]) {
+		const struct entry *entry = [_tape itemAtIndex: idx];
+
+		if (entry->type == ENTRY_TYPE_OBJECT)
+			idx = [self of_indexForKey: component
+					  inObject: idx];
+		else if (entry->type == ENTRY_TYPE_ARRAY) {
+			const char *cString = [component UTF8String];
+			size_t length = [component UTF8StringLength];
+			size_t element = 0;
+
+			if (length == 0) {
+				objc_autoreleasePoolPop(pool);
+				return nil;
+			}
+
+			for (size_t i = 0; i < length; i++) {
+				if (cString[i] < '0' || cString[i] > '9' ||
+				    element > (SIZE_MAX - 9) / 10) {
+					objc_autoreleasePoolPop(pool);
+					return nil;
+				}
+
+				element = element * 10 + (cString[i] - '0');
+			}
+
+			idx++;
+			while (element-- > 0 && idx < entry->next)
+				idx = ((const struct entry *)
+				    [_tape itemAtIndex: idx])->next;
+
+			if (idx >= entry->next)
+				idx = OF_NOT_FOUND;
+		} else
+			idx = OF_NOT_FOUND;
+
+		if (idx == OF_NOT_FOUND) {
+			objc_autoreleasePoolPop(pool);
+			return nil;
+		}
+	}
+
+	ret = [[self of_valueAtIndex: idx] retain];
+
+	objc_autoreleasePoolPop(pool);
+
+	return [ret autorelease];
+}
+@end
@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFObject.h"
+#import "OFString.h"
+#import "OFRunLoop.h"
+#ifdef OF_HAVE_SOCKETS
+# import "OFKernelEventObserver.h"
+#endif
+
+OF_ASSUME_NONNULL_BEGIN
+
+@class OFMutableData;
+@class OFNumber;
+@class OFStream;
+@class OFJSONParser;
+
+/*!
+ * @protocol OFJSONParserDelegate OFJSONParser.h ObjFW/OFJSONParser.h
+ *
+ * @brief A protocol that needs to be implemented by delegates for
+ *	  OFJSONParser.
+ */
+@protocol OFJSONParserDelegate <OFObject>
+@optional
+/*!
+ * @brief This callback is called when the JSON parser found the start of an
+ *	  object.
+ *
+ * @param parser The parser which found the start of an object
+ */
+- (void)parserDidStartObject: (OFJSONParser *)parser;
+
+/*!
+ * @brief This callback is called when the JSON parser found the end of an
+ *	  object.
+ *
+ * @param parser The parser which found the end of an object
+ */
+- (void)parserDidEndObject: (OFJSONParser *)parser;
+
+/*!
+ * @brief This callback is called when the JSON parser found the start of an
+ *	  array.
+ *
+ * @param parser The parser which found the start of an array
+ */
+- (void)parserDidStartArray: (OFJSONParser *)parser;
+
+/*!
+ * @brief This callback is called when the JSON parser found the end of an
+ *	  array.
+ *
+ * @param parser The parser which found the end of an array
+ */
+- (void)parserDidEndArray: (OFJSONParser *)parser;
+
+/*!
+ * @brief This callback is called when the JSON parser found the key of a
+ *	  member of an object.
+ *
+ * The value of the member is reported by the next callback.
+ *
+ * @param parser The parser which found a key
+ * @param key The key the JSON parser found
+ */
+- (void)parser: (OFJSONParser *)parser
+      foundKey: (OFString *)key;
+
+/*!
+ * @brief This callback is called when the JSON parser found a string.
+ *
+ * @param parser The parser which found a string
+ * @param string The string the JSON parser found
+ */
+- (void)parser: (OFJSONParser *)parser
+   foundString: (OFString *)string;
+
+/*!
+ * @brief This callback is called when the JSON parser found a number or a
+ *	  boolean.
+ *
+ * Booleans are reported as numbers created with
+ * @ref OFNumber::numberWithBool:, just like @ref OFString::JSONValue returns
+ * them.
+ *
+ * @param parser The parser which found a number
+ * @param number The number the JSON parser found
+ */
+- (void)parser: (OFJSONParser *)parser
+   foundNumber: (OFNumber *)number;
+
+/*!
+ * @brief This callback is called when the JSON parser found `null`.
+ *
+ * @param parser The parser which found `null`
+ */
+- (void)parserFoundNull: (OFJSONParser *)parser;
+
+/*!
+ * @brief This callback is called when the JSON parser finished parsing a
+ *	  top-level value.
+ *
+ * The parser accepts any number of top-level values separated by whitespace,
+ * which allows parsing newline-delimited JSON.
+ *
+ * @param parser The parser which finished parsing a top-level value
+ */
+- (void)parserDidEndDocument: (OFJSONParser *)parser;
+
+#ifdef OF_HAVE_SOCKETS
+/*!
+ * @brief This callback is called when the JSON parser finished parsing a
+ *	  stream that was passed to @ref OFJSONParser::asyncParseStream:.
+ *
+ * @param parser The parser which finished parsing the stream
+ * @param stream The stream which has been parsed
+ * @param exception An exception that occurred while reading or parsing the
+ *		    stream, or nil on success
+ */
+-           (void)parser: (OFJSONParser *)parser
+  didFinishParsingStream: (OFStream *)stream
+	       exception: (nullable id)exception;
+#endif
+@end
+
+/*!
+ * @class OFJSONParser OFJSONParser.h ObjFW/OFJSONParser.h
+ *
+ * @brief An event-based JSON parser.
+ *
+ * OFJSONParser calls the delegate's callbacks as soon as it finds something,
+ * without ever creating the whole object graph or requiring the whole document
+ * to be in memory. It accepts the same JSON5 extensions as
+ * @ref OFString::JSONValue.
+ *
+ * Data can be passed to the parser in chunks of any size. To parse a stream
+ * asynchronously, use @ref asyncParseStream:, which reports the end of the
+ * stream to the delegate.
+ */
+@interface OFJSONParser: OFObject
+{
+	id <OFJSONParserDelegate> _Nullable _delegate;
+	enum of_json_parser_state {
+		OF_JSON_PARSER_EXPECT_VALUE,
+		OF_JSON_PARSER_EXPECT_VALUE_OR_END,
+		OF_JSON_PARSER_EXPECT_KEY_OR_END,
+		OF_JSON_PARSER_EXPECT_COLON,
+		OF_JSON_PARSER_EXPECT_COMMA_OR_END,
+		OF_JSON_PARSER_IN_STRING,
+		OF_JSON_PARSER_IN_IDENTIFIER,
+		OF_JSON_PARSER_IN_LITERAL,
+		OF_JSON_PARSER_IN_NUMBER,
+		OF_JSON_PARSER_IN_COMMENT_OPENING,
+		OF_JSON_PARSER_IN_COMMENT,
+		OF_JSON_PARSER_IN_LINE_COMMENT,
+		OF_JSON_PARSER_NUM_STATES
+	} _state, _stateBeforeComment;
+	size_t _i, _last;
+	const char *_Nullable _data;
+	OFMutableData *_buffer, *_containers;
+	char _delimiter;
+	bool _inKey, _escaped, _escapedCarriageReturn, _lastIsAsterisk;
+	size_t _lineNumber;
+	size_t _depthLimit;
+	bool _foundValue;
+	char *_Nullable _readBuffer;
+}
+
+/*!
+ * @brief The delegate that is used by the JSON parser.
+ */
+@property OF_NULLABLE_PROPERTY (assign, nonatomic)
+    id <OFJSONParserDelegate> delegate;
+
+/*!
+ * @brief The current line number.
+ */
+@property (readonly, nonatomic) size_t lineNumber;
+
+/*!
+ * @brief The depth limit for the JSON parser.
+ *
+ * If the depth limit is exceeded, an OFInvalidJSONException is thrown.
+ *
+ * The default is 32. 0 means unlimited (insecure!).
+ */
+@property (nonatomic) size_t depthLimit;
+
+/*!
+ * @brief Creates a new JSON parser.
+ *
+ * @return A new, autoreleased OFJSONParser
+ */
++ (instancetype)parser;
+
+/*!
+ * @brief Parses the specified buffer with the specified size.
+ *
+ * @param buffer The buffer to parse
+ * @param length The length of the buffer
+ */
+- (void)parseBuffer: (const char *)buffer
+	     length: (size_t)length;
+
+/*!
+ * @brief Parses the specified string.
+ *
+ * @param string The string to parse
+ */
+- (void)parseString: (OFString *)string;
+
+/*!
+ * @brief Parses the specified stream until the end of the stream is reached
+ *	  and then calls @ref finishParsing.
+ *
+ * @param stream The stream to parse
+ */
+- (void)parseStream: (OFStream *)stream;
+
+#ifdef OF_HAVE_SOCKETS
+/*!
+ * @brief Asynchronously parses the specified stream until the end of the
+ *	  stream is reached and then calls @ref finishParsing.
+ *
+ * Once the stream has been parsed completely or an error occurred,
+ * @ref OFJSONParserDelegate::parser:didFinishParsingStream:exception: is
+ * called. If the delegate does not implement it, the exception is thrown from
+ * the run loop instead. The delegate of the stream is not changed.
+ *
+ * @note The stream must conform to @ref OFReadyForReadingObserving in order
+ *	 for this to work!
+ *
+ * @param stream The stream to parse
+ */
+- (void)asyncParseStream: (OFStream <OFReadyForReadingObserving> *)stream;
+
+/*!
+ * @brief Asynchronously parses the specified stream until the end of the
+ *	  stream is reached and then calls @ref finishParsing.
+ *
+ * Once the stream has been parsed completely or an error occurred,
+ * @ref OFJSONParserDelegate::parser:didFinishParsingStream:exception: is
+ * called. If the delegate does not implement it, the exception is thrown from
+ * the run loop instead. The delegate of the stream is not changed.
+ *
+ * @note The stream must conform to @ref OFReadyForReadingObserving in order
+ *	 for this to work!
+ *
+ * @param stream The stream to parse
+ * @param runLoopMode The run loop mode in which to perform the async read
+ */
+- (void)asyncParseStream: (OFStream <OFReadyForReadingObserving> *)stream
+	     runLoopMode: (of_run_loop_mode_t)runLoopMode;
+#endif
+
+/*!
+ * @brief Tells the parser that there is no more data.
+ *
+ * This is required to finish a top-level number, as the end of a number can
+ * only be detected by the character following it. If the data ended inside a
+ * value or contained no value at all, an OFInvalidJSONException is thrown.
+ */
+- (void)finishParsing;
+@end
+
+OF_ASSUME_NONNULL_END
@@ -0,0 +1,695 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "OFJSONParser.h"
+#import "OFString+JSONValue+Private.h"
+#import "OFData.h"
+#import "OFNumber.h"
+#import "OFStream.h"
+#import "OFSystemInfo.h"
+#ifdef OF_HAVE_SOCKETS
+# import "OFRunLoop+Private.h"
+#endif
+
+#import "OFInitializationFailedException.h"
+#import "OFInvalidJSONException.h"
+
+typedef void (*state_function_t)(id, SEL);
+static SEL selectors[OF_JSON_PARSER_NUM_STATES];
+static state_function_t lookupTable[OF_JSON_PARSER_NUM_STATES];
+
+@interface OFJSONParser () <OFStreamDelegate>
+- (void)of_expectValueState;
+- (void)of_expectValueOrEndState;
+- (void)of_expectKeyOrEndState;
+- (void)of_expectColonState;
+- (void)of_expectCommaOrEndState;
+- (void)of_inStringState;
+- (void)of_inIdentifierState;
+- (void)of_inLiteralState;
+- (void)of_inNumberState;
+- (void)of_inCommentOpeningState;
+- (void)of_inCommentState;
+- (void)of_inLineCommentState;
+- (bool)of_skipWhitespaceAndComments;
+- (void)of_startValue;
+- (void)of_endValue;
+- (void)of_endContainer;
+- (void)of_appendToBuffer;
+- (void)of_throwInvalidJSONException;
+@end
+
+static OF_INLINE bool
+isIdentifierCharacter(char c)
+{
+	return ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+	    (c >= '0' && c <= '9') || c == '_' || c == '$' || c == '\\' ||
+	    (c & 0x80));
+}
+
+@implementation OFJSONParser
+@synthesize delegate = _delegate, lineNumber = _lineNumber;
+@synthesize depthLimit = _depthLimit;
+
++ (void)initialize
+{
+	const SEL selectors_[OF_JSON_PARSER_NUM_STATES] = {
+		@selector(of_expectValueState),
+		@selector(of_expectValueOrEndState),
+		@selector(of_expectKeyOrEndState),
+		@selector(of_expectColonState),
+		@selector(of_expectCommaOrEndState),
+		@selector(of_inStringState),
+		@selector(of_inIdentifierState),
+		@selector(of_inLiteralState),
+		@selector(of_inNumberState),
+		@selector(of_inCommentOpeningState),
+		@selector(of_inCommentState),
+		@selector(of_inLineCommentState)
+	};
+	memcpy(selectors, selectors_, sizeof(selectors_));
+
+	for (size_t i = 0; i < OF_JSON_PARSER_NUM_STATES; i++) {
+		if (![self instancesRespondToSelector: selectors[i]])
+			@throw [OFInitializationFailedException
+			    exceptionWithClass: self];
+
+		lookupTable[i] = (state_function_t)
+		    [self instanceMethodForSelector: selectors[i]];
+	}
+}
+
++ (instancetype)parser
+{
+	return [[[self alloc] init] autorelease];
+}
+
+- (instancetype)init
+{
+	self = [super init];
+
+	@try {
+		_buffer = [[OFMutableData alloc] init];
+		_containers = [[OFMutableData alloc] init];
+
+		_lineNumber = 1;
+		_depthLimit = 32;
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_buffer release];
+	[_containers release];
+
+	[super dealloc];
+}
+
+- (void)parseBuffer: (const char *)buffer
+	     length: (size_t)length
+{
+	_data = buffer;
+
+	for (_i = _last = 0; _i < length; _i++) {
+		size_t j = _i;
+
+		lookupTable[_state](self, selectors[_state]);
+
+		/* Ensure we don't count this character twice */
+		if (_i != j)
+			continue;
+
+		if (_data[_i] == '\n')
+			_lineNumber++;
+	}
+
+	/* Keep the start of a token that continues in the next buffer */
+	if (length > _last && (_state == OF_JSON_PARSER_IN_STRING ||
+	    _state == OF_JSON_PARSER_IN_IDENTIFIER ||
+	    _state == OF_JSON_PARSER_IN_LITERAL ||
+	    _state == OF_JSON_PARSER_IN_NUMBER))
+		[_buffer addItems: _data + _last
+			    count: length - _last];
+
+	_data = NULL;
+}
+
+- (void)parseString: (OFString *)string
+{
+	[self parseBuffer: [string UTF8String]
+		   length: [string UTF8StringLength]];
+}
+
+- (void)parseStream: (OFStream *)stream
+{
+	size_t pageSize = [OFSystemInfo pageSize];
+	char *buffer = [self allocMemoryWithSize: pageSize];
+
+	@try {
+		while (![stream isAtEndOfStream]) {
+			size_t length = [stream readIntoBuffer: buffer
+							length: pageSize];
+
+			[self parseBuffer: buffer
+				   length: length];
+		}
+	} @finally {
+		[self freeMemory: buffer];
+	}
+
+	[self finishParsing];
+}
+
+#ifdef OF_HAVE_SOCKETS
+- (void)asyncParseStream: (OFStream <OFReadyForReadingObserving> *)stream
+{
+	[self asyncParseStream: stream
+		   runLoopMode: of_run_loop_mode_default];
+}
+
+- (void)asyncParseStream: (OFStream <OFReadyForReadingObserving> *)stream
+	     runLoopMode: (of_run_loop_mode_t)runLoopMode
+{
+	size_t pageSize = [OFSystemInfo pageSize];
+
+	if (_readBuffer == NULL)
+		_readBuffer = [self allocMemoryWithSize: pageSize];
+
+	/*
+	 * Pass ourself as the delegate of the read instead of changing the
+	 * delegate of the stream. The run loop retains us until the read is
+	 * done.
+	 */
+	[OFRunLoop of_addAsyncReadForStream: stream
+				     buffer: _readBuffer
+				     length: pageSize
+				       mode: runLoopMode
+# ifdef OF_HAVE_BLOCKS
+				      block: NULL
+# endif
+				   delegate: self];
+}
+
+-      (bool)stream: (OF_KINDOF(OFStream *))stream
+  didReadIntoBuffer: (void *)buffer
+	     length: (size_t)length
+	  exception: (id)exception
+{
+	if (exception == nil) {
+		@try {
+			[self parseBuffer: buffer
+				   length: length];
+
+			if (![stream isAtEndOfStream])
+				return true;
+
+			[self finishParsing];
+		} @catch (id e) {
+			exception = e;
+		}
+	}
+
+	if ([_delegate respondsToSelector:
+	    @selector(parser:didFinishParsingStream:exception:)])
+		[_delegate parser: self
+		    didFinishParsingStream: stream
+				 exception: exception];
+	else if (exception != nil)
+		@throw exception;	/* Nobody would notice it otherwise */
+
+	return false;
+}
+#endif
+
+- (void)finishParsing
+{
+	static const char space = ' ';
+
+	/* A space ends a number or literal, but is invalid anywhere else */
+	if (_state == OF_JSON_PARSER_IN_NUMBER ||
+	    _state == OF_JSON_PARSER_IN_LITERAL)
+		[self parseBuffer: &space
+			   length: 1];
+
+	/* A line comment can also be ended by the end of the data */
+	if (_state == OF_JSON_PARSER_IN_LINE_COMMENT)
+		_state = _stateBeforeComment;
+
+	if (_state != OF_JSON_PARSER_EXPECT_VALUE ||
+	    [_containers count] > 0 || !_foundValue)
+		[self of_throwInvalidJSONException];
+}
+
+- (void)of_throwInvalidJSONException
+{
+	@throw [OFInvalidJSONException exceptionWithString: nil
+						      line: _lineNumber];
+}
+
+- (void)of_appendToBuffer
+{
+	[_buffer addItems: _data + _last
+		    count: _i - _last];
+}
+
+/*
+ * Skips whitespace and the start of comments. Returns true if the current
+ * character has been handled.
+ */
+- (bool)of_skipWhitespaceAndComments
+{
+	switch (_data[_i]) {
+	case ' ':
+	case '\t':
+	case '\r':
+	case '\n':
+		return true;
+	case '/':
+		_stateBeforeComment = _state;
+		_state = OF_JSON_PARSER_IN_COMMENT_OPENING;
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Starts a new value, assuming whitespace has already been skipped. */
+- (void)of_startValue
+{
+	char container;
+
+	_foundValue = true;
+
+	switch (_data[_i]) {
+	case '{':
+	case '[':
+		container = _data[_i];
+
+		/* Same semantics as -[OFString JSONValueWithDepthLimit:] */
+		if (_depthLimit != 0 && [_containers count] + 1 >= _depthLimit)
+			[self of_throwInvalidJSONException];
+
+		[_containers addItem: &container];
+
+		if (container == '{') {
+			if ([_delegate respondsToSelector:
+			    @selector(parserDidStartObject:)])
+				[_delegate parserDidStartObject: self];
+
+			_state = OF_JSON_PARSER_EXPECT_KEY_OR_END;
+		} else {
+			if ([_delegate respondsToSelector:
+			    @selector(parserDidStartArray:)])
+				[_delegate parserDidStartArray: self];
+
+			_state = OF_JSON_PARSER_EXPECT_VALUE_OR_END;
+		}
+
+		break;
+	case '"':
+	case '\'':
+		_delimiter = _data[_i];
+		_inKey = false;
+		_escaped = _escapedCarriageReturn = false;
+		_last = _i;
+		_state = OF_JSON_PARSER_IN_STRING;
+		break;
+	case 't':
+	case 'f':
+	case 'n':
+		_last = _i;
+		_state = OF_JSON_PARSER_IN_LITERAL;
+		break;
+	case '0':
+	case '1':
+	case '2':
+	case '3':
+	case '4':
+	case '5':
+	case '6':
+	case '7':
+	case '8':
+	case '9':
+	case '+':
+	case '-':
+	case '.':
+	case 'I':
+		_last = _i;
+		_state = OF_JSON_PARSER_IN_NUMBER;
+		break;
+	default:
+		[self of_throwInvalidJSONException];
+	}
+}
+
+- (void)of_endValue
+{
+	if ([_containers count] > 0) {
+		_state = OF_JSON_PARSER_EXPECT_COMMA_OR_END;
+		return;
+	}
+
+	if ([_delegate respondsToSelector: @selector(parserDidEndDocument:)])
+		[_delegate parserDidEndDocument: self];
+
+	_state = OF_JSON_PARSER_EXPECT_VALUE;
+}
+
+- (void)of_endContainer
+{
+	char container = *(char *)[_containers lastItem];
+
+	if ((container == '{' && _data[_i] != '}') ||
+	    (container == '[' && _data[_i] != ']'))
+		[self of_throwInvalidJSONException];
+
+	[_containers removeLastItem];
+
+	if (container == '{') {
+		if ([_delegate respondsToSelector:
+		    @selector(parserDidEndObject:)])
+			[_delegate parserDidEndObject: self];
+	} else {
+		if ([_delegate respondsToSelector:
+		    @selector(parserDidEndArray:)])
+			[_delegate parserDidEndArray: self];
+	}
+
+	[self of_endValue];
+}
+
+/*
+ * The following methods handle the different states of the parser. They are
+ * looked up in +[initialize] and put in a lookup table to speed things up.
+ * One dispatch for every character would be way too slow!
+ */
+
+- (void)of_expectValueState
+{
+	if (![self of_skipWhitespaceAndComments])
+		[self of_startValue];
+}
+
+- (void)of_expectValueOrEndState
+{
+	if ([self of_skipWhitespaceAndComments])
+		return;
+
+	if (_data[_i] == ']')
+		[self of_endContainer];
+	else
+		[self of_startValue];
+}
+
+- (void)of_expectKeyOrEndState
+{
+	if ([self of_skipWhitespaceAndComments])
+		return;
+
+	switch (_data[_i]) {
+	case '}':
+		[self of_endContainer];
+		break;
+	case '"':
+	case '\'':
+		_delimiter = _data[_i];
+		_inKey = true;
+		_escaped = _escapedCarriageReturn = false;
+		_last = _i;
+		_state = OF_JSON_PARSER_IN_STRING;
+		break;
+	default:
+		if (!of_json_is_identifier_start(_data[_i]))
+			[self of_throwInvalidJSONException];
+
+		_last = _i;
+		_state = OF_JSON_PARSER_IN_IDENTIFIER;
+		break;
+	}
+}
+
+- (void)of_expectColonState
+{
+	if ([self of_skipWhitespaceAndComments])
+		return;
+
+	if (_data[_i] != ':')
+		[self of_throwInvalidJSONException];
+
+	_state = OF_JSON_PARSER_EXPECT_VALUE;
+}
+
+- (void)of_expectCommaOrEndState
+{
+	if ([self of_skipWhitespaceAndComments])
+		return;
+
+	switch (_data[_i]) {
+	case ',':
+		/* Trailing commas are allowed, so the container can end */
+		if (*(char *)[_containers lastItem] == '{')
+			_state = OF_JSON_PARSER_EXPECT_KEY_OR_END;
+		else
+			_state = OF_JSON_PARSER_EXPECT_VALUE_OR_END;
+		break;
+	case '}':
+	case ']':
+		[self of_endContainer];
+		break;
+	default:
+		[self of_throwInvalidJSONException];
+	}
+}
+
+- (void)of_inStringState
+{
+	void *pool;
+	const char *pointer, *stop;
+	size_t line = _lineNumber;
+	OFString *string;
+
+	if (_escaped) {
+		/* An escaped \r\n is a line continuation */
+		_escapedCarriageReturn = (_data[_i] == '\r');
+		_escaped = false;
+		return;
+	}
+
+	if (_data[_i] == '\\') {
+		_escapedCarriageReturn = false;
+		_escaped = true;
+		return;
+	}
+
+	/* Newlines in strings are only allowed when escaped */
+	if (_data[_i] == '\n' && _escapedCarriageReturn) {
+		_escapedCarriageReturn = false;
+		return;
+	}
+
+	_escapedCarriageReturn = false;
+
+	if (_data[_i] == '\r' || _data[_i] == '\n')
+		[self of_throwInvalidJSONException];
+
+	if (_data[_i] != _delimiter)
+		return;
+
+	/* Include the delimiter and a character following it */
+	_i++;
+	[self of_appendToBuffer];
+	[_buffer addItem: " "];
+	_i--;
+
+	pool = objc_autoreleasePoolPush();
+
+	pointer = [_buffer items];
+	stop = pointer + [_buffer count];
+
+	if ((string = of_json_parse_string(&pointer, stop, &line)) == nil)
+		[self of_throwInvalidJSONException];
+
+	[_buffer removeAllItems];
+
+	if (_inKey) {
+		if ([_delegate respondsToSelector: @selector(parser:foundKey:)])
+			[_delegate parser: self
+				 foundKey: string];
+
+		_state = OF_JSON_PARSER_EXPECT_COLON;
+	} else {
+		if ([_delegate respondsToSelector:
+		    @selector(parser:foundString:)])
+			[_delegate parser: self
+			      foundString: string];
+
+		[self of_endValue];
+	}
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (void)of_inIdentifierState
+{
+	void *pool;
+	const char *pointer, *stop;
+	OFString *key;
+
+	if (isIdentifierCharacter(_data[_i]))
+		return;
+
+	[self of_appendToBuffer];
+	[_buffer addItem: " "];
+
+	pool = objc_autoreleasePoolPush();
+
+	pointer = [_buffer items];
+	stop = pointer + [_buffer count];
+
+	if ((key = of_json_parse_identifier(&pointer, stop)) == nil)
+		[self of_throwInvalidJSONException];
+
+	[_buffer removeAllItems];
+
+	if ([_delegate respondsToSelector: @selector(parser:foundKey:)])
+		[_delegate parser: self
+			 foundKey: key];
+
+	objc_autoreleasePoolPop(pool);
+
+	/* The current character has not been handled yet */
+	_state = OF_JSON_PARSER_EXPECT_COLON;
+	_i--;
+}
+
+- (void)of_inLiteralState
+{
+	const char *literal;
+	size_t length;
+
+	if (_data[_i] >= 'a' && _data[_i] <= 'z')
+		return;
+
+	[self of_appendToBuffer];
+
+	literal = [_buffer items];
+	length = [_buffer count];
+
+	if (length == 4 && memcmp(literal, "true", 4) == 0) {
+		if ([_delegate respondsToSelector:
+		    @selector(parser:foundNumber:)])
+			[_delegate parser: self
+			      foundNumber: [OFNumber numberWithBool: true]];
+	} else if (length == 5 && memcmp(literal, "false", 5) == 0) {
+		if ([_delegate respondsToSelector:
+		    @selector(parser:foundNumber:)])
+			[_delegate parser: self
+			      foundNumber: [OFNumber numberWithBool: false]];
+	} else if (length == 4 && memcmp(literal, "null", 4) == 0) {
+		if ([_delegate respondsToSelector:
+		    @selector(parserFoundNull:)])
+			[_delegate parserFoundNull: self];
+	} else
+		[self of_throwInvalidJSONException];
+
+	[_buffer removeAllItems];
+	[self of_endValue];
+
+	/* The current character has not been handled yet */
+	_i--;
+}
+
+- (void)of_inNumberState
+{
+	void *pool;
+	const char *pointer, *stop;
+	size_t line = _lineNumber;
+	OFNumber *number;
+
+	switch (_data[_i]) {
+	case ' ':
+	case '\t':
+	case '\r':
+	case '\n':
+	case '/':
+	case ',':
+	case ']':
+	case '}':
+		break;
+	default:
+		return;
+	}
+
+	[self of_appendToBuffer];
+	[_buffer addItem: " "];
+
+	pool = objc_autoreleasePoolPush();
+
+	pointer = [_buffer items];
+	stop = pointer + [_buffer count];
+
+	if ((number = of_json_parse_number(&pointer, stop, &line)) == nil)
+		[self of_throwInvalidJSONException];
+
+	[_buffer removeAllItems];
+
+	if ([_delegate respondsToSelector: @selector(parser:foundNumber:)])
+		[_delegate parser: self
+		      foundNumber: number];
+
+	objc_autoreleasePoolPop(pool);
+
+	[self of_endValue];
+
+	/* The current character has not been handled yet */
+	_i--;
+}
+
+- (void)of_inCommentOpeningState
+{
+	if (_data[_i] == '*') {
+		_lastIsAsterisk = false;
+		_state = OF_JSON_PARSER_IN_COMMENT;
+	} else if (_data[_i] == '/')
+		_state = OF_JSON_PARSER_IN_LINE_COMMENT;
+	else
+		[self of_throwInvalidJSONException];
+}
+
+- (void)of_inCommentState
+{
+	if (_lastIsAsterisk && _data[_i] == '/')
+		_state = _stateBeforeComment;
+
+	_lastIsAsterisk = (_data[_i] == '*');
+}
+
+- (void)of_inLineCommentState
+{
+	if (_data[_i] == '\r' || _data[_i] == '\n')
+		_state = _stateBeforeComment;
+}
+@end
@@ -24,6 +24,7 @@ OF_ASSUME_NONNULL_BEGIN
 enum {
 	OF_JSON_REPRESENTATION_PRETTY	  = 0x01,
 	OF_JSON_REPRESENTATION_JSON5	  = 0x02,
+	OF_JSON_REPRESENTATION_SORTED	  = 0x04,
 	OF_JSON_REPRESENTATION_IDENTIFIER = 0x10
 };
 
@@ -47,12 +48,16 @@ enum {
 /*!
  * @brief Returns the JSON representation of the object as a string.
  *
+ * To write the JSON representation of large objects, consider using
+ * @ref OFJSONWriter, which writes it directly into a stream.
+ *
  * @param options The options to use when creating a JSON representation.@n
  *		  Possible values are:
  *		  Value                           | Description
  *		  --------------------------------|-------------------------
  *		  `OF_JSON_REPRESENTATION_PRETTY` | Optimize for readability
  *		  `OF_JSON_REPRESENTATION_JSON5`  | Generate JSON5
+ *		  `OF_JSON_REPRESENTATION_SORTED` | Sort keys of dictionaries
  *
  * @return The JSON representation of the object as a string
  */
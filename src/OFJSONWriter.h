@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFObject.h"
+#import "OFJSONRepresentation.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+@class OFMutableData;
+@class OFStream;
+@class OFString;
+
+/*!
+ * @class OFJSONWriter OFJSONWriter.h ObjFW/OFJSONWriter.h
+ *
+ * @brief A class for writing JSON directly into a stream.
+ *
+ * In contrast to @ref OFJSONRepresentation::JSONRepresentationWithOptions:,
+ * the JSON is written incrementally into the stream instead of being built as
+ * a string first. For the same options, the written bytes are exactly the same
+ * as the JSON representation.
+ *
+ * Values can either be written as a whole using @ref writeObject: or piece by
+ * piece using @ref startArray, @ref startObject, @ref writeKey: and the
+ * corresponding end methods, which makes it possible to write documents that
+ * are never completely in memory.
+ *
+ * The output is buffered and written to the stream whenever the buffer is full,
+ * whenever a top-level value has been completely written, when @ref flush is
+ * called and when the writer is deallocated.
+ */
+@interface OFJSONWriter: OFObject
+{
+	OFStream *_stream;
+	int _options;
+	char *_buffer;
+	size_t _bufferLength;
+	OFMutableData *_containers;
+	bool _expectingValue;
+}
+
+/*!
+ * @brief The stream the JSON is written to.
+ */
+@property (readonly, nonatomic) OFStream *stream;
+
+/*!
+ * @brief The options used for writing JSON.
+ */
+@property (readonly, nonatomic) int options;
+
+/*!
+ * @brief Creates a new JSON writer for the specified stream.
+ *
+ * @param stream The stream to write JSON to
+ * @param options The options to use for writing JSON. See
+ *		  @ref OFJSONRepresentation::JSONRepresentationWithOptions:
+ *		  for the possible values.
+ * @return A new, autoreleased OFJSONWriter
+ */
++ (instancetype)writerWithStream: (OFStream *)stream
+			 options: (int)options;
+
+- (instancetype)init OF_UNAVAILABLE;
+
+/*!
+ * @brief Initializes an already allocated JSON writer for the specified
+ *	  stream.
+ *
+ * @param stream The stream to write JSON to
+ * @param options The options to use for writing JSON. See
+ *		  @ref OFJSONRepresentation::JSONRepresentationWithOptions:
+ *		  for the possible values.
+ * @return An initialized OFJSONWriter
+ */
+- (instancetype)initWithStream: (OFStream *)stream
+		       options: (int)options OF_DESIGNATED_INITIALIZER;
+
+/*!
+ * @brief Writes the specified object as a value.
+ *
+ * @param object The object to write
+ */
+- (void)writeObject: (id <OFJSONRepresentation>)object;
+
+/*!
+ * @brief Starts an array.
+ *
+ * All following values are written as elements of the array until
+ * @ref endArray is called.
+ */
+- (void)startArray;
+
+/*!
+ * @brief Ends the array started last.
+ */
+- (void)endArray;
+
+/*!
+ * @brief Starts an object.
+ *
+ * Members are written by calling @ref writeKey: followed by writing the value
+ * until @ref endObject is called.
+ */
+- (void)startObject;
+
+/*!
+ * @brief Writes the key of a member of the object started last.
+ *
+ * @param key The key to write
+ */
+- (void)writeKey: (OFString *)key;
+
+/*!
+ * @brief Ends the object started last.
+ */
+- (void)endObject;
+
+/*!
+ * @brief Writes all buffered output to the stream.
+ *
+ * This is done automatically after each top-level value, so it is only needed
+ * to make a partially written value visible in the stream.
+ */
+- (void)flush;
+@end
+
+OF_ASSUME_NONNULL_END
@@ -0,0 +1,393 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "OFJSONWriter.h"
+#import "OFArray.h"
+#import "OFData.h"
+#import "OFDictionary.h"
+#import "OFStream.h"
+#import "OFString.h"
+
+#import "OFInvalidArgumentException.h"
+
+#define BUFFER_SIZE 4096
+
+struct container {
+	char type;
+	size_t count;
+};
+
+@protocol OFJSONWriterRepresentation
+- (OFString *)of_JSONRepresentationWithOptions: (int)options
+					 depth: (size_t)depth;
+@end
+
+@interface OFJSONWriter ()
+- (void)of_writeBuffer: (const char *)buffer
+		length: (size_t)length;
+- (void)of_writeIndentation: (size_t)depth;
+- (void)of_writeString: (OFString *)string
+	       options: (int)options;
+- (void)of_startValue;
+- (void)of_endValue;
+@end
+
+@implementation OFJSONWriter
+@synthesize stream = _stream, options = _options;
+
++ (instancetype)writerWithStream: (OFStream *)stream
+			 options: (int)options
+{
+	return [[[self alloc] initWithStream: stream
+				     options: options] autorelease];
+}
+
+- (instancetype)init
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithStream: (OFStream *)stream
+		       options: (int)options
+{
+	self = [super init];
+
+	@try {
+		_stream = [stream retain];
+		_options = options;
+		_buffer = [self allocMemoryWithSize: BUFFER_SIZE];
+		_containers = [[OFMutableData alloc]
+		    initWithItemSize: sizeof(struct container)];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	/*
+	 * Write what is still buffered, e.g. an unfinished top-level value.
+	 * There is no way to report an error from here, so it is ignored.
+	 */
+	@try {
+		[self flush];
+	} @catch (id e) {
+	}
+
+	[_stream release];
+	[_containers release];
+
+	[super dealloc];
+}
+
+- (void)flush
+{
+	if (_bufferLength == 0)
+		return;
+
+	[_stream writeBuffer: _buffer
+		      length: _bufferLength];
+	_bufferLength = 0;
+}
+
+- (void)of_writeBuffer: (const char *)buffer
+		length: (size_t)length
+{
+	while (length > 0) {
+		size_t toCopy = BUFFER_SIZE - _bufferLength;
+
+		if (toCopy > length)
+			toCopy = length;
+
+		memcpy(_buffer + _bufferLength, buffer, toCopy);
+		_bufferLength += toCopy;
+		buffer += toCopy;
+		length -= toCopy;
+
+		if (_bufferLength == BUFFER_SIZE)
+			[self flush];
+	}
+}
+
+- (void)of_writeIndentation: (size_t)depth
+{
+	static const char tabs[] = "\t\t\t\t\t\t\t\t";
+
+	[self of_writeBuffer: "\n"
+		      length: 1];
+
+	while (depth > 0) {
+		size_t length = (depth < 8 ? depth : 8);
+
+		[self of_writeBuffer: tabs
+			      length: length];
+		depth -= length;
+	}
+}
+
+/*
+ * This needs to produce exactly the same output as
+ * -[OFString of_JSONRepresentationWithOptions:depth:], but escapes in a single
+ * pass without creating any intermediate strings.
+ */
+- (void)of_writeString: (OFString *)string
+	       options: (int)options
+{
+	const char *cString = [string UTF8String];
+	size_t length = [string UTF8StringLength];
+	size_t last = 0;
+	bool quote = true;
+
+	if ((options & OF_JSON_REPRESENTATION_JSON5) &&
+	    (options & OF_JSON_REPRESENTATION_IDENTIFIER))
+		quote = ((!of_ascii_isalpha(cString[0]) &&
+		    cString[0] != '_' && cString[0] != '$') ||
+		    strpbrk(cString, " \n\r\t\b\f\\\"'") != NULL);
+
+	if (quote)
+		[self of_writeBuffer: "\""
+			      length: 1];
+
+	for (size_t i = 0; i < length; i++) {
+		const char *escape;
+
+		switch (cString[i]) {
+		case '\\':
+			escape = "\\\\";
+			break;
+		case '"':
+			escape = "\\\"";
+			break;
+		case '\b':
+			escape = "\\b";
+			break;
+		case '\f':
+			escape = "\\f";
+			break;
+		case '\r':
+			escape = "\\r";
+			break;
+		case '\t':
+			escape = "\\t";
+			break;
+		case '\n':
+			escape = (options & OF_JSON_REPRESENTATION_JSON5
+			    ? "\\\n" : "\\n");
+			break;
+		default:
+			continue;
+		}
+
+		[self of_writeBuffer: cString + last
+			      length: i - last];
+		[self of_writeBuffer: escape
+			      length: 2];
+		last = i + 1;
+	}
+
+	[self of_writeBuffer: cString + last
+		      length: length - last];
+
+	if (quote)
+		[self of_writeBuffer: "\""
+			      length: 1];
+}
+
+- (void)of_startValue
+{
+	struct container *container;
+
+	if (_expectingValue) {
+		_expectingValue = false;
+		return;
+	}
+
+	if ((container = [_containers lastItem]) == NULL)
+		return;
+
+	/* Members of objects need to be started with a key */
+	if (container->type != '[')
+		@throw [OFInvalidArgumentException exception];
+
+	if (container->count++ > 0)
+		[self of_writeBuffer: ","
+			      length: 1];
+
+	if (_options & OF_JSON_REPRESENTATION_PRETTY)
+		[self of_writeIndentation: [_containers count]];
+}
+
+- (void)of_endValue
+{
+	if ([_containers count] == 0)
+		[self flush];
+}
+
+- (void)writeObject: (id <OFJSONRepresentation>)object
+{
+	void *pool = objc_autoreleasePoolPush();
+
+	if ([(id)object isKindOfClass: [OFString class]]) {
+		[self of_startValue];
+		[self of_writeString: (OFString *)object
+			     options: _options];
+		[self of_endValue];
+	} else if ([(id)object isKindOfClass: [OFArray class]]) {
+		[self startArray];
+
+		for (id element in (OFArray *)object) {
+			void *pool2 = objc_autoreleasePoolPush();
+
+			[self writeObject: element];
+
+			objc_autoreleasePoolPop(pool2);
+		}
+
+		[self endArray];
+	} else if ([(id)object isKindOfClass: [OFDictionary class]]) {
+		OFDictionary *dictionary = (OFDictionary *)object;
+		OFEnumerator *keyEnumerator, *objectEnumerator = nil;
+		id key;
+
+		if (_options & OF_JSON_REPRESENTATION_SORTED)
+			keyEnumerator = [[[dictionary allKeys] sortedArray]
+			    objectEnumerator];
+		else {
+			keyEnumerator = [dictionary keyEnumerator];
+			objectEnumerator = [dictionary objectEnumerator];
+		}
+
+		[self startObject];
+
+		while ((key = [keyEnumerator nextObject]) != nil) {
+			void *pool2 = objc_autoreleasePoolPush();
+			id value = (objectEnumerator != nil
+			    ? [objectEnumerator nextObject]
+			    : [dictionary objectForKey: key]);
+
+			if (![key isKindOfClass: [OFString class]])
+				@throw [OFInvalidArgumentException exception];
+
+			[self writeKey: key];
+			[self writeObject: value];
+
+			objc_autoreleasePoolPop(pool2);
+		}
+
+		[self endObject];
+	} else {
+		OFString *JSON = [(id <OFJSONWriterRepresentation>)object
+		    of_JSONRepresentationWithOptions: _options
+					       depth: [_containers count]];
+
+		[self of_startValue];
+		[self of_writeBuffer: [JSON UTF8String]
+			      length: [JSON UTF8StringLength]];
+		[self of_endValue];
+	}
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (void)startArray
+{
+	struct container container = { '[', 0 };
+
+	[self of_startValue];
+	[self of_writeBuffer: "["
+		      length: 1];
+	[_containers addItem: &container];
+}
+
+- (void)endArray
+{
+	struct container *container = [_containers lastItem];
+
+	if (container == NULL || container->type != '[')
+		@throw [OFInvalidArgumentException exception];
+
+	[_containers removeLastItem];
+
+	if (_options & OF_JSON_REPRESENTATION_PRETTY)
+		[self of_writeIndentation: [_containers count]];
+
+	[self of_writeBuffer: "]"
+		      length: 1];
+	[self of_endValue];
+}
+
+- (void)startObject
+{
+	struct container container = { '{', 0 };
+
+	[self of_startValue];
+	[self of_writeBuffer: "{"
+		      length: 1];
+	[_containers addItem: &container];
+}
+
+- (void)writeKey: (OFString *)key
+{
+	struct container *container = [_containers lastItem];
+
+	if (container == NULL || container->type != '{' || _expectingValue)
+		@throw [OFInvalidArgumentException exception];
+
+	if (container->count++ > 0)
+		[self of_writeBuffer: ","
+			      length: 1];
+
+	if (_options & OF_JSON_REPRESENTATION_PRETTY)
+		[self of_writeIndentation: [_containers count]];
+
+	[self of_writeString: key
+		     options: _options | OF_JSON_REPRESENTATION_IDENTIFIER];
+
+	if (_options & OF_JSON_REPRESENTATION_PRETTY)
+		[self of_writeBuffer: ": "
+			      length: 2];
+	else
+		[self of_writeBuffer: ":"
+			      length: 1];
+
+	_expectingValue = true;
+}
+
+- (void)endObject
+{
+	struct container *container = [_containers lastItem];
+
+	if (container == NULL || container->type != '{' || _expectingValue)
+		@throw [OFInvalidArgumentException exception];
+
+	[_containers removeLastItem];
+
+	if (_options & OF_JSON_REPRESENTATION_PRETTY)
+		[self of_writeIndentation: [_containers count]];
+
+	[self of_writeBuffer: "}"
+		      length: 1];
+	[self of_endValue];
+}
+@end
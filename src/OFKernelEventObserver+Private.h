@@ -26,6 +26,17 @@ OF_ASSUME_NONNULL_BEGIN
 - (void)of_removeObjectForWriting: (id <OFReadyForWritingObserving>)object;
 - (void)of_processQueue;
 - (bool)of_processReadBuffers;
+
+/*
+ * Writes to an object that is observed for writing. Backends that can write
+ * to the object asynchronously start the write and throw an
+ * OFWriteFailedException with EAGAIN instead. Once the object is reported as
+ * ready for writing again, calling this again with the same buffer returns the
+ * result of the write.
+ */
+- (size_t)of_writeBuffer: (const void *)buffer
+		  length: (size_t)length
+		toObject: (id)object;
 @end
 
 OF_ASSUME_NONNULL_END
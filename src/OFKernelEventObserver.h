@@ -121,6 +121,7 @@ OF_ASSUME_NONNULL_BEGIN
 #endif
 	OFMutableData *_queueActions;
 	OFMutableArray *_queueObjects;
+	bool _edgeTriggered;
 }
 
 /*!
@@ -129,6 +130,21 @@ OF_ASSUME_NONNULL_BEGIN
 @property OF_NULLABLE_PROPERTY (assign, nonatomic)
     id <OFKernelEventObserverDelegate> delegate;
 
+/*!
+ * @brief Whether objects are only reported when they become ready instead of
+ *	  for as long as they are ready.
+ *
+ * In edge-triggered mode, the delegate needs to read or write until the
+ * operation would block, as the object is not reported again before that.
+ * This only applies to objects in non-blocking mode, all other objects are
+ * still observed level-triggered. Objects must not change their blocking mode
+ * while they are being observed.
+ *
+ * Not all backends support this, in which case enabling it throws an
+ * OFNotImplementedException.
+ */
+@property (nonatomic, getter=isEdgeTriggered) bool edgeTriggered;
+
 /*!
  * @brief Creates a new OFKernelEventObserver.
  *
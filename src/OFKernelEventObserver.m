@@ -41,6 +41,9 @@
 #ifdef HAVE_EPOLL
 # import "OFKernelEventObserver_epoll.h"
 #endif
+#ifdef HAVE_IO_URING
+# import "OFKernelEventObserver_io_uring.h"
+#endif
 #ifdef HAVE_POLL
 # import "OFKernelEventObserver_poll.h"
 #endif
@@ -50,6 +53,7 @@
 
 #import "OFInitializationFailedException.h"
 #import "OFInvalidArgumentException.h"
+#import "OFNotImplementedException.h"
 #import "OFOutOfRangeException.h"
 
 #import "socket.h"
@@ -64,7 +68,7 @@ enum {
 #define QUEUE_ACTION (QUEUE_ADD | QUEUE_REMOVE)
 
 @implementation OFKernelEventObserver
-@synthesize delegate = _delegate;
+@synthesize delegate = _delegate, edgeTriggered = _edgeTriggered;
 
 + (void)initialize
 {
@@ -83,7 +87,12 @@ enum {
 
 + (instancetype)alloc
 {
-	if (self == [OFKernelEventObserver class])
+	if (self == [OFKernelEventObserver class]) {
+#ifdef HAVE_IO_URING
+		if ([OFKernelEventObserver_io_uring of_isAvailable])
+			return [OFKernelEventObserver_io_uring alloc];
+#endif
+
 #if defined(HAVE_KQUEUE)
 		return [OFKernelEventObserver_kqueue alloc];
 #elif defined(HAVE_EPOLL)
@@ -95,6 +104,7 @@ enum {
 #else
 # error No kqueue / epoll / poll / select found!
 #endif
+	}
 
 	return [super alloc];
 }
@@ -280,6 +290,13 @@ enum {
 	[self cancel];
 }
 
+- (void)setEdgeTriggered: (bool)edgeTriggered
+{
+	if (edgeTriggered)
+		@throw [OFNotImplementedException exceptionWithSelector: _cmd
+								 object: self];
+}
+
 - (void)of_addObjectForReading: (id <OFReadyForReadingObserving>)object
 {
 	OF_UNRECOGNIZED_SELECTOR
@@ -300,6 +317,14 @@ enum {
 	OF_UNRECOGNIZED_SELECTOR
 }
 
+- (size_t)of_writeBuffer: (const void *)buffer
+		  length: (size_t)length
+		toObject: (id)object
+{
+	return [object writeBuffer: buffer
+			    length: length];
+}
+
 - (void)of_processQueue
 {
 	void *pool = objc_autoreleasePoolPush();
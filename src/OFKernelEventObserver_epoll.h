@@ -20,11 +20,16 @@
 OF_ASSUME_NONNULL_BEGIN
 
 @class OFMapTable;
+@class OFMutableData;
 
 @interface OFKernelEventObserver_epoll: OFKernelEventObserver
 {
 	int _epfd;
-	OFMapTable *_FDToEvents;
+	OFMapTable *_FDToState;
+	OFMutableData *_changedFDs;
+	bool _modeChanged;
+	void *_eventList;
+	size_t _eventListSize;
 }
 @end
 
@@ -31,6 +31,7 @@
 #import "OFKernelEventObserver+Private.h"
 #import "OFKernelEventObserver_epoll.h"
 #import "OFArray.h"
+#import "OFData.h"
 #import "OFMapTable.h"
 #import "OFNull.h"
 #ifdef OF_HAVE_THREADS
@@ -40,10 +41,32 @@
 #import "OFInitializationFailedException.h"
 #import "OFObserveFailedException.h"
 
-#define EVENTLIST_SIZE 64
+#define EVENTLIST_MIN_SIZE 64
+#define EVENTLIST_MAX_SIZE 4096
+
+/*
+ * Additions and modifications are only recorded in the state of the file
+ * descriptor and applied to epoll once per call to observe, so that e.g.
+ * switching an object from reading to writing only results in a single
+ * epoll_ctl(). Removing the last event is applied right away instead, as the
+ * file descriptor might be closed and its number reused before the next call
+ * to observe.
+ */
+struct fd_state {
+	id object;
+	int fd, events, registeredEvents;
+	bool changed, force;
+};
 
 static const of_map_table_functions_t mapFunctions = { NULL };
 
+static bool
+isNonBlocking(id object)
+{
+	return ([object respondsToSelector: @selector(isBlocking)] &&
+	    ![object isBlocking]);
+}
+
 @implementation OFKernelEventObserver_epoll
 - (instancetype)init
 {
@@ -67,9 +90,16 @@ static const of_map_table_functions_t mapFunctions = { NULL };
 			fcntl(_epfd, F_SETFD, flags | FD_CLOEXEC);
 #endif
 
-		_FDToEvents = [[OFMapTable alloc]
+		_FDToState = [[OFMapTable alloc]
 		    initWithKeyFunctions: mapFunctions
 			 objectFunctions: mapFunctions];
+		_changedFDs = [[OFMutableData alloc]
+		    initWithItemSize: sizeof(int)];
+
+		_eventListSize = EVENTLIST_MIN_SIZE;
+		_eventList = [self
+		    allocMemoryWithSize: sizeof(struct epoll_event)
+				  count: _eventListSize];
 
 		memset(&event, 0, sizeof(event));
 		event.events = EPOLLIN;
@@ -90,66 +120,181 @@ static const of_map_table_functions_t mapFunctions = { NULL };
 {
 	close(_epfd);
 
-	[_FDToEvents release];
+	[_FDToState release];
+	[_changedFDs release];
 
 	[super dealloc];
 }
 
+- (void)setEdgeTriggered: (bool)edgeTriggered
+{
+	_edgeTriggered = edgeTriggered;
+	_modeChanged = true;
+
+	[self cancel];
+}
+
+- (void)of_markChanged: (struct fd_state *)state
+{
+	if (state->changed)
+		return;
+
+	[_changedFDs addItem: &state->fd];
+	state->changed = true;
+}
+
 - (void)of_addObject: (id)object
       fileDescriptor: (int)fd
 	      events: (int)addEvents
 {
-	struct epoll_event event;
-	intptr_t events;
-
-	events = (intptr_t)[_FDToEvents
+	struct fd_state *state = [_FDToState
 	    objectForKey: (void *)((intptr_t)fd + 1)];
 
-	memset(&event, 0, sizeof(event));
-	event.events = (int)events | addEvents;
-	event.data.ptr = object;
+	if (state == NULL) {
+		state = [self allocMemoryWithSize: sizeof(*state)];
+		memset(state, 0, sizeof(*state));
+		state->fd = fd;
+
+		@try {
+			[_FDToState setObject: state
+				       forKey: (void *)((intptr_t)fd + 1)];
+		} @catch (id e) {
+			[self freeMemory: state];
+			@throw e;
+		}
+	}
 
-	if (epoll_ctl(_epfd, (events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD),
-	    fd, &event) == -1)
-		@throw [OFObserveFailedException exceptionWithObserver: self
-								 errNo: errno];
+	/*
+	 * In edge-triggered mode, adding an event that is already registered
+	 * still needs to re-arm it, as the edge might have been consumed
+	 * already.
+	 */
+	if (state->object != object || _edgeTriggered)
+		state->force = true;
 
-	[_FDToEvents setObject: (void *)(events | addEvents)
-			forKey: (void *)((intptr_t)fd + 1)];
+	state->object = object;
+	state->events |= addEvents;
+
+	[self of_markChanged: state];
 }
 
 - (void)of_removeObject: (id)object
 	 fileDescriptor: (int)fd
 		 events: (int)removeEvents
 {
-	intptr_t events;
-
-	events = (intptr_t)[_FDToEvents
+	struct fd_state *state = [_FDToState
 	    objectForKey: (void *)((intptr_t)fd + 1)];
-	events &= ~removeEvents;
 
-	if (events == 0) {
-		if (epoll_ctl(_epfd, EPOLL_CTL_DEL, fd, NULL) == -1)
+	if (state == NULL)
+		return;
+
+	state->events &= ~removeEvents;
+
+	if (state->events == 0)
+		[self of_applyChangeForState: state];
+	else
+		[self of_markChanged: state];
+}
+
+- (void)of_applyChangeForState: (struct fd_state *)state
+{
+	struct epoll_event event;
+	int events, op;
+
+	state->changed = false;
+
+	if (state->events == 0) {
+		/*
+		 * The kernel already removed the file descriptor if it has
+		 * been closed in the meantime.
+		 */
+		if (state->registeredEvents != 0 &&
+		    epoll_ctl(_epfd, EPOLL_CTL_DEL, state->fd, NULL) == -1 &&
+		    errno != EBADF && errno != ENOENT)
 			@throw [OFObserveFailedException
 			    exceptionWithObserver: self
 					    errNo: errno];
 
-		[_FDToEvents removeObjectForKey: (void *)((intptr_t)fd + 1)];
-	} else {
-		struct epoll_event event;
+		[_FDToState removeObjectForKey:
+		    (void *)((intptr_t)state->fd + 1)];
+		[self freeMemory: state];
 
-		memset(&event, 0, sizeof(event));
-		event.events = (int)events;
-		event.data.ptr = object;
+		return;
+	}
 
-		if (epoll_ctl(_epfd, EPOLL_CTL_MOD, fd, &event) == -1)
+	events = state->events;
+	if (_edgeTriggered && isNonBlocking(state->object))
+		events |= EPOLLET;
+
+	if (events == state->registeredEvents && !state->force)
+		return;
+
+	memset(&event, 0, sizeof(event));
+	event.events = events;
+	event.data.ptr = state->object;
+
+	op = (state->registeredEvents == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD);
+
+	if (epoll_ctl(_epfd, op, state->fd, &event) == -1) {
+		/*
+		 * If the file descriptor has been closed and the number
+		 * reused, the kernel has forgotten about it.
+		 */
+		if (op != EPOLL_CTL_MOD || errno != ENOENT ||
+		    epoll_ctl(_epfd, EPOLL_CTL_ADD, state->fd, &event) == -1)
 			@throw [OFObserveFailedException
 			    exceptionWithObserver: self
 					    errNo: errno];
+	}
+
+	state->registeredEvents = events;
+	state->force = false;
+}
+
+- (void)of_applyChanges
+{
+	const int *FDs;
+	size_t i, count;
 
-		[_FDToEvents setObject: (void *)events
-				forKey: (void *)((intptr_t)fd + 1)];
+	if (_modeChanged) {
+		OFMapTableEnumerator *enumerator =
+		    [_FDToState objectEnumerator];
+		void **object;
+
+		_modeChanged = false;
+
+		while ((object = [enumerator nextObject]) != NULL) {
+			struct fd_state *state = *object;
+
+			state->force = true;
+			[self of_markChanged: state];
+		}
+	}
+
+	FDs = [_changedFDs items];
+	count = [_changedFDs count];
+
+	for (i = 0; i < count; i++) {
+		struct fd_state *state = [_FDToState
+		    objectForKey: (void *)((intptr_t)FDs[i] + 1)];
+
+		if (state == NULL || !state->changed)
+			continue;
+
+		@try {
+			[self of_applyChangeForState: state];
+		} @catch (id e) {
+			/*
+			 * Only drop the changes applied so far, including the
+			 * failed one, so that the remaining ones are still
+			 * applied with the next call.
+			 */
+			[_changedFDs removeItemsInRange: of_range(0, i + 1)];
+			@throw e;
+		}
 	}
+
+	[_changedFDs removeAllItems];
 }
 
 - (void)of_addObjectForReading: (id <OFReadyForReadingObserving>)object
@@ -183,15 +328,16 @@ static const of_map_table_functions_t mapFunctions = { NULL };
 - (void)observeForTimeInterval: (of_time_interval_t)timeInterval
 {
 	OFNull *nullObject = [OFNull null];
-	struct epoll_event eventList[EVENTLIST_SIZE];
+	struct epoll_event *eventList = _eventList;
 	int events;
 
 	[self of_processQueue];
+	[self of_applyChanges];
 
 	if ([self of_processReadBuffers])
 		return;
 
-	events = epoll_wait(_epfd, eventList, EVENTLIST_SIZE,
+	events = epoll_wait(_epfd, eventList, (int)_eventListSize,
 	    (timeInterval != -1 ? timeInterval * 1000 : -1));
 
 	if (events < 0)
@@ -232,5 +378,17 @@ static const of_map_table_functions_t mapFunctions = { NULL };
 
 		assert((eventList[i].events & ~(EPOLLIN | EPOLLOUT)) == 0);
 	}
+
+	/*
+	 * If the event list was filled completely, there were probably more
+	 * events pending, so fetch more at once next time.
+	 */
+	if ((size_t)events == _eventListSize &&
+	    _eventListSize < EVENTLIST_MAX_SIZE) {
+		_eventList = [self resizeMemory: _eventList
+					   size: sizeof(struct epoll_event)
+					  count: _eventListSize * 2];
+		_eventListSize *= 2;
+	}
 }
 @end
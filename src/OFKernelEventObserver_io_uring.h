@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFKernelEventObserver.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+@class OFMapTable;
+
+@interface OFKernelEventObserver_io_uring: OFKernelEventObserver
+{
+	int _ringFD;
+	void *_SQRing, *_CQRing, *_SQEs, *_CQEs;
+	size_t _SQRingSize, _CQRingSize, _SQEsSize;
+	unsigned *_SQHead, *_SQTail, *_SQMask, *_SQArray;
+	unsigned *_CQHead, *_CQTail, *_CQMask;
+	unsigned _SQEntries, _toSubmit;
+	OFMapTable *_requests, *_readRequests, *_writeRequests;
+	size_t _pendingFileRequests;
+}
+
+/*
+ * Whether io_uring can be used, which is not the case on older kernels or if
+ * it has been disabled, e.g. by a seccomp filter.
+ */
++ (bool)of_isAvailable;
+@end
+
+OF_ASSUME_NONNULL_END
@@ -0,0 +1,812 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+
+#include "unistd_wrapper.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include <linux/io_uring.h>
+
+#import "OFKernelEventObserver.h"
+#import "OFKernelEventObserver+Private.h"
+#import "OFKernelEventObserver_io_uring.h"
+#import "OFMapTable.h"
+#import "OFSeekableStream.h"
+#import "OFStream.h"
+#import "OFStream+Private.h"
+
+#import "OFInitializationFailedException.h"
+#import "OFObserveFailedException.h"
+#import "OFOutOfMemoryException.h"
+#import "OFWriteFailedException.h"
+
+#define RING_ENTRIES 128
+
+/* Values for user_data that do not refer to a request */
+#define USER_DATA_IGNORE 0
+#define USER_DATA_CANCEL 1
+#define USER_DATA_TIMEOUT 2
+
+/* The most that is written to a file with a single request */
+#define MAX_FILE_WRITE_SIZE (1024 * 1024)
+
+enum {
+	REQUEST_POLL_READ,
+	REQUEST_POLL_WRITE,
+	REQUEST_READ_FILE,
+	REQUEST_WRITE_FILE
+};
+
+struct request {
+	id object;
+	int fd, type;
+	bool inFlight, removed, hasResult;
+	int32_t result;
+	char *buffer;
+	size_t bufferSize;
+	of_offset_t offset;
+};
+
+static const of_map_table_functions_t mapFunctions = { NULL };
+
+@interface OFKernelEventObserver_io_uring ()
+- (struct io_uring_sqe *)of_nextSQE;
+- (void)of_observeCancelFD;
+- (void)of_submitRequest: (struct request *)request;
+- (void)of_reapCompletionsAndNotify: (bool)notify;
+- (bool)of_notifyIdleFileWrites;
+@end
+
+static int
+ringSetup(unsigned entries, struct io_uring_params *params)
+{
+	return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int
+ringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+	return (int)syscall(__NR_io_uring_enter, fd, toSubmit, minComplete,
+	    flags, NULL, 0);
+}
+
+static int
+ringRegister(int fd, unsigned opcode, void *arg, unsigned numArgs)
+{
+	return (int)syscall(__NR_io_uring_register, fd, opcode, arg, numArgs);
+}
+
+static of_offset_t
+seekFileDescriptor(int fd, of_offset_t offset, int whence)
+{
+#ifdef OF_HAVE_OFF64_T
+	return lseek64(fd, offset, whence);
+#else
+	return lseek(fd, offset, whence);
+#endif
+}
+
+static bool
+isRegularFile(int fd)
+{
+#ifdef OF_HAVE_OFF64_T
+	struct stat64 s;
+
+	if (fstat64(fd, &s) != 0)
+		return false;
+#else
+	struct stat s;
+
+	if (fstat(fd, &s) != 0)
+		return false;
+#endif
+
+	return S_ISREG(s.st_mode);
+}
+
+@implementation OFKernelEventObserver_io_uring
++ (bool)of_isAvailable
+{
+	static int available = -1;
+	static const uint8_t requiredOps[] = {
+		IORING_OP_POLL_ADD, IORING_OP_POLL_REMOVE, IORING_OP_TIMEOUT,
+		IORING_OP_READ, IORING_OP_WRITE
+	};
+	struct io_uring_params params;
+	struct io_uring_probe *probe;
+	size_t probeSize;
+	int fd;
+
+	if (available != -1)
+		return available;
+
+	available = 0;
+
+	memset(&params, 0, sizeof(params));
+	if ((fd = ringSetup(1, &params)) == -1)
+		return false;
+
+	if (!(params.features & IORING_FEAT_NODROP)) {
+		close(fd);
+		return false;
+	}
+
+	probeSize = sizeof(*probe) + 256 * sizeof(struct io_uring_probe_op);
+	if ((probe = calloc(1, probeSize)) == NULL) {
+		close(fd);
+		return false;
+	}
+
+	if (ringRegister(fd, IORING_REGISTER_PROBE, probe, 256) == 0) {
+		available = 1;
+
+		for (size_t i = 0; i < sizeof(requiredOps); i++) {
+			if (requiredOps[i] > probe->last_op ||
+			    !(probe->ops[requiredOps[i]].flags &
+			    IO_URING_OP_SUPPORTED)) {
+				available = 0;
+				break;
+			}
+		}
+	}
+
+	free(probe);
+	close(fd);
+
+	return available;
+}
+
+- (instancetype)init
+{
+	self = [super init];
+
+	_ringFD = -1;
+	_SQRing = _CQRing = _SQEs = MAP_FAILED;
+
+	@try {
+		struct io_uring_params params;
+		char *SQRing, *CQRing;
+
+		memset(&params, 0, sizeof(params));
+		if ((_ringFD = ringSetup(RING_ENTRIES, &params)) == -1)
+			@throw [OFInitializationFailedException
+			    exceptionWithClass: [self class]];
+
+		_SQRingSize = params.sq_off.array +
+		    params.sq_entries * sizeof(unsigned);
+		_CQRingSize = params.cq_off.cqes +
+		    params.cq_entries * sizeof(struct io_uring_cqe);
+
+		if (params.features & IORING_FEAT_SINGLE_MMAP) {
+			if (_CQRingSize > _SQRingSize)
+				_SQRingSize = _CQRingSize;
+
+			_CQRingSize = _SQRingSize;
+		}
+
+		_SQRing = mmap(NULL, _SQRingSize, PROT_READ | PROT_WRITE,
+		    MAP_SHARED | MAP_POPULATE, _ringFD, IORING_OFF_SQ_RING);
+		if (_SQRing == MAP_FAILED)
+			@throw [OFInitializationFailedException
+			    exceptionWithClass: [self class]];
+
+		if (params.features & IORING_FEAT_SINGLE_MMAP)
+			_CQRing = _SQRing;
+		else {
+			_CQRing = mmap(NULL, _CQRingSize,
+			    PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+			    _ringFD, IORING_OFF_CQ_RING);
+			if (_CQRing == MAP_FAILED)
+				@throw [OFInitializationFailedException
+				    exceptionWithClass: [self class]];
+		}
+
+		_SQEsSize = params.sq_entries * sizeof(struct io_uring_sqe);
+		_SQEs = mmap(NULL, _SQEsSize, PROT_READ | PROT_WRITE,
+		    MAP_SHARED | MAP_POPULATE, _ringFD, IORING_OFF_SQES);
+		if (_SQEs == MAP_FAILED)
+			@throw [OFInitializationFailedException
+			    exceptionWithClass: [self class]];
+
+		SQRing = _SQRing;
+		_SQHead = (unsigned *)(void *)(SQRing + params.sq_off.head);
+		_SQTail = (unsigned *)(void *)(SQRing + params.sq_off.tail);
+		_SQMask = (unsigned *)(void *)(SQRing +
+		    params.sq_off.ring_mask);
+		_SQArray = (unsigned *)(void *)(SQRing + params.sq_off.array);
+		_SQEntries = params.sq_entries;
+
+		CQRing = _CQRing;
+		_CQHead = (unsigned *)(void *)(CQRing + params.cq_off.head);
+		_CQTail = (unsigned *)(void *)(CQRing + params.cq_off.tail);
+		_CQMask = (unsigned *)(void *)(CQRing +
+		    params.cq_off.ring_mask);
+		_CQEs = CQRing + params.cq_off.cqes;
+
+		_requests = [[OFMapTable alloc]
+		    initWithKeyFunctions: mapFunctions
+			 objectFunctions: mapFunctions];
+		_readRequests = [[OFMapTable alloc]
+		    initWithKeyFunctions: mapFunctions
+			 objectFunctions: mapFunctions];
+		_writeRequests = [[OFMapTable alloc]
+		    initWithKeyFunctions: mapFunctions
+			 objectFunctions: mapFunctions];
+
+		[self of_observeCancelFD];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	OFMapTableEnumerator *enumerator;
+	void **request;
+
+	/*
+	 * The kernel accesses the buffers of file reads and writes that are
+	 * still in flight, so they need to complete before the buffers can be
+	 * freed.
+	 */
+	while (_pendingFileRequests > 0) {
+		if (ringEnter(_ringFD, _toSubmit, 1,
+		    IORING_ENTER_GETEVENTS) == -1 && errno != EINTR)
+			break;
+
+		_toSubmit = 0;
+		[self of_reapCompletionsAndNotify: false];
+	}
+
+	enumerator = [_requests objectEnumerator];
+	while ((request = [enumerator nextObject]) != NULL) {
+		free(((struct request *)*request)->buffer);
+		free(*request);
+	}
+
+	[_requests release];
+	[_readRequests release];
+	[_writeRequests release];
+
+	if (_SQEs != MAP_FAILED)
+		munmap(_SQEs, _SQEsSize);
+	if (_CQRing != MAP_FAILED && _CQRing != _SQRing)
+		munmap(_CQRing, _CQRingSize);
+	if (_SQRing != MAP_FAILED)
+		munmap(_SQRing, _SQRingSize);
+
+	if (_ringFD != -1)
+		close(_ringFD);
+
+	[super dealloc];
+}
+
+- (void)setEdgeTriggered: (bool)edgeTriggered
+{
+	/*
+	 * Polls are one-shot and the re-armed poll only reaches the kernel
+	 * with the next call to observe, i.e. after the delegate drained the
+	 * object. That already avoids the redundant wakeups edge-triggered
+	 * mode is meant to avoid, while never missing an edge.
+	 */
+	_edgeTriggered = edgeTriggered;
+}
+
+- (struct io_uring_sqe *)of_nextSQE
+{
+	unsigned tail = *_SQTail;
+	unsigned head = __atomic_load_n(_SQHead, __ATOMIC_ACQUIRE);
+	unsigned index;
+	struct io_uring_sqe *sqe;
+
+	if (tail - head >= _SQEntries) {
+		/* Submission queue is full, submit what we have so far. */
+		int ret = ringEnter(_ringFD, _toSubmit, 0, 0);
+
+		if (ret == -1)
+			@throw [OFObserveFailedException
+			    exceptionWithObserver: self
+					    errNo: errno];
+
+		_toSubmit -= ret;
+
+		head = __atomic_load_n(_SQHead, __ATOMIC_ACQUIRE);
+		if (tail - head >= _SQEntries)
+			@throw [OFObserveFailedException
+			    exceptionWithObserver: self
+					    errNo: EBUSY];
+	}
+
+	index = tail & *_SQMask;
+	sqe = (struct io_uring_sqe *)_SQEs + index;
+	memset(sqe, 0, sizeof(*sqe));
+	_SQArray[index] = index;
+
+	/*
+	 * Without SQPOLL, the kernel only looks at the submission queue in
+	 * io_uring_enter(), so the entry can be published before the caller
+	 * filled it in.
+	 */
+	__atomic_store_n(_SQTail, tail + 1, __ATOMIC_RELEASE);
+	_toSubmit++;
+
+	return sqe;
+}
+
+- (void)of_observeCancelFD
+{
+	struct io_uring_sqe *sqe = [self of_nextSQE];
+
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = _cancelFD[0];
+	sqe->poll_events = POLLIN;
+	sqe->user_data = USER_DATA_CANCEL;
+}
+
+- (void)of_submitRequest: (struct request *)request
+{
+	struct io_uring_sqe *sqe = [self of_nextSQE];
+
+	switch (request->type) {
+	case REQUEST_POLL_READ:
+	case REQUEST_POLL_WRITE:
+		sqe->opcode = IORING_OP_POLL_ADD;
+		sqe->fd = request->fd;
+		sqe->poll_events =
+		    (request->type == REQUEST_POLL_READ ? POLLIN : POLLOUT);
+		break;
+	case REQUEST_READ_FILE:
+		request->offset = seekFileDescriptor(request->fd, 0, SEEK_CUR);
+
+		sqe->opcode = IORING_OP_READ;
+		sqe->fd = request->fd;
+		sqe->addr = (uintptr_t)request->buffer;
+		sqe->len = (uint32_t)request->bufferSize;
+		sqe->off = (uint64_t)request->offset;
+
+		_pendingFileRequests++;
+		break;
+	case REQUEST_WRITE_FILE:
+		request->offset = seekFileDescriptor(request->fd, 0, SEEK_CUR);
+
+		sqe->opcode = IORING_OP_WRITE;
+		sqe->fd = request->fd;
+		sqe->addr = (uintptr_t)request->buffer;
+		sqe->len = (uint32_t)request->bufferSize;
+		sqe->off = (uint64_t)request->offset;
+
+		_pendingFileRequests++;
+		break;
+	}
+
+	sqe->user_data = (uintptr_t)request;
+	request->inFlight = true;
+}
+
+- (void)of_addObject: (id)object
+      fileDescriptor: (int)fd
+	     forRead: (bool)forRead
+{
+	OFMapTable *requests = (forRead ? _readRequests : _writeRequests);
+	struct request *request;
+
+	if ([requests objectForKey: object] != NULL)
+		return;
+
+	if ((request = calloc(1, sizeof(*request))) == NULL)
+		@throw [OFOutOfMemoryException
+		    exceptionWithRequestedSize: sizeof(*request)];
+
+	request->object = object;
+	request->fd = fd;
+	request->type = (forRead ? REQUEST_POLL_READ : REQUEST_POLL_WRITE);
+
+	/*
+	 * Regular files are always ready for reading, so polling them is
+	 * pointless. Instead, read from them asynchronously into the read
+	 * buffer of the stream, as long as the stream reads straight from the
+	 * file descriptor.
+	 */
+	if (forRead && [object isKindOfClass: [OFStream class]] &&
+	    [object of_fileDescriptorForZeroCopyReading] == fd &&
+	    isRegularFile(fd)) {
+		size_t bufferSize = [object readBufferSize];
+
+		if ((request->buffer = malloc(bufferSize)) != NULL) {
+			request->type = REQUEST_READ_FILE;
+			request->bufferSize = bufferSize;
+		}
+	}
+
+	/*
+	 * Likewise, writes to regular files are performed asynchronously once
+	 * the delegate writes through -[of_writeBuffer:length:toObject:].
+	 */
+	if (!forRead && [object isKindOfClass: [OFStream class]] &&
+	    [object of_fileDescriptorForZeroCopyWriting] == fd &&
+	    isRegularFile(fd))
+		request->type = REQUEST_WRITE_FILE;
+
+	@try {
+		[_requests setObject: request
+			      forKey: request];
+		[requests setObject: request
+			     forKey: object];
+
+		/*
+		 * File reads are only submitted once we actually observe and
+		 * file writes once there is something to write.
+		 */
+		if (request->type != REQUEST_READ_FILE &&
+		    request->type != REQUEST_WRITE_FILE)
+			[self of_submitRequest: request];
+	} @catch (id e) {
+		[requests removeObjectForKey: object];
+		[_requests removeObjectForKey: request];
+		free(request->buffer);
+		free(request);
+		@throw e;
+	}
+}
+
+- (void)of_removeObject: (id)object
+		forRead: (bool)forRead
+{
+	OFMapTable *requests = (forRead ? _readRequests : _writeRequests);
+	struct request *request = [requests objectForKey: object];
+
+	if (request == NULL)
+		return;
+
+	[requests removeObjectForKey: object];
+
+	if (request->inFlight) {
+		/* Freed once the kernel is done with it. */
+		request->removed = true;
+
+		if (request->type != REQUEST_READ_FILE &&
+		    request->type != REQUEST_WRITE_FILE) {
+			struct io_uring_sqe *sqe = [self of_nextSQE];
+
+			sqe->opcode = IORING_OP_POLL_REMOVE;
+			sqe->addr = (uintptr_t)request;
+			sqe->user_data = USER_DATA_IGNORE;
+		}
+	} else {
+		[_requests removeObjectForKey: request];
+		free(request->buffer);
+		free(request);
+	}
+}
+
+- (void)of_addObjectForReading: (id <OFReadyForReadingObserving>)object
+{
+	[self of_addObject: object
+	    fileDescriptor: [object fileDescriptorForReading]
+		   forRead: true];
+}
+
+- (void)of_addObjectForWriting: (id <OFReadyForWritingObserving>)object
+{
+	[self of_addObject: object
+	    fileDescriptor: [object fileDescriptorForWriting]
+		   forRead: false];
+}
+
+- (void)of_removeObjectForReading: (id <OFReadyForReadingObserving>)object
+{
+	[self of_removeObject: object
+		      forRead: true];
+}
+
+- (void)of_removeObjectForWriting: (id <OFReadyForWritingObserving>)object
+{
+	[self of_removeObject: object
+		      forRead: false];
+}
+
+- (size_t)of_writeBuffer: (const void *)buffer
+		  length: (size_t)length
+		toObject: (id)object
+{
+	struct request *request = [_writeRequests objectForKey: object];
+	int32_t result;
+
+	if (request == NULL || request->type != REQUEST_WRITE_FILE ||
+	    [object isWriteBuffered] || length == 0)
+		return [super of_writeBuffer: buffer
+				      length: length
+				    toObject: object];
+
+	if (!request->hasResult) {
+		if (!request->inFlight) {
+			if (length > MAX_FILE_WRITE_SIZE)
+				length = MAX_FILE_WRITE_SIZE;
+
+			if ((request->buffer = malloc(length)) == NULL)
+				@throw [OFOutOfMemoryException
+				    exceptionWithRequestedSize: length];
+
+			memcpy(request->buffer, buffer, length);
+			request->bufferSize = length;
+
+			[self of_submitRequest: request];
+		}
+
+		/* The object is reported as ready once the write completed. */
+		@throw [OFWriteFailedException exceptionWithObject: object
+						   requestedLength: length
+						      bytesWritten: 0
+							     errNo: EAGAIN];
+	}
+
+	result = request->result;
+	request->hasResult = false;
+
+	if (result < 0)
+		@throw [OFWriteFailedException exceptionWithObject: object
+						   requestedLength: length
+						      bytesWritten: 0
+							     errNo: -result];
+
+	return result;
+}
+
+- (void)of_completeRequest: (struct request *)request
+		    result: (int32_t)result
+		    notify: (bool)notify
+{
+	request->inFlight = false;
+
+	if (request->type == REQUEST_READ_FILE ||
+	    request->type == REQUEST_WRITE_FILE)
+		_pendingFileRequests--;
+
+	if (request->removed) {
+		[_requests removeObjectForKey: request];
+		free(request->buffer);
+		free(request);
+		return;
+	}
+
+	if (!notify)
+		return;
+
+	if (request->type == REQUEST_READ_FILE) {
+		if (result == -EINVAL || result == -EOPNOTSUPP) {
+			/* Not supported for this file, fall back to polling. */
+			free(request->buffer);
+			request->buffer = NULL;
+			request->bufferSize = 0;
+			request->type = REQUEST_POLL_READ;
+
+			[self of_submitRequest: request];
+			return;
+		}
+
+		/*
+		 * On EOF or an error, the delegate is notified anyway, so that
+		 * the read it performs itself runs into the same condition.
+		 */
+		if (result > 0) {
+			seekFileDescriptor(request->fd,
+			    request->offset + result, SEEK_SET);
+			[request->object of_appendToReadBuffer: request->buffer
+							length: result];
+		}
+	} else if (request->type == REQUEST_WRITE_FILE) {
+		/* The buffer is a copy that is only needed while in flight. */
+		free(request->buffer);
+		request->buffer = NULL;
+		request->bufferSize = 0;
+
+		if (result == -EINVAL || result == -EOPNOTSUPP) {
+			/*
+			 * Not supported for this file, fall back to polling.
+			 * The delegate then retries the write synchronously.
+			 */
+			request->type = REQUEST_POLL_WRITE;
+
+			[self of_submitRequest: request];
+			return;
+		}
+
+		if (result > 0)
+			seekFileDescriptor(request->fd,
+			    request->offset + result, SEEK_SET);
+
+		/* Picked up by the next -[of_writeBuffer:length:toObject:]. */
+		request->result = result;
+		request->hasResult = true;
+	} else {
+		if (result == -ECANCELED)
+			return;
+
+		if (result < 0)
+			@throw [OFObserveFailedException
+			    exceptionWithObserver: self
+					    errNo: -result];
+
+		/* Polls are one-shot, so re-arm it to be level-triggered. */
+		[self of_submitRequest: request];
+	}
+
+	if (request->type == REQUEST_POLL_WRITE ||
+	    request->type == REQUEST_WRITE_FILE) {
+		if ([_delegate respondsToSelector:
+		    @selector(objectIsReadyForWriting:)])
+			[_delegate objectIsReadyForWriting: request->object];
+	} else {
+		if ([_delegate respondsToSelector:
+		    @selector(objectIsReadyForReading:)])
+			[_delegate objectIsReadyForReading: request->object];
+	}
+}
+
+- (void)of_reapCompletionsAndNotify: (bool)notify
+{
+	unsigned head = *_CQHead;
+
+	while (head != __atomic_load_n(_CQTail, __ATOMIC_ACQUIRE)) {
+		struct io_uring_cqe *cqe =
+		    (struct io_uring_cqe *)_CQEs + (head & *_CQMask);
+		uint64_t userData = cqe->user_data;
+		int32_t result = cqe->res;
+		void *pool;
+		char buffer;
+
+		/*
+		 * Release the entry before calling into the delegate, which
+		 * might cause new submissions.
+		 */
+		__atomic_store_n(_CQHead, ++head, __ATOMIC_RELEASE);
+
+		switch (userData) {
+		case USER_DATA_IGNORE:
+		case USER_DATA_TIMEOUT:
+			break;
+		case USER_DATA_CANCEL:
+			if (result > 0)
+				OF_ENSURE(read(_cancelFD[0], &buffer, 1) == 1);
+
+			[self of_observeCancelFD];
+			break;
+		default:
+			pool = objc_autoreleasePoolPush();
+
+			[self of_completeRequest: (void *)(uintptr_t)userData
+					  result: result
+					  notify: notify];
+
+			objc_autoreleasePoolPop(pool);
+			break;
+		}
+	}
+}
+
+/*
+ * Regular files are always ready for writing. So report those that have no
+ * write in flight right away, so that the delegate can start the next write.
+ */
+- (bool)of_notifyIdleFileWrites
+{
+	OFMapTableEnumerator *enumerator = [_writeRequests objectEnumerator];
+	void **object;
+	bool notified = false;
+
+	if (![_delegate respondsToSelector:
+	    @selector(objectIsReadyForWriting:)])
+		return false;
+
+	while ((object = [enumerator nextObject]) != NULL) {
+		struct request *request = *object;
+		void *pool;
+
+		if (request->type != REQUEST_WRITE_FILE || request->inFlight ||
+		    request->hasResult)
+			continue;
+
+		pool = objc_autoreleasePoolPush();
+		[_delegate objectIsReadyForWriting: request->object];
+		objc_autoreleasePoolPop(pool);
+
+		notified = true;
+	}
+
+	return notified;
+}
+
+- (void)observeForTimeInterval: (of_time_interval_t)timeInterval
+{
+	OFMapTableEnumerator *enumerator;
+	void **object;
+	struct __kernel_timespec timeout;
+	int ret;
+
+	[self of_processQueue];
+
+	if ([self of_processReadBuffers])
+		return;
+
+	if ([self of_notifyIdleFileWrites]) {
+		/* Only submit the writes that were started, don't wait. */
+		if ((ret = ringEnter(_ringFD, _toSubmit, 0, 0)) == -1) {
+			if (errno == EINTR)
+				return;
+
+			@throw [OFObserveFailedException
+			    exceptionWithObserver: self
+					    errNo: errno];
+		}
+
+		_toSubmit -= ret;
+		return;
+	}
+
+	enumerator = [_readRequests objectEnumerator];
+	while ((object = [enumerator nextObject]) != NULL) {
+		struct request *request = *object;
+
+		if (request->type == REQUEST_READ_FILE && !request->inFlight)
+			[self of_submitRequest: request];
+	}
+
+	if (timeInterval != -1) {
+		struct io_uring_sqe *sqe;
+
+		timeout.tv_sec = (int64_t)timeInterval;
+		timeout.tv_nsec = (long long)
+		    ((timeInterval - timeout.tv_sec) * 1000000000);
+
+		/*
+		 * A count of 1 makes the timeout complete as soon as any other
+		 * request completes, so it never outlives this call.
+		 */
+		sqe = [self of_nextSQE];
+		sqe->opcode = IORING_OP_TIMEOUT;
+		sqe->addr = (uintptr_t)&timeout;
+		sqe->len = 1;
+		sqe->off = 1;
+		sqe->user_data = USER_DATA_TIMEOUT;
+	}
+
+	ret = ringEnter(_ringFD, _toSubmit, 1, IORING_ENTER_GETEVENTS);
+
+	if (ret == -1) {
+		if (errno == EINTR)
+			return;
+
+		@throw [OFObserveFailedException exceptionWithObserver: self
+								 errNo: errno];
+	}
+
+	_toSubmit -= ret;
+
+	[self of_reapCompletionsAndNotify: true];
+}
+@end
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFData.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+/*! @file */
+
+/*!
+ * @brief A hint how the data of an @ref OFMappedData is going to be accessed.
+ */
+typedef enum {
+	/*! No particular access pattern */
+	OF_MAPPED_DATA_ACCESS_NORMAL,
+	/*! The data is accessed sequentially, so it can be read ahead */
+	OF_MAPPED_DATA_ACCESS_SEQUENTIAL,
+	/*! The data is accessed randomly, so reading ahead is not useful */
+	OF_MAPPED_DATA_ACCESS_RANDOM,
+	/*! All of the data is going to be accessed soon */
+	OF_MAPPED_DATA_ACCESS_WILL_NEED
+} of_mapped_data_access_t;
+
+/*!
+ * @class OFMappedData OFMappedData.h ObjFW/OFMappedData.h
+ *
+ * @brief A class for accessing the contents of a file as data by mapping it
+ *	  into memory.
+ *
+ * The contents of the file are only read when they are accessed, so this is
+ * useful for large files of which only parts are needed or which should be
+ * usable before they have been read completely. The mapping is removed when
+ * the OFMappedData is deallocated.
+ *
+ * @note If memory mapping is unavailable on the platform, this falls back to
+ *	 reading the whole file into memory.
+ *
+ * @warning The file must not be truncated while it is mapped, as accessing
+ *	    the data beyond the end of the file crashes the process on many
+ *	    platforms.
+ */
+@interface OFMappedData: OFData
+{
+	size_t _mappingSize;
+}
+
+/*!
+ * @brief Creates a new OFMappedData with the contents of the specified file.
+ *
+ * @param path The path of the file
+ * @return A new autoreleased OFMappedData
+ */
++ (instancetype)dataWithContentsOfMappedFile: (OFString *)path;
+
+/*!
+ * @brief Creates a new OFMappedData with the contents of the specified file.
+ *
+ * @param path The path of the file
+ * @param access A hint how the data is going to be accessed
+ * @return A new autoreleased OFMappedData
+ */
++ (instancetype)dataWithContentsOfMappedFile: (OFString *)path
+				      access: (of_mapped_data_access_t)access;
+
++ (instancetype)dataWithItems: (const void *)items
+			count: (size_t)count OF_UNAVAILABLE;
++ (instancetype)dataWithItems: (const void *)items
+		     itemSize: (size_t)itemSize
+			count: (size_t)count OF_UNAVAILABLE;
++ (instancetype)dataWithItemsNoCopy: (void *)items
+			      count: (size_t)count
+		       freeWhenDone: (bool)freeWhenDone OF_UNAVAILABLE;
++ (instancetype)dataWithItemsNoCopy: (void *)items
+			   itemSize: (size_t)itemSize
+			      count: (size_t)count
+		       freeWhenDone: (bool)freeWhenDone OF_UNAVAILABLE;
++ (instancetype)dataWithContentsOfFile: (OFString *)path OF_UNAVAILABLE;
++ (instancetype)dataWithContentsOfURL: (OFURL *)URL OF_UNAVAILABLE;
++ (instancetype)dataWithStringRepresentation: (OFString *)string OF_UNAVAILABLE;
++ (instancetype)dataWithBase64EncodedString: (OFString *)string OF_UNAVAILABLE;
++ (instancetype)dataWithSerialization: (OFXMLElement *)element OF_UNAVAILABLE;
+
+/*!
+ * @brief Initializes an already allocated OFMappedData with the contents of
+ *	  the specified file.
+ *
+ * @param path The path of the file
+ * @return An initialized OFMappedData
+ */
+- (instancetype)initWithContentsOfMappedFile: (OFString *)path;
+
+/*!
+ * @brief Initializes an already allocated OFMappedData with the contents of
+ *	  the specified file.
+ *
+ * @param path The path of the file
+ * @param access A hint how the data is going to be accessed
+ * @return An initialized OFMappedData
+ */
+- (instancetype)initWithContentsOfMappedFile: (OFString *)path
+				      access: (of_mapped_data_access_t)access;
+
+- (instancetype)initWithItems: (const void *)items
+			count: (size_t)count OF_UNAVAILABLE;
+- (instancetype)initWithItems: (const void *)items
+		     itemSize: (size_t)itemSize
+			count: (size_t)count OF_UNAVAILABLE;
+- (instancetype)initWithItemsNoCopy: (void *)items
+			      count: (size_t)count
+		       freeWhenDone: (bool)freeWhenDone OF_UNAVAILABLE;
+- (instancetype)initWithItemsNoCopy: (void *)items
+			   itemSize: (size_t)itemSize
+			      count: (size_t)count
+		       freeWhenDone: (bool)freeWhenDone OF_UNAVAILABLE;
+- (instancetype)initWithContentsOfFile: (OFString *)path OF_UNAVAILABLE;
+- (instancetype)initWithContentsOfURL: (OFURL *)URL OF_UNAVAILABLE;
+- (instancetype)initWithStringRepresentation: (OFString *)string OF_UNAVAILABLE;
+- (instancetype)initWithBase64EncodedString: (OFString *)string OF_UNAVAILABLE;
+- (instancetype)initWithSerialization: (OFXMLElement *)element OF_UNAVAILABLE;
+
+/*!
+ * @brief Changes the hint how the data is going to be accessed.
+ *
+ * @param access A hint how the data is going to be accessed
+ * @param range The range of items the hint applies to
+ */
+- (void)adviseAccess: (of_mapped_data_access_t)access
+	     inRange: (of_range_t)range;
+@end
+
+OF_ASSUME_NONNULL_END
@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdlib.h>
+
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+
+#import "OFMappedData.h"
+#import "OFFile.h"
+#import "OFString.h"
+#import "OFSystemInfo.h"
+
+#import "OFInvalidArgumentException.h"
+#import "OFOutOfMemoryException.h"
+#import "OFOutOfRangeException.h"
+#import "OFReadFailedException.h"
+
+#if defined(HAVE_MMAP) && defined(OF_FILE_HANDLE_IS_FD)
+# define USE_MMAP
+#endif
+
+@implementation OFMappedData
++ (instancetype)dataWithContentsOfMappedFile: (OFString *)path
+{
+	return [[[self alloc] initWithContentsOfMappedFile: path] autorelease];
+}
+
++ (instancetype)dataWithContentsOfMappedFile: (OFString *)path
+				      access: (of_mapped_data_access_t)access
+{
+	return [[[self alloc]
+	    initWithContentsOfMappedFile: path
+				  access: access] autorelease];
+}
+
++ (instancetype)dataWithItems: (const void *)items
+			count: (size_t)count
+{
+	OF_UNRECOGNIZED_SELECTOR
+}
+
++ (instancetype)dataWithItems: (const void *)items
+		     itemSize: (size_t)itemSize
+			count: (size_t)count
+{
+	OF_UNRECOGNIZED_SELECTOR
+}
+
++ (instancetype)dataWithItemsNoCopy: (void *)items
+			      count: (size_t)count
+		       freeWhenDone: (bool)freeWhenDone
+{
+	OF_UNRECOGNIZED_SELECTOR
+}
+
++ (instancetype)dataWithItemsNoCopy: (void *)items
+			   itemSize: (size_t)itemSize
+			      count: (size_t)count
+		       freeWhenDone: (bool)freeWhenDone
+{
+	OF_UNRECOGNIZED_SELECTOR
+}
+
++ (instancetype)dataWithContentsOfFile: (OFString *)path
+{
+	OF_UNRECOGNIZED_SELECTOR
+}
+
++ (instancetype)dataWithContentsOfURL: (OFURL *)URL
+{
+	OF_UNRECOGNIZED_SELECTOR
+}
+
++ (instancetype)dataWithStringRepresentation: (OFString *)string
+{
+	OF_UNRECOGNIZED_SELECTOR
+}
+
++ (instancetype)dataWithBase64EncodedString: (OFString *)string
+{
+	OF_UNRECOGNIZED_SELECTOR
+}
+
++ (instancetype)dataWithSerialization: (OFXMLElement *)element
+{
+	OF_UNRECOGNIZED_SELECTOR
+}
+
+- (instancetype)initWithContentsOfMappedFile: (OFString *)path
+{
+	return [self
+	    initWithContentsOfMappedFile: path
+				  access: OF_MAPPED_DATA_ACCESS_NORMAL];
+}
+
+- (instancetype)initWithContentsOfMappedFile: (OFString *)path
+				      access: (of_mapped_data_access_t)access
+{
+	self = [super init];
+
+	@try {
+		OFFile *file = [[OFFile alloc] initWithPath: path
+						       mode: @"r"];
+
+		@try {
+			of_offset_t size = [file seekToOffset: 0
+						       whence: SEEK_END];
+
+			if (size < 0)
+				@throw [OFOutOfRangeException exception];
+#if UINTMAX_MAX > SIZE_MAX
+			if ((uintmax_t)size > SIZE_MAX)
+				@throw [OFOutOfRangeException exception];
+#endif
+
+			_itemSize = 1;
+			_count = (size_t)size;
+
+			/* An empty file cannot be mapped. */
+			if (_count > 0) {
+#ifdef USE_MMAP
+				void *items = mmap(NULL, _count, PROT_READ,
+				    MAP_SHARED, [file fileDescriptorForReading],
+				    0);
+
+				if (items == MAP_FAILED)
+					@throw [OFReadFailedException
+					    exceptionWithObject: file
+						requestedLength: _count
+							  errNo: errno];
+
+				_items = items;
+				_mappingSize = _count;
+#else
+				[file seekToOffset: 0
+					    whence: SEEK_SET];
+
+				if ((_items = malloc(_count)) == NULL)
+					@throw [OFOutOfMemoryException
+					    exceptionWithRequestedSize: _count];
+
+				_freeWhenDone = true;
+
+				[file readIntoBuffer: _items
+					 exactLength: _count];
+#endif
+			}
+		} @finally {
+			/* A mapping stays valid after closing the file. */
+			[file release];
+		}
+
+		[self adviseAccess: access
+			   inRange: of_range(0, _count)];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (instancetype)initWithItems: (const void *)items
+			count: (size_t)count
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithItems: (const void *)items
+		     itemSize: (size_t)itemSize
+			count: (size_t)count
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithItemsNoCopy: (void *)items
+			      count: (size_t)count
+		       freeWhenDone: (bool)freeWhenDone
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithItemsNoCopy: (void *)items
+			   itemSize: (size_t)itemSize
+			      count: (size_t)count
+		       freeWhenDone: (bool)freeWhenDone
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithContentsOfFile: (OFString *)path
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithContentsOfURL: (OFURL *)URL
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithStringRepresentation: (OFString *)string
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithBase64EncodedString: (OFString *)string
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithSerialization: (OFXMLElement *)element
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (void)dealloc
+{
+#ifdef USE_MMAP
+	if (_mappingSize > 0)
+		munmap(_items, _mappingSize);
+#endif
+
+	[super dealloc];
+}
+
+- (void)adviseAccess: (of_mapped_data_access_t)access
+	     inRange: (of_range_t)range
+{
+#if defined(USE_MMAP) && defined(HAVE_MADVISE)
+	size_t pageSize, offset;
+	int advice;
+#endif
+
+	if (range.length > SIZE_MAX - range.location ||
+	    range.location + range.length > _count)
+		@throw [OFOutOfRangeException exception];
+
+	if (access != OF_MAPPED_DATA_ACCESS_NORMAL &&
+	    access != OF_MAPPED_DATA_ACCESS_SEQUENTIAL &&
+	    access != OF_MAPPED_DATA_ACCESS_RANDOM &&
+	    access != OF_MAPPED_DATA_ACCESS_WILL_NEED)
+		@throw [OFInvalidArgumentException exception];
+
+#if defined(USE_MMAP) && defined(HAVE_MADVISE)
+	if (_mappingSize == 0 || range.length == 0)
+		return;
+
+	switch (access) {
+	case OF_MAPPED_DATA_ACCESS_SEQUENTIAL:
+		advice = MADV_SEQUENTIAL;
+		break;
+	case OF_MAPPED_DATA_ACCESS_RANDOM:
+		advice = MADV_RANDOM;
+		break;
+	case OF_MAPPED_DATA_ACCESS_WILL_NEED:
+		advice = MADV_WILLNEED;
+		break;
+	default:
+		advice = MADV_NORMAL;
+		break;
+	}
+
+	/* madvise() requires the address to be page aligned. */
+	pageSize = [OFSystemInfo pageSize];
+	offset = range.location % pageSize;
+
+	/* This is only a hint, so failing is not an error. */
+	madvise((char *)_items + range.location - offset,
+	    range.length + offset, advice);
+#endif
+}
+@end
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFSeekableStream.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+@class OFData;
+
+/*!
+ * @class OFMemoryStream OFMemoryStream.h ObjFW/OFMemoryStream.h
+ *
+ * @brief A class for reading the contents of an @ref OFData as a stream.
+ *
+ * This is useful to pass data that is already in memory, e.g. an
+ * @ref OFMappedData, to APIs that expect a stream, e.g. @ref OFZIPArchive.
+ */
+@interface OFMemoryStream: OFSeekableStream
+{
+	OFData *_Nullable _data;
+	const unsigned char *_Nullable _items;
+	size_t _size, _position;
+}
+
+/*!
+ * @brief Creates a new OFMemoryStream with the specified data.
+ *
+ * @param data The data to read from. The data is copied, which does not
+ *	       copy immutable data.
+ * @return A new autoreleased OFMemoryStream
+ */
++ (instancetype)streamWithData: (OFData *)data;
+
+- (instancetype)init OF_UNAVAILABLE;
+
+/*!
+ * @brief Initializes an already allocated OFMemoryStream with the specified
+ *	  data.
+ *
+ * @param data The data to read from. The data is copied, which does not
+ *	       copy immutable data.
+ * @return An initialized OFMemoryStream
+ */
+- (instancetype)initWithData: (OFData *)data OF_DESIGNATED_INITIALIZER;
+@end
+
+OF_ASSUME_NONNULL_END
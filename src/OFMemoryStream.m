@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <string.h>
+
+#import "OFMemoryStream.h"
+#import "OFData.h"
+
+#import "OFNotOpenException.h"
+#import "OFSeekFailedException.h"
+
+@implementation OFMemoryStream
++ (instancetype)streamWithData: (OFData *)data
+{
+	return [[[self alloc] initWithData: data] autorelease];
+}
+
+- (instancetype)init
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithData: (OFData *)data
+{
+	self = [super init];
+
+	@try {
+		/* Mutable data could be resized, which moves its items. */
+		_data = [data copy];
+		_items = [_data items];
+		_size = [_data count] * [_data itemSize];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	if (_data != nil)
+		[self close];
+
+	[super dealloc];
+}
+
+- (bool)lowlevelIsAtEndOfStream
+{
+	if (_data == nil)
+		@throw [OFNotOpenException exceptionWithObject: self];
+
+	return (_position == _size);
+}
+
+- (size_t)lowlevelReadIntoBuffer: (void *)buffer
+			  length: (size_t)length
+{
+	if (_data == nil)
+		@throw [OFNotOpenException exceptionWithObject: self];
+
+	if (length > _size - _position)
+		length = _size - _position;
+
+	memcpy(buffer, _items + _position, length);
+	_position += length;
+
+	return length;
+}
+
+- (of_offset_t)lowlevelSeekToOffset: (of_offset_t)offset
+			     whence: (int)whence
+{
+	of_offset_t base;
+
+	if (_data == nil)
+		@throw [OFNotOpenException exceptionWithObject: self];
+
+	switch (whence) {
+	case SEEK_SET:
+		base = 0;
+		break;
+	case SEEK_CUR:
+		base = (of_offset_t)_position;
+		break;
+	case SEEK_END:
+		base = (of_offset_t)_size;
+		break;
+	default:
+		@throw [OFSeekFailedException exceptionWithStream: self
+							   offset: offset
+							   whence: whence
+							    errNo: EINVAL];
+	}
+
+	/* Seeking beyond the end is not possible, as the data is read-only. */
+	if (offset < -base || offset > (of_offset_t)_size - base)
+		@throw [OFSeekFailedException exceptionWithStream: self
+							   offset: offset
+							   whence: whence
+							    errNo: EINVAL];
+
+	_position = (size_t)(base + offset);
+
+	return (of_offset_t)_position;
+}
+
+- (void)close
+{
+	if (_data == nil)
+		@throw [OFNotOpenException exceptionWithObject: self];
+
+	[_data release];
+	_data = nil;
+	_items = NULL;
+
+	[super close];
+}
+@end
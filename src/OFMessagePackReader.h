@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFObject.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+@class OFData;
+@class OFMessagePackReader;
+@class OFMutableData;
+@class OFStream;
+
+#ifdef OF_HAVE_SOCKETS
+/*!
+ * @protocol OFMessagePackReaderDelegate
+ *	     OFMessagePackReader.h ObjFW/OFMessagePackReader.h
+ *
+ * @brief A protocol that needs to be implemented by delegates for
+ *	  OFMessagePackReader.
+ */
+@protocol OFMessagePackReaderDelegate <OFObject>
+/*!
+ * @brief This method is called when an object was read asynchronously.
+ *
+ * @param reader The reader which read an object
+ * @param object The object which has been read or `nil` when the end of the
+ *		 stream occurred
+ * @param exception An exception that occurred while reading, or nil on success
+ * @return A bool whether the reader should read the next object
+ */
+- (bool)reader: (OFMessagePackReader *)reader
+  didReadObject: (nullable id)object
+      exception: (nullable id)exception;
+@end
+#endif
+
+/*!
+ * @class OFMessagePackReader OFMessagePackReader.h ObjFW/OFMessagePackReader.h
+ *
+ * @brief A class for reading objects in MessagePack representation from a
+ *	  stream.
+ *
+ * The stream can contain any number of objects one after another. Objects are
+ * read incrementally, so it does not matter how the data is split into reads.
+ * The bytes of an object are only scanned once while waiting for it to be
+ * complete, independent of how many reads it took.
+ *
+ * Unlike @ref OFData::messagePackValue, bin and ext payloads are not copied.
+ * Instead, they are returned as subdata of the buffer the reader read the
+ * object into. Note that this means that the buffer is kept alive for as long
+ * as any of them is.
+ */
+@interface OFMessagePackReader: OFObject
+{
+	OFStream *_stream;
+	size_t _depthLimit;
+#ifdef OF_HAVE_SOCKETS
+	id <OFMessagePackReaderDelegate> _Nullable _delegate;
+#endif
+	OFData *_Nullable _chunk;
+	unsigned char *_Nullable _buffer;
+	size_t _size, _length, _start, _scanned, _needed;
+	OFMutableData *_pending;
+	bool _objectHasSubdata, _chunkHandedOut;
+}
+
+/*!
+ * @brief The stream the objects are read from.
+ */
+@property (readonly, nonatomic) OFStream *stream;
+
+/*!
+ * @brief The maximum depth of nested arrays and maps the reader accepts.
+ *
+ * Defaults to 32. 0 means no limit (insecure!).
+ */
+@property (nonatomic) size_t depthLimit;
+
+#ifdef OF_HAVE_SOCKETS
+/*!
+ * @brief The delegate for asynchronous reads.
+ */
+@property OF_NULLABLE_PROPERTY (assign, nonatomic)
+    id <OFMessagePackReaderDelegate> delegate;
+#endif
+
+/*!
+ * @brief Creates a new MessagePack reader for the specified stream.
+ *
+ * @param stream The stream to read MessagePack from
+ * @return A new, autoreleased OFMessagePackReader
+ */
++ (instancetype)readerWithStream: (OFStream *)stream;
+
+- (instancetype)init OF_UNAVAILABLE;
+
+/*!
+ * @brief Initializes an already allocated MessagePack reader for the
+ *	  specified stream.
+ *
+ * @param stream The stream to read MessagePack from
+ * @return An initialized OFMessagePackReader
+ */
+- (instancetype)initWithStream: (OFStream *)stream OF_DESIGNATED_INITIALIZER;
+
+/*!
+ * @brief Reads the next object from the stream.
+ *
+ * This blocks until a complete object has been read.
+ *
+ * @return The object which has been read or `nil` if the stream ended after
+ *	   the last object
+ * @throw OFTruncatedDataException The stream ended in the middle of an object
+ */
+- (nullable id)readObject;
+
+#ifdef OF_HAVE_SOCKETS
+/*!
+ * @brief Asynchronously reads the next object from the stream.
+ *
+ * The object is passed to the delegate once it is complete. The delegate of
+ * the stream is not changed.
+ *
+ * @note The stream must conform to @ref OFReadyForReadingObserving in order
+ *	 for this to work!
+ */
+- (void)asyncReadObject;
+#endif
+@end
+
+OF_ASSUME_NONNULL_END
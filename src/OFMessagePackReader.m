@@ -0,0 +1,503 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#import "OFMessagePackReader.h"
+#import "OFData.h"
+#import "OFData+MessagePackValue+Private.h"
+#import "OFStream.h"
+#ifdef OF_HAVE_SOCKETS
+# import "OFRunLoop+Private.h"
+#endif
+
+#import "OFInvalidFormatException.h"
+#import "OFOutOfMemoryException.h"
+#import "OFOutOfRangeException.h"
+#import "OFTruncatedDataException.h"
+
+#define BUFFER_SIZE 4096
+
+@interface OFMessagePackReader ()
+- (bool)of_scanObject;
+- (id)of_takeObject;
+- (void)of_prepareRead;
+@end
+
+#ifdef OF_HAVE_SOCKETS
+@interface OFMessagePackReader () <OFStreamDelegate>
+- (void)of_asyncRead;
+- (void)of_deliverObject;
+@end
+#endif
+
+static uint16_t
+readUInt16(const unsigned char *buffer)
+{
+	return ((uint16_t)buffer[0] << 8) | buffer[1];
+}
+
+static uint32_t
+readUInt32(const unsigned char *buffer)
+{
+	return ((uint32_t)buffer[0] << 24) | ((uint32_t)buffer[1] << 16) |
+	    ((uint32_t)buffer[2] << 8) | buffer[3];
+}
+
+/* Returns whether the type has a payload that is returned as subdata. */
+static OF_INLINE bool
+isBinOrExt(unsigned char type)
+{
+	return ((type >= 0xC4 && type <= 0xC9) ||
+	    (type >= 0xD4 && type <= 0xD8));
+}
+
+/*
+ * Determines how many bytes the object starting at buffer takes, not counting
+ * its children, and how many children follow it. Returns false if the buffer
+ * does not contain all of these bytes yet, in which case length is set to the
+ * number of bytes that are needed at least.
+ */
+static bool
+scanHeader(const unsigned char *buffer, size_t *length, uint64_t *children,
+    bool *isContainer)
+{
+	size_t available = *length;
+	size_t headerLength;
+	uint64_t payloadLength = 0;
+
+	*children = 0;
+	*isContainer = false;
+
+	/* positive fixint, negative fixint */
+	if ((buffer[0] & 0x80) == 0 || (buffer[0] & 0xE0) == 0xE0)
+		headerLength = 1;
+	/* fixstr */
+	else if ((buffer[0] & 0xE0) == 0xA0) {
+		headerLength = 1;
+		payloadLength = buffer[0] & 0x1F;
+	/* fixarray */
+	} else if ((buffer[0] & 0xF0) == 0x90) {
+		headerLength = 1;
+		*children = buffer[0] & 0xF;
+		*isContainer = true;
+	/* fixmap */
+	} else if ((buffer[0] & 0xF0) == 0x80) {
+		headerLength = 1;
+		*children = 2 * (buffer[0] & 0xF);
+		*isContainer = true;
+	} else {
+		switch (buffer[0]) {
+		case 0xC0: /* nil */
+		case 0xC2: /* false */
+		case 0xC3: /* true */
+			headerLength = 1;
+			break;
+		case 0xCC: /* uint 8 */
+		case 0xD0: /* int 8 */
+			headerLength = 2;
+			break;
+		case 0xCD: /* uint 16 */
+		case 0xD1: /* int 16 */
+			headerLength = 3;
+			break;
+		case 0xCA: /* float 32 */
+		case 0xCE: /* uint 32 */
+		case 0xD2: /* int 32 */
+			headerLength = 5;
+			break;
+		case 0xCB: /* float 64 */
+		case 0xCF: /* uint 64 */
+		case 0xD3: /* int 64 */
+			headerLength = 9;
+			break;
+		case 0xD4: /* fixext 1 */
+			headerLength = 3;
+			break;
+		case 0xD5: /* fixext 2 */
+			headerLength = 4;
+			break;
+		case 0xD6: /* fixext 4 */
+			headerLength = 6;
+			break;
+		case 0xD7: /* fixext 8 */
+			headerLength = 10;
+			break;
+		case 0xD8: /* fixext 16 */
+			headerLength = 18;
+			break;
+		case 0xC4: /* bin 8 */
+		case 0xD9: /* str 8 */
+			headerLength = 2;
+			if (available >= 2)
+				payloadLength = buffer[1];
+			break;
+		case 0xC5: /* bin 16 */
+		case 0xDA: /* str 16 */
+			headerLength = 3;
+			if (available >= 3)
+				payloadLength = readUInt16(buffer + 1);
+			break;
+		case 0xC6: /* bin 32 */
+		case 0xDB: /* str 32 */
+			headerLength = 5;
+			if (available >= 5)
+				payloadLength = readUInt32(buffer + 1);
+			break;
+		case 0xC7: /* ext 8 */
+			headerLength = 3;
+			if (available >= 2)
+				payloadLength = buffer[1];
+			break;
+		case 0xC8: /* ext 16 */
+			headerLength = 4;
+			if (available >= 3)
+				payloadLength = readUInt16(buffer + 1);
+			break;
+		case 0xC9: /* ext 32 */
+			headerLength = 6;
+			if (available >= 5)
+				payloadLength = readUInt32(buffer + 1);
+			break;
+		case 0xDC: /* array 16 */
+			headerLength = 3;
+			if (available >= 3)
+				*children = readUInt16(buffer + 1);
+			*isContainer = true;
+			break;
+		case 0xDD: /* array 32 */
+			headerLength = 5;
+			if (available >= 5)
+				*children = readUInt32(buffer + 1);
+			*isContainer = true;
+			break;
+		case 0xDE: /* map 16 */
+			headerLength = 3;
+			if (available >= 3)
+				*children =
+				    2 * (uint64_t)readUInt16(buffer + 1);
+			*isContainer = true;
+			break;
+		case 0xDF: /* map 32 */
+			headerLength = 5;
+			if (available >= 5)
+				*children =
+				    2 * (uint64_t)readUInt32(buffer + 1);
+			*isContainer = true;
+			break;
+		default:
+			@throw [OFInvalidFormatException exception];
+		}
+	}
+
+	if (available < headerLength) {
+		*length = headerLength;
+		return false;
+	}
+
+	if (payloadLength > SIZE_MAX - headerLength)
+		@throw [OFOutOfRangeException exception];
+
+	*length = headerLength + (size_t)payloadLength;
+
+	return (available >= *length);
+}
+
+@implementation OFMessagePackReader
+@synthesize stream = _stream, depthLimit = _depthLimit;
+#ifdef OF_HAVE_SOCKETS
+@synthesize delegate = _delegate;
+#endif
+
++ (instancetype)readerWithStream: (OFStream *)stream
+{
+	return [[[self alloc] initWithStream: stream] autorelease];
+}
+
+- (instancetype)init
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithStream: (OFStream *)stream
+{
+	self = [super init];
+
+	@try {
+		_stream = [stream retain];
+		_depthLimit = 32;
+		_pending = [[OFMutableData alloc]
+		    initWithItemSize: sizeof(uint64_t)];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_stream release];
+	[_chunk release];
+	[_pending release];
+
+	[super dealloc];
+}
+
+/*
+ * Scans the buffered data for the end of the current object without creating
+ * any objects. The scan continues where it stopped last time, so that every
+ * byte is only looked at once, no matter how many reads an object takes.
+ * Returns true once the object from _start to _scanned is complete.
+ */
+- (bool)of_scanObject
+{
+	while (_scanned < _length) {
+		size_t length = _length - _scanned;
+		uint64_t children, *remaining;
+		bool isContainer;
+
+		if (!scanHeader(_buffer + _scanned, &length, &children,
+		    &isContainer)) {
+			_needed = _scanned - _start + length;
+			return false;
+		}
+
+		if (isBinOrExt(_buffer[_scanned]))
+			_objectHasSubdata = true;
+
+		_scanned += length;
+
+		if (isContainer) {
+			if (_depthLimit != 0 &&
+			    [_pending count] + 1 >= _depthLimit)
+				@throw [OFOutOfRangeException exception];
+
+			if (children > 0) {
+				[_pending addItem: &children];
+				continue;
+			}
+		}
+
+		/* The object is complete, which might complete its parents */
+		while ((remaining = [_pending lastItem]) != NULL) {
+			if (--*remaining > 0)
+				break;
+
+			[_pending removeLastItem];
+		}
+
+		if (remaining == NULL) {
+			_needed = 0;
+			return true;
+		}
+	}
+
+	_needed = _scanned - _start + 1;
+	return false;
+}
+
+- (id)of_takeObject
+{
+	size_t start = _start, length = _scanned - _start;
+	id object;
+
+	/* Skip the object even if it turns out to be invalid */
+	_start = _scanned;
+
+	/*
+	 * Subdata of _chunk is handed out, so the bytes of _chunk must not be
+	 * overwritten anymore.
+	 */
+	if (_objectHasSubdata)
+		_chunkHandedOut = true;
+	_objectHasSubdata = false;
+
+	if (of_message_pack_parse_object(_buffer + start, length, &object,
+	    _depthLimit, _chunk) != length)
+		@throw [OFInvalidFormatException exception];
+
+	return object;
+}
+
+/*
+ * Makes sure there is space left in the buffer to read into. The buffer is
+ * wrapped in an OFData so that bin and ext payloads can be returned as subdata
+ * of it. Everything after _start has not been handed out, so it can still be
+ * written to. Once subdata of the buffer has been handed out, a new buffer is
+ * used instead of moving the bytes of the current object to the front.
+ */
+- (void)of_prepareRead
+{
+	size_t pending = _length - _start;
+	size_t size = (_size > 0 ? _size : BUFFER_SIZE);
+	unsigned char *buffer;
+	OFData *chunk;
+
+	if (_length < _size && _needed <= _size - _start)
+		return;
+
+	if (_needed > size) {
+		if (size <= SIZE_MAX / 2)
+			size *= 2;
+
+		if (size < _needed)
+			size = _needed;
+	}
+
+	if (size == _size && !_chunkHandedOut) {
+		memmove(_buffer, _buffer + _start, pending);
+	} else {
+		if ((buffer = malloc(size)) == NULL)
+			@throw [OFOutOfMemoryException
+			    exceptionWithRequestedSize: size];
+
+		@try {
+			chunk = [[OFData alloc] initWithItemsNoCopy: buffer
+							      count: size
+						       freeWhenDone: true];
+		} @catch (id e) {
+			free(buffer);
+			@throw e;
+		}
+
+		if (pending > 0)
+			memcpy(buffer, _buffer + _start, pending);
+
+		[_chunk release];
+		_chunk = chunk;
+		_chunkHandedOut = false;
+		_buffer = buffer;
+		_size = size;
+	}
+
+	_scanned -= _start;
+	_length = pending;
+	_start = 0;
+}
+
+- (id)readObject
+{
+	for (;;) {
+		if ([self of_scanObject])
+			return [self of_takeObject];
+
+		if ([_stream isAtEndOfStream]) {
+			if (_length == _start)
+				return nil;
+
+			@throw [OFTruncatedDataException exception];
+		}
+
+		[self of_prepareRead];
+
+		_length += [_stream readIntoBuffer: _buffer + _length
+					    length: _size - _length];
+	}
+}
+
+#ifdef OF_HAVE_SOCKETS
+- (void)asyncReadObject
+{
+	if ([self of_scanObject]) {
+		[self performSelector: @selector(of_deliverObject)
+			   afterDelay: 0];
+		return;
+	}
+
+	[self of_prepareRead];
+	[self of_asyncRead];
+}
+
+- (void)of_asyncRead
+{
+	OFStream <OFReadyForReadingObserving> *stream =
+	    (OFStream <OFReadyForReadingObserving> *)_stream;
+
+	/*
+	 * The reader is passed as the delegate of the read instead of
+	 * becoming the delegate of the stream, so the delegate of the stream
+	 * is left alone. The run loop retains the reader until the read is
+	 * done.
+	 */
+	[OFRunLoop of_addAsyncReadForStream: stream
+				     buffer: _buffer + _length
+				     length: _size - _length
+				       mode: of_run_loop_mode_default
+# ifdef OF_HAVE_BLOCKS
+				      block: NULL
+# endif
+				   delegate: self];
+}
+
+- (void)of_deliverObject
+{
+	id object = nil, exception = nil;
+
+	@try {
+		object = [self of_takeObject];
+	} @catch (id e) {
+		exception = e;
+	}
+
+	if ([_delegate reader: self
+		didReadObject: object
+		    exception: exception] && object != nil)
+		[self asyncReadObject];
+}
+
+-      (bool)stream: (OFStream *)stream
+  didReadIntoBuffer: (void *)buffer
+	     length: (size_t)length
+	  exception: (id)exception
+{
+	id object = nil;
+
+	if (exception == nil) {
+		_length += length;
+
+		@try {
+			if ([self of_scanObject])
+				object = [self of_takeObject];
+			else if (![_stream isAtEndOfStream]) {
+				/*
+				 * The buffer might move, so a new read needs
+				 * to be started instead of repeating this one.
+				 */
+				[self of_prepareRead];
+				[self of_asyncRead];
+				return false;
+			} else if (_length != _start)
+				@throw [OFTruncatedDataException exception];
+		} @catch (id e) {
+			exception = e;
+		}
+	}
+
+	if ([_delegate reader: self
+		didReadObject: object
+		    exception: exception] && object != nil)
+		[self asyncReadObject];
+
+	return false;
+}
+#endif
+@end
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFObject.h"
+#import "OFMessagePackRepresentation.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+@class OFMutableData;
+@class OFStream;
+
+/*!
+ * @class OFMessagePackWriter OFMessagePackWriter.h ObjFW/OFMessagePackWriter.h
+ *
+ * @brief A class for writing MessagePack directly into a stream.
+ *
+ * In contrast to @ref OFMessagePackRepresentation::messagePackRepresentation,
+ * the MessagePack representation is written incrementally into the stream
+ * instead of being built in memory first. The written bytes are exactly the
+ * same as the MessagePack representation. Payloads of large strings and data
+ * are written to the stream directly without being copied.
+ *
+ * Values can either be written as a whole using @ref writeObject: or piece by
+ * piece using @ref startArrayWithCount: and @ref startMapWithCount:, which
+ * makes it possible to write arrays and maps that are never completely in
+ * memory.
+ *
+ * The output is buffered and written to the stream whenever the buffer is full,
+ * whenever a top-level value has been completely written, when @ref flush is
+ * called and when the writer is deallocated.
+ */
+@interface OFMessagePackWriter: OFObject
+{
+	OFStream *_stream;
+	char *_buffer;
+	size_t _bufferLength;
+	OFMutableData *_pending;
+}
+
+/*!
+ * @brief The stream the MessagePack is written to.
+ */
+@property (readonly, nonatomic) OFStream *stream;
+
+/*!
+ * @brief Creates a new MessagePack writer for the specified stream.
+ *
+ * @param stream The stream to write MessagePack to
+ * @return A new, autoreleased OFMessagePackWriter
+ */
++ (instancetype)writerWithStream: (OFStream *)stream;
+
+- (instancetype)init OF_UNAVAILABLE;
+
+/*!
+ * @brief Initializes an already allocated MessagePack writer for the
+ *	  specified stream.
+ *
+ * @param stream The stream to write MessagePack to
+ * @return An initialized OFMessagePackWriter
+ */
+- (instancetype)initWithStream: (OFStream *)stream OF_DESIGNATED_INITIALIZER;
+
+/*!
+ * @brief Writes the specified object.
+ *
+ * @param object The object to write
+ */
+- (void)writeObject: (id <OFMessagePackRepresentation>)object;
+
+/*!
+ * @brief Starts an array with the specified number of elements.
+ *
+ * The following count values are written as the elements of the array.
+ *
+ * @param count The number of elements of the array
+ */
+- (void)startArrayWithCount: (size_t)count;
+
+/*!
+ * @brief Starts a map with the specified number of entries.
+ *
+ * The following 2 * count values are written as the keys and values of the
+ * map, alternating between a key and its value.
+ *
+ * @param count The number of entries of the map
+ */
+- (void)startMapWithCount: (size_t)count;
+
+/*!
+ * @brief Writes all buffered output to the stream.
+ *
+ * This is done automatically after each top-level value, so it is only needed
+ * to make a partially written value visible in the stream.
+ */
+- (void)flush;
+@end
+
+OF_ASSUME_NONNULL_END
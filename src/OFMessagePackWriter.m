@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "OFMessagePackWriter.h"
+#import "OFArray.h"
+#import "OFData.h"
+#import "OFDictionary.h"
+#import "OFSecureData.h"
+#import "OFStream.h"
+#import "OFString.h"
+
+#import "OFInvalidArgumentException.h"
+#import "OFOutOfRangeException.h"
+
+#define BUFFER_SIZE 4096
+
+@interface OFMessagePackWriter ()
+- (void)of_writeBuffer: (const void *)buffer
+		length: (size_t)length;
+- (void)of_writeHeaderWithFixType: (uint8_t)fixType
+			   fixMax: (size_t)fixMax
+			    type8: (uint8_t)type8
+			   type16: (uint8_t)type16
+			   type32: (uint8_t)type32
+			   length: (size_t)length;
+- (void)of_endValue;
+@end
+
+@implementation OFMessagePackWriter
+@synthesize stream = _stream;
+
++ (instancetype)writerWithStream: (OFStream *)stream
+{
+	return [[[self alloc] initWithStream: stream] autorelease];
+}
+
+- (instancetype)init
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithStream: (OFStream *)stream
+{
+	self = [super init];
+
+	@try {
+		_stream = [stream retain];
+		_buffer = [self allocMemoryWithSize: BUFFER_SIZE];
+		_pending = [[OFMutableData alloc]
+		    initWithItemSize: sizeof(uint64_t)];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	/*
+	 * Write what is still buffered, e.g. an unfinished top-level value.
+	 * There is no way to report an error from here, so it is ignored.
+	 */
+	@try {
+		[self flush];
+	} @catch (id e) {
+	}
+
+	[_stream release];
+	[_pending release];
+
+	[super dealloc];
+}
+
+- (void)flush
+{
+	if (_bufferLength == 0)
+		return;
+
+	[_stream writeBuffer: _buffer
+		      length: _bufferLength];
+	_bufferLength = 0;
+}
+
+- (void)of_writeBuffer: (const void *)buffer
+		length: (size_t)length
+{
+	/* Large payloads are written directly instead of being copied */
+	if (length >= BUFFER_SIZE) {
+		[self flush];
+		[_stream writeBuffer: buffer
+			      length: length];
+		return;
+	}
+
+	if (length > BUFFER_SIZE - _bufferLength)
+		[self flush];
+
+	memcpy(_buffer + _bufferLength, buffer, length);
+	_bufferLength += length;
+}
+
+/*
+ * Writes the type and length of a string, bin, array or map. Lengths up to
+ * fixMax are encoded in the type byte if fixType is not 0. Types without an
+ * 8 bit length are indicated by type8 being 0.
+ */
+- (void)of_writeHeaderWithFixType: (uint8_t)fixType
+			   fixMax: (size_t)fixMax
+			    type8: (uint8_t)type8
+			   type16: (uint8_t)type16
+			   type32: (uint8_t)type32
+			   length: (size_t)length
+{
+	unsigned char header[5];
+	size_t headerLength;
+
+	if (fixType != 0 && length <= fixMax) {
+		header[0] = fixType | (uint8_t)length;
+		headerLength = 1;
+	} else if (type8 != 0 && length <= UINT8_MAX) {
+		header[0] = type8;
+		header[1] = (uint8_t)length;
+		headerLength = 2;
+	} else if (length <= UINT16_MAX) {
+		header[0] = type16;
+		header[1] = (uint8_t)(length >> 8);
+		header[2] = (uint8_t)length;
+		headerLength = 3;
+	} else if (length <= UINT32_MAX) {
+		header[0] = type32;
+		header[1] = (uint8_t)(length >> 24);
+		header[2] = (uint8_t)(length >> 16);
+		header[3] = (uint8_t)(length >> 8);
+		header[4] = (uint8_t)length;
+		headerLength = 5;
+	} else
+		@throw [OFOutOfRangeException exception];
+
+	[self of_writeBuffer: header
+		      length: headerLength];
+}
+
+- (void)of_endValue
+{
+	uint64_t *remaining;
+
+	while ((remaining = [_pending lastItem]) != NULL) {
+		if (--*remaining > 0)
+			return;
+
+		[_pending removeLastItem];
+	}
+
+	[self flush];
+}
+
+- (void)writeObject: (id <OFMessagePackRepresentation>)object
+{
+	void *pool = objc_autoreleasePoolPush();
+
+	if ([(id)object isKindOfClass: [OFString class]]) {
+		OFString *string = (OFString *)object;
+		size_t length = [string UTF8StringLength];
+
+		[self of_writeHeaderWithFixType: 0xA0
+					 fixMax: 31
+					  type8: 0xD9
+					 type16: 0xDA
+					 type32: 0xDB
+					 length: length];
+		[self of_writeBuffer: [string UTF8String]
+			      length: length];
+		[self of_endValue];
+	} else if ([(id)object isKindOfClass: [OFData class]] &&
+	    ![(id)object isKindOfClass: [OFSecureData class]]) {
+		OFData *data = (OFData *)object;
+
+		if ([data itemSize] != 1)
+			@throw [OFInvalidArgumentException exception];
+
+		[self of_writeHeaderWithFixType: 0
+					 fixMax: 0
+					  type8: 0xC4
+					 type16: 0xC5
+					 type32: 0xC6
+					 length: [data count]];
+		[self of_writeBuffer: [data items]
+			      length: [data count]];
+		[self of_endValue];
+	} else if ([(id)object isKindOfClass: [OFArray class]]) {
+		[self startArrayWithCount: [(OFArray *)object count]];
+
+		for (id element in (OFArray *)object) {
+			void *pool2 = objc_autoreleasePoolPush();
+
+			[self writeObject: element];
+
+			objc_autoreleasePoolPop(pool2);
+		}
+	} else if ([(id)object isKindOfClass: [OFDictionary class]]) {
+		OFDictionary *dictionary = (OFDictionary *)object;
+		OFEnumerator *keyEnumerator = [dictionary keyEnumerator];
+		OFEnumerator *objectEnumerator = [dictionary objectEnumerator];
+		id key, value;
+
+		[self startMapWithCount: [dictionary count]];
+
+		while ((key = [keyEnumerator nextObject]) != nil &&
+		    (value = [objectEnumerator nextObject]) != nil) {
+			void *pool2 = objc_autoreleasePoolPush();
+
+			[self writeObject: key];
+			[self writeObject: value];
+
+			objc_autoreleasePoolPop(pool2);
+		}
+	} else {
+		/*
+		 * This also handles OFSecureData, which refuses to be
+		 * serialized.
+		 */
+		OFData *data = [object messagePackRepresentation];
+
+		[self of_writeBuffer: [data items]
+			      length: [data count]];
+		[self of_endValue];
+	}
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (void)startArrayWithCount: (size_t)count
+{
+	uint64_t remaining = count;
+
+	[self of_writeHeaderWithFixType: 0x90
+				 fixMax: 15
+				  type8: 0
+				 type16: 0xDC
+				 type32: 0xDD
+				 length: count];
+
+	if (remaining > 0)
+		[_pending addItem: &remaining];
+	else
+		[self of_endValue];
+}
+
+- (void)startMapWithCount: (size_t)count
+{
+	uint64_t remaining = 2 * (uint64_t)count;
+
+	[self of_writeHeaderWithFixType: 0x80
+				 fixMax: 15
+				  type8: 0
+				 type16: 0xDE
+				 type32: 0xDF
+				 length: count];
+
+	if (remaining > 0)
+		[_pending addItem: &remaining];
+	else
+		[self of_endValue];
+}
+@end
@@ -150,6 +150,23 @@ OF_ASSUME_NONNULL_BEGIN
  */
 - (void)increaseCountBy: (size_t)count;
 
+/*!
+ * @brief Makes sure the OFMutableData can hold at least the specified number of
+ *	  items without having to reallocate its memory.
+ *
+ * @param capacity The number of items the OFMutableData should be able to hold
+ */
+- (void)reserveCapacity: (size_t)capacity;
+
+/*!
+ * @brief Frees all memory that is not needed to hold the current items.
+ *
+ * As the OFMutableData grows geometrically when items are added, it usually
+ * holds more memory than needed. This can be used to release it once no more
+ * items will be added.
+ */
+- (void)shrinkToFit;
+
 /*!
  * @brief Removes the item at the specified index.
  *
@@ -28,6 +28,13 @@
 #import "OFOutOfMemoryException.h"
 #import "OFOutOfRangeException.h"
 
+#define MIN_CAPACITY 16
+
+@interface OFMutableData ()
+- (void)of_growToCount: (size_t)count;
+- (void)of_shrinkIfSparse;
+@end
+
 @implementation OFMutableData
 + (instancetype)data
 {
@@ -153,17 +160,89 @@
 			       count: range.length];
 }
 
-- (void)addItem: (const void *)item
+- (void)of_growToCount: (size_t)count
 {
-	if (SIZE_MAX - _count < 1)
-		@throw [OFOutOfRangeException exception];
+	size_t capacity = _capacity;
+
+	/*
+	 * Grow by 50% at a time so that appending items one by one only needs
+	 * a logarithmic number of reallocations.
+	 */
+	if (capacity < MIN_CAPACITY)
+		capacity = MIN_CAPACITY;
+
+	while (capacity < count) {
+		if (capacity > SIZE_MAX / 3 * 2) {
+			capacity = count;
+			break;
+		}
+
+		capacity += capacity / 2;
+	}
+
+	[self reserveCapacity: capacity];
+}
 
-	if (_count + 1 > _capacity) {
+- (void)of_shrinkIfSparse
+{
+	/*
+	 * Only give memory back once less than a quarter is used, so that
+	 * alternating between adding and removing items does not cause a
+	 * reallocation every time.
+	 */
+	if (_count >= _capacity / 4 || _capacity <= MIN_CAPACITY)
+		return;
+
+	@try {
 		_items = [self resizeMemory: _items
 				       size: _itemSize
-				      count: _count + 1];
-		_capacity = _count + 1;
+				      count: _capacity / 2];
+		_capacity /= 2;
+	} @catch (OFOutOfMemoryException *e) {
+		/* We don't care, as we only made it smaller */
 	}
+}
+
+- (void)reserveCapacity: (size_t)capacity
+{
+	if (capacity <= _capacity)
+		return;
+
+	_items = [self resizeMemory: _items
+			       size: _itemSize
+			      count: capacity];
+	_capacity = capacity;
+}
+
+- (void)shrinkToFit
+{
+	if (_count == _capacity)
+		return;
+
+	if (_count == 0) {
+		[self freeMemory: _items];
+		_items = NULL;
+		_capacity = 0;
+		return;
+	}
+
+	@try {
+		_items = [self resizeMemory: _items
+				       size: _itemSize
+				      count: _count];
+		_capacity = _count;
+	} @catch (OFOutOfMemoryException *e) {
+		/* We don't care, as we only made it smaller */
+	}
+}
+
+- (void)addItem: (const void *)item
+{
+	if (SIZE_MAX - _count < 1)
+		@throw [OFOutOfRangeException exception];
+
+	if (_count + 1 > _capacity)
+		[self of_growToCount: _count + 1];
 
 	memcpy(_items + _count * _itemSize, item, _itemSize);
 
@@ -184,12 +263,8 @@
 	if (count > SIZE_MAX - _count)
 		@throw [OFOutOfRangeException exception];
 
-	if (_count + count > _capacity) {
-		_items = [self resizeMemory: _items
-				       size: _itemSize
-				      count: _count + count];
-		_capacity = _count + count;
-	}
+	if (_count + count > _capacity)
+		[self of_growToCount: _count + count];
 
 	memcpy(_items + _count * _itemSize, items, count * _itemSize);
 	_count += count;
@@ -202,12 +277,8 @@
 	if (count > SIZE_MAX - _count || idx > _count)
 		@throw [OFOutOfRangeException exception];
 
-	if (_count + count > _capacity) {
-		_items = [self resizeMemory: _items
-				       size: _itemSize
-				      count: _count + count];
-		_capacity = _count + count;
-	}
+	if (_count + count > _capacity)
+		[self of_growToCount: _count + count];
 
 	memmove(_items + (idx + count) * _itemSize, _items + idx * _itemSize,
 	    (_count - idx) * _itemSize);
@@ -221,12 +292,8 @@
 	if (count > SIZE_MAX - _count)
 		@throw [OFOutOfRangeException exception];
 
-	if (_count + count > _capacity) {
-		_items = [self resizeMemory: _items
-				       size: _itemSize
-				      count: _count + count];
-		_capacity = _count + count;
-	}
+	if (_count + count > _capacity)
+		[self of_growToCount: _count + count];
 
 	memset(_items + _count * _itemSize, '\0', count * _itemSize);
 	_count += count;
@@ -248,14 +315,8 @@
 	    (_count - range.location - range.length) * _itemSize);
 
 	_count -= range.length;
-	@try {
-		_items = [self resizeMemory: _items
-				       size: _itemSize
-				      count: _count];
-		_capacity = _count;
-	} @catch (OFOutOfMemoryException *e) {
-		/* We don't really care, as we only made it smaller */
-	}
+
+	[self of_shrinkIfSparse];
 }
 
 - (void)removeLastItem
@@ -264,14 +325,8 @@
 		return;
 
 	_count--;
-	@try {
-		_items = [self resizeMemory: _items
-				       size: _itemSize
-				      count: _count];
-		_capacity = _count;
-	} @catch (OFOutOfMemoryException *e) {
-		/* We don't care, as we only made it smaller */
-	}
+
+	[self of_shrinkIfSparse];
 }
 
 - (void)removeAllItems
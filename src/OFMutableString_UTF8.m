@@ -33,6 +33,7 @@
 #import "OFOutOfRangeException.h"
 
 #import "of_asprintf.h"
+#import "swar.h"
 #import "unicode.h"
 
 @implementation OFMutableString_UTF8
@@ -195,6 +196,28 @@
 	 */
 }
 
+- (void)uppercase
+{
+	if (_s->isUTF8) {
+		[super uppercase];
+		return;
+	}
+
+	of_swar_ascii_uppercase(_s->cString, _s->cStringLength);
+	_s->hashed = false;
+}
+
+- (void)lowercase
+{
+	if (_s->isUTF8) {
+		[super lowercase];
+		return;
+	}
+
+	of_swar_ascii_lowercase(_s->cString, _s->cStringLength);
+	_s->hashed = false;
+}
+
 - (void)setCharacter: (of_unichar_t)character
 	     atIndex: (size_t)idx
 {
@@ -29,6 +29,8 @@
 #import "OFInvalidFormatException.h"
 #import "OFOutOfRangeException.h"
 
+#import "of_dtoa.h"
+
 #define RETURN_AS(t)							\
 	switch (_type) {						\
 	case OF_NUMBER_TYPE_BOOL:					\
@@ -1117,7 +1119,8 @@
 
 - (OFString *)description
 {
-	OFMutableString *ret;
+	char buffer[OF_DTOA_BUFFER_SIZE];
+	size_t length;
 
 	switch (_type) {
 	case OF_NUMBER_TYPE_BOOL:
@@ -1150,23 +1153,17 @@
 	case OF_NUMBER_TYPE_INTPTR:
 		return [OFString stringWithFormat: @"%jd", [self intMaxValue]];
 	case OF_NUMBER_TYPE_FLOAT:
-		ret = [OFMutableString stringWithFormat: @"%g", _value.float_];
-
-		if (![ret containsString: @"."])
-			[ret appendString: @".0"];
-
-		[ret makeImmutable];
+		length = of_ftoa(_value.float_, buffer);
 
-		return ret;
+		return [OFString stringWithCString: buffer
+					  encoding: OF_STRING_ENCODING_ASCII
+					    length: length];
 	case OF_NUMBER_TYPE_DOUBLE:
-		ret = [OFMutableString stringWithFormat: @"%g", _value.double_];
-
-		if (![ret containsString: @"."])
-			[ret appendString: @".0"];
-
-		[ret makeImmutable];
+		length = of_dtoa(_value.double_, buffer);
 
-		return ret;
+		return [OFString stringWithCString: buffer
+					  encoding: OF_STRING_ENCODING_ASCII
+					    length: length];
 	default:
 		@throw [OFInvalidFormatException exception];
 	}
@@ -19,6 +19,8 @@
 
 OF_ASSUME_NONNULL_BEGIN
 
+@class OFData;
+@class OFStream;
 @class OFString;
 
 #ifdef __cplusplus
@@ -34,6 +36,39 @@ extern int _OFObject_Serialization_reference;
  * @brief The object serialized as a string.
  */
 @property (readonly, nonatomic) OFString *stringBySerializing;
+
+/*!
+ * @brief Writes the object serialized as a string to the specified stream.
+ *
+ * The output is the same as @ref stringBySerializing, but it is written to the
+ * stream directly instead of being created in memory first.
+ *
+ * @param stream The stream to write the serialization to
+ */
+- (void)writeSerializationToStream: (OFStream *)stream;
+
+/*!
+ * @brief The object serialized in binary form.
+ *
+ * This contains the same information as @ref stringBySerializing, but is
+ * considerably smaller and faster to write and to read, as no XML needs to be
+ * generated or parsed. Repeated strings like class names and short keys are
+ * only stored once.
+ *
+ * The object can be restored using @ref OFData::objectByDeserializing.
+ */
+@property (readonly, nonatomic) OFData *dataBySerializing;
+
+/*!
+ * @brief Writes the object serialized in binary form to the specified stream.
+ *
+ * The output is the same as @ref dataBySerializing, but it is written to the
+ * stream in chunks instead of being created in memory first. The object can
+ * be read again using @ref OFStream::readSerializedObject.
+ *
+ * @param stream The stream to write the serialization to
+ */
+- (void)writeBinarySerializationToStream: (OFStream *)stream;
 @end
 
 OF_ASSUME_NONNULL_END
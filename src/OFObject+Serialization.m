@@ -21,35 +21,45 @@
 
 #import "OFObject.h"
 #import "OFObject+Serialization.h"
+#import "OFData.h"
 #import "OFSerialization.h"
+#import "OFStream.h"
 #import "OFString.h"
 #import "OFXMLElement.h"
 
+#import "binary_serialization.h"
+
 int _OFObject_Serialization_reference;
 
 @implementation OFObject (Serialization)
-- (OFString *)stringBySerializing
+- (OFXMLElement *)of_XMLElementBySerializing
 {
-	void *pool;
-	OFXMLElement *element;
-	OFXMLElement *root;
-	OFString *ret;
-
 	if (![self conformsToProtocol: @protocol(OFSerialization)]) {
 		[self doesNotRecognizeSelector: _cmd];
 		abort();
 	}
 
-	pool = objc_autoreleasePoolPush();
-	element = [(id)self XMLElementBySerializing];
+	return [(id)self XMLElementBySerializing];
+}
+
+- (OFXMLElement *)of_serializationElement
+{
+	OFXMLElement *root;
 
 	root = [OFXMLElement elementWithName: @"serialization"
 				   namespace: OF_SERIALIZATION_NS];
 	[root addAttributeWithName: @"version"
 		       stringValue: @"1"];
-	[root addChild: element];
+	[root addChild: [self of_XMLElementBySerializing]];
 
-	ret = [@"<?xml version='1.0' encoding='UTF-8'?>\n"
+	return root;
+}
+
+- (OFString *)stringBySerializing
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFXMLElement *root = [self of_serializationElement];
+	OFString *ret = [@"<?xml version='1.0' encoding='UTF-8'?>\n"
 	    stringByAppendingString: [root XMLStringWithIndentation: 2]];
 
 	[ret retain];
@@ -58,4 +68,41 @@ int _OFObject_Serialization_reference;
 
 	return [ret autorelease];
 }
+
+- (void)writeSerializationToStream: (OFStream *)stream
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFXMLElement *root = [self of_serializationElement];
+
+	[stream writeString: @"<?xml version='1.0' encoding='UTF-8'?>\n"];
+	[root writeToStream: stream
+		indentation: 2];
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (OFData *)dataBySerializing
+{
+	OFMutableData *data = [OFMutableData data];
+	void *pool = objc_autoreleasePoolPush();
+
+	of_binary_serialization_write([self of_XMLElementBySerializing], data,
+	    nil);
+
+	objc_autoreleasePoolPop(pool);
+
+	[data makeImmutable];
+
+	return data;
+}
+
+- (void)writeBinarySerializationToStream: (OFStream *)stream
+{
+	void *pool = objc_autoreleasePoolPush();
+
+	of_binary_serialization_write([self of_XMLElementBySerializing],
+	    [OFMutableData data], stream);
+
+	objc_autoreleasePoolPop(pool);
+}
 @end
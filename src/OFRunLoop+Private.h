@@ -84,6 +84,17 @@ OF_ASSUME_NONNULL_BEGIN
 				       block
 # endif
 			 delegate: (nullable id <OFStreamDelegate>)delegate;
++ (void)of_addAsyncWriteForStream: (OFStream <OFReadyForWritingObserving> *)
+				       stream
+		       fromStream: (OFStream *)sourceStream
+			   length: (size_t)length
+			     mode: (of_run_loop_mode_t)mode
+# ifdef OF_HAVE_BLOCKS
+			    block: (nullable
+				    of_stream_async_write_from_stream_block_t)
+				       block
+# endif
+			 delegate: (nullable id <OFStreamDelegate>)delegate;
 + (void)of_addAsyncConnectForTCPSocket: (OFTCPSocket *)socket
 				  mode: (of_run_loop_mode_t)mode
 			      delegate: (id <OFTCPSocketDelegate_Private>)
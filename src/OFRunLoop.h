@@ -63,6 +63,9 @@ extern of_run_loop_mode_t of_run_loop_mode_default;
 #endif
 	of_run_loop_mode_t _Nullable _currentMode;
 	volatile bool _stop;
+#ifdef OF_HAVE_SOCKETS
+	bool _edgeTriggered;
+#endif
 }
 
 #ifdef OF_HAVE_CLASS_PROPERTIES
@@ -72,6 +75,26 @@ extern of_run_loop_mode_t of_run_loop_mode_default;
 @property OF_NULLABLE_PROPERTY (readonly, nonatomic)
     of_run_loop_mode_t currentMode;
 
+#ifdef OF_HAVE_SOCKETS
+/*!
+ * @brief Whether the run loop observes non-blocking streams and sockets
+ *	  edge-triggered.
+ *
+ * In edge-triggered mode, the run loop keeps handling the asynchronous
+ * requests of a non-blocking object until they would block, instead of
+ * handling one request per readiness notification. This avoids redundant
+ * wakeups with many mostly idle connections.
+ *
+ * So that an object that never runs out of data cannot starve all other
+ * objects and timers, only a limited number of requests is handled at once.
+ * The remaining requests are handled before the run loop waits again.
+ *
+ * This is off by default. Enabling it throws an OFNotImplementedException if
+ * the kernel event observer used on this platform does not support it.
+ */
+@property (nonatomic, getter=isEdgeTriggered) bool edgeTriggered;
+#endif
+
 /*!
  * @brief Returns the run loop for the main thread.
  *
@@ -22,10 +22,12 @@
 
 #import "OFRunLoop.h"
 #import "OFRunLoop+Private.h"
+#import "OFArray.h"
 #import "OFData.h"
 #import "OFDictionary.h"
 #ifdef OF_HAVE_SOCKETS
 # import "OFKernelEventObserver.h"
+# import "OFKernelEventObserver+Private.h"
 # import "OFTCPSocket.h"
 # import "OFTCPSocket+Private.h"
 #endif
@@ -44,9 +46,38 @@
 # import "OFConnectionFailedException.h"
 #endif
 
+/*
+ * The maximum number of queue items handled for an object per wakeup in
+ * edge-triggered mode, so that an object that never runs out of data does not
+ * starve all other objects and timers.
+ */
+#define MAX_DRAIN_ITERATIONS 64
+
 of_run_loop_mode_t of_run_loop_mode_default = @"of_run_loop_mode_default";
 static OFRunLoop *mainRunLoop = nil;
 
+#ifdef OF_HAVE_SOCKETS
+static bool
+isNonBlocking(id object)
+{
+	return ([object respondsToSelector: @selector(isBlocking)] &&
+	    ![object isBlocking]);
+}
+
+static bool
+isWouldBlockException(id exception)
+{
+	int errNo;
+
+	if (![exception respondsToSelector: @selector(errNo)])
+		return false;
+
+	errNo = [exception errNo];
+
+	return (errNo == EWOULDBLOCK || errNo == EAGAIN);
+}
+#endif
+
 @interface OFRunLoop ()
 - (OFRunLoop_State *)of_stateForMode: (of_run_loop_mode_t)mode
 			      create: (bool)create;
@@ -65,10 +96,20 @@ static OFRunLoop *mainRunLoop = nil;
 #if defined(OF_HAVE_SOCKETS)
 	OFKernelEventObserver *_kernelEventObserver;
 	OFMutableDictionary *_readQueues, *_writeQueues;
+	/*
+	 * Objects that were not drained completely in edge-triggered mode and
+	 * therefore need to be handled before the next wait.
+	 */
+	OFMutableArray *_unfinishedReadObjects, *_unfinishedWriteObjects;
 #elif defined(OF_HAVE_THREADS)
 	OFCondition *_condition;
 #endif
 }
+
+#ifdef OF_HAVE_SOCKETS
+- (bool)of_hasUnfinishedObjects;
+- (void)of_handleUnfinishedObjects;
+#endif
 @end
 
 #ifdef OF_HAVE_SOCKETS
@@ -76,6 +117,10 @@ static OFRunLoop *mainRunLoop = nil;
 {
 @public
 	id _delegate;
+	/* Not retained, as it belongs to the state that owns the item. */
+	OFKernelEventObserver *_kernelEventObserver;
+	/* No progress can be made until the object is ready again. */
+	bool _drained;
 }
 
 - (bool)handleObject: (id)object;
@@ -136,6 +181,17 @@ static OFRunLoop *mainRunLoop = nil;
 }
 @end
 
+@interface OFRunLoop_WriteFromStreamQueueItem: OFRunLoop_QueueItem
+{
+@public
+# ifdef OF_HAVE_BLOCKS
+	of_stream_async_write_from_stream_block_t _block;
+# endif
+	OFStream *_sourceStream;
+	size_t _length, _writtenLength;
+}
+@end
+
 @interface OFRunLoop_ConnectQueueItem: OFRunLoop_QueueItem
 @end
 
@@ -185,6 +241,8 @@ static OFRunLoop *mainRunLoop = nil;
 
 		_readQueues = [[OFMutableDictionary alloc] init];
 		_writeQueues = [[OFMutableDictionary alloc] init];
+		_unfinishedReadObjects = [[OFMutableArray alloc] init];
+		_unfinishedWriteObjects = [[OFMutableArray alloc] init];
 #elif defined(OF_HAVE_THREADS)
 		_condition = [[OFCondition alloc] init];
 #endif
@@ -203,6 +261,8 @@ static OFRunLoop *mainRunLoop = nil;
 	[_kernelEventObserver release];
 	[_readQueues release];
 	[_writeQueues release];
+	[_unfinishedReadObjects release];
+	[_unfinishedWriteObjects release];
 #elif defined(OF_HAVE_THREADS)
 	[_condition release];
 #endif
@@ -220,35 +280,66 @@ static OFRunLoop *mainRunLoop = nil;
 	OFList OF_GENERIC(OF_KINDOF(OFRunLoop_ReadQueueItem *)) *queue =
 	    [[_readQueues objectForKey: object] retain];
 
+	/*
+	 * In edge-triggered mode, the object is not reported again until it
+	 * was drained, so keep handling the queue until it would block.
+	 */
+	bool drain = ([_kernelEventObserver isEdgeTriggered] &&
+	    isNonBlocking(object));
+
 	assert(queue != nil);
 
 	@try {
-		if (![[queue firstObject] handleObject: object]) {
-			of_list_object_t *listObject = [queue firstListObject];
+		OFRunLoop_QueueItem *queueItem;
+		size_t iterations = 0;
+
+		while ((queueItem = [queue firstObject]) != nil) {
+			of_list_object_t *listObject;
+
+			if (drain && iterations++ == MAX_DRAIN_ITERATIONS) {
+				if (![_unfinishedReadObjects
+				    containsObjectIdenticalTo: object])
+					[_unfinishedReadObjects
+					    addObject: object];
+
+				break;
+			}
+
+			queueItem->_drained = false;
+
+			if ([queueItem handleObject: object]) {
+				if (!drain || queueItem->_drained)
+					break;
+
+				continue;
+			}
 
 			/*
 			 * The handler might have called -[cancelAsyncRequests]
 			 * so that our queue is now empty, in which case we
 			 * should do nothing.
 			 */
-			if (listObject != NULL) {
-				/*
-				 * Make sure we keep the target until after we
-				 * are done removing the object. The reason for
-				 * this is that the target might call
-				 * -[cancelAsyncRequests] in its dealloc.
-				 */
-				[[listObject->object retain] autorelease];
-
-				[queue removeListObject: listObject];
-
-				if ([queue count] == 0) {
-					[_kernelEventObserver
-					    removeObjectForReading: object];
-					[_readQueues
-					    removeObjectForKey: object];
-				}
+			if ((listObject = [queue firstListObject]) == NULL)
+				break;
+
+			/*
+			 * Make sure we keep the target until after we are done
+			 * removing the object. The reason for this is that the
+			 * target might call -[cancelAsyncRequests] in its
+			 * dealloc.
+			 */
+			[[listObject->object retain] autorelease];
+
+			[queue removeListObject: listObject];
+
+			if ([queue count] == 0) {
+				[_kernelEventObserver
+				    removeObjectForReading: object];
+				[_readQueues removeObjectForKey: object];
 			}
+
+			if (!drain || queueItem->_drained)
+				break;
 		}
 	} @finally {
 		[queue release];
@@ -263,40 +354,97 @@ static OFRunLoop *mainRunLoop = nil;
 	 */
 	OFList *queue = [[_writeQueues objectForKey: object] retain];
 
+	/*
+	 * In edge-triggered mode, the object is not reported again until it
+	 * was drained, so keep handling the queue until it would block.
+	 */
+	bool drain = ([_kernelEventObserver isEdgeTriggered] &&
+	    isNonBlocking(object));
+
 	assert(queue != nil);
 
 	@try {
-		if (![[queue firstObject] handleObject: object]) {
-			of_list_object_t *listObject = [queue firstListObject];
+		OFRunLoop_QueueItem *queueItem;
+		size_t iterations = 0;
+
+		while ((queueItem = [queue firstObject]) != nil) {
+			of_list_object_t *listObject;
+
+			if (drain && iterations++ == MAX_DRAIN_ITERATIONS) {
+				if (![_unfinishedWriteObjects
+				    containsObjectIdenticalTo: object])
+					[_unfinishedWriteObjects
+					    addObject: object];
+
+				break;
+			}
+
+			queueItem->_drained = false;
+
+			if ([queueItem handleObject: object]) {
+				if (!drain || queueItem->_drained)
+					break;
+
+				continue;
+			}
 
 			/*
 			 * The handler might have called -[cancelAsyncRequests]
 			 * so that our queue is now empty, in which case we
 			 * should do nothing.
 			 */
-			if (listObject != NULL) {
-				/*
-				 * Make sure we keep the target until after we
-				 * are done removing the object. The reason for
-				 * this is that the target might call
-				 * -[cancelAsyncRequests] in its dealloc.
-				 */
-				[[listObject->object retain] autorelease];
-
-				[queue removeListObject: listObject];
-
-				if ([queue count] == 0) {
-					[_kernelEventObserver
-					    removeObjectForWriting: object];
-					[_writeQueues
-					    removeObjectForKey: object];
-				}
+			if ((listObject = [queue firstListObject]) == NULL)
+				break;
+
+			/*
+			 * Make sure we keep the target until after we are done
+			 * removing the object. The reason for this is that the
+			 * target might call -[cancelAsyncRequests] in its
+			 * dealloc.
+			 */
+			[[listObject->object retain] autorelease];
+
+			[queue removeListObject: listObject];
+
+			if ([queue count] == 0) {
+				[_kernelEventObserver
+				    removeObjectForWriting: object];
+				[_writeQueues removeObjectForKey: object];
 			}
+
+			if (!drain || queueItem->_drained)
+				break;
 		}
 	} @finally {
 		[queue release];
 	}
 }
+
+- (bool)of_hasUnfinishedObjects
+{
+	return ([_unfinishedReadObjects count] > 0 ||
+	    [_unfinishedWriteObjects count] > 0);
+}
+
+- (void)of_handleUnfinishedObjects
+{
+	OFArray *objects;
+
+	/* Handling an object might add it again, so work on a copy. */
+	objects = [[_unfinishedReadObjects copy] autorelease];
+	[_unfinishedReadObjects removeAllObjects];
+
+	for (id object in objects)
+		if ([_readQueues objectForKey: object] != nil)
+			[self objectIsReadyForReading: object];
+
+	objects = [[_unfinishedWriteObjects copy] autorelease];
+	[_unfinishedWriteObjects removeAllObjects];
+
+	for (id object in objects)
+		if ([_writeQueues objectForKey: object] != nil)
+			[self objectIsReadyForWriting: object];
+}
 #endif
 @end
 
@@ -325,10 +473,18 @@ static OFRunLoop *mainRunLoop = nil;
 		length = [object readIntoBuffer: _buffer
 					 length: _length];
 	} @catch (id e) {
+		if (isWouldBlockException(e)) {
+			_drained = true;
+			return true;
+		}
+
 		length = 0;
 		exception = e;
 	}
 
+	if (length == 0)
+		_drained = true;
+
 # ifdef OF_HAVE_BLOCKS
 	if (_block != NULL)
 		return _block(object, _buffer, length, exception);
@@ -367,10 +523,18 @@ static OFRunLoop *mainRunLoop = nil;
 		length = [object readIntoBuffer: (char *)_buffer + _readLength
 					 length: _exactLength - _readLength];
 	} @catch (id e) {
+		if (isWouldBlockException(e)) {
+			_drained = true;
+			return true;
+		}
+
 		length = 0;
 		exception = e;
 	}
 
+	if (length == 0)
+		_drained = true;
+
 	_readLength += length;
 
 	if (_readLength != _exactLength && ![object isAtEndOfStream] &&
@@ -422,12 +586,21 @@ static OFRunLoop *mainRunLoop = nil;
 	@try {
 		line = [object tryReadLineWithEncoding: _encoding];
 	} @catch (id e) {
+		if (isWouldBlockException(e)) {
+			_drained = true;
+			return true;
+		}
+
 		line = nil;
 		exception = e;
 	}
 
-	if (line == nil && ![object isAtEndOfStream] && exception == nil)
-		return true;
+	if (line == nil) {
+		if (![object isAtEndOfStream] && exception == nil)
+			return true;
+
+		_drained = true;
+	}
 
 # ifdef OF_HAVE_BLOCKS
 	if (_block != NULL)
@@ -467,13 +640,23 @@ static OFRunLoop *mainRunLoop = nil;
 	@try {
 		const char *dataItems = [_data items];
 
-		length = [object writeBuffer: dataItems + _writtenLength
-				      length: dataLength - _writtenLength];
+		length = [_kernelEventObserver
+		    of_writeBuffer: dataItems + _writtenLength
+			    length: dataLength - _writtenLength
+			  toObject: object];
 	} @catch (id e) {
+		if (isWouldBlockException(e)) {
+			_drained = true;
+			return true;
+		}
+
 		length = 0;
 		exception = e;
 	}
 
+	if (length == 0)
+		_drained = true;
+
 	_writtenLength += length;
 
 	if (_writtenLength != dataLength && exception == nil)
@@ -539,13 +722,23 @@ static OFRunLoop *mainRunLoop = nil;
 	@try {
 		const char *cString = [_string cStringWithEncoding: _encoding];
 
-		length = [object writeBuffer: cString + _writtenLength
-				      length: cStringLength - _writtenLength];
+		length = [_kernelEventObserver
+		    of_writeBuffer: cString + _writtenLength
+			    length: cStringLength - _writtenLength
+			  toObject: object];
 	} @catch (id e) {
+		if (isWouldBlockException(e)) {
+			_drained = true;
+			return true;
+		}
+
 		length = 0;
 		exception = e;
 	}
 
+	if (length == 0)
+		_drained = true;
+
 	_writtenLength += length;
 
 	if (_writtenLength != cStringLength && exception == nil)
@@ -602,6 +795,63 @@ static OFRunLoop *mainRunLoop = nil;
 }
 @end
 
+@implementation OFRunLoop_WriteFromStreamQueueItem
+- (bool)handleObject: (id)object
+{
+	size_t length;
+	id exception = nil;
+
+	@try {
+		length = [object writeFromStream: _sourceStream
+					  length: _length - _writtenLength];
+	} @catch (id e) {
+		if (isWouldBlockException(e)) {
+			_drained = true;
+			return true;
+		}
+
+		length = 0;
+		exception = e;
+	}
+
+	if (length == 0)
+		_drained = true;
+
+	_writtenLength += length;
+
+	if (_writtenLength != _length && exception == nil &&
+	    (length > 0 || ![_sourceStream isAtEndOfStream]))
+		return true;
+
+# ifdef OF_HAVE_BLOCKS
+	if (_block != NULL)
+		_block(object, _sourceStream, _writtenLength, exception);
+	else {
+# endif
+		if ([_delegate respondsToSelector: @selector(stream:
+		    didWriteFromStream:bytesWritten:exception:)])
+			[_delegate	stream: object
+			    didWriteFromStream: _sourceStream
+				  bytesWritten: _writtenLength
+				     exception: exception];
+# ifdef OF_HAVE_BLOCKS
+	}
+# endif
+
+	return false;
+}
+
+- (void)dealloc
+{
+	[_sourceStream release];
+# ifdef OF_HAVE_BLOCKS
+	[_block release];
+# endif
+
+	[super dealloc];
+}
+@end
+
 @implementation OFRunLoop_ConnectQueueItem
 - (bool)handleObject: (id)object
 {
@@ -633,8 +883,14 @@ static OFRunLoop *mainRunLoop = nil;
 	@try {
 		acceptedSocket = [object accept];
 	} @catch (id e) {
+		if (isWouldBlockException(e)) {
+			_drained = true;
+			return true;
+		}
+
 		acceptedSocket = nil;
 		exception = e;
+		_drained = true;
 	}
 
 # ifdef OF_HAVE_BLOCKS
@@ -676,8 +932,14 @@ static OFRunLoop *mainRunLoop = nil;
 					    length: _length
 					    sender: &address];
 	} @catch (id e) {
+		if (isWouldBlockException(e)) {
+			_drained = true;
+			return true;
+		}
+
 		length = 0;
 		exception = e;
+		_drained = true;
 	}
 
 # ifdef OF_HAVE_BLOCKS
@@ -720,7 +982,13 @@ static OFRunLoop *mainRunLoop = nil;
 			    length: [_data count] * [_data itemSize]
 			  receiver: &_receiver];
 	} @catch (id e) {
+		if (isWouldBlockException(e)) {
+			_drained = true;
+			return true;
+		}
+
 		exception = e;
+		_drained = true;
 	}
 
 # ifdef OF_HAVE_BLOCKS
@@ -831,7 +1099,8 @@ static OFRunLoop *mainRunLoop = nil;
 		[state->_kernelEventObserver				\
 		    addObjectForWriting: object];			\
 									\
-	queueItem = [[[type alloc] init] autorelease];
+	queueItem = [[[type alloc] init] autorelease];			\
+	queueItem->_kernelEventObserver = state->_kernelEventObserver;
 #define QUEUE_ITEM							\
 	[queue appendObject: queueItem];				\
 									\
@@ -943,6 +1212,29 @@ static OFRunLoop *mainRunLoop = nil;
 	QUEUE_ITEM
 }
 
++ (void)of_addAsyncWriteForStream: (OFStream <OFReadyForWritingObserving> *)
+				       stream
+		       fromStream: (OFStream *)sourceStream
+			   length: (size_t)length
+			     mode: (of_run_loop_mode_t)mode
+# ifdef OF_HAVE_BLOCKS
+			    block: (of_stream_async_write_from_stream_block_t)
+				       block
+# endif
+			 delegate: (id <OFStreamDelegate>)delegate
+{
+	NEW_WRITE(OFRunLoop_WriteFromStreamQueueItem, stream, mode)
+
+	queueItem->_delegate = [delegate retain];
+# ifdef OF_HAVE_BLOCKS
+	queueItem->_block = [block copy];
+# endif
+	queueItem->_sourceStream = [sourceStream retain];
+	queueItem->_length = length;
+
+	QUEUE_ITEM
+}
+
 + (void)of_addAsyncConnectForTCPSocket: (OFTCPSocket *)stream
 				  mode: (of_run_loop_mode_t)mode
 			      delegate: (id <OFTCPSocketDelegate_Private>)
@@ -1042,6 +1334,8 @@ static OFRunLoop *mainRunLoop = nil;
 
 		[state->_kernelEventObserver removeObjectForWriting: object];
 		[state->_writeQueues removeObjectForKey: object];
+		[state->_unfinishedWriteObjects
+		    removeObjectIdenticalTo: object];
 	}
 
 	if ((queue = [state->_readQueues objectForKey: object]) != nil) {
@@ -1055,6 +1349,8 @@ static OFRunLoop *mainRunLoop = nil;
 
 		[state->_kernelEventObserver removeObjectForReading: object];
 		[state->_readQueues removeObjectForKey: object];
+		[state->_unfinishedReadObjects
+		    removeObjectIdenticalTo: object];
 	}
 
 	objc_autoreleasePoolPop(pool);
@@ -1113,6 +1409,12 @@ static OFRunLoop *mainRunLoop = nil;
 		if (create && state == nil) {
 			state = [[OFRunLoop_State alloc] init];
 			@try {
+#ifdef OF_HAVE_SOCKETS
+				if (_edgeTriggered)
+					[state->_kernelEventObserver
+					    setEdgeTriggered: true];
+#endif
+
 				[_states setObject: state
 					    forKey: mode];
 			} @finally {
@@ -1128,6 +1430,31 @@ static OFRunLoop *mainRunLoop = nil;
 	return state;
 }
 
+#ifdef OF_HAVE_SOCKETS
+- (bool)isEdgeTriggered
+{
+	return _edgeTriggered;
+}
+
+- (void)setEdgeTriggered: (bool)edgeTriggered
+{
+# ifdef OF_HAVE_THREADS
+	[_statesMutex lock];
+	@try {
+# endif
+		for (OFRunLoop_State *state in [_states allObjects])
+			[state->_kernelEventObserver
+			    setEdgeTriggered: edgeTriggered];
+
+		_edgeTriggered = edgeTriggered;
+# ifdef OF_HAVE_THREADS
+	} @finally {
+		[_statesMutex unlock];
+	}
+# endif
+}
+#endif
+
 - (void)addTimer: (OFTimer *)timer
 {
 	[self addTimer: timer
@@ -1219,6 +1546,7 @@ static OFRunLoop *mainRunLoop = nil;
 	_currentMode = mode;
 	@try {
 		OFDate *nextTimer;
+		bool hasUnfinishedObjects = false;
 
 		for (;;) {
 			OFTimer *timer;
@@ -1266,11 +1594,24 @@ static OFRunLoop *mainRunLoop = nil;
 		}
 #endif
 
+#ifdef OF_HAVE_SOCKETS
+		/*
+		 * Objects that were not drained completely are not reported
+		 * again, so handle them now and only poll if some are still
+		 * left afterwards.
+		 */
+		[state of_handleUnfinishedObjects];
+		hasUnfinishedObjects = [state of_hasUnfinishedObjects];
+#endif
+
 		/* Watch for I/O events until the next timer is due */
-		if (nextTimer != nil || deadline != nil) {
+		if (nextTimer != nil || deadline != nil ||
+		    hasUnfinishedObjects) {
 			of_time_interval_t timeout;
 
-			if (nextTimer != nil && deadline == nil)
+			if (hasUnfinishedObjects)
+				timeout = 0;
+			else if (nextTimer != nil && deadline == nil)
 				timeout = [nextTimer timeIntervalSinceNow];
 			else if (nextTimer == nil && deadline != nil)
 				timeout = [deadline timeIntervalSinceNow];
@@ -55,8 +55,8 @@
 	offset = [self lowlevelSeekToOffset: offset
 				     whence: whence];
 
-	[self freeMemory: _readBufferMemory];
-	_readBuffer = _readBufferMemory = NULL;
+	/* Keep the memory of the read buffer for the following reads */
+	_readBuffer = _readBufferMemory;
 	_readBufferLength = 0;
 
 	return offset;
@@ -22,6 +22,36 @@ OF_ASSUME_NONNULL_BEGIN
 @interface OFStream ()
 @property (readonly, nonatomic, getter=of_isWaitingForDelimiter)
     bool of_waitingForDelimiter;
+
+/*
+ * The file descriptors lowlevel reads and writes go to without modifying the
+ * data, or -1 if there are none. Used to move data inside the kernel.
+ */
+- (int)of_fileDescriptorForZeroCopyReading;
+- (int)of_fileDescriptorForZeroCopyWriting;
+
+/*
+ * Called right before data is moved to the file descriptor for zero copy
+ * writing, so that data which needs to precede it can be written first.
+ */
+- (void)of_prepareForZeroCopyWriting;
+
+/*
+ * Appends data that was read from the underlying stream by other means, e.g.
+ * by a kernel event observer, to the read buffer.
+ */
+- (void)of_appendToReadBuffer: (const void *)buffer
+		       length: (size_t)length;
+
+#if defined(HAVE_WRITEV) && !defined(OF_WINDOWS)
+/*
+ * Writes as many of the buffers as writev() accepts at once to the specified
+ * file descriptor. Used to implement lowlevelWriteBuffers:count:.
+ */
+- (size_t)of_writeBuffers: (const of_stream_buffer_t *)buffers
+		    count: (size_t)count
+	 toFileDescriptor: (int)fd;
+#endif
 @end
 
 OF_ASSUME_NONNULL_END
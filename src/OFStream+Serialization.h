@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFStream.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern int _OFStream_Serialization_reference;
+#ifdef __cplusplus
+}
+#endif
+
+@interface OFStream (Serialization)
+/*!
+ * @brief Reads an object in binary serialization from the stream.
+ *
+ * The object needs to be written by
+ * @ref OFObject::writeBinarySerializationToStream:. Only the bytes of the
+ * object are read from the stream, so several objects can be written to and
+ * read from a stream one after another.
+ *
+ * @return The deserialized object
+ */
+- (id)readSerializedObject;
+@end
+
+OF_ASSUME_NONNULL_END
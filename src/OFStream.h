@@ -37,6 +37,20 @@ OF_ASSUME_NONNULL_BEGIN
 
 @class OFStream;
 @class OFData;
+@class OFMutableArray OF_GENERIC(ObjectType);
+@class OFMutableData;
+
+/*!
+ * @struct of_stream_buffer_t OFStream.h ObjFW/OFStream.h
+ *
+ * @brief A buffer for a vectored write.
+ */
+typedef struct {
+	/*! The data to write */
+	const void *_Nullable buffer;
+	/*! The length of the data to write */
+	size_t length;
+} of_stream_buffer_t;
 
 #if defined(OF_HAVE_SOCKETS) && defined(OF_HAVE_BLOCKS)
 /*!
@@ -101,6 +115,37 @@ typedef OFData *_Nullable (^of_stream_async_write_data_block_t)(
 typedef OFString *_Nullable (^of_stream_async_write_string_block_t)(
     OF_KINDOF(OFStream *) _Nonnull stream, OFString *_Nonnull string,
     of_string_encoding_t encoding, size_t bytesWritten, id _Nullable exception);
+
+/*!
+ * @brief A block which is called when data from another stream was written
+ *	  asynchronously to a stream.
+ *
+ * @param stream The stream to which the data was written
+ * @param sourceStream The stream from which the data was read
+ * @param bytesWritten The number of bytes which have been written. This
+ *		       matches the requested length if neither an exception
+ *		       was encountered nor the end of the source stream was
+ *		       reached.
+ * @param exception An exception which occurred while writing or `nil` on
+ *		    success
+ */
+typedef void (^of_stream_async_write_from_stream_block_t)(
+    OF_KINDOF(OFStream *) _Nonnull stream, OFStream *_Nonnull sourceStream,
+    size_t bytesWritten, id _Nullable exception);
+#endif
+
+#ifdef OF_HAVE_BLOCKS
+/*!
+ * @brief A block which is called for each line of a stream.
+ *
+ * @param line The bytes of the line without the line ending. They are only
+ *	       valid until the block returns.
+ * @param length The length of the line in bytes
+ * @param stop A pointer to a variable that can be set to true to stop the
+ *	       enumeration
+ */
+typedef void (^of_stream_line_enumeration_block_t)(const char *line,
+    size_t length, bool *stop);
 #endif
 
 /*!
@@ -174,6 +219,23 @@ typedef OFString *_Nullable (^of_stream_async_write_string_block_t)(
 		     encoding: (of_string_encoding_t)encoding
 		 bytesWritten: (size_t)bytesWritten
 		    exception: (nullable id)exception;
+
+/*!
+ * @brief This method is called when data from another stream was written
+ *	  asynchronously to a stream.
+ *
+ * @param stream The stream to which the data was written
+ * @param sourceStream The stream from which the data was read
+ * @param bytesWritten The number of bytes which have been written. This
+ *		       matches the requested length if neither an exception
+ *		       was encountered nor the end of the source stream was
+ *		       reached.
+ * @param exception An exception that occurred while writing, or nil on success
+ */
+-	(void)stream: (OF_KINDOF(OFStream *))stream
+  didWriteFromStream: (OFStream *)sourceStream
+	bytesWritten: (size_t)bytesWritten
+	   exception: (nullable id)exception;
 @end
 
 /*!
@@ -194,7 +256,9 @@ typedef OFString *_Nullable (^of_stream_async_write_string_block_t)(
  *	 the methods that do the actual work. OFStream uses those for all other
  *	 methods and does all the caching and other stuff for you. If you
  *	 override these methods without the `lowlevel` prefix, you *will* break
- *	 caching and get broken results!
+ *	 caching and get broken results! If the underlying stream supports
+ *	 vectored writes, @ref lowlevelWriteBuffers:count: can be overridden as
+ *	 well.
  */
 @interface OFStream: OFObject <OFCopying>
 {
@@ -203,7 +267,10 @@ typedef OFString *_Nullable (^of_stream_async_write_string_block_t)(
 #endif
 	char *_Nullable _readBuffer, *_Nullable _readBufferMemory;
 	char *_Nullable _writeBuffer;
-	size_t _readBufferLength, _writeBufferLength;
+	size_t _readBufferLength, _readBufferCapacity, _readBufferSize;
+	size_t _writeBufferLength;
+	OFMutableArray OF_GENERIC(OFData *) *_Nullable _writeBufferData;
+	OFMutableData *_Nullable _writeBufferDataOffsets;
 	bool _writeBuffered, _waitingForDelimiter;
 @protected
 	bool _blocking;
@@ -220,6 +287,19 @@ typedef OFString *_Nullable (^of_stream_async_write_string_block_t)(
  */
 @property (nonatomic, nonatomic, getter=isWriteBuffered) bool writeBuffered;
 
+/*!
+ * @brief The size of the internal read buffer.
+ *
+ * Small reads as well as reading lines and reading until a delimiter are
+ * served from a read buffer, which @ref lowlevelReadIntoBuffer:length: fills
+ * directly with at least this many bytes at a time. The buffer is kept for as
+ * long as the stream is open and is only enlarged further if a line or
+ * delimited string does not fit into it.
+ *
+ * Defaults to the page size.
+ */
+@property (nonatomic) size_t readBufferSize;
+
 /*!
  * @brief Whether data is present in the internal read buffer.
  */
@@ -973,6 +1053,51 @@ typedef OFString *_Nullable (^of_stream_async_write_string_block_t)(
 - (nullable OFString *)tryReadTillDelimiter: (OFString *)delimiter
 				   encoding: (of_string_encoding_t)encoding;
 
+/*!
+ * @brief Reads until the specified byte sequence is found or the end of stream
+ *	  occurs.
+ *
+ * Unlike @ref readTillDelimiter:, `\0` has no special meaning and the data is
+ * returned as is.
+ *
+ * @param delimiter The delimiter. Its item size needs to be 1.
+ * @return The data before the delimiter, autoreleased, or `nil` if the end of
+ *	   the stream has been reached.
+ */
+- (nullable OFData *)readDataUntilDelimiter: (OFData *)delimiter;
+
+/*!
+ * @brief Tries to read until the specified byte sequence is found or the end of
+ *	  stream occurs (see @ref readDataUntilDelimiter:) and returns `nil` if
+ *	  not enough data has been received yet.
+ *
+ * @param delimiter The delimiter. Its item size needs to be 1.
+ * @return The data before the delimiter, autoreleased, or `nil` if the end of
+ *	   the stream has been reached.
+ */
+- (nullable OFData *)tryReadDataUntilDelimiter: (OFData *)delimiter;
+
+#ifdef OF_HAVE_BLOCKS
+/*!
+ * @brief Reads lines until the end of the stream and calls the specified block
+ *	  for each of them.
+ *
+ * The lines are passed as bytes directly from the read buffer, so no object is
+ * created for a line unless the block creates one. Lines are terminated by
+ * `\n` or `\r\n` and `\0` has no special meaning.
+ *
+ * If the stream is in non-blocking mode, this also returns when no complete
+ * line can be read without waiting for more data. The incomplete line is kept
+ * and the method can be called again once the stream is ready for reading.
+ *
+ * @param block The block to call for each line
+ * @return Whether the end of the stream was reached. This is false if the block
+ *	   stopped the enumeration or if the stream is in non-blocking mode and
+ *	   no complete line is available yet.
+ */
+- (bool)enumerateLinesUsingBlock: (of_stream_line_enumeration_block_t)block;
+#endif
+
 /*!
  * @brief Writes everything in the write buffer to the stream.
  */
@@ -989,6 +1114,40 @@ typedef OFString *_Nullable (^of_stream_async_write_string_block_t)(
 - (size_t)writeBuffer: (const void *)buffer
 	       length: (size_t)length;
 
+/*!
+ * @brief Writes from several buffers into the stream.
+ *
+ * If the stream is not write buffered, the buffers are written with as few
+ * lowlevel writes as possible, ideally a single one.
+ *
+ * @param buffers The buffers from which the data is written into the stream
+ * @param count The number of buffers
+ * @return The number of bytes written. This can only differ from the combined
+ *	   length of the buffers in non-blocking mode.
+ */
+- (size_t)writeBuffers: (const of_stream_buffer_t *)buffers
+		 count: (size_t)count;
+
+/*!
+ * @brief Writes data read from the specified stream into the stream.
+ *
+ * If both streams are backed by file descriptors and the stream is not write
+ * buffered, the data is moved inside the kernel where supported, e.g. using
+ * `copy_file_range()`, `sendfile()` or `splice()`. Otherwise, it is read into
+ * the read buffer of the specified stream and written from there.
+ *
+ * In non-blocking mode, this returns the number of bytes written so far, which
+ * might be 0, as soon as the stream cannot take more data without blocking.
+ *
+ * @param stream The stream to read the data from
+ * @param length The number of bytes to write
+ * @return The number of bytes written. This can only differ from the specified
+ *	   length if the end of the specified stream has been reached or in
+ *	   non-blocking mode.
+ */
+- (size_t)writeFromStream: (OFStream *)stream
+		   length: (size_t)length;
+
 #ifdef OF_HAVE_SOCKETS
 /*!
  * @brief Asynchronously writes data into the stream.
@@ -1052,6 +1211,38 @@ typedef OFString *_Nullable (^of_stream_async_write_string_block_t)(
 		encoding: (of_string_encoding_t)encoding
 	     runLoopMode: (of_run_loop_mode_t)runLoopMode;
 
+/*!
+ * @brief Asynchronously writes data read from the specified stream into the
+ *	  stream (see @ref writeFromStream:length:).
+ *
+ * @note The stream must conform to @ref OFReadyForWritingObserving in order
+ *	 for this to work! The specified stream is read from whenever the
+ *	 stream is ready for writing, so it should be a stream that can always
+ *	 be read from without blocking, like a file.
+ *
+ * @param stream The stream to read the data from
+ * @param length The number of bytes to write
+ */
+- (void)asyncWriteFromStream: (OFStream *)stream
+		      length: (size_t)length;
+
+/*!
+ * @brief Asynchronously writes data read from the specified stream into the
+ *	  stream (see @ref writeFromStream:length:).
+ *
+ * @note The stream must conform to @ref OFReadyForWritingObserving in order
+ *	 for this to work! The specified stream is read from whenever the
+ *	 stream is ready for writing, so it should be a stream that can always
+ *	 be read from without blocking, like a file.
+ *
+ * @param stream The stream to read the data from
+ * @param length The number of bytes to write
+ * @param runLoopMode The run loop mode in which to perform the async write
+ */
+- (void)asyncWriteFromStream: (OFStream *)stream
+		      length: (size_t)length
+		 runLoopMode: (of_run_loop_mode_t)runLoopMode;
+
 # ifdef OF_HAVE_BLOCKS
 /*!
  * @brief Asynchronously writes data into the stream.
@@ -1134,6 +1325,42 @@ typedef OFString *_Nullable (^of_stream_async_write_string_block_t)(
 		encoding: (of_string_encoding_t)encoding
 	     runLoopMode: (of_run_loop_mode_t)runLoopMode
 		   block: (of_stream_async_write_string_block_t)block;
+
+/*!
+ * @brief Asynchronously writes data read from the specified stream into the
+ *	  stream (see @ref writeFromStream:length:).
+ *
+ * @note The stream must conform to @ref OFReadyForWritingObserving in order
+ *	 for this to work! The specified stream is read from whenever the
+ *	 stream is ready for writing, so it should be a stream that can always
+ *	 be read from without blocking, like a file.
+ *
+ * @param stream The stream to read the data from
+ * @param length The number of bytes to write
+ * @param block The block to call when the data has been written
+ */
+- (void)asyncWriteFromStream: (OFStream *)stream
+		      length: (size_t)length
+		       block: (of_stream_async_write_from_stream_block_t)block;
+
+/*!
+ * @brief Asynchronously writes data read from the specified stream into the
+ *	  stream (see @ref writeFromStream:length:).
+ *
+ * @note The stream must conform to @ref OFReadyForWritingObserving in order
+ *	 for this to work! The specified stream is read from whenever the
+ *	 stream is ready for writing, so it should be a stream that can always
+ *	 be read from without blocking, like a file.
+ *
+ * @param stream The stream to read the data from
+ * @param length The number of bytes to write
+ * @param runLoopMode The run loop mode in which to perform the async write
+ * @param block The block to call when the data has been written
+ */
+- (void)asyncWriteFromStream: (OFStream *)stream
+		      length: (size_t)length
+		 runLoopMode: (of_run_loop_mode_t)runLoopMode
+		       block: (of_stream_async_write_from_stream_block_t)block;
 # endif
 #endif
 
@@ -1337,6 +1564,9 @@ typedef OFString *_Nullable (^of_stream_async_write_string_block_t)(
 /*!
  * @brief Writes OFData into the stream.
  *
+ * If the stream is write buffered, large data is not copied into the write
+ * buffer, but referenced until the write buffer is flushed.
+ *
  * @param data The OFData to write into the stream
  * @return The number of bytes written
  */
@@ -1387,6 +1617,10 @@ typedef OFString *_Nullable (^of_stream_async_write_string_block_t)(
  * format specifier for objects, `%C` for `of_unichar_t` and `%S` for
  * `const of_unichar_t *`.
  *
+ * Short output is formatted on the stack without allocating memory. If the
+ * format is invalid, an @ref OFInvalidFormatException is thrown and nothing is
+ * written.
+ *
  * @param format A string used as format
  * @return The number of bytes written
  */
@@ -1399,6 +1633,10 @@ typedef OFString *_Nullable (^of_stream_async_write_string_block_t)(
  * format specifier for objects, `%C` for `of_unichar_t` and `%S` for
  * `const of_unichar_t *`.
  *
+ * Short output is formatted on the stack without allocating memory. If the
+ * format is invalid, an @ref OFInvalidFormatException is thrown and nothing is
+ * written.
+ *
  * @param format A string used as format
  * @param arguments The arguments used in the format string
  * @return The number of bytes written
@@ -1474,6 +1712,24 @@ typedef OFString *_Nullable (^of_stream_async_write_string_block_t)(
 - (size_t)lowlevelWriteBuffer: (const void *)buffer
 		       length: (size_t)length;
 
+/*!
+ * @brief Performs a lowlevel write from several buffers.
+ *
+ * The default implementation calls @ref lowlevelWriteBuffer:length: for each
+ * buffer until one of them is written only partially.
+ *
+ * @warning Do not call this directly!
+ *
+ * @note Override this method if the stream supports vectored writes, e.g.
+ *	 using `writev()`. It is fine to write less than all buffers.
+ *
+ * @param buffers The buffers with the data to write
+ * @param count The number of buffers
+ * @return The number of bytes written
+ */
+- (size_t)lowlevelWriteBuffers: (const of_stream_buffer_t *)buffers
+			 count: (size_t)count;
+
 /*!
  * @brief Returns whether the lowlevel is at the end of the stream.
  *
@@ -1488,3 +1744,5 @@ typedef OFString *_Nullable (^of_stream_async_write_string_block_t)(
 @end
 
 OF_ASSUME_NONNULL_END
+
+#import "OFStream+Serialization.h"
@@ -21,6 +21,7 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <limits.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -29,6 +30,13 @@
 #ifdef HAVE_FCNTL_H
 # include <fcntl.h>
 #endif
+#include "unistd_wrapper.h"
+#ifdef HAVE_SYS_SENDFILE_H
+# include <sys/sendfile.h>
+#endif
+#ifdef HAVE_SYS_UIO_H
+# include <sys/uio.h>
+#endif
 
 #ifdef OF_HAVE_SOCKETS
 # import "socket_helpers.h"
@@ -42,6 +50,7 @@
 
 #import "OFStream.h"
 #import "OFStream+Private.h"
+#import "OFArray.h"
 #import "OFData.h"
 #import "OFKernelEventObserver.h"
 #import "OFRunLoop+Private.h"
@@ -59,8 +68,266 @@
 #import "OFWriteFailedException.h"
 
 #import "of_asprintf.h"
+#import "swar.h"
+
+/* References for static linking */
+void
+_references_to_categories_of_OFStream(void)
+{
+	_OFStream_Serialization_reference = 1;
+}
 
 #define MIN_READ_SIZE 512
+#define MIN_WRITE_REFERENCE_SIZE 4096
+#define FORMAT_BUFFER_SIZE 256
+/* The minimum number of buffers for writev() that POSIX guarantees */
+#define MAX_IOVEC_COUNT 16
+
+#if defined(HAVE_COPY_FILE_RANGE) || defined(HAVE_SPLICE) || \
+    (defined(HAVE_SYS_SENDFILE_H) && defined(HAVE_SENDFILE))
+# define HAVE_KERNEL_COPY
+
+enum {
+	KERNEL_COPY_COPY_FILE_RANGE,
+	KERNEL_COPY_SENDFILE,
+	KERNEL_COPY_SPLICE,
+	KERNEL_COPY_NONE
+};
+#endif
+
+/*
+ * Short output is collected on the stack. Longer output moves to memory
+ * allocated on the stream, as nothing may be written before the whole format
+ * was known to be valid.
+ */
+struct formatContext {
+	OFStream *stream;
+	char stackBuffer[FORMAT_BUFFER_SIZE];
+	char *buffer;
+	size_t length, capacity;
+};
+
+static bool
+collectFormatted(void *context_, const char *string, size_t length)
+{
+	struct formatContext *context = context_;
+
+	if (length > context->capacity - context->length) {
+		size_t capacity = context->capacity;
+
+		while (length > capacity - context->length) {
+			if (capacity > SIZE_MAX / 2)
+				@throw [OFOutOfRangeException exception];
+
+			capacity *= 2;
+		}
+
+		if (context->buffer == context->stackBuffer) {
+			context->buffer = [context->stream
+			    allocMemoryWithSize: capacity];
+			memcpy(context->buffer, context->stackBuffer,
+			    context->length);
+		} else
+			context->buffer = [context->stream
+			    resizeMemory: context->buffer
+				    size: capacity];
+
+		context->capacity = capacity;
+	}
+
+	memcpy(context->buffer + context->length, string, length);
+	context->length += length;
+
+	return true;
+}
+
+@interface OFStream ()
+- (void)of_reserveReadBufferSpace: (size_t)length;
+- (size_t)of_fillReadBuffer;
+- (void)of_consumeReadBuffer: (size_t)length;
+- (size_t)of_tryFindDelimiter: (const char *)delimiter
+		       length: (size_t)delimiterLength
+		    stopAtNUL: (bool)stopAtNUL;
+- (size_t)of_writeBuffers: (const of_stream_buffer_t *)buffers
+		    count: (size_t)count;
+@end
+
+/*
+ * Returns the index of the last byte of the first delimiter that ends at or
+ * after start, or length if there is none. If stopAtNUL is true, a \0 is
+ * treated like a delimiter and its index is returned.
+ *
+ * Bytes that can not end a delimiter are skipped a word at a time.
+ */
+static size_t
+findDelimiter(const char *buffer, size_t start, size_t length,
+    const char *delimiter, size_t delimiterLength, bool stopAtNUL)
+{
+	unsigned char last = delimiter[delimiterLength - 1];
+	size_t i = start;
+
+	while (i < length) {
+		while (i + sizeof(uintptr_t) <= length) {
+			uintptr_t word = of_swar_load(buffer + i);
+			uintptr_t mask = of_swar_byte_mask(word, last);
+
+			if (stopAtNUL)
+				mask |= of_swar_byte_mask(word, '\0');
+
+			if (mask != 0)
+				break;
+
+			i += sizeof(uintptr_t);
+		}
+
+		for (size_t end = i + sizeof(uintptr_t);
+		    i < length && i < end; i++) {
+			if (stopAtNUL && buffer[i] == '\0')
+				return i;
+
+			if ((unsigned char)buffer[i] == last &&
+			    i + 1 >= delimiterLength &&
+			    memcmp(buffer + i + 1 - delimiterLength, delimiter,
+			    delimiterLength - 1) == 0)
+				return i;
+		}
+	}
+
+	return length;
+}
+
+#ifdef HAVE_KERNEL_COPY
+static bool
+isUnsupportedErrNo(int errNo)
+{
+	switch (errNo) {
+	case EBADF:
+	case EINVAL:
+	case ENOSYS:
+	case ESPIPE:
+	case EXDEV:
+# ifdef EOPNOTSUPP
+	case EOPNOTSUPP:
+# endif
+# if defined(ENOTSUP) && (!defined(EOPNOTSUPP) || ENOTSUP != EOPNOTSUPP)
+	case ENOTSUP:
+# endif
+		return true;
+	default:
+		return false;
+	}
+}
+
+# ifdef HAVE_SPLICE
+/*
+ * splice() needs a pipe on one side, so the data is moved through a pipe,
+ * which is created on first use and always drained before returning. The
+ * caller closes it once it is done copying.
+ */
+static ssize_t
+spliceThroughPipe(int in, int out, size_t length, int pipeFDs[2])
+{
+	int errNo = 0;
+	ssize_t ret;
+
+	if (pipeFDs[0] == -1) {
+		if (pipe(pipeFDs) != 0)
+			return -1;
+	}
+
+	ret = splice(in, NULL, pipeFDs[1], NULL, length, SPLICE_F_MOVE);
+	if (ret < 0)
+		errNo = errno;
+
+	for (ssize_t written = 0; ret > 0 && written < ret;) {
+		ssize_t tmp = splice(pipeFDs[0], NULL, out, NULL,
+		    (size_t)(ret - written), SPLICE_F_MOVE);
+
+		if (tmp <= 0) {
+			/* Data in the pipe is lost, so don't fall back */
+			errNo = (tmp < 0 && !isUnsupportedErrNo(errno)
+			    ? errno : EIO);
+			ret = -1;
+			break;
+		}
+
+		written += tmp;
+	}
+
+	if (ret < 0)
+		errno = errNo;
+
+	return ret;
+}
+# endif
+
+/*
+ * Moves up to length bytes from one file descriptor to another without copying
+ * them to userspace. *method is the first method to try and is advanced past
+ * methods that are not supported for the file descriptors. pipeFDs is the pipe
+ * for splice(), which is created on first use if it is -1. Returns the number
+ * of bytes moved, 0 if the end of the input has been reached or if nothing can
+ * be moved without blocking (in which case *wouldBlock is set), or
+ * OF_NOT_FOUND if no method is supported.
+ */
+static size_t
+kernelCopy(OFStream *stream, int in, int out, size_t length, int *method,
+    int pipeFDs[2], bool *wouldBlock)
+{
+	ssize_t ret = -1;
+
+	*wouldBlock = false;
+
+	if (length > SSIZE_MAX)
+		length = SSIZE_MAX;
+
+	for (; *method != KERNEL_COPY_NONE; (*method)++) {
+		switch (*method) {
+# ifdef HAVE_COPY_FILE_RANGE
+		case KERNEL_COPY_COPY_FILE_RANGE:
+			ret = copy_file_range(in, NULL, out, NULL, length, 0);
+			break;
+# endif
+# if defined(HAVE_SYS_SENDFILE_H) && defined(HAVE_SENDFILE)
+		case KERNEL_COPY_SENDFILE:
+			ret = sendfile(out, in, NULL, length);
+			break;
+# endif
+# ifdef HAVE_SPLICE
+		case KERNEL_COPY_SPLICE:
+			/* Data left in the pipe would be lost */
+			if (![stream isBlocking])
+				continue;
+
+			ret = spliceThroughPipe(in, out, length, pipeFDs);
+			break;
+# endif
+		default:
+			continue;
+		}
+
+		if (ret >= 0 || !isUnsupportedErrNo(errno))
+			break;
+	}
+
+	if (*method == KERNEL_COPY_NONE)
+		return OF_NOT_FOUND;
+
+	if (ret < 0) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			*wouldBlock = true;
+			return 0;
+		}
+
+		@throw [OFWriteFailedException exceptionWithObject: stream
+						   requestedLength: length
+						      bytesWritten: 0
+							     errNo: errno];
+	}
+
+	return (size_t)ret;
+}
+#endif
 
 @implementation OFStream
 @synthesize of_waitingForDelimiter = _waitingForDelimiter, delegate = _delegate;
@@ -88,10 +355,19 @@
 	self = [super init];
 
 	_blocking = true;
+	_readBufferSize = [OFSystemInfo pageSize];
 
 	return self;
 }
 
+- (void)dealloc
+{
+	[_writeBufferData release];
+	[_writeBufferDataOffsets release];
+
+	[super dealloc];
+}
+
 - (bool)lowlevelIsAtEndOfStream
 {
 	OF_UNRECOGNIZED_SELECTOR
@@ -109,6 +385,66 @@
 	OF_UNRECOGNIZED_SELECTOR
 }
 
+- (size_t)lowlevelWriteBuffers: (const of_stream_buffer_t *)buffers
+			 count: (size_t)count
+{
+	size_t bytesWritten = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		size_t ret;
+
+		if (buffers[i].length == 0)
+			continue;
+
+		ret = [self lowlevelWriteBuffer: buffers[i].buffer
+					 length: buffers[i].length];
+		bytesWritten += ret;
+
+		if (ret < buffers[i].length)
+			break;
+	}
+
+	return bytesWritten;
+}
+
+#if defined(HAVE_WRITEV) && !defined(OF_WINDOWS)
+- (size_t)of_writeBuffers: (const of_stream_buffer_t *)buffers
+		    count: (size_t)count
+	 toFileDescriptor: (int)fd
+{
+	struct iovec iov[MAX_IOVEC_COUNT];
+	size_t length = 0;
+	ssize_t bytesWritten;
+
+	if (count > MAX_IOVEC_COUNT)
+		count = MAX_IOVEC_COUNT;
+
+	for (size_t i = 0; i < count; i++) {
+		if (buffers[i].length > SSIZE_MAX - length) {
+			if (i == 0)
+				@throw [OFOutOfRangeException exception];
+
+			/* Write the rest with the next call */
+			count = i;
+			break;
+		}
+
+		iov[i].iov_base = (void *)buffers[i].buffer;
+		iov[i].iov_len = buffers[i].length;
+		length += buffers[i].length;
+	}
+
+	if ((bytesWritten = writev(fd, iov, (int)count)) < 0)
+		@throw [OFWriteFailedException
+		    exceptionWithObject: self
+			requestedLength: length
+			   bytesWritten: 0
+				  errNo: errno];
+
+	return (size_t)bytesWritten;
+}
+#endif
+
 - (id)copy
 {
 	return [self retain];
@@ -122,62 +458,207 @@
 	return [self lowlevelIsAtEndOfStream];
 }
 
-- (size_t)readIntoBuffer: (void *)buffer
-		  length: (size_t)length
+/*
+ * Makes sure that there is room for at least length bytes after the data in
+ * the read buffer. If moving the data to the start of the buffer makes enough
+ * room, the buffer is not enlarged.
+ */
+- (void)of_reserveReadBufferSpace: (size_t)length
 {
-	if (_readBufferLength == 0) {
-		/*
-		 * For small sizes, it is cheaper to read more and cache the
-		 * remainder - even if that means more copying of data - than
-		 * to do a syscall for every read.
-		 */
-		if (length < MIN_READ_SIZE) {
-			char tmp[MIN_READ_SIZE], *readBuffer;
-			size_t bytesRead;
+	size_t capacity;
 
-			bytesRead = [self
-			    lowlevelReadIntoBuffer: tmp
-					    length: MIN_READ_SIZE];
+	if (_readBufferMemory == NULL) {
+		capacity = (length > _readBufferSize
+		    ? length : _readBufferSize);
 
-			if (bytesRead > length) {
-				memcpy(buffer, tmp, length);
+		_readBufferMemory = [self allocMemoryWithSize: capacity];
+		_readBuffer = _readBufferMemory;
+		_readBufferCapacity = capacity;
 
-				readBuffer = [self allocMemoryWithSize:
-				    bytesRead - length];
-				memcpy(readBuffer, tmp + length,
-				    bytesRead - length);
+		return;
+	}
 
-				_readBuffer = _readBufferMemory = readBuffer;
-				_readBufferLength = bytesRead - length;
+	if (_readBufferCapacity - (size_t)(_readBuffer - _readBufferMemory) -
+	    _readBufferLength >= length)
+		return;
 
-				return length;
-			} else {
-				memcpy(buffer, tmp, bytesRead);
-				return bytesRead;
-			}
-		}
+	if (length > SIZE_MAX - _readBufferLength)
+		@throw [OFOutOfRangeException exception];
 
-		return [self lowlevelReadIntoBuffer: buffer
-					     length: length];
-	}
+	memmove(_readBufferMemory, _readBuffer, _readBufferLength);
+	_readBuffer = _readBufferMemory;
+
+	if (_readBufferCapacity - _readBufferLength >= length)
+		return;
 
-	if (length >= _readBufferLength) {
-		size_t ret = _readBufferLength;
-		memcpy(buffer, _readBuffer, _readBufferLength);
+	capacity = _readBufferLength + length;
+	if (capacity < _readBufferCapacity * 2 &&
+	    _readBufferCapacity <= SIZE_MAX / 2)
+		capacity = _readBufferCapacity * 2;
 
+	_readBufferMemory = [self resizeMemory: _readBufferMemory
+					  size: capacity];
+	_readBuffer = _readBufferMemory;
+	_readBufferCapacity = capacity;
+}
+
+/*
+ * Reads from the underlying stream directly into the free space after the
+ * data in the read buffer. At least the read buffer size is read at once.
+ */
+- (size_t)of_fillReadBuffer
+{
+	size_t bytesRead;
+
+	[self of_reserveReadBufferSpace: _readBufferSize];
+
+	bytesRead = [self
+	    lowlevelReadIntoBuffer: _readBuffer + _readBufferLength
+			    length: _readBufferCapacity -
+				    (size_t)(_readBuffer - _readBufferMemory) -
+				    _readBufferLength];
+	_readBufferLength += bytesRead;
+
+	return bytesRead;
+}
+
+- (void)of_consumeReadBuffer: (size_t)length
+{
+	_readBuffer += length;
+	_readBufferLength -= length;
+
+	if (_readBufferLength > 0)
+		return;
+
+	/*
+	 * Leftover data and a full read fit into twice the size, anything
+	 * beyond was only needed for a long line.
+	 */
+	if (_readBufferCapacity > 2 * _readBufferSize) {
 		[self freeMemory: _readBufferMemory];
-		_readBuffer = _readBufferMemory = NULL;
-		_readBufferLength = 0;
+		_readBufferMemory = NULL;
+		_readBufferCapacity = 0;
+	}
 
-		return ret;
-	} else {
-		memcpy(buffer, _readBuffer, length);
+	_readBuffer = _readBufferMemory;
+}
 
-		_readBuffer += length;
-		_readBufferLength -= length;
+- (void)of_appendToReadBuffer: (const void *)buffer
+		       length: (size_t)length
+{
+	[self of_reserveReadBufferSpace: length];
 
-		return length;
+	memcpy(_readBuffer + _readBufferLength, buffer, length);
+	_readBufferLength += length;
+
+	/* The new data has not been searched for a delimiter yet */
+	_waitingForDelimiter = false;
+}
+
+/*
+ * Searches the read buffer for a delimiter and reads from the underlying
+ * stream once if there is none yet. Returns the index of the last byte of the
+ * delimiter, _readBufferLength if the end of the stream has been reached or
+ * OF_NOT_FOUND if more data is needed.
+ */
+- (size_t)of_tryFindDelimiter: (const char *)delimiter
+		       length: (size_t)delimiterLength
+		    stopAtNUL: (bool)stopAtNUL
+{
+	/* If we are waiting for a delimiter, the buffer was searched already */
+	size_t i = findDelimiter(_readBuffer,
+	    (_waitingForDelimiter ? _readBufferLength : 0), _readBufferLength,
+	    delimiter, delimiterLength, stopAtNUL);
+
+	if (i < _readBufferLength)
+		return i;
+
+	if ([self lowlevelIsAtEndOfStream])
+		return _readBufferLength;
+
+	[self of_fillReadBuffer];
+
+	/* Only the new data needs to be searched */
+	i = findDelimiter(_readBuffer, i, _readBufferLength, delimiter,
+	    delimiterLength, stopAtNUL);
+
+	return (i < _readBufferLength ? i : OF_NOT_FOUND);
+}
+
+/*
+ * Writes the buffers using as few lowlevel writes as possible. In blocking
+ * mode, partial writes are continued until everything has been written or
+ * nothing could be written anymore.
+ */
+- (size_t)of_writeBuffers: (const of_stream_buffer_t *)buffers
+		    count: (size_t)count
+{
+	size_t bytesWritten = 0;
+
+	while (count > 0) {
+		size_t ret = [self lowlevelWriteBuffers: buffers
+						  count: count];
+		size_t remaining = ret;
+
+		bytesWritten += ret;
+
+		while (count > 0 && remaining >= buffers->length) {
+			remaining -= buffers->length;
+			buffers++;
+			count--;
+		}
+
+		if (count == 0 || ret == 0 || !_blocking)
+			break;
+
+		/* Finish the partially written buffer before continuing */
+		if (remaining > 0) {
+			const char *buffer = (const char *)buffers->buffer +
+			    remaining;
+			size_t length = buffers->length - remaining;
+
+			while (length > 0) {
+				if ((ret = [self lowlevelWriteBuffer: buffer
+							      length: length])
+				    == 0)
+					return bytesWritten;
+
+				bytesWritten += ret;
+				buffer += ret;
+				length -= ret;
+			}
+
+			buffers++;
+			count--;
+		}
 	}
+
+	return bytesWritten;
+}
+
+- (size_t)readIntoBuffer: (void *)buffer
+		  length: (size_t)length
+{
+	if (_readBufferLength == 0) {
+		/*
+		 * For small sizes, it is cheaper to read more and cache the
+		 * remainder - even if that means more copying of data - than
+		 * to do a syscall for every read.
+		 */
+		if (length >= MIN_READ_SIZE)
+			return [self lowlevelReadIntoBuffer: buffer
+						     length: length];
+
+		[self of_fillReadBuffer];
+	}
+
+	if (length > _readBufferLength)
+		length = _readBufferLength;
+
+	memcpy(buffer, _readBuffer, length);
+	[self of_consumeReadBuffer: length];
+
+	return length;
 }
 
 - (void)readIntoBuffer: (void *)buffer
@@ -707,154 +1188,42 @@
 
 - (OFString *)tryReadLineWithEncoding: (of_string_encoding_t)encoding
 {
-	size_t pageSize, bufferLength, retLength;
-	char *retCString, *buffer, *readBuffer;
+	size_t i, retLength;
 	OFString *ret;
 
-	/* Look if there's a line or \0 in our buffer */
-	if (!_waitingForDelimiter && _readBuffer != NULL) {
-		for (size_t i = 0; i < _readBufferLength; i++) {
-			if OF_UNLIKELY (_readBuffer[i] == '\n' ||
-			    _readBuffer[i] == '\0') {
-				retLength = i;
-
-				if (i > 0 && _readBuffer[i - 1] == '\r')
-					retLength--;
-
-				ret = [OFString stringWithCString: _readBuffer
-							 encoding: encoding
-							   length: retLength];
+	i = [self of_tryFindDelimiter: "\n"
+			       length: 1
+			    stopAtNUL: true];
 
-				_readBuffer += i + 1;
-				_readBufferLength -= i + 1;
-
-				_waitingForDelimiter = false;
-				return ret;
-			}
-		}
+	if (i == OF_NOT_FOUND) {
+		_waitingForDelimiter = true;
+		return nil;
 	}
 
-	/* Read and see if we got a newline or \0 */
-	pageSize = [OFSystemInfo pageSize];
-	buffer = [self allocMemoryWithSize: pageSize];
-
-	@try {
-		if ([self lowlevelIsAtEndOfStream]) {
-			if (_readBuffer == NULL) {
-				_waitingForDelimiter = false;
-				return nil;
-			}
-
-			retLength = _readBufferLength;
-
-			if (retLength > 0 && _readBuffer[retLength - 1] == '\r')
-				retLength--;
-
-			ret = [OFString stringWithCString: _readBuffer
-						 encoding: encoding
-						   length: retLength];
-
-			[self freeMemory: _readBufferMemory];
-			_readBuffer = _readBufferMemory = NULL;
-			_readBufferLength = 0;
-
+	if (i == _readBufferLength) {
+		/* End of stream */
+		if (_readBufferLength == 0) {
 			_waitingForDelimiter = false;
-			return ret;
+			return nil;
 		}
 
-		bufferLength = [self lowlevelReadIntoBuffer: buffer
-						     length: pageSize];
-
-		/* Look if there's a newline or \0 */
-		for (size_t i = 0; i < bufferLength; i++) {
-			if OF_UNLIKELY (buffer[i] == '\n' ||
-			    buffer[i] == '\0') {
-				retLength = _readBufferLength + i;
-				retCString = [self
-				    allocMemoryWithSize: retLength];
-
-				if (_readBuffer != NULL)
-					memcpy(retCString, _readBuffer,
-					    _readBufferLength);
-				memcpy(retCString + _readBufferLength,
-				    buffer, i);
-
-				if (retLength > 0 &&
-				    retCString[retLength - 1] == '\r')
-					retLength--;
-
-				@try {
-					char *rcs = retCString;
-					size_t rl = retLength;
-
-					ret = [OFString
-					    stringWithCString: rcs
-						     encoding: encoding
-						       length: rl];
-				} @catch (id e) {
-					if (bufferLength > 0) {
-						/*
-						 * Append data to _readBuffer
-						 * to prevent loss of data.
-						 */
-						readBuffer = [self
-						    allocMemoryWithSize:
-						    _readBufferLength +
-						    bufferLength];
-
-						memcpy(readBuffer, _readBuffer,
-						    _readBufferLength);
-						memcpy(readBuffer +
-						    _readBufferLength,
-						    buffer, bufferLength);
-
-						[self freeMemory:
-						    _readBufferMemory];
-						_readBuffer = readBuffer;
-						_readBufferMemory = readBuffer;
-						_readBufferLength +=
-						    bufferLength;
-					}
-
-					@throw e;
-				} @finally {
-					[self freeMemory: retCString];
-				}
-
-				readBuffer = [self
-				    allocMemoryWithSize: bufferLength - i - 1];
-				if (readBuffer != NULL)
-					memcpy(readBuffer, buffer + i + 1,
-					    bufferLength - i - 1);
-
-				[self freeMemory: _readBufferMemory];
-				_readBuffer = _readBufferMemory = readBuffer;
-				_readBufferLength = bufferLength - i - 1;
-
-				_waitingForDelimiter = false;
-				return ret;
-			}
-		}
+		retLength = _readBufferLength;
+		i = _readBufferLength - 1;
+	} else
+		retLength = i;
 
-		/* There was no newline or \0 */
-		if (bufferLength > 0) {
-			readBuffer = [self allocMemoryWithSize:
-			    _readBufferLength + bufferLength];
+	if (retLength > 0 && _readBuffer[retLength - 1] == '\r')
+		retLength--;
 
-			memcpy(readBuffer, _readBuffer, _readBufferLength);
-			memcpy(readBuffer + _readBufferLength,
-			    buffer, bufferLength);
+	/* If this throws, the data stays in the buffer and is not lost */
+	ret = [OFString stringWithCString: _readBuffer
+				 encoding: encoding
+				   length: retLength];
 
-			[self freeMemory: _readBufferMemory];
-			_readBuffer = _readBufferMemory = readBuffer;
-			_readBufferLength += bufferLength;
-		}
-	} @finally {
-		[self freeMemory: buffer];
-	}
+	[self of_consumeReadBuffer: i + 1];
 
-	_waitingForDelimiter = true;
-	return nil;
+	_waitingForDelimiter = false;
+	return ret;
 }
 
 - (OFString *)readLine
@@ -942,166 +1311,148 @@
 			  encoding: (of_string_encoding_t)encoding
 {
 	const char *delimiterCString;
-	size_t j, delimiterLength, pageSize, bufferLength, retLength;
-	char *retCString, *buffer, *readBuffer;
+	size_t i, delimiterLength, retLength;
 	OFString *ret;
 
 	delimiterCString = [delimiter cStringWithEncoding: encoding];
 	delimiterLength = [delimiter cStringLengthWithEncoding: encoding];
-	j = 0;
 
 	if (delimiterLength == 0)
 		@throw [OFInvalidArgumentException exception];
 
-	/* Look if there's something in our buffer */
-	if (!_waitingForDelimiter && _readBuffer != NULL) {
-		for (size_t i = 0; i < _readBufferLength; i++) {
-			if (_readBuffer[i] != delimiterCString[j++])
-				j = 0;
+	i = [self of_tryFindDelimiter: delimiterCString
+			       length: delimiterLength
+			    stopAtNUL: true];
 
-			if (j == delimiterLength || _readBuffer[i] == '\0') {
-				if (_readBuffer[i] == '\0')
-					delimiterLength = 1;
+	if (i == OF_NOT_FOUND) {
+		_waitingForDelimiter = true;
+		return nil;
+	}
 
-				ret = [OFString
-				    stringWithCString: _readBuffer
-					     encoding: encoding
-					      length: i + 1 - delimiterLength];
+	if (i == _readBufferLength) {
+		/* End of stream */
+		if (_readBufferLength == 0) {
+			_waitingForDelimiter = false;
+			return nil;
+		}
 
-				_readBuffer += i + 1;
-				_readBufferLength -= i + 1;
+		retLength = _readBufferLength;
+		i = _readBufferLength - 1;
+	} else if (_readBuffer[i] == '\0')
+		retLength = i;
+	else
+		retLength = i + 1 - delimiterLength;
 
-				_waitingForDelimiter = false;
-				return ret;
-			}
-		}
-	}
+	/* If this throws, the data stays in the buffer and is not lost */
+	ret = [OFString stringWithCString: _readBuffer
+				 encoding: encoding
+				   length: retLength];
 
-	/* Read and see if we got a delimiter or \0 */
-	pageSize = [OFSystemInfo pageSize];
-	buffer = [self allocMemoryWithSize: pageSize];
+	[self of_consumeReadBuffer: i + 1];
 
-	@try {
-		if ([self lowlevelIsAtEndOfStream]) {
-			if (_readBuffer == NULL) {
-				_waitingForDelimiter = false;
-				return nil;
-			}
+	_waitingForDelimiter = false;
+	return ret;
+}
 
-			ret = [OFString stringWithCString: _readBuffer
-						 encoding: encoding
-						   length: _readBufferLength];
+- (OFData *)readDataUntilDelimiter: (OFData *)delimiter
+{
+	OFData *ret = nil;
 
-			[self freeMemory: _readBufferMemory];
-			_readBuffer = _readBufferMemory = NULL;
-			_readBufferLength = 0;
+	while ((ret = [self tryReadDataUntilDelimiter: delimiter]) == nil)
+		if ([self isAtEndOfStream])
+			return nil;
 
+	return ret;
+}
+
+- (OFData *)tryReadDataUntilDelimiter: (OFData *)delimiter
+{
+	size_t i, delimiterLength = [delimiter count], retLength;
+	OFData *ret;
+
+	if ([delimiter itemSize] != 1 || delimiterLength == 0)
+		@throw [OFInvalidArgumentException exception];
+
+	i = [self of_tryFindDelimiter: [delimiter items]
+			       length: delimiterLength
+			    stopAtNUL: false];
+
+	if (i == OF_NOT_FOUND) {
+		_waitingForDelimiter = true;
+		return nil;
+	}
+
+	if (i == _readBufferLength) {
+		/* End of stream */
+		if (_readBufferLength == 0) {
 			_waitingForDelimiter = false;
-			return ret;
+			return nil;
 		}
 
-		bufferLength = [self lowlevelReadIntoBuffer: buffer
-						     length: pageSize];
-
-		/* Look if there's a delimiter or \0 */
-		for (size_t i = 0; i < bufferLength; i++) {
-			if (buffer[i] != delimiterCString[j++])
-				j = 0;
-
-			if (j == delimiterLength || buffer[i] == '\0') {
-				if (buffer[i] == '\0')
-					delimiterLength = 1;
-
-				retLength = _readBufferLength + i + 1 -
-				    delimiterLength;
-				retCString = [self
-				    allocMemoryWithSize: retLength];
-
-				if (_readBuffer != NULL &&
-				    _readBufferLength <= retLength)
-					memcpy(retCString, _readBuffer,
-					    _readBufferLength);
-				else if (_readBuffer != NULL)
-					memcpy(retCString, _readBuffer,
-					    retLength);
-				if (i >= delimiterLength)
-					memcpy(retCString + _readBufferLength,
-					    buffer, i + 1 - delimiterLength);
-
-				@try {
-					char *rcs = retCString;
-					size_t rl = retLength;
-
-					ret = [OFString
-					    stringWithCString: rcs
-						     encoding: encoding
-						       length: rl];
-				} @catch (id e) {
-					if (bufferLength > 0) {
-						/*
-						 * Append data to _readBuffer
-						 * to prevent loss of data.
-						 */
-						readBuffer = [self
-						    allocMemoryWithSize:
-						    _readBufferLength +
-						    bufferLength];
-
-						memcpy(readBuffer, _readBuffer,
-						    _readBufferLength);
-						memcpy(readBuffer +
-						    _readBufferLength,
-						    buffer, bufferLength);
-
-						[self freeMemory:
-						    _readBufferMemory];
-						_readBuffer = readBuffer;
-						_readBufferMemory = readBuffer;
-						_readBufferLength +=
-						    bufferLength;
-					}
+		retLength = _readBufferLength;
+		i = _readBufferLength - 1;
+	} else
+		retLength = i + 1 - delimiterLength;
 
-					@throw e;
-				} @finally {
-					[self freeMemory: retCString];
-				}
-
-				readBuffer = [self allocMemoryWithSize:
-				    bufferLength - i - 1];
-				if (readBuffer != NULL)
-					memcpy(readBuffer, buffer + i + 1,
-					    bufferLength - i - 1);
-
-				[self freeMemory: _readBufferMemory];
-				_readBuffer = _readBufferMemory = readBuffer;
-				_readBufferLength = bufferLength - i - 1;
-
-				_waitingForDelimiter = false;
-				return ret;
-			}
-		}
+	ret = [OFData dataWithItems: _readBuffer
+			      count: retLength];
 
-		/* Neither the delimiter nor \0 was found */
-		if (bufferLength > 0) {
-			readBuffer = [self allocMemoryWithSize:
-			    _readBufferLength + bufferLength];
+	[self of_consumeReadBuffer: i + 1];
 
-			memcpy(readBuffer, _readBuffer, _readBufferLength);
-			memcpy(readBuffer + _readBufferLength,
-			    buffer, bufferLength);
+	_waitingForDelimiter = false;
+	return ret;
+}
 
-			[self freeMemory: _readBufferMemory];
-			_readBuffer = _readBufferMemory = readBuffer;
-			_readBufferLength += bufferLength;
+#ifdef OF_HAVE_BLOCKS
+- (bool)enumerateLinesUsingBlock: (of_stream_line_enumeration_block_t)block
+{
+	bool stop = false;
+
+	_waitingForDelimiter = false;
+
+	while (!stop) {
+		size_t i, length;
+		void *pool;
+
+		i = [self of_tryFindDelimiter: "\n"
+				       length: 1
+				    stopAtNUL: false];
+
+		if (i == OF_NOT_FOUND) {
+			_waitingForDelimiter = true;
+
+			/* Don't spin waiting for data if non-blocking */
+			if (!_blocking)
+				return false;
+
+			continue;
 		}
-	} @finally {
-		[self freeMemory: buffer];
+
+		_waitingForDelimiter = false;
+
+		if (i == _readBufferLength) {
+			/* End of stream */
+			if (_readBufferLength == 0)
+				return true;
+
+			length = _readBufferLength;
+			i = _readBufferLength - 1;
+		} else
+			length = i;
+
+		if (length > 0 && _readBuffer[length - 1] == '\r')
+			length--;
+
+		pool = objc_autoreleasePoolPush();
+		block(_readBuffer, length, &stop);
+		objc_autoreleasePoolPop(pool);
+
+		[self of_consumeReadBuffer: i + 1];
 	}
 
-	_waitingForDelimiter = true;
-	return nil;
+	return false;
 }
-
+#endif
 
 - (OFString *)readTillDelimiter: (OFString *)delimiter
 {
@@ -1141,15 +1492,60 @@
 
 - (void)flushWriteBuffer
 {
-	if (_writeBuffer == NULL)
+	OFData *const *data;
+	const size_t *offsets;
+	size_t dataCount, count = 0, offset = 0;
+	of_stream_buffer_t *buffers;
+
+	if (_writeBuffer == NULL && _writeBufferData == nil)
 		return;
 
-	[self lowlevelWriteBuffer: _writeBuffer
-			   length: _writeBufferLength];
+	/*
+	 * Referenced data is interleaved with the write buffer: Each offset
+	 * specifies after how many bytes of the write buffer the data follows.
+	 */
+	data = [_writeBufferData objects];
+	offsets = [_writeBufferDataOffsets items];
+	dataCount = [_writeBufferData count];
+
+	buffers = [self allocMemoryWithSize: sizeof(*buffers)
+				      count: 2 * dataCount + 1];
+	@try {
+		for (size_t i = 0; i < dataCount; i++) {
+			if (offsets[i] > offset) {
+				buffers[count].buffer = _writeBuffer + offset;
+				buffers[count].length = offsets[i] - offset;
+				count++;
+
+				offset = offsets[i];
+			}
+
+			buffers[count].buffer = [data[i] items];
+			buffers[count].length =
+			    [data[i] count] * [data[i] itemSize];
+			count++;
+		}
+
+		if (_writeBufferLength > offset) {
+			buffers[count].buffer = _writeBuffer + offset;
+			buffers[count].length = _writeBufferLength - offset;
+			count++;
+		}
+
+		[self of_writeBuffers: buffers
+				count: count];
+	} @finally {
+		[self freeMemory: buffers];
+	}
 
 	[self freeMemory: _writeBuffer];
 	_writeBuffer = NULL;
 	_writeBufferLength = 0;
+
+	[_writeBufferData release];
+	_writeBufferData = nil;
+	[_writeBufferDataOffsets release];
+	_writeBufferDataOffsets = nil;
 }
 
 - (size_t)writeBuffer: (const void *)buffer
@@ -1177,6 +1573,159 @@
 	}
 }
 
+- (int)of_fileDescriptorForZeroCopyReading
+{
+	return -1;
+}
+
+- (int)of_fileDescriptorForZeroCopyWriting
+{
+	return -1;
+}
+
+- (void)of_prepareForZeroCopyWriting
+{
+}
+
+- (size_t)writeFromStream: (OFStream *)stream
+		   length: (size_t)length
+{
+#ifdef HAVE_KERNEL_COPY
+	int method = KERNEL_COPY_COPY_FILE_RANGE, in, out;
+	int pipeFDs[2] = { -1, -1 };
+#endif
+	size_t bytesWritten = 0;
+
+	if (stream == nil || stream == self)
+		@throw [OFInvalidArgumentException exception];
+
+#ifdef HAVE_KERNEL_COPY
+	in = [stream of_fileDescriptorForZeroCopyReading];
+	out = (!_writeBuffered
+	    ? [self of_fileDescriptorForZeroCopyWriting] : -1);
+#endif
+
+	@try {
+		while (bytesWritten < length) {
+			size_t toWrite = length - bytesWritten, ret;
+
+#ifdef HAVE_KERNEL_COPY
+			/* Data in the read buffer needs to be written first */
+			if (in != -1 && out != -1 &&
+			    stream->_readBufferLength == 0) {
+				bool wouldBlock;
+
+				[self of_prepareForZeroCopyWriting];
+
+				ret = kernelCopy(self, in, out, toWrite,
+				    &method, pipeFDs, &wouldBlock);
+
+				if (ret == OF_NOT_FOUND)
+					in = -1;
+				else if (ret > 0) {
+					bytesWritten += ret;
+					continue;
+				} else if (wouldBlock)
+					break;
+
+				/*
+				 * At the end of the stream, fall through to
+				 * the read, so that the stream notices it.
+				 */
+			}
+#endif
+
+			if (stream->_readBufferLength == 0) {
+				if ([stream lowlevelIsAtEndOfStream])
+					break;
+
+				if ([stream of_fillReadBuffer] == 0)
+					break;
+			}
+
+			if (toWrite > stream->_readBufferLength)
+				toWrite = stream->_readBufferLength;
+
+			@try {
+				ret = [self
+				    writeBuffer: stream->_readBuffer
+					 length: toWrite];
+			} @catch (OFWriteFailedException *e) {
+				int errNo = [e errNo];
+
+				/*
+				 * If a non-blocking stream is full, return how
+				 * much has been written so far, as that data
+				 * has already been consumed from the other
+				 * stream. This is the same as for the kernel
+				 * copy above.
+				 */
+				if (_blocking ||
+				    (errNo != EWOULDBLOCK && errNo != EAGAIN))
+					@throw e;
+
+				ret = [e bytesWritten];
+			}
+
+			[stream of_consumeReadBuffer: ret];
+			bytesWritten += ret;
+
+			if (ret < toWrite)
+				break;
+		}
+	} @finally {
+#ifdef HAVE_SPLICE
+		if (pipeFDs[0] != -1) {
+			close(pipeFDs[0]);
+			close(pipeFDs[1]);
+		}
+#endif
+	}
+
+	return bytesWritten;
+}
+
+- (size_t)writeBuffers: (const of_stream_buffer_t *)buffers
+		 count: (size_t)count
+{
+	size_t length = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		if (SIZE_MAX - length < buffers[i].length)
+			@throw [OFOutOfRangeException exception];
+
+		length += buffers[i].length;
+	}
+
+	if (!_writeBuffered) {
+		size_t bytesWritten = [self of_writeBuffers: buffers
+						      count: count];
+
+		if (_blocking && bytesWritten < length)
+			@throw [OFWriteFailedException
+			    exceptionWithObject: self
+				requestedLength: length
+				   bytesWritten: bytesWritten
+					  errNo: 0];
+
+		return bytesWritten;
+	} else {
+		if (SIZE_MAX - _writeBufferLength < length)
+			@throw [OFOutOfRangeException exception];
+
+		_writeBuffer = [self resizeMemory: _writeBuffer
+					     size: _writeBufferLength + length];
+
+		for (size_t i = 0; i < count; i++) {
+			memcpy(_writeBuffer + _writeBufferLength,
+			    buffers[i].buffer, buffers[i].length);
+			_writeBufferLength += buffers[i].length;
+		}
+
+		return length;
+	}
+}
+
 #ifdef OF_HAVE_SOCKETS
 - (void)asyncWriteData: (OFData *)data
 {
@@ -1231,6 +1780,31 @@
 				    delegate: _delegate];
 }
 
+- (void)asyncWriteFromStream: (OFStream *)stream
+		      length: (size_t)length
+{
+	[self asyncWriteFromStream: stream
+			    length: length
+		       runLoopMode: of_run_loop_mode_default];
+}
+
+- (void)asyncWriteFromStream: (OFStream *)stream
+		      length: (size_t)length
+		 runLoopMode: (of_run_loop_mode_t)runLoopMode
+{
+	OFStream <OFReadyForWritingObserving> *destination =
+	    (OFStream <OFReadyForWritingObserving> *)self;
+
+	[OFRunLoop of_addAsyncWriteForStream: destination
+				  fromStream: stream
+				      length: length
+					mode: runLoopMode
+# ifdef OF_HAVE_BLOCKS
+				       block: NULL
+# endif
+				    delegate: _delegate];
+}
+
 # ifdef OF_HAVE_BLOCKS
 - (void)asyncWriteData: (OFData *)data
 		 block: (of_stream_async_write_data_block_t)block
@@ -1288,6 +1862,32 @@
 				       block: block
 				    delegate: nil];
 }
+
+- (void)asyncWriteFromStream: (OFStream *)stream
+		      length: (size_t)length
+		       block: (of_stream_async_write_from_stream_block_t)block
+{
+	[self asyncWriteFromStream: stream
+			    length: length
+		       runLoopMode: of_run_loop_mode_default
+			     block: block];
+}
+
+- (void)asyncWriteFromStream: (OFStream *)stream
+		      length: (size_t)length
+		 runLoopMode: (of_run_loop_mode_t)runLoopMode
+		       block: (of_stream_async_write_from_stream_block_t)block
+{
+	OFStream <OFReadyForWritingObserving> *destination =
+	    (OFStream <OFReadyForWritingObserving> *)self;
+
+	[OFRunLoop of_addAsyncWriteForStream: destination
+				  fromStream: stream
+				      length: length
+					mode: runLoopMode
+				       block: block
+				    delegate: nil];
+}
 # endif
 #endif
 
@@ -1698,8 +2298,28 @@
 	pool = objc_autoreleasePoolPush();
 	length = [data count] * [data itemSize];
 
-	[self writeBuffer: [data items]
-		   length: length];
+	if (_writeBuffered && length >= MIN_WRITE_REFERENCE_SIZE) {
+		/*
+		 * Large data is referenced instead of copied into the write
+		 * buffer. Copying immutable data only retains it.
+		 */
+		if (_writeBufferData == nil) {
+			_writeBufferData = [[OFMutableArray alloc] init];
+			_writeBufferDataOffsets = [[OFMutableData alloc]
+			    initWithItemSize: sizeof(size_t)];
+		}
+
+		[_writeBufferDataOffsets addItem: &_writeBufferLength];
+		@try {
+			[_writeBufferData addObject:
+			    [[data copy] autorelease]];
+		} @catch (id e) {
+			[_writeBufferDataOffsets removeLastItem];
+			@throw e;
+		}
+	} else
+		[self writeBuffer: [data items]
+			   length: length];
 
 	objc_autoreleasePoolPop(pool);
 
@@ -1776,21 +2396,28 @@
 - (size_t)writeFormat: (OFConstantString *)format
 	    arguments: (va_list)arguments
 {
-	char *UTF8String;
+	struct formatContext context;
 	int length;
 
 	if (format == nil)
 		@throw [OFInvalidArgumentException exception];
 
-	if ((length = of_vasprintf(&UTF8String, [format UTF8String],
-	    arguments)) == -1)
-		@throw [OFInvalidFormatException exception];
+	context.stream = self;
+	context.buffer = context.stackBuffer;
+	context.length = 0;
+	context.capacity = FORMAT_BUFFER_SIZE;
 
 	@try {
-		[self writeBuffer: UTF8String
-			   length: length];
+		if ((length = of_vformat(collectFormatted, &context,
+		    [format UTF8String], arguments)) == -1)
+			@throw [OFInvalidFormatException exception];
+
+		if (context.length > 0)
+			[self writeBuffer: context.buffer
+				   length: context.length];
 	} @finally {
-		free(UTF8String);
+		if (context.buffer != context.stackBuffer)
+			[self freeMemory: context.buffer];
 	}
 
 	return length;
@@ -1801,6 +2428,26 @@
 	return (_readBufferLength > 0);
 }
 
+- (size_t)readBufferSize
+{
+	return _readBufferSize;
+}
+
+- (void)setReadBufferSize: (size_t)readBufferSize
+{
+	if (readBufferSize == 0)
+		@throw [OFInvalidArgumentException exception];
+
+	_readBufferSize = readBufferSize;
+
+	/* Use the new size right away if the buffer is not in use */
+	if (_readBufferLength == 0 && _readBufferCapacity != readBufferSize) {
+		[self freeMemory: _readBufferMemory];
+		_readBuffer = _readBufferMemory = NULL;
+		_readBufferCapacity = 0;
+	}
+}
+
 - (bool)isBlocking
 {
 	return _blocking;
@@ -1894,17 +2541,14 @@
 - (void)unreadFromBuffer: (const void *)buffer
 		  length: (size_t)length
 {
-	char *readBuffer;
+	if (_readBufferMemory == NULL ||
+	    (size_t)(_readBuffer - _readBufferMemory) < length) {
+		[self of_reserveReadBufferSpace: length];
+		memmove(_readBuffer + length, _readBuffer, _readBufferLength);
+	} else
+		_readBuffer -= length;
 
-	if (length > SIZE_MAX - _readBufferLength)
-		@throw [OFOutOfRangeException exception];
-
-	readBuffer = [self allocMemoryWithSize: _readBufferLength + length];
-	memcpy(readBuffer, buffer, length);
-	memcpy(readBuffer + length, _readBuffer, _readBufferLength);
-
-	[self freeMemory: _readBufferMemory];
-	_readBuffer = _readBufferMemory = readBuffer;
+	memcpy(_readBuffer, buffer, length);
 	_readBufferLength += length;
 }
 
@@ -1912,13 +2556,18 @@
 {
 	[self freeMemory: _readBufferMemory];
 	_readBuffer = _readBufferMemory = NULL;
-	_readBufferLength = 0;
+	_readBufferLength = _readBufferCapacity = 0;
 
 	[self freeMemory: _writeBuffer];
 	_writeBuffer = NULL;
 	_writeBufferLength = 0;
 	_writeBuffered = false;
 
+	[_writeBufferData release];
+	_writeBufferData = nil;
+	[_writeBufferDataOffsets release];
+	_writeBufferDataOffsets = nil;
+
 	_waitingForDelimiter = false;
 }
 @end
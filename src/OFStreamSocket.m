@@ -23,6 +23,7 @@
 #include <string.h>
 
 #import "OFStreamSocket.h"
+#import "OFStream+Private.h"
 
 #import "OFInitializationFailedException.h"
 #import "OFNotImplementedException.h"
@@ -124,6 +125,30 @@
 	return (size_t)bytesWritten;
 }
 
+#if defined(HAVE_WRITEV) && !defined(OF_WINDOWS)
+- (size_t)lowlevelWriteBuffers: (const of_stream_buffer_t *)buffers
+			 count: (size_t)count
+{
+	SEL selector = @selector(lowlevelWriteBuffer:length:);
+
+	/*
+	 * Subclasses that override lowlevelWriteBuffer:length:, e.g. to
+	 * encrypt the data, need it to be called for every buffer.
+	 */
+	if ([self methodForSelector: selector] !=
+	    [OFStreamSocket instanceMethodForSelector: selector])
+		return [super lowlevelWriteBuffers: buffers
+					     count: count];
+
+	if (_socket == INVALID_SOCKET)
+		@throw [OFNotOpenException exceptionWithObject: self];
+
+	return [self of_writeBuffers: buffers
+			       count: count
+		    toFileDescriptor: _socket];
+}
+#endif
+
 #ifdef OF_WINDOWS
 - (void)setBlocking: (bool)enable
 {
@@ -168,6 +193,31 @@
 #endif
 }
 
+#ifndef OF_WINDOWS
+- (int)of_fileDescriptorForZeroCopyReading
+{
+	SEL selector = @selector(lowlevelReadIntoBuffer:length:);
+
+	/* Subclasses might modify the data, e.g. to decrypt it */
+	if ([self methodForSelector: selector] !=
+	    [OFStreamSocket instanceMethodForSelector: selector])
+		return -1;
+
+	return _socket;
+}
+
+- (int)of_fileDescriptorForZeroCopyWriting
+{
+	SEL selector = @selector(lowlevelWriteBuffer:length:);
+
+	if ([self methodForSelector: selector] !=
+	    [OFStreamSocket instanceMethodForSelector: selector])
+		return -1;
+
+	return _socket;
+}
+#endif
+
 - (void)close
 {
 	if (_socket == INVALID_SOCKET)
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFString+JSONValue.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+@class OFNumber;
+
+/*
+ * Whether an unquoted key can start with the character. Non-ASCII characters
+ * need to be escaped there, but not in the rest of the key.
+ */
+static OF_INLINE bool
+of_json_is_identifier_start(char c)
+{
+	return ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+	    c == '_' || c == '$' || c == '\\');
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * These parse a single token starting at *pointer and advance *pointer past
+ * it. They return nil if the token is invalid. The token must not end at stop,
+ * but be followed by at least one more character.
+ */
+extern OFString *_Nullable of_json_parse_string(
+    const char *_Nonnull *_Nonnull pointer, const char *stop, size_t *line);
+extern OFString *_Nullable of_json_parse_identifier(
+    const char *_Nonnull *_Nonnull pointer, const char *stop);
+extern OFNumber *_Nullable of_json_parse_number(
+    const char *_Nonnull *_Nonnull pointer, const char *stop, size_t *line);
+#ifdef __cplusplus
+}
+#endif
+
+OF_ASSUME_NONNULL_END
@@ -25,6 +25,7 @@
 #include <assert.h>
 
 #import "OFString+JSONValue.h"
+#import "OFString+JSONValue+Private.h"
 #import "OFArray.h"
 #import "OFDictionary.h"
 #import "OFNumber.h"
@@ -32,6 +33,8 @@
 
 #import "OFInvalidJSONException.h"
 
+#import "of_dtoa.h"
+
 int _OFString_JSONValue_reference;
 
 static id nextObject(const char **pointer, const char *stop, size_t *line,
@@ -138,8 +141,8 @@ parseUnicodeEscape(const char *pointer, const char *stop)
 	return ret;
 }
 
-static inline OFString *
-parseString(const char **pointer, const char *stop, size_t *line)
+OFString *
+of_json_parse_string(const char **pointer, const char *stop, size_t *line)
 {
 	char *buffer;
 	size_t i = 0;
@@ -289,8 +292,8 @@ parseString(const char **pointer, const char *stop, size_t *line)
 	return nil;
 }
 
-static inline OFString *
-parseIdentifier(const char **pointer, const char *stop)
+OFString *
+of_json_parse_identifier(const char **pointer, const char *stop)
 {
 	char *buffer;
 	size_t i = 0;
@@ -483,10 +486,8 @@ parseDictionary(const char **pointer, const char *stop, size_t *line,
 		if (*pointer + 1 >= stop)
 			return nil;
 
-		if ((**pointer >= 'a' && **pointer <= 'z') ||
-		    (**pointer >= 'A' && **pointer <= 'Z') ||
-		    **pointer == '_' || **pointer == '$' || **pointer == '\\')
-			key = parseIdentifier(pointer, stop);
+		if (of_json_is_identifier_start(**pointer))
+			key = of_json_parse_identifier(pointer, stop);
 		else
 			key = nextObject(pointer, stop, line, depthLimit);
 
@@ -525,8 +526,8 @@ parseDictionary(const char **pointer, const char *stop, size_t *line,
 	return dictionary;
 }
 
-static inline OFNumber *
-parseNumber(const char **pointer, const char *stop, size_t *line)
+OFNumber *
+of_json_parse_number(const char **pointer, const char *stop, size_t *line)
 {
 	bool isHex = (*pointer + 1 < stop && (*pointer)[1] == 'x');
 	bool hasDecimal = false;
@@ -535,7 +536,8 @@ parseNumber(const char **pointer, const char *stop, size_t *line)
 	OFNumber *number;
 
 	for (i = 0; *pointer + i < stop; i++) {
-		if ((*pointer)[i] == '.')
+		if ((*pointer)[i] == '.' || (!isHex &&
+		    ((*pointer)[i] == 'e' || (*pointer)[i] == 'E')))
 			hasDecimal = true;
 
 		if ((*pointer)[i] == ' ' || (*pointer)[i] == '\t' ||
@@ -549,6 +551,16 @@ parseNumber(const char **pointer, const char *stop, size_t *line)
 		}
 	}
 
+	if (hasDecimal) {
+		double value;
+
+		/* Avoid creating a string for the common case */
+		if (of_parse_double(*pointer, i, &value)) {
+			*pointer += i;
+			return [OFNumber numberWithDouble: value];
+		}
+	}
+
 	string = [[OFString alloc] initWithUTF8String: *pointer
 					       length: i];
 	*pointer += i;
@@ -586,7 +598,7 @@ nextObject(const char **pointer, const char *stop, size_t *line,
 	switch (**pointer) {
 	case '"':
 	case '\'':
-		return parseString(pointer, stop, line);
+		return of_json_parse_string(pointer, stop, line);
 	case '[':
 		return parseArray(pointer, stop, line, depthLimit);
 	case '{':
@@ -635,7 +647,7 @@ nextObject(const char **pointer, const char *stop, size_t *line,
 	case '-':
 	case '.':
 	case 'I':
-		return parseNumber(pointer, stop, line);
+		return of_json_parse_number(pointer, stop, line);
 	default:
 		return nil;
 	}
@@ -31,7 +31,8 @@ extern int _OFString_PropertyListValue_reference;
 /*!
  * @brief The string interpreted as a property list and parsed as an object.
  *
- * @note This only supports XML property lists!
+ * @note This only supports XML property lists! For binary property lists, use
+ *	 @ref OFData::propertyListValue.
  */
 @property (readonly, nonatomic) id propertyListValue;
 @end
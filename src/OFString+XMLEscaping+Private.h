@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFString+XMLEscaping.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+typedef void (*of_xml_escaping_output_t)(void *_Nullable context,
+    const char *string, size_t length);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Escapes the specified UTF-8 string for use in an XML document the same way
+ * as -[OFString stringByXMLEscaping] and passes the result to output. Runs of
+ * characters that need no escaping are passed on as a whole without copying.
+ */
+extern void of_xml_escape(const char *string, size_t length,
+    of_xml_escaping_output_t output, void *_Nullable context);
+#ifdef __cplusplus
+}
+#endif
+
+OF_ASSUME_NONNULL_END
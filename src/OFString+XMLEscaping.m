@@ -17,41 +17,77 @@
 
 #include "config.h"
 
-#include <assert.h>
-#include <stdlib.h>
-#include <string.h>
-
 #import "OFString.h"
+#import "OFString+XMLEscaping+Private.h"
+#import "OFData.h"
 
-#import "OFOutOfMemoryException.h"
+#import "swar.h"
 
 int _OFString_XMLEscaping_reference;
 
-@implementation OFString (XMLEscaping)
-- (OFString *)stringByXMLEscaping
+static OF_INLINE bool
+needsEscaping(char c)
 {
-	void *pool = objc_autoreleasePoolPush();
-	char *retCString;
-	const char *string, *append;
-	size_t length, retLength, appendLen;
-	size_t j;
-	OFString *ret;
+	switch (c) {
+	case '<':
+	case '>':
+	case '"':
+	case '\'':
+	case '&':
+	case '\r':
+		return true;
+	default:
+		return false;
+	}
+}
 
-	string = [self UTF8String];
-	length = [self UTF8StringLength];
+/*
+ * Returns the number of bytes at the start of the string that don't need to be
+ * escaped, checking a whole word at a time.
+ */
+static size_t
+unescapedLength(const char *string, size_t length)
+{
+	size_t i = 0;
+
+	for (; i + sizeof(uintptr_t) <= length; i += sizeof(uintptr_t)) {
+		uintptr_t word = of_swar_load(string + i);
+
+		if (of_swar_byte_mask(word, '<') |
+		    of_swar_byte_mask(word, '>') |
+		    of_swar_byte_mask(word, '"') |
+		    of_swar_byte_mask(word, '\'') |
+		    of_swar_byte_mask(word, '&') |
+		    of_swar_byte_mask(word, '\r'))
+			break;
+	}
+
+	for (; i < length; i++)
+		if (needsEscaping(string[i]))
+			break;
+
+	return i;
+}
+
+void
+of_xml_escape(const char *string, size_t length,
+    of_xml_escaping_output_t output, void *context)
+{
+	while (length > 0) {
+		size_t unescaped = unescapedLength(string, length);
+		const char *append;
+		size_t appendLen;
 
-	j = 0;
-	retLength = length;
+		if (unescaped > 0) {
+			output(context, string, unescaped);
+			string += unescaped;
+			length -= unescaped;
 
-	/*
-	 * We can't use allocMemoryWithSize: here as it might be a @"" literal
-	 */
-	if ((retCString = malloc(retLength)) == NULL)
-		@throw [OFOutOfMemoryException
-		    exceptionWithRequestedSize: retLength];
+			if (length == 0)
+				break;
+		}
 
-	for (size_t i = 0; i < length; i++) {
-		switch (string[i]) {
+		switch (*string) {
 		case '<':
 			append = "&lt;";
 			appendLen = 4;
@@ -77,38 +113,50 @@ int _OFString_XMLEscaping_reference;
 			appendLen = 5;
 			break;
 		default:
-			append = NULL;
-			appendLen = 0;
+			OF_ENSURE(0);
 		}
 
-		if (append != NULL) {
-			char *newRetCString;
-
-			if ((newRetCString = realloc(retCString,
-			    retLength + appendLen)) == NULL) {
-				free(retCString);
-				@throw [OFOutOfMemoryException
-				     exceptionWithRequestedSize: retLength +
-								 appendLen];
-			}
-			retCString = newRetCString;
-			retLength += appendLen - 1;
-
-			memcpy(retCString + j, append, appendLen);
-			j += appendLen;
-		} else
-			retCString[j++] = string[i];
+		output(context, append, appendLen);
+		string++;
+		length--;
 	}
-	assert(j == retLength);
+}
 
-	objc_autoreleasePoolPop(pool);
+static void
+appendToData(void *context, const char *string, size_t length)
+{
+	[(OFMutableData *)context addItems: string
+				     count: length];
+}
+
+@implementation OFString (XMLEscaping)
+- (OFString *)stringByXMLEscaping
+{
+	void *pool;
+	const char *string;
+	size_t length;
+	OFMutableData *data;
+	OFString *ret;
+
+	pool = objc_autoreleasePoolPush();
+
+	string = [self UTF8String];
+	length = [self UTF8StringLength];
 
-	@try {
-		ret = [OFString stringWithUTF8String: retCString
-					      length: retLength];
-	} @finally {
-		free(retCString);
+	/* Fast path: Nothing to escape */
+	if (unescapedLength(string, length) == length) {
+		objc_autoreleasePoolPop(pool);
+		return [[self copy] autorelease];
 	}
-	return ret;
+
+	data = [OFMutableData dataWithCapacity: length + length / 8];
+	of_xml_escape(string, length, appendToData, data);
+
+	ret = [[OFString alloc] initWithUTF8String: [data items]
+					    length: [data count]];
+
+	objc_autoreleasePoolPop(pool);
+
+	return [ret autorelease];
 }
 @end
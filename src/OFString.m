@@ -60,6 +60,7 @@
 #import "OFUnsupportedProtocolException.h"
 
 #import "of_asprintf.h"
+#import "of_dtoa.h"
 #import "unicode.h"
 
 /*
@@ -2604,6 +2605,27 @@ decomposedString(OFString *self, const char *const *const *table, size_t size)
 - (double)doubleValue
 {
 	void *pool = objc_autoreleasePoolPush();
+	const char *UTF8String = [self UTF8String];
+	size_t UTF8StringLength = [self UTF8StringLength];
+	char *endPointer = NULL;
+	double value;
+
+	while (UTF8StringLength > 0 && of_ascii_isspace(*UTF8String)) {
+		UTF8String++;
+		UTF8StringLength--;
+	}
+	while (UTF8StringLength > 0 &&
+	    of_ascii_isspace(UTF8String[UTF8StringLength - 1]))
+		UTF8StringLength--;
+
+	/*
+	 * Plain decimal numbers are parsed directly, which is faster and
+	 * independent of the locale. Everything else is left to strtod().
+	 */
+	if (of_parse_double(UTF8String, UTF8StringLength, &value)) {
+		objc_autoreleasePoolPop(pool);
+		return value;
+	}
 
 #if defined(OF_AMIGAOS_M68K) || defined(OF_MORPHOS)
 	OFString *stripped = [self stringByDeletingEnclosingWhitespaces];
@@ -2616,23 +2638,19 @@ decomposedString(OFString *self, const char *const *const *table, size_t size)
 		return -INFINITY;
 #endif
 
-#ifdef HAVE_STRTOD_L
-	const char *UTF8String = [self UTF8String];
-#else
+#ifndef HAVE_STRTOD_L
 	/*
 	 * If we have no strtod_l, we have no other choice but to replace "."
 	 * with the locale's decimal point.
 	 */
 	OFString *decimalPoint = [OFLocale decimalPoint];
-	const char *UTF8String = [[self
+	UTF8String = [[self
 	    stringByReplacingOccurrencesOfString: @"."
 				      withString: decimalPoint] UTF8String];
-#endif
-	char *endPointer = NULL;
-	double value;
 
 	while (of_ascii_isspace(*UTF8String))
 		UTF8String++;
+#endif
 
 #ifdef HAVE_STRTOD_L
 	value = strtod_l(UTF8String, &endPointer, cLocale);
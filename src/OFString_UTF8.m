@@ -38,6 +38,7 @@
 #import "OFOutOfRangeException.h"
 
 #import "of_asprintf.h"
+#import "swar.h"
 #import "unicode.h"
 
 extern const of_char16_t of_iso_8859_2_table[];
@@ -66,7 +67,22 @@ extern const size_t of_koi8_u_table_offset;
 static inline int
 memcasecmp(const char *first, const char *second, size_t length)
 {
-	for (size_t i = 0; i < length; i++) {
+	size_t i = 0;
+
+	/* Skip over equal words of ASCII without looking at single bytes */
+	for (; i + sizeof(uintptr_t) <= length; i += sizeof(uintptr_t)) {
+		uintptr_t f = of_swar_load(first + i);
+		uintptr_t s = of_swar_load(second + i);
+
+		if (f == s)
+			continue;
+
+		if ((f | s) & OF_SWAR_HIGHS ||
+		    of_swar_ascii_toupper(f) != of_swar_ascii_toupper(s))
+			break;
+	}
+
+	for (; i < length; i++) {
 		unsigned char f = first[i];
 		unsigned char s = second[i];
 
@@ -82,6 +98,50 @@ memcasecmp(const char *first, const char *second, size_t length)
 	return OF_ORDERED_SAME;
 }
 
+static inline bool
+isSingleByteEncoding(of_string_encoding_t encoding)
+{
+	switch (encoding) {
+	case OF_STRING_ENCODING_ISO_8859_1:
+#ifdef HAVE_ISO_8859_2
+	case OF_STRING_ENCODING_ISO_8859_2:
+#endif
+#ifdef HAVE_ISO_8859_3
+	case OF_STRING_ENCODING_ISO_8859_3:
+#endif
+#ifdef HAVE_ISO_8859_15
+	case OF_STRING_ENCODING_ISO_8859_15:
+#endif
+#ifdef HAVE_WINDOWS_1251
+	case OF_STRING_ENCODING_WINDOWS_1251:
+#endif
+#ifdef HAVE_WINDOWS_1252
+	case OF_STRING_ENCODING_WINDOWS_1252:
+#endif
+#ifdef HAVE_CODEPAGE_437
+	case OF_STRING_ENCODING_CODEPAGE_437:
+#endif
+#ifdef HAVE_CODEPAGE_850
+	case OF_STRING_ENCODING_CODEPAGE_850:
+#endif
+#ifdef HAVE_CODEPAGE_858
+	case OF_STRING_ENCODING_CODEPAGE_858:
+#endif
+#ifdef HAVE_MAC_ROMAN
+	case OF_STRING_ENCODING_MAC_ROMAN:
+#endif
+#ifdef HAVE_KOI8_R
+	case OF_STRING_ENCODING_KOI8_R:
+#endif
+#ifdef HAVE_KOI8_U
+	case OF_STRING_ENCODING_KOI8_U:
+#endif
+		return true;
+	default:
+		return false;
+	}
+}
+
 int
 of_string_utf8_check(const char *UTF8String, size_t UTF8Length, size_t *length)
 {
@@ -89,9 +149,12 @@ of_string_utf8_check(const char *UTF8String, size_t UTF8Length, size_t *length)
 	int isUTF8 = 0;
 
 	for (size_t i = 0; i < UTF8Length; i++) {
-		/* No sign of UTF-8 here */
-		if OF_LIKELY (!(UTF8String[i] & 0x80))
+		/* No sign of UTF-8 here, skip the whole run of ASCII */
+		if OF_LIKELY (!(UTF8String[i] & 0x80)) {
+			i += of_swar_ascii_length(UTF8String + i,
+			    UTF8Length - i) - 1;
 			continue;
+		}
 
 		isUTF8 = 1;
 
@@ -172,6 +235,104 @@ of_string_utf8_get_position(const char *string, size_t idx, size_t length)
 	return idx;
 }
 
+/*
+ * Converts from one of the supported single byte encodings to UTF-8. As these
+ * encodings have no state, a large input can be converted in arbitrary chunks.
+ * The output needs to have room for 3 bytes per input byte, or 1 byte per input
+ * byte if the input is pure ASCII.
+ *
+ * Returns the number of bytes written or -1 if the input is invalid.
+ */
+static ssize_t
+convertSingleByteToUTF8(const char *input, size_t length,
+    of_string_encoding_t encoding, char *output)
+{
+	const of_char16_t *table;
+	size_t tableOffset, i, j;
+
+	switch (encoding) {
+	case OF_STRING_ENCODING_ISO_8859_1:
+		table = NULL;
+		tableOffset = 0;
+		break;
+#define CASE(encoding, var)			\
+	case encoding:				\
+		table = var;			\
+		tableOffset = var##_offset;	\
+		break;
+#ifdef HAVE_ISO_8859_2
+	CASE(OF_STRING_ENCODING_ISO_8859_2, of_iso_8859_2_table)
+#endif
+#ifdef HAVE_ISO_8859_3
+	CASE(OF_STRING_ENCODING_ISO_8859_3, of_iso_8859_3_table)
+#endif
+#ifdef HAVE_ISO_8859_15
+	CASE(OF_STRING_ENCODING_ISO_8859_15, of_iso_8859_15_table)
+#endif
+#ifdef HAVE_WINDOWS_1251
+	CASE(OF_STRING_ENCODING_WINDOWS_1251, of_windows_1251_table)
+#endif
+#ifdef HAVE_WINDOWS_1252
+	CASE(OF_STRING_ENCODING_WINDOWS_1252, of_windows_1252_table)
+#endif
+#ifdef HAVE_CODEPAGE_437
+	CASE(OF_STRING_ENCODING_CODEPAGE_437, of_codepage_437_table)
+#endif
+#ifdef HAVE_CODEPAGE_850
+	CASE(OF_STRING_ENCODING_CODEPAGE_850, of_codepage_850_table)
+#endif
+#ifdef HAVE_CODEPAGE_858
+	CASE(OF_STRING_ENCODING_CODEPAGE_858, of_codepage_858_table)
+#endif
+#ifdef HAVE_MAC_ROMAN
+	CASE(OF_STRING_ENCODING_MAC_ROMAN, of_mac_roman_table)
+#endif
+#ifdef HAVE_KOI8_R
+	CASE(OF_STRING_ENCODING_KOI8_R, of_koi8_r_table)
+#endif
+#ifdef HAVE_KOI8_U
+	CASE(OF_STRING_ENCODING_KOI8_U, of_koi8_u_table)
+#endif
+#undef CASE
+	default:
+		return -1;
+	}
+
+	i = j = 0;
+	while (i < length) {
+		unsigned char character;
+		of_unichar_t unichar;
+		size_t asciiLength, byteLength;
+
+		/* All supported encodings are supersets of ASCII */
+		asciiLength = of_swar_ascii_length(input + i, length - i);
+		memcpy(output + j, input + i, asciiLength);
+		i += asciiLength;
+		j += asciiLength;
+
+		if (i >= length)
+			break;
+
+		character = (unsigned char)input[i++];
+
+		if (table != NULL && character >= tableOffset) {
+			unichar = table[character - tableOffset];
+
+			if (unichar == 0xFFFF)
+				return -1;
+		} else
+			unichar = character;
+
+		if ((byteLength = of_string_utf8_encode(unichar,
+		    output + j)) == 0)
+			return -1;
+
+		j += byteLength;
+	}
+
+	return j;
+}
+
 @implementation OFString_UTF8
 - (instancetype)init
 {
@@ -234,8 +395,7 @@ of_string_utf8_get_position(const char *string, size_t idx, size_t length)
 	self = [super init];
 
 	@try {
-		const of_char16_t *table;
-		size_t tableOffset, j;
+		ssize_t UTF8StringLength;
 
 		if (encoding == OF_STRING_ENCODING_UTF_8 &&
 		    cStringLength >= 3 &&
@@ -273,116 +433,39 @@ of_string_utf8_get_position(const char *string, size_t idx, size_t length)
 		/* All other encodings we support are single byte encodings */
 		_s->length = cStringLength;
 
-		if (encoding == OF_STRING_ENCODING_ISO_8859_1) {
-			j = 0;
-			for (size_t i = 0; i < cStringLength; i++) {
-				char buffer[4];
-				size_t bytes;
+		if (of_swar_ascii_length(cString, cStringLength) !=
+		    cStringLength) {
+			/* Every character needs at most 3 bytes in UTF-8 */
+			if (cStringLength > (SIZE_MAX - 1) / 3)
+				@throw [OFOutOfRangeException exception];
+
+			_s->isUTF8 = true;
+			_s->cString = [self
+			    resizeMemory: _s->cString
+				    size: cStringLength * 3 + 1];
+		}
 
-				if (!(cString[i] & 0x80)) {
-					_s->cString[j++] = cString[i];
-					continue;
-				}
+		UTF8StringLength = convertSingleByteToUTF8(cString,
+		    cStringLength, encoding, _s->cString);
 
-				_s->isUTF8 = true;
-				bytes = of_string_utf8_encode(
-				    (uint8_t)cString[i], buffer);
+		if (UTF8StringLength < 0)
+			@throw [OFInvalidEncodingException exception];
 
-				if (bytes == 0)
-					@throw [OFInvalidEncodingException
-					    exception];
+		_s->cStringLength = UTF8StringLength;
+		_s->cString[_s->cStringLength] = 0;
 
-				_s->cStringLength += bytes - 1;
+		if (_s->isUTF8) {
+			@try {
 				_s->cString = [self
 				    resizeMemory: _s->cString
 					    size: _s->cStringLength + 1];
-
-				memcpy(_s->cString + j, buffer, bytes);
-				j += bytes;
+			} @catch (OFOutOfMemoryException *e) {
+				/*
+				 * We don't care, as we only tried to make it
+				 * smaller
+				 */
 			}
-
-			_s->cString[_s->cStringLength] = 0;
-
-			return self;
 		}
-
-		switch (encoding) {
-#define CASE(encoding, var)			\
-	case encoding:				\
-		table = var;			\
-		tableOffset = var##_offset;	\
-		break;
-#ifdef HAVE_ISO_8859_2
-		CASE(OF_STRING_ENCODING_ISO_8859_2, of_iso_8859_2_table)
-#endif
-#ifdef HAVE_ISO_8859_3
-		CASE(OF_STRING_ENCODING_ISO_8859_3, of_iso_8859_3_table)
-#endif
-#ifdef HAVE_ISO_8859_15
-		CASE(OF_STRING_ENCODING_ISO_8859_15, of_iso_8859_15_table)
-#endif
-#ifdef HAVE_WINDOWS_1251
-		CASE(OF_STRING_ENCODING_WINDOWS_1251, of_windows_1251_table)
-#endif
-#ifdef HAVE_WINDOWS_1252
-		CASE(OF_STRING_ENCODING_WINDOWS_1252, of_windows_1252_table)
-#endif
-#ifdef HAVE_CODEPAGE_437
-		CASE(OF_STRING_ENCODING_CODEPAGE_437, of_codepage_437_table)
-#endif
-#ifdef HAVE_CODEPAGE_850
-		CASE(OF_STRING_ENCODING_CODEPAGE_850, of_codepage_850_table)
-#endif
-#ifdef HAVE_CODEPAGE_858
-		CASE(OF_STRING_ENCODING_CODEPAGE_858, of_codepage_858_table)
-#endif
-#ifdef HAVE_MAC_ROMAN
-		CASE(OF_STRING_ENCODING_MAC_ROMAN, of_mac_roman_table)
-#endif
-#ifdef HAVE_KOI8_R
-		CASE(OF_STRING_ENCODING_KOI8_R, of_koi8_r_table)
-#endif
-#ifdef HAVE_KOI8_U
-		CASE(OF_STRING_ENCODING_KOI8_U, of_koi8_u_table)
-#endif
-#undef CASE
-		default:
-			@throw [OFInvalidEncodingException exception];
-		}
-
-		j = 0;
-		for (size_t i = 0; i < cStringLength; i++) {
-			unsigned char character = (unsigned char)cString[i];
-			of_unichar_t unichar;
-			char buffer[4];
-			size_t byteLength;
-
-			if (character < tableOffset) {
-				_s->cString[j++] = cString[i];
-				continue;
-			}
-
-			unichar = table[character - tableOffset];
-
-			if (unichar == 0xFFFF)
-				@throw [OFInvalidEncodingException exception];
-
-			_s->isUTF8 = true;
-			byteLength = of_string_utf8_encode(unichar, buffer);
-
-			if (byteLength == 0)
-				@throw [OFInvalidEncodingException exception];
-
-			_s->cStringLength += byteLength - 1;
-			_s->cString = [self
-			    resizeMemory: _s->cString
-				    size: _s->cStringLength + 1];
-
-			memcpy(_s->cString + j, buffer, byteLength);
-			j += byteLength;
-		}
-
-		_s->cString[_s->cStringLength] = 0;
 	} @catch (id e) {
 		[self release];
 		@throw e;
@@ -521,7 +604,7 @@ of_string_utf8_get_position(const char *string, size_t idx, size_t length)
 	self = [super init];
 
 	@try {
-		size_t j;
+		size_t i, j;
 		bool swap = false;
 
 		if (length > 0 && *string == 0xFEFF) {
@@ -539,11 +622,31 @@ of_string_utf8_get_position(const char *string, size_t idx, size_t length)
 		_s->cString = [self allocMemoryWithSize: (length * 4) + 1];
 		_s->length = length;
 
-		j = 0;
-		for (size_t i = 0; i < length; i++) {
-			of_unichar_t character =
-			    (swap ? OF_BSWAP16(string[i]) : string[i]);
-			size_t len;
+		i = j = 0;
+		while (i < length) {
+			of_unichar_t character;
+			size_t asciiLength, len;
+
+			/* Copy runs of ASCII without encoding each character */
+			asciiLength = of_swar_utf16_ascii_length(string + i,
+			    length - i, swap);
+
+			if (swap)
+				for (size_t k = 0; k < asciiLength; k++)
+					_s->cString[j + k] =
+					    (char)(string[i + k] >> 8);
+			else
+				for (size_t k = 0; k < asciiLength; k++)
+					_s->cString[j + k] =
+					    (char)string[i + k];
+
+			i += asciiLength;
+			j += asciiLength;
+
+			if (i >= length)
+				break;
+
+			character = (swap ? OF_BSWAP16(string[i]) : string[i]);
 
 			/* Missing high surrogate */
 			if ((character & 0xFC00) == 0xDC00)
@@ -579,6 +682,7 @@ of_string_utf8_get_position(const char *string, size_t idx, size_t length)
 			if (len > 1)
 				_s->isUTF8 = true;
 
+			i++;
 			j += len;
 		}
 
@@ -606,7 +710,7 @@ of_string_utf8_get_position(const char *string, size_t idx, size_t length)
 	self = [super init];
 
 	@try {
-		size_t j;
+		size_t i, j;
 		bool swap = false;
 
 		if (length > 0 && *characters == 0xFEFF) {
@@ -624,29 +728,46 @@ of_string_utf8_get_position(const char *string, size_t idx, size_t length)
 		_s->cString = [self allocMemoryWithSize: (length * 4) + 1];
 		_s->length = length;
 
-		j = 0;
-		for (size_t i = 0; i < length; i++) {
-			char buffer[4];
-			size_t len = of_string_utf8_encode(
-			    (swap ? OF_BSWAP32(characters[i]) : characters[i]),
-			    buffer);
+		i = j = 0;
+		while (i < length) {
+			of_unichar_t character;
+			size_t asciiLength, len;
 
-			switch (len) {
-			case 1:
-				_s->cString[j++] = buffer[0];
-				break;
-			case 2:
-			case 3:
-			case 4:
-				_s->isUTF8 = true;
+			/* Copy runs of ASCII without encoding each character */
+			asciiLength = of_swar_utf32_ascii_length(
+			    characters + i, length - i, swap);
 
-				memcpy(_s->cString + j, buffer, len);
-				j += len;
+			if (swap)
+				for (size_t k = 0; k < asciiLength; k++)
+					_s->cString[j + k] =
+					    (char)(characters[i + k] >> 24);
+			else
+				for (size_t k = 0; k < asciiLength; k++)
+					_s->cString[j + k] =
+					    (char)characters[i + k];
 
+			i += asciiLength;
+			j += asciiLength;
+
+			if (i >= length)
 				break;
-			default:
+
+			character = (swap
+			    ? OF_BSWAP32(characters[i]) : characters[i]);
+
+			/* Surrogates are not valid in UTF-32 */
+			if ((character & 0xFFFFF800) == 0xD800)
 				@throw [OFInvalidEncodingException exception];
-			}
+
+			len = of_string_utf8_encode(character, _s->cString + j);
+
+			if (len == 0)
+				@throw [OFInvalidEncodingException exception];
+
+			_s->isUTF8 = true;
+
+			i++;
+			j += len;
 		}
 
 		_s->cString[j] = '\0';
@@ -735,6 +856,15 @@ of_string_utf8_get_position(const char *string, size_t idx, size_t length)
 
 		return _s->cStringLength;
 	default:
+		/*
+		 * All supported single byte encodings are supersets of ASCII,
+		 * so pure ASCII needs no conversion.
+		 */
+		if (!_s->isUTF8 && isSingleByteEncoding(encoding))
+			return [self getCString: cString
+				      maxLength: maxLength
+				       encoding: OF_STRING_ENCODING_ASCII];
+
 		return [super getCString: cString
 			       maxLength: maxLength
 				encoding: encoding];
@@ -751,6 +881,9 @@ of_string_utf8_get_position(const char *string, size_t idx, size_t length)
 	case OF_STRING_ENCODING_UTF_8:
 		return _s->cString;
 	default:
+		if (!_s->isUTF8 && isSingleByteEncoding(encoding))
+			return _s->cString;
+
 		return [super cStringWithEncoding: encoding];
 	}
 }
@@ -887,6 +1020,19 @@ of_string_utf8_get_position(const char *string, size_t idx, size_t length)
 		of_unichar_t c1, c2;
 		ssize_t l1, l2;
 
+		/* Case folding of ASCII does not need the tables */
+		if (!(_s->cString[i] & 0x80) && !(otherCString[j] & 0x80)) {
+			char f = of_ascii_tolower(_s->cString[i++]);
+			char s = of_ascii_tolower(otherCString[j++]);
+
+			if (f > s)
+				return OF_ORDERED_DESCENDING;
+			if (f < s)
+				return OF_ORDERED_ASCENDING;
+
+			continue;
+		}
+
 		l1 = of_string_utf8_decode(_s->cString + i,
 		    _s->cStringLength - i, &c1);
 		l2 = of_string_utf8_decode(otherCString + j,
@@ -1161,19 +1307,44 @@ of_string_utf8_get_position(const char *string, size_t idx, size_t length)
 }
 
 - (const of_unichar_t *)characters
+{
+	return [self UTF32StringWithByteOrder: OF_BYTE_ORDER_NATIVE];
+}
+
+- (const of_char16_t *)UTF16StringWithByteOrder: (of_byte_order_t)byteOrder
 {
 	OFObject *object = [[[OFObject alloc] init] autorelease];
-	of_unichar_t *ret;
+	bool swap = (byteOrder != OF_BYTE_ORDER_NATIVE);
+	of_char16_t *ret;
 	size_t i, j;
 
-	ret = [object allocMemoryWithSize: sizeof(of_unichar_t)
-				    count: _s->length];
+	/* Allocate memory for the worst case */
+	ret = [object allocMemoryWithSize: sizeof(of_char16_t)
+				    count: (_s->length + 1) * 2];
 
 	i = j = 0;
-
 	while (i < _s->cStringLength) {
 		of_unichar_t c;
 		ssize_t cLen;
+		size_t asciiLength;
+
+		/* Widen runs of ASCII without decoding each character */
+		asciiLength = of_swar_ascii_length(_s->cString + i,
+		    _s->cStringLength - i);
+
+		if (swap)
+			for (size_t k = 0; k < asciiLength; k++)
+				ret[j + k] = (of_char16_t)
+				    ((uint8_t)_s->cString[i + k] << 8);
+		else
+			for (size_t k = 0; k < asciiLength; k++)
+				ret[j + k] = (uint8_t)_s->cString[i + k];
+
+		i += asciiLength;
+		j += asciiLength;
+
+		if (i >= _s->cStringLength)
+			break;
 
 		cLen = of_string_utf8_decode(_s->cString + i,
 		    _s->cStringLength - i, &c);
@@ -1181,27 +1352,80 @@ of_string_utf8_get_position(const char *string, size_t idx, size_t length)
 		if (cLen <= 0 || c > 0x10FFFF)
 			@throw [OFInvalidEncodingException exception];
 
-		ret[j++] = c;
+		if (c > 0xFFFF) {
+			c -= 0x10000;
+			ret[j++] = (swap
+			    ? OF_BSWAP16(0xD800 | (c >> 10))
+			    : 0xD800 | (c >> 10));
+			ret[j++] = (swap
+			    ? OF_BSWAP16(0xDC00 | (c & 0x3FF))
+			    : 0xDC00 | (c & 0x3FF));
+		} else
+			ret[j++] = (swap ? OF_BSWAP16(c) : c);
+
 		i += cLen;
 	}
+	ret[j] = 0;
+
+	@try {
+		ret = [object resizeMemory: ret
+				      size: sizeof(of_char16_t)
+				     count: j + 1];
+	} @catch (OFOutOfMemoryException *e) {
+		/* We don't care, as we only tried to make it smaller */
+	}
 
 	return ret;
 }
 
+- (size_t)UTF16StringLength
+{
+	size_t UTF16StringLength = _s->length;
+
+	if (!_s->isUTF8)
+		return UTF16StringLength;
+
+	/* Every character that needs 4 bytes in UTF-8 is a surrogate pair */
+	for (size_t i = 0; i < _s->cStringLength; i++)
+		if (((uint8_t)_s->cString[i] & 0xF8) == 0xF0)
+			UTF16StringLength++;
+
+	return UTF16StringLength;
+}
+
 - (const of_char32_t *)UTF32StringWithByteOrder: (of_byte_order_t)byteOrder
 {
 	OFObject *object = [[[OFObject alloc] init] autorelease];
+	bool swap = (byteOrder != OF_BYTE_ORDER_NATIVE);
 	of_char32_t *ret;
 	size_t i, j;
 
-	ret = [object allocMemoryWithSize: sizeof(of_unichar_t)
+	ret = [object allocMemoryWithSize: sizeof(of_char32_t)
 				    count: _s->length + 1];
 
 	i = j = 0;
-
 	while (i < _s->cStringLength) {
 		of_unichar_t c;
 		ssize_t cLen;
+		size_t asciiLength;
+
+		/* Widen runs of ASCII without decoding each character */
+		asciiLength = of_swar_ascii_length(_s->cString + i,
+		    _s->cStringLength - i);
+
+		if (swap)
+			for (size_t k = 0; k < asciiLength; k++)
+				ret[j + k] = (of_char32_t)
+				    (uint8_t)_s->cString[i + k] << 24;
+		else
+			for (size_t k = 0; k < asciiLength; k++)
+				ret[j + k] = (uint8_t)_s->cString[i + k];
+
+		i += asciiLength;
+		j += asciiLength;
+
+		if (i >= _s->cStringLength)
+			break;
 
 		cLen = of_string_utf8_decode(_s->cString + i,
 		    _s->cStringLength - i, &c);
@@ -1209,11 +1433,7 @@ of_string_utf8_get_position(const char *string, size_t idx, size_t length)
 		if (cLen <= 0 || c > 0x10FFFF)
 			@throw [OFInvalidEncodingException exception];
 
-		if (byteOrder != OF_BYTE_ORDER_NATIVE)
-			ret[j++] = OF_BSWAP32(c);
-		else
-			ret[j++] = c;
-
+		ret[j++] = (swap ? OF_BSWAP32(c) : c);
 		i += cLen;
 	}
 	ret[j] = 0;
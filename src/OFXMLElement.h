@@ -23,6 +23,7 @@ OF_ASSUME_NONNULL_BEGIN
 @class OFMutableArray OF_GENERIC(ObjectType);
 @class OFMutableDictionary OF_GENERIC(KeyType, ObjectType);
 @class OFMutableString;
+@class OFStream;
 @class OFString;
 @class OFXMLAttribute;
 
@@ -422,6 +423,29 @@ OF_ASSUME_NONNULL_BEGIN
 - (OFArray OF_GENERIC(OFXMLElement *) *)
     elementsForName: (OFString *)elementName
 	  namespace: (nullable OFString *)elementNS;
+
+/*!
+ * @brief Writes the element as an XML string to the specified stream.
+ *
+ * Unlike @ref XMLString, this does not create the XML string in memory, but
+ * writes it to the stream using a buffer of fixed size. The output is the same
+ * as the one of @ref XMLString.
+ *
+ * @param stream The stream to write the element to
+ */
+- (void)writeToStream: (OFStream *)stream;
+
+/*!
+ * @brief Writes the element as an XML string with indentation to the specified
+ *	  stream.
+ *
+ * The output is the same as the one of @ref XMLStringWithIndentation:.
+ *
+ * @param stream The stream to write the element to
+ * @param indentation The indentation for the XML string
+ */
+- (void)writeToStream: (OFStream *)stream
+	  indentation: (unsigned int)indentation;
 @end
 
 OF_ASSUME_NONNULL_END
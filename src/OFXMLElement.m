@@ -22,11 +22,11 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include <assert.h>
-
 #import "OFXMLElement.h"
 #import "OFXMLNode+Private.h"
 #import "OFString.h"
+#import "OFString+XMLEscaping+Private.h"
+#import "OFStream.h"
 #import "OFArray.h"
 #import "OFDictionary.h"
 #import "OFData.h"
@@ -51,6 +51,77 @@ _references_to_categories_of_OFXMLElement(void)
 static Class charactersClass = Nil;
 static Class CDATAClass = Nil;
 
+#define BUFFER_SIZE 4096
+
+/*
+ * The XML string is either collected in data or written to stream using a
+ * buffer of fixed size, so that huge trees can be written without having the
+ * whole XML string in memory.
+ */
+struct XMLWriter {
+	OFStream *stream;
+	OFMutableData *data;
+	char *buffer;
+	size_t bufferLength;
+};
+
+static void
+writerFlush(struct XMLWriter *writer)
+{
+	if (writer->bufferLength == 0)
+		return;
+
+	[writer->stream writeBuffer: writer->buffer
+			     length: writer->bufferLength];
+	writer->bufferLength = 0;
+}
+
+static void
+writerWrite(void *context, const char *string, size_t length)
+{
+	struct XMLWriter *writer = context;
+
+	if (writer->stream == nil) {
+		[writer->data addItems: string
+				 count: length];
+		return;
+	}
+
+	while (length > 0) {
+		size_t toCopy = BUFFER_SIZE - writer->bufferLength;
+
+		if (toCopy > length)
+			toCopy = length;
+
+		memcpy(writer->buffer + writer->bufferLength, string, toCopy);
+		writer->bufferLength += toCopy;
+		string += toCopy;
+		length -= toCopy;
+
+		if (writer->bufferLength == BUFFER_SIZE)
+			writerFlush(writer);
+	}
+}
+
+static OF_INLINE void
+writerWriteString(struct XMLWriter *writer, OFString *string)
+{
+	writerWrite(writer, [string UTF8String], [string UTF8StringLength]);
+}
+
+static void
+writerWriteIndentation(struct XMLWriter *writer, size_t count)
+{
+	static const char spaces[] = "                ";
+
+	while (count > 0) {
+		size_t length = (count < 16 ? count : 16);
+
+		writerWrite(writer, spaces, length);
+		count -= length;
+	}
+}
+
 @interface OFXMLElement_OFXMLElementBuilderDelegate: OFObject
     <OFXMLElementBuilderDelegate>
 {
@@ -426,16 +497,14 @@ static Class CDATAClass = Nil;
 	return ret;
 }
 
-- (OFString *)of_XMLStringWithParent: (OFXMLElement *)parent
-			  namespaces: (OFDictionary *)allNamespaces
-			 indentation: (unsigned int)indentation
-			       level: (unsigned int)level
+- (void)of_writeToWriter: (struct XMLWriter *)writer
+		  parent: (OFXMLElement *)parent
+	      namespaces: (OFDictionary *)allNamespaces
+	     indentation: (unsigned int)indentation
+		   level: (unsigned int)level
 {
 	void *pool;
-	char *cString;
-	size_t length, i;
 	OFString *prefix, *parentPrefix;
-	OFString *ret;
 	OFString *defaultNS;
 
 	pool = objc_autoreleasePoolPush();
@@ -472,65 +541,32 @@ static Class CDATAClass = Nil;
 	else
 		defaultNS = _defaultNamespace;
 
-	i = 0;
-	length = [_name UTF8StringLength] + 3 + (level * indentation);
-	cString = [self allocMemoryWithSize: length];
-
-	memset(cString + i, ' ', level * indentation);
-	i += level * indentation;
+	writerWriteIndentation(writer, level * indentation);
 
 	/* Start of tag */
-	cString[i++] = '<';
+	writerWrite(writer, "<", 1);
 
 	if (prefix != nil && ![_namespace isEqual: defaultNS]) {
-		length += [prefix UTF8StringLength] + 1;
-		@try {
-			cString = [self resizeMemory: cString
-						size: length];
-		} @catch (id e) {
-			[self freeMemory: cString];
-			@throw e;
-		}
-
-		memcpy(cString + i, [prefix UTF8String],
-		    [prefix UTF8StringLength]);
-		i += [prefix UTF8StringLength];
-		cString[i++] = ':';
+		writerWriteString(writer, prefix);
+		writerWrite(writer, ":", 1);
 	}
 
-	memcpy(cString + i, [_name UTF8String], [_name UTF8StringLength]);
-	i += [_name UTF8StringLength];
+	writerWriteString(writer, _name);
 
 	/* xmlns if necessary */
 	if (prefix == nil && ((_namespace != nil &&
 	    ![_namespace isEqual: defaultNS]) ||
 	    (_namespace == nil && defaultNS != nil))) {
-		length += [_namespace UTF8StringLength] + 9;
-		@try {
-			cString = [self resizeMemory: cString
-						size: length];
-		} @catch (id e) {
-			[self freeMemory: cString];
-			@throw e;
-		}
-
-		memcpy(cString + i, " xmlns='", 8);
-		i += 8;
-		memcpy(cString + i, [_namespace UTF8String],
-		    [_namespace UTF8StringLength]);
-		i += [_namespace UTF8StringLength];
-		cString[i++] = '\'';
+		writerWrite(writer, " xmlns='", 8);
+		if (_namespace != nil)
+			writerWriteString(writer, _namespace);
+		writerWrite(writer, "'", 1);
 	}
 
 	/* Attributes */
 	for (OFXMLAttribute *attribute in _attributes) {
-		void *pool2 = objc_autoreleasePoolPush();
-		const char *attributeNameCString =
-		    [attribute->_name UTF8String];
-		size_t attributeNameLength =
-		    [attribute->_name UTF8StringLength];
 		OFString *attributePrefix = nil;
-		OFString *tmp = [[attribute stringValue] stringByXMLEscaping];
+		OFString *value = [attribute stringValue];
 		char delimiter = (attribute->_useDoubleQuotes ? '"' : '\'');
 
 		if (attribute->_namespace != nil &&
@@ -540,40 +576,21 @@ static Class CDATAClass = Nil;
 			    exceptionWithNamespace: [attribute namespace]
 					   element: self];
 
-		length += attributeNameLength +
-		    (attributePrefix != nil ?
-		    [attributePrefix UTF8StringLength] + 1 : 0) +
-		    [tmp UTF8StringLength] + 4;
-
-		@try {
-			cString = [self resizeMemory: cString
-						size: length];
-		} @catch (id e) {
-			[self freeMemory: cString];
-			@throw e;
-		}
-
-		cString[i++] = ' ';
+		writerWrite(writer, " ", 1);
 		if (attributePrefix != nil) {
-			memcpy(cString + i, [attributePrefix UTF8String],
-			    [attributePrefix UTF8StringLength]);
-			i += [attributePrefix UTF8StringLength];
-			cString[i++] = ':';
+			writerWriteString(writer, attributePrefix);
+			writerWrite(writer, ":", 1);
 		}
-		memcpy(cString + i, attributeNameCString, attributeNameLength);
-		i += attributeNameLength;
-		cString[i++] = '=';
-		cString[i++] = delimiter;
-		memcpy(cString + i, [tmp UTF8String], [tmp UTF8StringLength]);
-		i += [tmp UTF8StringLength];
-		cString[i++] = delimiter;
-
-		objc_autoreleasePoolPop(pool2);
+		writerWriteString(writer, attribute->_name);
+		writerWrite(writer, "=", 1);
+		writerWrite(writer, &delimiter, 1);
+		of_xml_escape([value UTF8String], [value UTF8StringLength],
+		    writerWrite, writer);
+		writerWrite(writer, &delimiter, 1);
 	}
 
 	/* Children */
 	if (_children != nil) {
-		OFMutableData *tmp = [OFMutableData data];
 		bool indent;
 
 		if (indentation > 0) {
@@ -589,111 +606,107 @@ static Class CDATAClass = Nil;
 		} else
 			indent = false;
 
+		writerWrite(writer, ">", 1);
+
 		for (OFXMLNode *child in _children) {
-			OFString *childString;
 			unsigned int ind = (indent ? indentation : 0);
 
 			if (ind)
-				[tmp addItem: "\n"];
+				writerWrite(writer, "\n", 1);
 
 			if ([child isKindOfClass: [OFXMLElement class]])
-				childString = [(OFXMLElement *)child
-				    of_XMLStringWithParent: self
-						namespaces: allNamespaces
-					       indentation: ind
-						     level: level + 1];
-			else
-				childString = [child
+				[(OFXMLElement *)child
+				    of_writeToWriter: writer
+					      parent: self
+					  namespaces: allNamespaces
+					 indentation: ind
+					       level: level + 1];
+			else if ([child isKindOfClass: charactersClass]) {
+				OFString *characters = [child stringValue];
+
+				of_xml_escape([characters UTF8String],
+				    [characters UTF8StringLength],
+				    writerWrite, writer);
+			} else {
+				OFString *childString = [child
 				    XMLStringWithIndentation: ind
 						       level: level + 1];
 
-			[tmp addItems: [childString UTF8String]
-				count: [childString UTF8StringLength]];
-		}
-
-		if (indent)
-			[tmp addItem: "\n"];
-
-		length += [tmp count] + [_name UTF8StringLength] + 2 +
-		    (indent ? level * indentation : 0);
-		@try {
-			cString = [self resizeMemory: cString
-						size: length];
-		} @catch (id e) {
-			[self freeMemory: cString];
-			@throw e;
+				writerWriteString(writer, childString);
+			}
 		}
 
-		cString[i++] = '>';
-
-		memcpy(cString + i, [tmp items], [tmp count]);
-		i += [tmp count];
-
 		if (indent) {
-			memset(cString + i, ' ', level * indentation);
-			i += level * indentation;
+			writerWrite(writer, "\n", 1);
+			writerWriteIndentation(writer, level * indentation);
 		}
 
-		cString[i++] = '<';
-		cString[i++] = '/';
+		writerWrite(writer, "</", 2);
 		if (prefix != nil) {
-			length += [prefix UTF8StringLength] + 1;
-			@try {
-				cString = [self resizeMemory: cString
-							size: length];
-			} @catch (id e) {
-				[self freeMemory: cString];
-				@throw e;
-			}
-
-			memcpy(cString + i, [prefix UTF8String],
-			    [prefix UTF8StringLength]);
-			i += [prefix UTF8StringLength];
-			cString[i++] = ':';
+			writerWriteString(writer, prefix);
+			writerWrite(writer, ":", 1);
 		}
-		memcpy(cString + i, [_name UTF8String],
-		    [_name UTF8StringLength]);
-		i += [_name UTF8StringLength];
+		writerWriteString(writer, _name);
 	} else
-		cString[i++] = '/';
+		writerWrite(writer, "/", 1);
 
-	cString[i++] = '>';
-	assert(i == length);
+	writerWrite(writer, ">", 1);
 
 	objc_autoreleasePoolPop(pool);
-
-	@try {
-		ret = [OFString stringWithUTF8String: cString
-					      length: length];
-	} @finally {
-		[self freeMemory: cString];
-	}
-	return ret;
 }
 
 - (OFString *)XMLString
 {
-	return [self of_XMLStringWithParent: nil
-				 namespaces: nil
-				indentation: 0
-				      level: 0];
+	return [self XMLStringWithIndentation: 0
+					level: 0];
 }
 
 - (OFString *)XMLStringWithIndentation: (unsigned int)indentation
 {
-	return [self of_XMLStringWithParent: nil
-				 namespaces: nil
-				indentation: indentation
-				      level: 0];
+	return [self XMLStringWithIndentation: indentation
+					level: 0];
 }
 
 - (OFString *)XMLStringWithIndentation: (unsigned int)indentation
 				 level: (unsigned int)level
 {
-	return [self of_XMLStringWithParent: nil
-				 namespaces: nil
-				indentation: indentation
-				      level: level];
+	void *pool = objc_autoreleasePoolPush();
+	struct XMLWriter writer = { nil, [OFMutableData data], NULL, 0 };
+	OFString *ret;
+
+	[self of_writeToWriter: &writer
+			parent: nil
+		    namespaces: nil
+		   indentation: indentation
+			 level: level];
+
+	ret = [[OFString alloc] initWithUTF8String: [writer.data items]
+					    length: [writer.data count]];
+
+	objc_autoreleasePoolPop(pool);
+
+	return [ret autorelease];
+}
+
+- (void)writeToStream: (OFStream *)stream
+{
+	[self writeToStream: stream
+		indentation: 0];
+}
+
+- (void)writeToStream: (OFStream *)stream
+	  indentation: (unsigned int)indentation
+{
+	char buffer[BUFFER_SIZE];
+	struct XMLWriter writer = { stream, nil, buffer, 0 };
+
+	[self of_writeToWriter: &writer
+			parent: nil
+		    namespaces: nil
+		   indentation: indentation
+			 level: 0];
+
+	writerFlush(&writer);
 }
 
 - (OFXMLElement *)XMLElementBySerializing
@@ -20,7 +20,9 @@
 
 OF_ASSUME_NONNULL_BEGIN
 
+@class OFArray OF_GENERIC(ObjectType);
 @class OFMutableArray OF_GENERIC(ObjectType);
+@class OFXMLAttribute;
 @class OFXMLElement;
 @class OFXMLElementBuilder;
 
@@ -92,6 +94,28 @@ OF_ASSUME_NONNULL_BEGIN
  */
 - (OFString *)elementBuilder: (OFXMLElementBuilder *)builder
      foundUnknownEntityNamed: (OFString *)entity;
+
+/*!
+ * @brief This callback is called when the element builder found the start of
+ *	  an element that is not inside an element that is being built.
+ *
+ * If this method is implemented, only elements for which it returns true are
+ * built, each of them being passed to
+ * @ref elementBuilder:didBuildElement: when it is complete. All other nodes
+ * are discarded while parsing, so that huge documents can be processed with
+ * constant memory.
+ *
+ * @param builder The element builder which found the start of an element
+ * @param path The names of the element and all its ancestors, starting with
+ *	       the root element
+ * @param namespace_ The namespace of the element
+ * @param attributes The attributes of the element
+ * @return Whether the element should be built
+ */
+-	(bool)elementBuilder: (OFXMLElementBuilder *)builder
+  shouldBuildElementAtPath: (OFArray OF_GENERIC(OFString *) *)path
+		 namespace: (nullable OFString *)namespace_
+		attributes: (OFArray OF_GENERIC(OFXMLAttribute *) *)attributes;
 @end
 
 /*!
@@ -103,11 +127,16 @@ OF_ASSUME_NONNULL_BEGIN
  * It can also be used to build OFXMLElements from parts of the document by
  * first parsing stuff using the OFXMLParser with another delegate and then
  * setting the OFXMLElementBuilder as delegate for the parser.
+ *
+ * To only build certain elements of a document, either set a
+ * @ref filterPath or let the delegate decide which elements to build.
  */
 @interface OFXMLElementBuilder: OFObject <OFXMLParserDelegate>
 {
 	OFMutableArray OF_GENERIC(OFXMLElement *) *_stack;
 	id <OFXMLElementBuilderDelegate> _Nullable _delegate;
+	OFArray OF_GENERIC(OFString *) *_Nullable _filterPath;
+	OFMutableArray OF_GENERIC(OFString *) *_path;
 }
 
 /*!
@@ -116,6 +145,20 @@ OF_ASSUME_NONNULL_BEGIN
 @property OF_NULLABLE_PROPERTY (assign, nonatomic)
     id <OFXMLElementBuilderDelegate> delegate;
 
+/*!
+ * @brief The path of the elements to build.
+ *
+ * If this is set, only elements at the specified path are built, each of them
+ * being passed to the delegate when it is complete. All other nodes are
+ * discarded while parsing.
+ *
+ * The path consists of the names of the element and all its ancestors,
+ * starting with the root element, e.g. `rss`, `channel`, `item`. Namespaces
+ * are not taken into account.
+ */
+@property OF_NULLABLE_PROPERTY (copy, nonatomic)
+    OFArray OF_GENERIC(OFString *) *filterPath;
+
 /*!
  * @brief Creates a new element builder.
  *
@@ -29,8 +29,12 @@
 
 #import "OFMalformedXMLException.h"
 
+@interface OFXMLElementBuilder ()
+- (bool)of_isFiltering;
+@end
+
 @implementation OFXMLElementBuilder
-@synthesize delegate = _delegate;
+@synthesize delegate = _delegate, filterPath = _filterPath;
 
 + (instancetype)elementBuilder
 {
@@ -43,6 +47,7 @@
 
 	@try {
 		_stack = [[OFMutableArray alloc] init];
+		_path = [[OFMutableArray alloc] init];
 	} @catch (id e) {
 		[self release];
 		@throw e;
@@ -54,10 +59,19 @@
 - (void)dealloc
 {
 	[_stack release];
+	[_filterPath release];
+	[_path release];
 
 	[super dealloc];
 }
 
+- (bool)of_isFiltering
+{
+	return (_filterPath != nil || [_delegate respondsToSelector:
+	    @selector(elementBuilder:shouldBuildElementAtPath:namespace:
+	    attributes:)]);
+}
+
 -		 (void)parser: (OFXMLParser *)parser
   foundProcessingInstructions: (OFString *)pi
 {
@@ -67,7 +81,7 @@
 
 	if (parent != nil)
 		[parent addChild: node];
-	else if ([_delegate respondsToSelector:
+	else if (![self of_isFiltering] && [_delegate respondsToSelector:
 	    @selector(elementBuilder:didBuildParentlessNode:)])
 		[_delegate elementBuilder: self
 		   didBuildParentlessNode: node];
@@ -79,8 +93,27 @@
 	namespace: (OFString *)namespace
        attributes: (OFArray *)attributes
 {
-	OFXMLElement *element = [OFXMLElement elementWithName: name
-						    namespace: namespace];
+	OFXMLElement *element;
+
+	if ([_stack count] == 0 && [self of_isFiltering]) {
+		bool build;
+
+		[_path addObject: name];
+
+		if (_filterPath != nil)
+			build = [_path isEqual: _filterPath];
+		else
+			build = [_delegate elementBuilder: self
+				 shouldBuildElementAtPath: _path
+						namespace: namespace
+					       attributes: attributes];
+
+		if (!build)
+			return;
+	}
+
+	element = [OFXMLElement elementWithName: name
+				      namespace: namespace];
 
 	for (OFXMLAttribute *attribute in attributes) {
 		if ([attribute namespace] == nil &&
@@ -106,6 +139,12 @@
 {
 	switch ([_stack count]) {
 	case 0:
+		/* The end of an element that was not built */
+		if ([_path count] > 0) {
+			[_path removeLastObject];
+			return;
+		}
+
 		if ([_delegate respondsToSelector: @selector(elementBuilder:
 		    didNotExpectCloseTag:prefix:namespace:)])
 			[_delegate elementBuilder: self
@@ -119,6 +158,7 @@
 	case 1:
 		[_delegate elementBuilder: self
 			  didBuildElement: [_stack firstObject]];
+		[_path removeLastObject];
 		break;
 	}
 
@@ -136,7 +176,7 @@
 
 	if (parent != nil)
 		[parent addChild: node];
-	else if ([_delegate respondsToSelector:
+	else if (![self of_isFiltering] && [_delegate respondsToSelector:
 	    @selector(elementBuilder:didBuildParentlessNode:)])
 		[_delegate  elementBuilder: self
 		    didBuildParentlessNode: node];
@@ -150,7 +190,7 @@
 
 	if (parent != nil)
 		[parent addChild: node];
-	else if ([_delegate respondsToSelector:
+	else if (![self of_isFiltering] && [_delegate respondsToSelector:
 	    @selector(elementBuilder:didBuildParentlessNode:)])
 		[_delegate elementBuilder: self
 		   didBuildParentlessNode: node];
@@ -164,7 +204,7 @@
 
 	if (parent != nil)
 		[parent addChild: node];
-	else if ([_delegate respondsToSelector:
+	else if (![self of_isFiltering] && [_delegate respondsToSelector:
 	    @selector(elementBuilder:didBuildParentlessNode:)])
 		[_delegate elementBuilder: self
 		   didBuildParentlessNode: node];
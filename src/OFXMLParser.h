@@ -155,7 +155,7 @@ OF_ASSUME_NONNULL_BEGIN
 		OF_XMLPARSER_IN_DOCTYPE,
 		OF_XMLPARSER_NUM_STATES
 	} _state;
-	size_t _i, _last;
+	size_t _i, _last, _length;
 	const char *_Nullable _data;
 	OFMutableData *_buffer;
 	OFString *_Nullable _name, *_Nullable _prefix;
@@ -30,6 +30,8 @@
 #import "OFStream.h"
 #ifdef OF_HAVE_FILES
 # import "OFFile.h"
+# import "OFFileManager.h"
+# import "OFMappedData.h"
 #endif
 #import "OFSystemInfo.h"
 
@@ -39,6 +41,8 @@
 #import "OFOutOfRangeException.h"
 #import "OFUnboundPrefixException.h"
 
+#import "swar.h"
+
 typedef void (*state_function_t)(id, SEL);
 static SEL selectors[OF_XMLPARSER_NUM_STATES];
 static state_function_t lookupTable[OF_XMLPARSER_NUM_STATES];
@@ -84,6 +88,63 @@ appendToBuffer(OFMutableData *buffer, const char *string,
 	}
 }
 
+/*
+ * Counts the lines in the specified bytes, skipping words without line breaks.
+ */
+static OF_INLINE void
+countLines(const char *data, size_t length, size_t *lineNumber,
+    bool *lastCarriageReturn)
+{
+	size_t i = 0;
+
+	while (i < length) {
+		if (i + sizeof(uintptr_t) <= length) {
+			uintptr_t word = of_swar_load(data + i);
+
+			if ((of_swar_byte_mask(word, '\r') |
+			    of_swar_byte_mask(word, '\n')) == 0) {
+				*lastCarriageReturn = false;
+				i += sizeof(uintptr_t);
+				continue;
+			}
+		}
+
+		if (data[i] == '\r' ||
+		    (data[i] == '\n' && !*lastCarriageReturn))
+			(*lineNumber)++;
+
+		*lastCarriageReturn = (data[i] == '\r');
+		i++;
+	}
+}
+
+/*
+ * Returns the index of the last byte before the next occurrence of stop after
+ * i, or the index of the last byte if there is none. This allows states that
+ * only wait for a certain byte to skip ahead instead of being dispatched for
+ * every byte. The skipped bytes are searched a word at a time.
+ *
+ * The lines in the bytes from i up to the returned index are counted, the
+ * byte at the returned index is counted by -[parseBuffer:length:].
+ */
+static OF_INLINE size_t
+skipUntil(const char *data, size_t i, size_t length, char stop,
+    size_t *lineNumber, bool *lastCarriageReturn)
+{
+	size_t j = i + 1;
+
+	while (j + sizeof(uintptr_t) <= length &&
+	    of_swar_byte_mask(of_swar_load(data + j), stop) == 0)
+		j += sizeof(uintptr_t);
+
+	while (j < length && data[j] != stop)
+		j++;
+
+	countLines(data + i, j - 1 - i, lineNumber, lastCarriageReturn);
+
+	return j - 1;
+}
+
 static OFString *
 transformString(OFXMLParser *parser, OFMutableData *buffer, size_t cut,
     bool unescape)
@@ -257,14 +318,19 @@ resolveAttributeNamespace(OFXMLAttribute *attribute, OFArray *namespaces,
 	     length: (size_t)length
 {
 	_data = buffer;
+	_length = length;
 
 	for (_i = _last = 0; _i < length; _i++) {
 		size_t j = _i;
 
 		lookupTable[_state](self, selectors[_state]);
 
-		/* Ensure we don't count this character twice */
-		if (_i != j)
+		/*
+		 * Ensure we don't count this character twice. If the state
+		 * skipped ahead, it counted all skipped characters except the
+		 * current one.
+		 */
+		if (_i < j)
 			continue;
 
 		if (_data[_i] == '\r' || (_data[_i] == '\n' &&
@@ -307,13 +373,31 @@ resolveAttributeNamespace(OFXMLAttribute *attribute, OFArray *namespaces,
 #ifdef OF_HAVE_FILES
 - (void)parseFile: (OFString *)path
 {
-	OFFile *file = [[OFFile alloc] initWithPath: path
-					       mode: @"r"];
-	@try {
-		[self parseStream: file];
-	} @finally {
-		[file release];
-	}
+	void *pool = objc_autoreleasePoolPush();
+	of_file_attributes_t attributes = [[OFFileManager defaultManager]
+	    attributesOfItemAtPath: path];
+
+	/*
+	 * Map regular files instead of copying them page by page into a
+	 * buffer. FIFOs and devices cannot be mapped, and files in e.g. procfs
+	 * or sysfs have a size of 0 even though they have contents, so those
+	 * are read as a stream.
+	 */
+	if ([[attributes fileType] isEqual: of_file_type_regular] &&
+	    [attributes fileSize] > 0) {
+		of_mapped_data_access_t access =
+		    OF_MAPPED_DATA_ACCESS_SEQUENTIAL;
+		OFMappedData *data = [OFMappedData
+		    dataWithContentsOfMappedFile: path
+					  access: access];
+
+		[self parseBuffer: [data items]
+			   length: [data count]];
+	} else
+		[self parseStream: [OFFile fileWithPath: path
+						   mode: @"r"]];
+
+	objc_autoreleasePoolPop(pool);
 }
 #endif
 
@@ -351,8 +435,13 @@ resolveAttributeNamespace(OFXMLAttribute *attribute, OFArray *namespaces,
 	    _data[_i] != '<')
 		@throw [OFMalformedXMLException exceptionWithParser: self];
 
-	if (_data[_i] != '<')
+	if (_data[_i] != '<') {
+		if (!_finishedParsing && [_previous count] > 0)
+			_i = skipUntil(_data, _i, _length, '<', &_lineNumber,
+			    &_lastCarriageReturn);
+
 		return;
+	}
 
 	if ((length = _i - _last) > 0)
 		appendToBuffer(_buffer, _data + _last, _encoding, length);
@@ -526,8 +615,13 @@ resolveAttributeNamespace(OFXMLAttribute *attribute, OFArray *namespaces,
 
 		_last = _i + 1;
 		_state = OF_XMLPARSER_OUTSIDE_TAG;
-	} else
+	} else {
 		_level = 0;
+
+		/* The end can only follow a '?' */
+		_i = skipUntil(_data, _i, _length, '?', &_lineNumber,
+		    &_lastCarriageReturn);
+	}
 }
 
 /* Inside a tag, no name yet */
@@ -843,8 +937,11 @@ resolveAttributeNamespace(OFXMLAttribute *attribute, OFArray *namespaces,
 	size_t length;
 	OFXMLAttribute *attribute;
 
-	if (_data[_i] != _delimiter)
+	if (_data[_i] != _delimiter) {
+		_i = skipUntil(_data, _i, _length, _delimiter, &_lineNumber,
+		    &_lastCarriageReturn);
 		return;
+	}
 
 	if ((length = _i - _last) > 0)
 		appendToBuffer(_buffer, _data + _last, _encoding, length);
@@ -954,8 +1051,13 @@ resolveAttributeNamespace(OFXMLAttribute *attribute, OFArray *namespaces,
 
 		_last = _i + 1;
 		_state = OF_XMLPARSER_OUTSIDE_TAG;
-	} else
+	} else {
 		_level = 0;
+
+		/* The end can only follow a ']' */
+		_i = skipUntil(_data, _i, _length, ']', &_lineNumber,
+		    &_lastCarriageReturn);
+	}
 }
 
 /* Comment */
@@ -973,9 +1075,13 @@ resolveAttributeNamespace(OFXMLAttribute *attribute, OFArray *namespaces,
 {
 	if (_data[_i] == '-')
 		_level++;
-	else
+	else {
 		_level = 0;
 
+		_i = skipUntil(_data, _i, _length, '-', &_lineNumber,
+		    &_lastCarriageReturn);
+	}
+
 	if (_level == 2)
 		_state = OF_XMLPARSER_IN_COMMENT_2;
 }
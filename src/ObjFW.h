@@ -58,6 +58,7 @@
 #import "OFInflateStream.h"
 #import "OFInflate64Stream.h"
 #import "OFGZIPStream.h"
+#import "OFMemoryStream.h"
 #import "OFLHAArchive.h"
 #import "OFLHAArchiveEntry.h"
 #import "OFTarArchive.h"
@@ -65,9 +66,11 @@
 #import "OFZIPArchive.h"
 #import "OFZIPArchiveEntry.h"
 #ifdef OF_HAVE_FILES
+# import "OFDirectoryEnumerator.h"
 # import "OFFile.h"
 # import "OFFileManager.h"
 # import "OFINIFile.h"
+# import "OFMappedData.h"
 # import "OFSettings.h"
 #endif
 #ifdef OF_HAVE_SOCKETS
@@ -114,8 +117,14 @@
 #import "OFXMLProcessingInstructions.h"
 #import "OFXMLParser.h"
 #import "OFXMLElementBuilder.h"
+#import "OFJSONDocument.h"
+#import "OFJSONParser.h"
+#import "OFJSONWriter.h"
+#import "OFBinaryPropertyList.h"
 
 #import "OFMessagePackExtension.h"
+#import "OFMessagePackReader.h"
+#import "OFMessagePackWriter.h"
 
 #import "OFApplication.h"
 #import "OFSystemInfo.h"
@@ -131,6 +140,7 @@
 
 #import "OFASN1BitString.h"
 #import "OFASN1Boolean.h"
+#import "OFASN1DERElement.h"
 #import "OFASN1Enumerated.h"
 #import "OFASN1IA5String.h"
 #import "OFASN1Integer.h"
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#ifndef __STDC_LIMIT_MACROS
+# define __STDC_LIMIT_MACROS
+#endif
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif
+
+#import "macros.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+@class OFMutableData;
+@class OFStream;
+@class OFXMLElement;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Writes the binary serialization of the element to data. If a stream is
+ * specified, data is used as a buffer which is written to the stream whenever
+ * it gets full and at the end.
+ */
+extern void of_binary_serialization_write(OFXMLElement *, OFMutableData *,
+    OFStream *_Nullable);
+/*
+ * Reads a binary serialization, either from the stream or, if the stream is
+ * nil, from the buffer.
+ */
+extern OFXMLElement *of_binary_serialization_read(OFStream *_Nullable,
+    const void *_Nullable, size_t);
+#ifdef __cplusplus
+}
+#endif
+
+OF_ASSUME_NONNULL_END
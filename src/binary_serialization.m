@@ -0,0 +1,393 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+/*
+ * The binary serialization stores the same tree of elements as the XML
+ * serialization, which is what all classes implementing OFSerialization
+ * produce and consume, so it works for all of them.
+ *
+ * It starts with the magic "OFSB" and a version byte, followed by the element
+ * of the serialized object. All integers are stored as unsigned LEB128
+ * varints. Nodes start with a tag byte:
+ *
+ *   element:    tag, name, namespace, number of attributes, attributes as
+ *               name, namespace, value, number of children, children
+ *   characters: tag, string
+ *   CDATA:      tag, string
+ *
+ * A string is a varint v. If v is odd, v >> 1 is the index into the table of
+ * previously read strings. Otherwise, v >> 1 UTF-8 bytes follow. Non-empty
+ * strings of up to 64 bytes are added to the table, so repeated element names,
+ * namespaces and keys are only stored once. A nil namespace is stored as the
+ * empty string.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "OFArray.h"
+#import "OFData.h"
+#import "OFDictionary.h"
+#import "OFNumber.h"
+#import "OFStream.h"
+#import "OFString.h"
+#import "OFXMLAttribute.h"
+#import "OFXMLCDATA.h"
+#import "OFXMLCharacters.h"
+#import "OFXMLElement.h"
+
+#import "OFInvalidArgumentException.h"
+#import "OFInvalidFormatException.h"
+#import "OFOutOfRangeException.h"
+#import "OFTruncatedDataException.h"
+#import "OFUnsupportedVersionException.h"
+
+#import "binary_serialization.h"
+
+#define VERSION 1
+#define TAG_ELEMENT 1
+#define TAG_CHARACTERS 2
+#define TAG_CDATA 3
+#define TABLE_MAX_LENGTH 64
+#define BUFFER_SIZE 4096
+#define DEPTH_LIMIT 256
+
+struct writer {
+	OFMutableData *data;
+	OFStream *stream;
+	OFMutableDictionary OF_GENERIC(OFString *, OFNumber *) *strings;
+};
+
+struct reader {
+	OFStream *stream;
+	const unsigned char *buffer;
+	size_t length, position;
+	OFMutableArray OF_GENERIC(OFString *) *strings;
+};
+
+static void
+writeVarint(struct writer *writer, uint64_t value)
+{
+	unsigned char buffer[10];
+	size_t i = 0;
+
+	do {
+		buffer[i] = value & 0x7F;
+		value >>= 7;
+
+		if (value != 0)
+			buffer[i] |= 0x80;
+
+		i++;
+	} while (value != 0);
+
+	[writer->data addItems: buffer
+			 count: i];
+}
+
+static void
+writeString(struct writer *writer, OFString *string)
+{
+	OFNumber *idx;
+	size_t length;
+
+	if (string == nil) {
+		writeVarint(writer, 0);
+		return;
+	}
+
+	if ((idx = [writer->strings objectForKey: string]) != nil) {
+		writeVarint(writer, ((uint64_t)[idx sizeValue] << 1) | 1);
+		return;
+	}
+
+	length = [string UTF8StringLength];
+
+	writeVarint(writer, (uint64_t)length << 1);
+	[writer->data addItems: [string UTF8String]
+			 count: length];
+
+	if (length > 0 && length <= TABLE_MAX_LENGTH)
+		[writer->strings setObject:
+		    [OFNumber numberWithSize: [writer->strings count]]
+				    forKey: string];
+}
+
+static void
+writeElement(struct writer *writer, OFXMLElement *element)
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFArray OF_GENERIC(OFXMLAttribute *) *attributes = [element attributes];
+	OFArray OF_GENERIC(OFXMLNode *) *children = [element children];
+	unsigned char tag = TAG_ELEMENT;
+
+	[writer->data addItem: &tag];
+	writeString(writer, [element name]);
+	writeString(writer, [element namespace]);
+
+	writeVarint(writer, [attributes count]);
+	for (OFXMLAttribute *attribute in attributes) {
+		writeString(writer, [attribute name]);
+		writeString(writer, [attribute namespace]);
+		writeString(writer, [attribute stringValue]);
+	}
+
+	writeVarint(writer, [children count]);
+	for (OFXMLNode *child in children) {
+		if ([child isKindOfClass: [OFXMLElement class]]) {
+			writeElement(writer, (OFXMLElement *)child);
+			continue;
+		}
+
+		if ([child isKindOfClass: [OFXMLCharacters class]])
+			tag = TAG_CHARACTERS;
+		else if ([child isKindOfClass: [OFXMLCDATA class]])
+			tag = TAG_CDATA;
+		else
+			@throw [OFInvalidArgumentException exception];
+
+		[writer->data addItem: &tag];
+		writeString(writer, [child stringValue]);
+	}
+
+	if (writer->stream != nil && [writer->data count] >= BUFFER_SIZE) {
+		[writer->stream writeData: writer->data];
+		[writer->data removeAllItems];
+	}
+
+	objc_autoreleasePoolPop(pool);
+}
+
+void
+of_binary_serialization_write(OFXMLElement *element, OFMutableData *data,
+    OFStream *stream)
+{
+	void *pool = objc_autoreleasePoolPush();
+	struct writer writer;
+	unsigned char version = VERSION;
+
+	writer.data = data;
+	writer.stream = stream;
+	writer.strings = [OFMutableDictionary dictionary];
+
+	[data addItems: "OFSB"
+		 count: 4];
+	[data addItem: &version];
+	writeElement(&writer, element);
+
+	if (stream != nil) {
+		[stream writeData: data];
+		[data removeAllItems];
+	}
+
+	objc_autoreleasePoolPop(pool);
+}
+
+static void
+readBytes(struct reader *reader, void *buffer, size_t length)
+{
+	if (reader->stream != nil) {
+		[reader->stream readIntoBuffer: buffer
+				   exactLength: length];
+		return;
+	}
+
+	if (reader->length - reader->position < length)
+		@throw [OFTruncatedDataException exception];
+
+	memcpy(buffer, reader->buffer + reader->position, length);
+	reader->position += length;
+}
+
+static unsigned char
+readByte(struct reader *reader)
+{
+	unsigned char byte;
+
+	readBytes(reader, &byte, 1);
+
+	return byte;
+}
+
+static uint64_t
+readVarint(struct reader *reader)
+{
+	uint64_t value = 0;
+
+	for (unsigned int shift = 0;; shift += 7) {
+		unsigned char byte = readByte(reader);
+
+		/* The 10th byte may only contain the highest bit */
+		if (shift == 63 && (byte & 0xFE) != 0)
+			@throw [OFInvalidFormatException exception];
+
+		value |= (uint64_t)(byte & 0x7F) << shift;
+
+		if (!(byte & 0x80))
+			return value;
+	}
+}
+
+static OFString *
+readString(struct reader *reader)
+{
+	uint64_t value = readVarint(reader);
+	size_t length;
+	OFString *string;
+
+	if (value & 1) {
+		if (value >> 1 >= [reader->strings count])
+			@throw [OFInvalidFormatException exception];
+
+		return [reader->strings objectAtIndex: (size_t)(value >> 1)];
+	}
+
+#if UINT64_MAX > SIZE_MAX
+	if (value >> 1 > SIZE_MAX)
+		@throw [OFOutOfRangeException exception];
+#endif
+
+	length = (size_t)(value >> 1);
+
+	if (length == 0)
+		return @"";
+
+	if (reader->stream == nil) {
+		if (reader->length - reader->position < length)
+			@throw [OFTruncatedDataException exception];
+
+		string = [OFString stringWithUTF8String:
+		    (const char *)reader->buffer + reader->position
+						 length: length];
+		reader->position += length;
+	} else {
+		/*
+		 * Read in chunks, so that an invalid length can not make us
+		 * allocate more memory than the stream actually contains.
+		 */
+		OFMutableData *data = [OFMutableData data];
+		unsigned char buffer[BUFFER_SIZE];
+
+		while ([data count] < length) {
+			size_t chunkLength = length - [data count];
+
+			if (chunkLength > BUFFER_SIZE)
+				chunkLength = BUFFER_SIZE;
+
+			readBytes(reader, buffer, chunkLength);
+			[data addItems: buffer
+				 count: chunkLength];
+		}
+
+		string = [OFString stringWithUTF8String: [data items]
+						 length: length];
+	}
+
+	if (length <= TABLE_MAX_LENGTH)
+		[reader->strings addObject: string];
+
+	return string;
+}
+
+static OFXMLElement *
+readElement(struct reader *reader, size_t depth)
+{
+	OFXMLElement *element;
+	void *pool;
+	OFString *name, *namespace;
+	uint64_t count;
+
+	if (depth >= DEPTH_LIMIT)
+		@throw [OFOutOfRangeException exception];
+
+	name = readString(reader);
+	namespace = readString(reader);
+	element = [OFXMLElement
+	    elementWithName: name
+		  namespace: ([namespace length] > 0 ? namespace : nil)];
+
+	pool = objc_autoreleasePoolPush();
+
+	count = readVarint(reader);
+	for (uint64_t i = 0; i < count; i++) {
+		name = readString(reader);
+		namespace = readString(reader);
+
+		[element addAttributeWithName: name
+				    namespace: ([namespace length] > 0
+						   ? namespace : nil)
+				  stringValue: readString(reader)];
+	}
+
+	count = readVarint(reader);
+	for (uint64_t i = 0; i < count; i++) {
+		switch (readByte(reader)) {
+		case TAG_ELEMENT:
+			[element addChild: readElement(reader, depth + 1)];
+			break;
+		case TAG_CHARACTERS:
+			[element addChild: [OFXMLCharacters
+			    charactersWithString: readString(reader)]];
+			break;
+		case TAG_CDATA:
+			[element addChild:
+			    [OFXMLCDATA CDATAWithString: readString(reader)]];
+			break;
+		default:
+			@throw [OFInvalidFormatException exception];
+		}
+	}
+
+	objc_autoreleasePoolPop(pool);
+
+	return element;
+}
+
+OFXMLElement *
+of_binary_serialization_read(OFStream *stream, const void *buffer,
+    size_t length)
+{
+	void *pool = objc_autoreleasePoolPush();
+	struct reader reader;
+	unsigned char header[5];
+	OFXMLElement *element;
+
+	reader.stream = stream;
+	reader.buffer = buffer;
+	reader.length = length;
+	reader.position = 0;
+	reader.strings = [OFMutableArray array];
+
+	readBytes(&reader, header, 5);
+
+	if (memcmp(header, "OFSB", 4) != 0)
+		@throw [OFInvalidFormatException exception];
+
+	if (header[4] != VERSION)
+		@throw [OFUnsupportedVersionException exceptionWithVersion:
+		    [OFString stringWithFormat: @"%u", header[4]]];
+
+	if (readByte(&reader) != TAG_ELEMENT)
+		@throw [OFInvalidFormatException exception];
+
+	element = [readElement(&reader, 0) retain];
+
+	objc_autoreleasePoolPop(pool);
+
+	return [element autorelease];
+}
@@ -28,6 +28,13 @@
 
 OF_ASSUME_NONNULL_BEGIN
 
+/*
+ * Function that receives the output of of_vformat() piece by piece. Returning
+ * false aborts formatting.
+ */
+typedef bool (*of_format_output_t)(void *_Nullable context,
+    const char *_Nonnull string, size_t length);
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -35,6 +42,8 @@ extern int of_asprintf(
     char *_Nullable *_Nonnull, const char *_Nonnull, ...);
 extern int of_vasprintf(
     char *_Nullable *_Nonnull, const char *_Nonnull, va_list);
+extern int of_vformat(of_format_output_t _Nonnull, void *_Nullable,
+    const char *_Nonnull, va_list);
 #ifdef __cplusplus
 }
 #endif
@@ -61,8 +61,9 @@ struct context {
 	char subformat[MAX_SUBFORMAT_LEN + 1];
 	size_t subformatLen;
 	va_list arguments;
-	char *buffer;
-	size_t bufferLen;
+	of_format_output_t output;
+	void *outputContext;
+	size_t length;
 	size_t i, last;
 	enum {
 		STATE_STRING,
@@ -85,6 +86,16 @@ struct context {
 	bool useLocale;
 };
 
+struct specification {
+	bool leftAlign, plus, space, alternate, zero, hasPrecision;
+	size_t width, precision;
+};
+
+struct stringBuffer {
+	char *buffer;
+	size_t length, capacity;
+};
+
 #ifdef HAVE_ASPRINTF_L
 static locale_t cLocale;
 
@@ -129,19 +140,33 @@ asprintf(char **string, const char *format, ...)
 static bool
 appendString(struct context *ctx, const char *append, size_t appendLen)
 {
-	char *newBuf;
-
 	if (appendLen == 0)
 		return true;
 
-	if ((newBuf = realloc(ctx->buffer,
-	    ctx->bufferLen + appendLen + 1)) == NULL)
+	if (!ctx->output(ctx->outputContext, append, appendLen))
 		return false;
 
-	memcpy(newBuf + ctx->bufferLen, append, appendLen);
+	ctx->length += appendLen;
+
+	return true;
+}
+
+static bool
+appendPadding(struct context *ctx, char character, size_t count)
+{
+	char padding[16];
+
+	memset(padding, character, sizeof(padding));
 
-	ctx->buffer = newBuf;
-	ctx->bufferLen += appendLen;
+	while (count > 0) {
+		size_t length = (count < sizeof(padding)
+		    ? count : sizeof(padding));
+
+		if (!appendString(ctx, padding, length))
+			return false;
+
+		count -= length;
+	}
 
 	return true;
 }
@@ -160,6 +185,232 @@ appendSubformat(struct context *ctx, const char *subformat,
 	return true;
 }
 
+/*
+ * Parses flags, field width and precision of the current subformat for the
+ * conversions that are done without the help of libc. Arguments for "*" are
+ * taken from the argument list.
+ */
+static bool
+parseSpecification(struct context *ctx, struct specification *spec)
+{
+	const char *subformat = ctx->subformat + 1;
+	int argument;
+
+	memset(spec, 0, sizeof(*spec));
+
+	for (;; subformat++) {
+		switch (*subformat) {
+		case '-':
+			spec->leftAlign = true;
+			continue;
+		case '+':
+			spec->plus = true;
+			continue;
+		case ' ':
+			spec->space = true;
+			continue;
+		case '#':
+			spec->alternate = true;
+			continue;
+		case '0':
+			spec->zero = true;
+			continue;
+		}
+
+		break;
+	}
+
+	if (*subformat == '*') {
+		if ((argument = va_arg(ctx->arguments, int)) < 0) {
+			spec->leftAlign = true;
+			argument = -argument;
+		}
+
+		spec->width = argument;
+		subformat++;
+	} else
+		for (; *subformat >= '0' && *subformat <= '9'; subformat++) {
+			if (spec->width > INT_MAX / 10)
+				return false;
+
+			spec->width = spec->width * 10 + (*subformat - '0');
+		}
+
+	if (*subformat == '.') {
+		spec->hasPrecision = true;
+		subformat++;
+
+		if (*subformat == '*') {
+			if ((argument = va_arg(ctx->arguments, int)) < 0)
+				spec->hasPrecision = false;
+			else
+				spec->precision = argument;
+
+			subformat++;
+		} else
+			for (; *subformat >= '0' && *subformat <= '9';
+			    subformat++) {
+				if (spec->precision > INT_MAX / 10)
+					return false;
+
+				spec->precision = spec->precision * 10 +
+				    (*subformat - '0');
+			}
+	}
+
+	/* Anything left that is not a length modifier is invalid */
+	return !(*subformat == '*' || *subformat == '.' ||
+	    (*subformat >= '0' && *subformat <= '9'));
+}
+
+static bool
+formatString(struct context *ctx, const struct specification *spec,
+    const char *string, size_t length)
+{
+	if (spec->hasPrecision && spec->precision < length)
+		length = spec->precision;
+
+	if (!spec->leftAlign && spec->width > length)
+		if (!appendPadding(ctx, ' ', spec->width - length))
+			return false;
+
+	if (!appendString(ctx, string, length))
+		return false;
+
+	if (spec->leftAlign && spec->width > length)
+		if (!appendPadding(ctx, ' ', spec->width - length))
+			return false;
+
+	return true;
+}
+
+static bool
+formatUnicodeString(struct context *ctx, const struct specification *spec,
+    const of_unichar_t *string)
+{
+	char buffer[64];
+	size_t i, length = 0, bufferLength = 0, remaining;
+
+	for (i = 0; string[i] != 0; i++) {
+		size_t characterLength = of_string_utf8_encode(string[i],
+		    buffer);
+
+		if (characterLength == 0)
+			return false;
+
+		length += characterLength;
+	}
+
+	if (spec->hasPrecision && spec->precision < length)
+		length = spec->precision;
+
+	if (!spec->leftAlign && spec->width > length)
+		if (!appendPadding(ctx, ' ', spec->width - length))
+			return false;
+
+	remaining = length;
+	for (i = 0; remaining > 0; i++) {
+		size_t characterLength;
+
+		if (bufferLength > sizeof(buffer) - 4) {
+			if (!appendString(ctx, buffer, bufferLength))
+				return false;
+
+			bufferLength = 0;
+		}
+
+		characterLength = of_string_utf8_encode(string[i],
+		    buffer + bufferLength);
+		if (characterLength > remaining)
+			characterLength = remaining;
+
+		bufferLength += characterLength;
+		remaining -= characterLength;
+	}
+
+	if (!appendString(ctx, buffer, bufferLength))
+		return false;
+
+	if (spec->leftAlign && spec->width > length)
+		if (!appendPadding(ctx, ' ', spec->width - length))
+			return false;
+
+	return true;
+}
+
+static bool
+formatInteger(struct context *ctx, const struct specification *spec,
+    uintmax_t value, bool negative, char conversion)
+{
+	const char *alphabet = "0123456789abcdef";
+	char digits[sizeof(uintmax_t) * 3], prefix[2];
+	size_t digitsLength = 0, prefixLength = 0, zeros = 0, length;
+	unsigned int base = 10;
+	bool isZero = (value == 0);
+
+	if (conversion == 'o')
+		base = 8;
+	else if (conversion == 'x')
+		base = 16;
+	else if (conversion == 'X') {
+		base = 16;
+		alphabet = "0123456789ABCDEF";
+	}
+
+	/* Generate the digits backwards */
+	while (value != 0) {
+		digits[sizeof(digits) - ++digitsLength] = alphabet[value % base];
+		value /= base;
+	}
+
+	if (negative)
+		prefix[prefixLength++] = '-';
+	else if (conversion == 'd' || conversion == 'i') {
+		if (spec->plus)
+			prefix[prefixLength++] = '+';
+		else if (spec->space)
+			prefix[prefixLength++] = ' ';
+	}
+
+	if (spec->alternate && base == 16 && !isZero) {
+		prefix[prefixLength++] = '0';
+		prefix[prefixLength++] = conversion;
+	}
+
+	if (spec->hasPrecision) {
+		if (spec->precision > digitsLength)
+			zeros = spec->precision - digitsLength;
+	} else if (isZero)
+		zeros = 1;
+
+	if (spec->alternate && base == 8 && zeros == 0)
+		zeros = 1;
+
+	length = prefixLength + zeros + digitsLength;
+
+	if (spec->zero && !spec->leftAlign && !spec->hasPrecision &&
+	    spec->width > length) {
+		zeros += spec->width - length;
+		length = spec->width;
+	}
+
+	if (!spec->leftAlign && spec->width > length)
+		if (!appendPadding(ctx, ' ', spec->width - length))
+			return false;
+
+	if (!appendString(ctx, prefix, prefixLength) ||
+	    !appendPadding(ctx, '0', zeros) ||
+	    !appendString(ctx, digits + sizeof(digits) - digitsLength,
+	    digitsLength))
+		return false;
+
+	if (spec->leftAlign && spec->width > length)
+		if (!appendPadding(ctx, ' ', spec->width - length))
+			return false;
+
+	return true;
+}
+
 static bool
 stringState(struct context *ctx)
 {
@@ -352,6 +603,7 @@ formatLengthModifierState(struct context *ctx)
 static bool
 formatConversionSpecifierState(struct context *ctx)
 {
+	struct specification spec;
 	char *tmp = NULL;
 	int tmpLen = 0;
 
@@ -360,27 +612,48 @@ formatConversionSpecifierState(struct context *ctx)
 
 	switch (ctx->format[ctx->i]) {
 	case '@':
-		if (ctx->lengthModifier != LENGTH_MODIFIER_NONE)
+	case 'C':
+	case 'S':
+	case 'd':
+	case 'i':
+	case 'o':
+	case 'u':
+	case 'x':
+	case 'X':
+		if (!parseSpecification(ctx, &spec))
+			return false;
+
+		break;
+	case 'c':
+	case 's':
+		if (ctx->lengthModifier == LENGTH_MODIFIER_NONE &&
+		    !parseSpecification(ctx, &spec))
 			return false;
 
-		ctx->subformat[ctx->subformatLen - 1] = 's';
+		break;
+	}
+
+	switch (ctx->format[ctx->i]) {
+	case '@':
+		if (ctx->lengthModifier != LENGTH_MODIFIER_NONE)
+			return false;
 
-		@try {
+		{
 			id object;
 
 			if ((object = va_arg(ctx->arguments, id)) != nil) {
 				void *pool = objc_autoreleasePoolPush();
-
-				tmpLen = asprintf(&tmp, ctx->subformat,
-				    [[object description] UTF8String]);
+				OFString *description = [object description];
+				bool success = formatString(ctx, &spec,
+				    [description UTF8String],
+				    [description UTF8StringLength]);
 
 				objc_autoreleasePoolPop(pool);
-			} else
-				tmpLen = asprintf(&tmp, ctx->subformat,
-				    "(nil)");
-		} @catch (id e) {
-			free(ctx->buffer);
-			@throw e;
+
+				if (!success)
+					return false;
+			} else if (!formatString(ctx, &spec, "(nil)", 5))
+				return false;
 		}
 
 		break;
@@ -388,18 +661,16 @@ formatConversionSpecifierState(struct context *ctx)
 		if (ctx->lengthModifier != LENGTH_MODIFIER_NONE)
 			return false;
 
-		ctx->subformat[ctx->subformatLen - 1] = 's';
-
 		{
-			char buffer[5];
+			char buffer[4];
 			size_t len = of_string_utf8_encode(
 			    va_arg(ctx->arguments, of_unichar_t), buffer);
 
 			if (len == 0)
 				return false;
 
-			buffer[len] = 0;
-			tmpLen = asprintf(&tmp, ctx->subformat, buffer);
+			if (!formatString(ctx, &spec, buffer, len))
+				return false;
 		}
 
 		break;
@@ -407,109 +678,93 @@ formatConversionSpecifierState(struct context *ctx)
 		if (ctx->lengthModifier != LENGTH_MODIFIER_NONE)
 			return false;
 
-		ctx->subformat[ctx->subformatLen - 1] = 's';
-
-		{
-			const of_unichar_t *arg =
-			    va_arg(ctx->arguments, const of_unichar_t *);
-			size_t j, len = of_string_utf32_length(arg);
-			char *buffer;
-
-			if (SIZE_MAX / 4 < len || (SIZE_MAX / 4) - len < 1)
-				return false;
-
-			if ((buffer = malloc((len * 4) + 1)) == NULL)
-				return false;
-
-			j = 0;
-			for (size_t i = 0; i < len; i++) {
-				size_t clen = of_string_utf8_encode(arg[i],
-				    buffer + j);
-
-				if (clen == 0) {
-					free(buffer);
-					return false;
-				}
-
-				j += clen;
-			}
-			buffer[j] = 0;
-
-			tmpLen = asprintf(&tmp, ctx->subformat, buffer);
-
-			free(buffer);
-		}
+		if (!formatUnicodeString(ctx, &spec,
+		    va_arg(ctx->arguments, const of_unichar_t *)))
+			return false;
 
 		break;
 	case 'd':
-	case 'i':
+	case 'i':;
+		intmax_t signedValue;
+
 		switch (ctx->lengthModifier) {
 		case LENGTH_MODIFIER_NONE:
+			signedValue = va_arg(ctx->arguments, int);
+			break;
 		case LENGTH_MODIFIER_HH:
+			signedValue = (signed char)va_arg(ctx->arguments, int);
+			break;
 		case LENGTH_MODIFIER_H:
-			tmpLen = asprintf(&tmp, ctx->subformat,
-			    va_arg(ctx->arguments, int));
+			signedValue = (short)va_arg(ctx->arguments, int);
 			break;
 		case LENGTH_MODIFIER_L:
-			tmpLen = asprintf(&tmp, ctx->subformat,
-			    va_arg(ctx->arguments, long));
+			signedValue = va_arg(ctx->arguments, long);
 			break;
 		case LENGTH_MODIFIER_LL:
-			tmpLen = asprintf(&tmp, ctx->subformat,
-			    va_arg(ctx->arguments, long long));
+			signedValue = va_arg(ctx->arguments, long long);
 			break;
 		case LENGTH_MODIFIER_J:
-			tmpLen = asprintf(&tmp, ctx->subformat,
-			    va_arg(ctx->arguments, intmax_t));
+			signedValue = va_arg(ctx->arguments, intmax_t);
 			break;
 		case LENGTH_MODIFIER_Z:
-			tmpLen = asprintf(&tmp, ctx->subformat,
-			    va_arg(ctx->arguments, ssize_t));
+			signedValue = va_arg(ctx->arguments, ssize_t);
 			break;
 		case LENGTH_MODIFIER_T:
-			tmpLen = asprintf(&tmp, ctx->subformat,
-			    va_arg(ctx->arguments, ptrdiff_t));
+			signedValue = va_arg(ctx->arguments, ptrdiff_t);
 			break;
 		default:
 			return false;
 		}
 
+		/* Negate as unsigned so that INTMAX_MIN works */
+		if (!formatInteger(ctx, &spec, (signedValue < 0
+		    ? -(uintmax_t)signedValue : (uintmax_t)signedValue),
+		    signedValue < 0, ctx->format[ctx->i]))
+			return false;
+
 		break;
 	case 'o':
 	case 'u':
 	case 'x':
-	case 'X':
+	case 'X':;
+		uintmax_t unsignedValue;
+
 		switch (ctx->lengthModifier) {
 		case LENGTH_MODIFIER_NONE:
+			unsignedValue = va_arg(ctx->arguments, unsigned int);
+			break;
 		case LENGTH_MODIFIER_HH:
+			unsignedValue =
+			    (unsigned char)va_arg(ctx->arguments, unsigned int);
+			break;
 		case LENGTH_MODIFIER_H:
-			tmpLen = asprintf(&tmp, ctx->subformat,
-			    va_arg(ctx->arguments, unsigned int));
+			unsignedValue = (unsigned short)
+			    va_arg(ctx->arguments, unsigned int);
 			break;
 		case LENGTH_MODIFIER_L:
-			tmpLen = asprintf(&tmp, ctx->subformat,
-			    va_arg(ctx->arguments, unsigned long));
+			unsignedValue = va_arg(ctx->arguments, unsigned long);
 			break;
 		case LENGTH_MODIFIER_LL:
-			tmpLen = asprintf(&tmp, ctx->subformat,
-			    va_arg(ctx->arguments, unsigned long long));
+			unsignedValue =
+			    va_arg(ctx->arguments, unsigned long long);
 			break;
 		case LENGTH_MODIFIER_J:
-			tmpLen = asprintf(&tmp, ctx->subformat,
-			    va_arg(ctx->arguments, uintmax_t));
+			unsignedValue = va_arg(ctx->arguments, uintmax_t);
 			break;
 		case LENGTH_MODIFIER_Z:
-			tmpLen = asprintf(&tmp, ctx->subformat,
-			    va_arg(ctx->arguments, size_t));
+			unsignedValue = va_arg(ctx->arguments, size_t);
 			break;
 		case LENGTH_MODIFIER_T:
-			tmpLen = asprintf(&tmp, ctx->subformat,
-			    va_arg(ctx->arguments, ptrdiff_t));
+			unsignedValue = (size_t)va_arg(ctx->arguments, ptrdiff_t);
 			break;
 		default:
 			return false;
 		}
 
+		if (!formatInteger(ctx, &spec, unsignedValue, false,
+		    ctx->format[ctx->i]))
+			return false;
+
 		break;
 	case 'f':
 	case 'F':
@@ -583,9 +838,15 @@ formatConversionSpecifierState(struct context *ctx)
 		break;
 	case 'c':
 		switch (ctx->lengthModifier) {
-		case LENGTH_MODIFIER_NONE:
-			tmpLen = asprintf(&tmp, ctx->subformat,
-			    va_arg(ctx->arguments, int));
+		case LENGTH_MODIFIER_NONE:;
+			char character = (char)va_arg(ctx->arguments, int);
+
+			/* The precision has no meaning for %c */
+			spec.hasPrecision = false;
+
+			if (!formatString(ctx, &spec, &character, 1))
+				return false;
+
 			break;
 		case LENGTH_MODIFIER_L:
 #ifdef HAVE_WCHAR_H
@@ -605,9 +866,25 @@ formatConversionSpecifierState(struct context *ctx)
 		break;
 	case 's':
 		switch (ctx->lengthModifier) {
-		case LENGTH_MODIFIER_NONE:
-			tmpLen = asprintf(&tmp, ctx->subformat,
-			    va_arg(ctx->arguments, const char *));
+		case LENGTH_MODIFIER_NONE:;
+			const char *string =
+			    va_arg(ctx->arguments, const char *);
+			size_t length = 0;
+
+			if (string == NULL)
+				string = "(null)";
+
+			/* With a precision, the string needs no terminator */
+			if (spec.hasPrecision)
+				while (length < spec.precision &&
+				    string[length] != '\0')
+					length++;
+			else
+				length = strlen(string);
+
+			if (!formatString(ctx, &spec, string, length))
+				return false;
+
 			break;
 #ifdef HAVE_WCHAR_T
 		case LENGTH_MODIFIER_L:
@@ -631,35 +908,35 @@ formatConversionSpecifierState(struct context *ctx)
 	case 'n':
 		switch (ctx->lengthModifier) {
 		case LENGTH_MODIFIER_NONE:
-			*va_arg(ctx->arguments, int *) = (int)ctx->bufferLen;
+			*va_arg(ctx->arguments, int *) = (int)ctx->length;
 			break;
 		case LENGTH_MODIFIER_HH:
 			*va_arg(ctx->arguments, signed char *) =
-			    (signed char)ctx->bufferLen;
+			    (signed char)ctx->length;
 			break;
 		case LENGTH_MODIFIER_H:
 			*va_arg(ctx->arguments, short *) =
-			    (short)ctx->bufferLen;
+			    (short)ctx->length;
 			break;
 		case LENGTH_MODIFIER_L:
 			*va_arg(ctx->arguments, long *) =
-			    (long)ctx->bufferLen;
+			    (long)ctx->length;
 			break;
 		case LENGTH_MODIFIER_LL:
 			*va_arg(ctx->arguments, long long *) =
-			    (long long)ctx->bufferLen;
+			    (long long)ctx->length;
 			break;
 		case LENGTH_MODIFIER_J:
 			*va_arg(ctx->arguments, intmax_t *) =
-			    (intmax_t)ctx->bufferLen;
+			    (intmax_t)ctx->length;
 			break;
 		case LENGTH_MODIFIER_Z:
 			*va_arg(ctx->arguments, size_t *) =
-			    (size_t)ctx->bufferLen;
+			    (size_t)ctx->length;
 			break;
 		case LENGTH_MODIFIER_T:
 			*va_arg(ctx->arguments, ptrdiff_t *) =
-			    (ptrdiff_t)ctx->bufferLen;
+			    (ptrdiff_t)ctx->length;
 			break;
 		default:
 			return false;
@@ -710,7 +987,8 @@ static bool (*states[])(struct context *) = {
 };
 
 int
-of_vasprintf(char **string, const char *format, va_list arguments)
+of_vformat(of_format_output_t output, void *outputContext, const char *format,
+    va_list arguments)
 {
 	struct context ctx;
 
@@ -719,37 +997,88 @@ of_vasprintf(char **string, const char *format, va_list arguments)
 	memset(ctx.subformat, 0, MAX_SUBFORMAT_LEN + 1);
 	ctx.subformatLen = 0;
 	va_copy(ctx.arguments, arguments);
-	ctx.bufferLen = 0;
+	ctx.output = output;
+	ctx.outputContext = outputContext;
+	ctx.length = 0;
 	ctx.last = 0;
 	ctx.state = STATE_STRING;
 	ctx.lengthModifier = LENGTH_MODIFIER_NONE;
 	ctx.useLocale = false;
 
-	if ((ctx.buffer = malloc(1)) == NULL)
+	for (ctx.i = 0; ctx.i < ctx.formatLen; ctx.i++)
+		if (!states[ctx.state](&ctx))
+			return -1;
+
+	if (ctx.state != STATE_STRING)
 		return -1;
 
-	for (ctx.i = 0; ctx.i < ctx.formatLen; ctx.i++) {
-		if (!states[ctx.state](&ctx)) {
-			free(ctx.buffer);
-			return -1;
-		}
+	if (!appendString(&ctx, ctx.format + ctx.last,
+	    ctx.formatLen - ctx.last))
+		return -1;
+
+	return (ctx.length <= INT_MAX ? (int)ctx.length : -1);
+}
+
+static bool
+appendToStringBuffer(void *context, const char *string, size_t length)
+{
+	struct stringBuffer *buffer = context;
+
+	/* Always keep room for the terminating NUL */
+	if (length >= buffer->capacity - buffer->length) {
+		size_t capacity;
+		char *newBuffer;
+
+		if (length >= SIZE_MAX - buffer->length)
+			return false;
+
+		capacity = buffer->length + length + 1;
+		if (capacity < buffer->capacity * 2 &&
+		    buffer->capacity <= SIZE_MAX / 2)
+			capacity = buffer->capacity * 2;
+
+		if ((newBuffer = realloc(buffer->buffer, capacity)) == NULL)
+			return false;
+
+		buffer->buffer = newBuffer;
+		buffer->capacity = capacity;
 	}
 
-	if (ctx.state != STATE_STRING) {
-		free(ctx.buffer);
+	memcpy(buffer->buffer + buffer->length, string, length);
+	buffer->length += length;
+
+	return true;
+}
+
+int
+of_vasprintf(char **string, const char *format, va_list arguments)
+{
+	struct stringBuffer buffer;
+	int length;
+
+	buffer.length = 0;
+	buffer.capacity = strlen(format) + 1;
+
+	if ((buffer.buffer = malloc(buffer.capacity)) == NULL)
 		return -1;
+
+	@try {
+		length = of_vformat(appendToStringBuffer, &buffer, format,
+		    arguments);
+	} @catch (id e) {
+		free(buffer.buffer);
+		@throw e;
 	}
 
-	if (!appendString(&ctx, ctx.format + ctx.last,
-	    ctx.formatLen - ctx.last)) {
-		free(ctx.buffer);
+	if (length == -1) {
+		free(buffer.buffer);
 		return -1;
 	}
 
-	ctx.buffer[ctx.bufferLen] = 0;
+	buffer.buffer[buffer.length] = '\0';
 
-	*string = ctx.buffer;
-	return (ctx.bufferLen <= INT_MAX ? (int)ctx.bufferLen : -1);
+	*string = buffer.buffer;
+	return length;
 }
 
 int
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#ifndef __STDC_LIMIT_MACROS
+# define __STDC_LIMIT_MACROS
+#endif
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif
+
+#import "macros.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+/*
+ * The size a buffer passed to of_dtoa() or of_ftoa() needs to have, including
+ * the terminating NUL.
+ */
+#define OF_DTOA_BUFFER_SIZE 32
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Writes a decimal representation of the value that converts back to the same
+ * value into the buffer and returns its length. It is usually, but not always,
+ * the shortest one: For example, 1e23 is written as 9.999999999999999e+22.
+ *
+ * The result is independent of the locale and always contains a "." or an
+ * exponent, so that it can be told apart from an integer.
+ */
+extern size_t of_dtoa(double value, char *buffer);
+extern size_t of_ftoa(float value, char *buffer);
+
+/*
+ * Parses a decimal floating point number that makes up the whole string,
+ * rounding it correctly and independent of the locale.
+ *
+ * Returns false if the string is not a plain decimal number or has too many
+ * significant digits to be converted without arbitrary precision arithmetic,
+ * in which case the caller needs to fall back to strtod().
+ */
+extern bool of_parse_double(const char *string, size_t length, double *value);
+#ifdef __cplusplus
+}
+#endif
+
+OF_ASSUME_NONNULL_END
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+/*
+ * Helpers for processing byte strings one machine word at a time ("SIMD within
+ * a register"). They only use plain integer arithmetic, so they work on every
+ * platform ObjFW supports, independent of endianess and alignment
+ * requirements.
+ */
+
+#ifndef __STDC_LIMIT_MACROS
+# define __STDC_LIMIT_MACROS
+#endif
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif
+
+#include <string.h>
+
+#import "OFString.h"
+
+#define OF_SWAR_ONES ((uintptr_t)-1 / 0xFF)
+#define OF_SWAR_HIGHS (OF_SWAR_ONES * 0x80)
+#define OF_SWAR_ONES16 ((uintptr_t)-1 / 0xFFFF)
+#define OF_SWAR_ONES32 ((uintptr_t)-1 / 0xFFFFFFFF)
+
+static OF_INLINE uintptr_t
+of_swar_load(const void *pointer)
+{
+	uintptr_t word;
+
+	memcpy(&word, pointer, sizeof(word));
+
+	return word;
+}
+
+static OF_INLINE void
+of_swar_store(void *pointer, uintptr_t word)
+{
+	memcpy(pointer, &word, sizeof(word));
+}
+
+/*
+ * Returns the number of bytes at the start of the buffer that are ASCII.
+ */
+static OF_INLINE size_t
+of_swar_ascii_length(const char *buffer, size_t length)
+{
+	size_t i = 0;
+
+	for (; i + sizeof(uintptr_t) <= length; i += sizeof(uintptr_t))
+		if (of_swar_load(buffer + i) & OF_SWAR_HIGHS)
+			break;
+
+	for (; i < length; i++)
+		if (buffer[i] & 0x80)
+			break;
+
+	return i;
+}
+
+/*
+ * Returns a mask that has the high bit set in every byte of the word that is
+ * in the range from first to last. All bytes of the word must be ASCII.
+ */
+static OF_INLINE uintptr_t
+of_swar_range_mask(uintptr_t word, unsigned char first, unsigned char last)
+{
+	uintptr_t above = word + OF_SWAR_ONES * (0x80 - first);
+	uintptr_t beyond = word + OF_SWAR_ONES * (0x7F - last);
+
+	return (above ^ beyond) & OF_SWAR_HIGHS;
+}
+
+/*
+ * Returns a mask that has the high bit set in every byte of the word that is
+ * equal to the specified byte. Unlike the well-known shortcut, this has no
+ * false positives, so it works for any bytes.
+ */
+static OF_INLINE uintptr_t
+of_swar_byte_mask(uintptr_t word, unsigned char byte)
+{
+	uintptr_t x = word ^ (OF_SWAR_ONES * byte);
+
+	return ~(((x & ~OF_SWAR_HIGHS) + ~OF_SWAR_HIGHS) | x) & OF_SWAR_HIGHS;
+}
+
+/*
+ * Returns whether the word contains a byte that is less than the specified
+ * byte, which must be at most 0x80.
+ */
+static OF_INLINE bool
+of_swar_has_less(uintptr_t word, unsigned char byte)
+{
+	return (((word - OF_SWAR_ONES * byte) & ~word & OF_SWAR_HIGHS) != 0);
+}
+
+static OF_INLINE uintptr_t
+of_swar_ascii_tolower(uintptr_t word)
+{
+	return word | (of_swar_range_mask(word, 'A', 'Z') >> 2);
+}
+
+static OF_INLINE uintptr_t
+of_swar_ascii_toupper(uintptr_t word)
+{
+	return word & ~(of_swar_range_mask(word, 'a', 'z') >> 2);
+}
+
+/*
+ * Converts all ASCII bytes of the buffer to lowercase / uppercase. All bytes
+ * of the buffer must be ASCII.
+ */
+static OF_INLINE void
+of_swar_ascii_lowercase(char *buffer, size_t length)
+{
+	size_t i = 0;
+
+	for (; i + sizeof(uintptr_t) <= length; i += sizeof(uintptr_t))
+		of_swar_store(buffer + i,
+		    of_swar_ascii_tolower(of_swar_load(buffer + i)));
+
+	for (; i < length; i++)
+		buffer[i] = of_ascii_tolower(buffer[i]);
+}
+
+static OF_INLINE void
+of_swar_ascii_uppercase(char *buffer, size_t length)
+{
+	size_t i = 0;
+
+	for (; i + sizeof(uintptr_t) <= length; i += sizeof(uintptr_t))
+		of_swar_store(buffer + i,
+		    of_swar_ascii_toupper(of_swar_load(buffer + i)));
+
+	for (; i < length; i++)
+		buffer[i] = of_ascii_toupper(buffer[i]);
+}
+
+/*
+ * Returns the number of UTF-16 code units at the start of the string that are
+ * ASCII. If swap is true, the code units are in the non-native byte order.
+ */
+static OF_INLINE size_t
+of_swar_utf16_ascii_length(const of_char16_t *string, size_t length, bool swap)
+{
+	const size_t step = sizeof(uintptr_t) / sizeof(of_char16_t);
+	uintptr_t mask = OF_SWAR_ONES16 * (swap ? 0x80FF : 0xFF80);
+	size_t i = 0;
+
+	for (; i + step <= length; i += step)
+		if (of_swar_load(string + i) & mask)
+			break;
+
+	for (; i < length; i++)
+		if ((swap ? OF_BSWAP16(string[i]) : string[i]) >= 0x80)
+			break;
+
+	return i;
+}
+
+/*
+ * Returns the number of UTF-32 code units at the start of the string that are
+ * ASCII. If swap is true, the code units are in the non-native byte order.
+ */
+static OF_INLINE size_t
+of_swar_utf32_ascii_length(const of_char32_t *string, size_t length, bool swap)
+{
+	const size_t step = sizeof(uintptr_t) / sizeof(of_char32_t);
+	uintptr_t mask = OF_SWAR_ONES32 * (swap ? 0x80FFFFFF : 0xFFFFFF80);
+	size_t i = 0;
+
+	if (step > 1)
+		for (; i + step <= length; i += step)
+			if (of_swar_load(string + i) & mask)
+				break;
+
+	for (; i < length; i++)
+		if ((swap ? OF_BSWAP32(string[i]) : string[i]) >= 0x80)
+			break;
+
+	return i;
+}
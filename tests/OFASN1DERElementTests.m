@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#import "OFASN1DERElement.h"
+#import "OFData.h"
+#import "OFString.h"
+#import "OFAutoreleasePool.h"
+
+#import "TestsAppDelegate.h"
+
+#import "OFInvalidFormatException.h"
+#import "OFOutOfRangeException.h"
+#import "OFTruncatedDataException.h"
+
+static OFString *module = @"OFASN1DERElement";
+
+@implementation TestsAppDelegate (OFASN1DERElementTests)
+- (void)ASN1DERElementTests
+{
+	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
+	OFData *data;
+	OFASN1DERElement *element, *child;
+
+	data = [OFData dataWithItems: "\x30\x0B\x02\x01\x7B\xA0\x06\x04\x04"
+				      "abcd"
+			       count: 13];
+
+	TEST(@"+[elementWithDERRepresentation:]",
+	    (element = [OFASN1DERElement elementWithDERRepresentation: data]) &&
+	    [element tagNumber] == OF_ASN1_TAG_NUMBER_SEQUENCE &&
+	    [element isConstructed] && [element count] == 2)
+
+	TEST(@"-[elementAtIndex:]",
+	    [[[element elementAtIndex: 0] value] integerValue] == 123 &&
+	    (child = [element elementAtIndex: 1]) &&
+	    [child tagClass] == OF_ASN1_TAG_CLASS_CONTEXT_SPECIFIC &&
+	    [child count] == 1 &&
+	    [[[child elementAtIndex: 0] DEREncodedContents] isEqual:
+	    [OFData dataWithItems: "abcd"
+			    count: 4]])
+
+	TEST(@"-[value]", [[element value] isEqual: [data ASN1DERValue]])
+
+	EXPECT_EXCEPTION(@"Detection of truncated nested element",
+	    OFTruncatedDataException, [OFASN1DERElement
+	    elementWithDERRepresentation: [OFData dataWithItems: "\x30\x03"
+								 "\x02\x02\x7B"
+							  count: 5]])
+
+	EXPECT_EXCEPTION(@"Detection of unsorted set",
+	    OFInvalidFormatException, [OFASN1DERElement
+	    elementWithDERRepresentation: [OFData dataWithItems: "\x31\x06"
+								 "\x02\x01\x02"
+								 "\x02\x01\x01"
+							  count: 8]])
+
+	EXPECT_EXCEPTION(@"Detection of exceeded depth limit",
+	    OFOutOfRangeException, [OFASN1DERElement
+	    elementWithDERRepresentation: [OFData dataWithItems: "\x30\x02"
+								 "\x30\x00"
+							  count: 4]
+			      depthLimit: 2])
+
+	[pool drain];
+}
+@end
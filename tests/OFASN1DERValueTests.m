@@ -51,6 +51,7 @@ static OFString *module = @"OFData+ASN1DERValue";
 	OFArray *array;
 	OFSet *set;
 	OFEnumerator *enumerator;
+	OFData *data;
 
 	/* Boolean */
 	TEST(@"Parsing of boolean",
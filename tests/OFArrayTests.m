@@ -18,6 +18,7 @@
 #include "config.h"
 
 #import "OFArray.h"
+#import "OFDate.h"
 #import "OFString.h"
 #import "OFNumber.h"
 #import "OFURL.h"
@@ -453,6 +454,26 @@ static OFString *c_ary[] = {
 	[pool drain];
 }
 
+- (void)arrayAppendingTests
+{
+	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
+	OFMutableArray *array = [OFMutableArray array];
+	OFDate *start = [OFDate date];
+
+	/*
+	 * The limit is generous for slow machines, but growing by one object
+	 * at a time would take far longer.
+	 */
+	for (size_t i = 0; i < 1000000; i++)
+		[array addObject: @"x"];
+
+	TEST(@"Appending 1000000 objects takes less than 5 seconds",
+	    [array count] == 1000000 &&
+	    [[OFDate date] timeIntervalSinceDate: start] < 5)
+
+	[pool drain];
+}
+
 - (void)arrayTests
 {
 	module = @"OFArray";
@@ -462,5 +483,6 @@ static OFString *c_ary[] = {
 	module = @"OFArray_adjacent";
 	[self arrayTestsWithClass: [OFArray class]
 		     mutableClass: [OFMutableArray class]];
+	[self arrayAppendingTests];
 }
 @end
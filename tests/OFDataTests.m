@@ -20,6 +20,10 @@
 #include <string.h>
 
 #import "OFData.h"
+#import "OFDate.h"
+#ifdef OF_HAVE_FILES
+# import "OFMappedData.h"
+#endif
 #import "OFString.h"
 #import "OFAutoreleasePool.h"
 
@@ -99,6 +103,31 @@ const char *str = "Hello!";
 			     count: 2]) && [mutable count] == 5 &&
 	    memcmp([mutable items], "abcde", 5) == 0)
 
+	TEST(@"-[reserveCapacity:]", R([mutable reserveCapacity: 1024]) &&
+	    [mutable count] == 5 && memcmp([mutable items], "abcde", 5) == 0)
+
+	[mutable addItems: "fgh"
+		    count: 3];
+	TEST(@"-[shrinkToFit]", R([mutable shrinkToFit]) &&
+	    [mutable count] == 8 && memcmp([mutable items], "abcdefgh", 8) == 0)
+	[mutable removeItemsInRange: of_range(5, 3)];
+
+	/*
+	 * The limit is generous for slow machines, but growing by one item at
+	 * a time would take far longer.
+	 */
+	{
+		OFMutableData *appended = [OFMutableData data];
+		OFDate *start = [OFDate date];
+
+		for (size_t i = 0; i < 1000000; i++)
+			[appended addItem: "x"];
+
+		TEST(@"Appending 1000000 items takes less than 5 seconds",
+		    [appended count] == 1000000 &&
+		    [[OFDate date] timeIntervalSinceDate: start] < 5)
+	}
+
 	immutable = [OFData dataWithItems: "aaabaccdacaabb"
 				 itemSize: 2
 				    count: 7];
@@ -216,6 +245,30 @@ const char *str = "Hello!";
 	    OFOutOfRangeException,
 	    [mutable removeItemsInRange: of_range([mutable count], 1)])
 
+#ifdef OF_HAVE_FILES
+	TEST(@"+[OFMappedData dataWithContentsOfMappedFile:]",
+	    (immutable = [OFMappedData
+	    dataWithContentsOfMappedFile: @"testfile.bin"]) &&
+	    [immutable isEqual:
+	    [OFData dataWithContentsOfFile: @"testfile.bin"]])
+
+	TEST(@"-[OFMappedData subdataWithRange:]",
+	    [[immutable subdataWithRange: of_range(1000, 24)] isEqual:
+	    [[OFData dataWithContentsOfFile: @"testfile.bin"]
+	    subdataWithRange: of_range(1000, 24)]])
+
+	TEST(@"-[OFMappedData adviseAccess:inRange:]",
+	    R([(OFMappedData *)immutable
+	    adviseAccess: OF_MAPPED_DATA_ACCESS_RANDOM
+		 inRange: of_range(100, 500)]))
+
+	EXPECT_EXCEPTION(@"Detect out of range in "
+	    @"-[OFMappedData adviseAccess:inRange:]", OFOutOfRangeException,
+	    [(OFMappedData *)immutable
+	    adviseAccess: OF_MAPPED_DATA_ACCESS_RANDOM
+		 inRange: of_range(1000, 25)])
+#endif
+
 	[pool drain];
 }
 @end
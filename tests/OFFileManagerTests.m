@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#import "OFArray.h"
+#import "OFData.h"
+#import "OFDictionary.h"
+#import "OFDirectoryEnumerator.h"
+#import "OFFileManager.h"
+#import "OFNumber.h"
+#import "OFSet.h"
+#import "OFString.h"
+#import "OFURL.h"
+#import "OFAutoreleasePool.h"
+
+#import "TestsAppDelegate.h"
+
+static OFString *module = @"OFFileManager";
+
+@interface FileManagerDelegate: OFObject <OFFileManagerDelegate>
+{
+@public
+	uintmax_t _totalBytesCopied;
+	size_t _callsCount;
+}
+@end
+
+@implementation FileManagerDelegate
+- (void)fileManager: (OFFileManager *)fileManager
+       didCopyBytes: (uintmax_t)bytesCopied
+	ofItemAtURL: (OFURL *)source
+	      toURL: (OFURL *)destination
+   totalBytesCopied: (uintmax_t)totalBytesCopied
+     bytesPerSecond: (double)bytesPerSecond
+{
+	/* Calls are serialized, so no lock is needed */
+	if (totalBytesCopied > _totalBytesCopied)
+		_totalBytesCopied = totalBytesCopied;
+
+	_callsCount++;
+}
+@end
+
+@implementation TestsAppDelegate (OFFileManagerTests)
+- (void)fileManagerTests
+{
+	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
+	OFFileManager *fileManager = [OFFileManager defaultManager];
+	OFString *root = @"filemanager_tests";
+	OFString *source = [root stringByAppendingPathComponent: @"source"];
+	OFString *destination =
+	    [root stringByAppendingPathComponent: @"destination"];
+	OFString *subdirectory =
+	    [source stringByAppendingPathComponent: @"sub/subsub"];
+	OFString *fileA = [source stringByAppendingPathComponent: @"a"];
+	OFString *fileB = [subdirectory stringByAppendingPathComponent: @"b"];
+	OFString *copyA = [destination stringByAppendingPathComponent: @"a"];
+	OFString *copyB =
+	    [destination stringByAppendingPathComponent: @"sub/subsub/b"];
+	OFData *testfile = [OFData dataWithContentsOfFile: @"testfile.bin"];
+	FileManagerDelegate *delegate =
+	    [[[FileManagerDelegate alloc] init] autorelease];
+	OFSet OF_GENERIC(OFString *) *expectedPaths = [OFSet setWithObjects:
+	    @"a", @"sub", @"sub/subsub", @"sub/subsub/b", nil];
+	OFMutableSet OF_GENERIC(OFString *) *paths;
+	OFDirectoryEnumerator *enumerator;
+	OFString *path;
+	bool ok;
+
+	if ([fileManager directoryExistsAtPath: root])
+		[fileManager removeItemAtPath: root];
+
+	[fileManager createDirectoryAtPath: subdirectory
+			     createParents: true];
+	[testfile writeToFile: fileA];
+	[testfile writeToFile: fileB];
+#ifdef OF_FILE_MANAGER_SUPPORTS_PERMISSIONS
+	[fileManager setAttributes: [OFDictionary
+	    dictionaryWithObject: [OFNumber numberWithUInt16: 0600]
+			  forKey: of_file_attribute_key_posix_permissions]
+		      ofItemAtPath: fileA];
+#endif
+
+	[fileManager setDelegate: delegate];
+	TEST(@"-[copyItemAtPath:toPath:] with a directory",
+	    R([fileManager copyItemAtPath: source
+				   toPath: destination]) &&
+	    [[OFData dataWithContentsOfFile: copyA] isEqual: testfile] &&
+	    [[OFData dataWithContentsOfFile: copyB] isEqual: testfile])
+	[fileManager setDelegate: nil];
+
+#ifdef OF_FILE_MANAGER_SUPPORTS_PERMISSIONS
+	TEST(@"-[copyItemAtPath:toPath:] copies permissions",
+	    [[fileManager attributesOfItemAtPath: copyA]
+	    filePOSIXPermissions] == 0600)
+#endif
+
+	TEST(@"-[fileManager:didCopyBytes:ofItemAtURL:toURL:totalBytesCopied:"
+	    @"bytesPerSecond:]", delegate->_callsCount >= 2 &&
+	    delegate->_totalBytesCopied == 2 * [testfile count])
+
+	/*
+	 * The order of entries within a directory is unspecified, so only
+	 * check that every directory is returned before its contents.
+	 */
+	paths = [OFMutableSet set];
+	ok = true;
+	enumerator = [fileManager enumeratorAtPath: source];
+	while ((path = [enumerator nextObject]) != nil) {
+		OFArray OF_GENERIC(OFString *) *components =
+		    [path pathComponents];
+		OFString *fullPath =
+		    [source stringByAppendingPathComponent: path];
+		of_file_type_t type = [[fileManager
+		    attributesOfItemAtPath: fullPath] fileType];
+
+		if ([components count] > 1 && ![paths containsObject:
+		    [path stringByDeletingLastPathComponent]])
+			ok = false;
+
+		if ([enumerator level] != [components count])
+			ok = false;
+
+		if (![[enumerator currentEntryType] isEqual: type])
+			ok = false;
+
+		[paths addObject: path];
+	}
+	TEST(@"OFDirectoryEnumerator returns relative paths in pre-order",
+	    ok && [paths isEqual: expectedPaths])
+
+	paths = [OFMutableSet set];
+	enumerator = [fileManager enumeratorAtPath: source];
+	while ((path = [enumerator nextObject]) != nil) {
+		if ([path isEqual: @"sub"])
+			[enumerator skipDescendants];
+
+		[paths addObject: path];
+	}
+	TEST(@"-[OFDirectoryEnumerator skipDescendants]",
+	    [paths isEqual: [OFSet setWithObjects: @"a", @"sub", nil]])
+
+	[fileManager removeItemAtPath: root];
+
+	[pool drain];
+}
+@end
@@ -22,14 +22,113 @@
 #import "OFDictionary.h"
 #import "OFNumber.h"
 #import "OFNull.h"
+#import "OFJSONDocument.h"
+#import "OFJSONParser.h"
+#import "OFJSONWriter.h"
+#import "OFData.h"
+#import "OFDate.h"
+#import "OFRunLoop.h"
+#ifdef OF_HAVE_SOCKETS
+# import "OFTCPSocket.h"
+#endif
 #import "OFAutoreleasePool.h"
 
+#import "OFInvalidArgumentException.h"
 #import "OFInvalidJSONException.h"
 
 #import "TestsAppDelegate.h"
+#import "TestStream.h"
 
 static OFString *module = @"OFJSON";
 
+@interface JSONParserDelegate: OFObject <OFJSONParserDelegate>
+{
+@public
+	OFMutableString *_events;
+	bool _finished;
+	id _exception;
+}
+@end
+
+@implementation JSONParserDelegate
+- (instancetype)init
+{
+	self = [super init];
+
+	_events = [[OFMutableString alloc] init];
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_events release];
+	[_exception release];
+
+	[super dealloc];
+}
+
+- (void)parserDidStartObject: (OFJSONParser *)parser
+{
+	[_events appendString: @"{"];
+}
+
+- (void)parserDidEndObject: (OFJSONParser *)parser
+{
+	[_events appendString: @"}"];
+}
+
+- (void)parserDidStartArray: (OFJSONParser *)parser
+{
+	[_events appendString: @"["];
+}
+
+- (void)parserDidEndArray: (OFJSONParser *)parser
+{
+	[_events appendString: @"]"];
+}
+
+- (void)parser: (OFJSONParser *)parser
+      foundKey: (OFString *)key
+{
+	[_events appendFormat: @"k(%@)", key];
+}
+
+- (void)parser: (OFJSONParser *)parser
+   foundString: (OFString *)string
+{
+	[_events appendFormat: @"s(%@)", string];
+}
+
+- (void)parser: (OFJSONParser *)parser
+   foundNumber: (OFNumber *)number
+{
+	[_events appendFormat: @"n(%@)", number];
+}
+
+- (void)parserFoundNull: (OFJSONParser *)parser
+{
+	[_events appendString: @"null"];
+}
+
+- (void)parserDidEndDocument: (OFJSONParser *)parser
+{
+	[_events appendString: @";"];
+}
+
+#ifdef OF_HAVE_SOCKETS
+-           (void)parser: (OFJSONParser *)parser
+  didFinishParsingStream: (OFStream *)stream
+	       exception: (id)exception
+{
+	_finished = true;
+	_exception = [exception retain];
+
+	[[OFRunLoop mainRunLoop] stop];
+}
+#endif
+@end
+
 @implementation TestsAppDelegate (JSONTests)
 - (void)JSONTests
 {
@@ -46,6 +145,18 @@ static OFString *module = @"OFJSON";
 		[OFNumber numberWithBool: false],
 		nil],
 	    nil];
+	OFJSONDocument *document;
+	TestStream *stream;
+	OFJSONWriter *writer;
+	bool writerMatches = false;
+	JSONParserDelegate *delegate;
+	OFJSONParser *parser;
+	const char *str;
+	size_t len;
+#ifdef OF_HAVE_SOCKETS
+	OFTCPSocket *server, *client, *accepted;
+	uint16_t port;
+#endif
 
 	TEST(@"-[JSONValue] #1", [[s JSONValue] isEqual: d])
 
@@ -61,6 +172,11 @@ static OFString *module = @"OFJSON";
 	    [[d JSONRepresentationWithOptions: OF_JSON_REPRESENTATION_JSON5]
 	    isEqual: @"{x:[0.5,15,null,\"foo\",false],foo:\"b\\\na\\r\"}"])
 
+	TEST(@"OF_JSON_REPRESENTATION_SORTED",
+	    [[d JSONRepresentationWithOptions: OF_JSON_REPRESENTATION_SORTED]
+	    isEqual: @"{\"foo\":\"b\\na\\r\",\"x\":[0.5,15,null,\"foo\","
+	    @"false]}"])
+
 	EXPECT_EXCEPTION(@"-[JSONValue] #2", OFInvalidJSONException,
 	    [@"{" JSONValue])
 	EXPECT_EXCEPTION(@"-[JSONValue] #3", OFInvalidJSONException,
@@ -94,6 +210,216 @@ static OFString *module = @"OFJSON";
 	    [@"[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[{}]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]"
 	    JSONValue])
 
+	TEST(@"-[JSONValue] #8",
+	    [[@"[1e3, -2.5E-3, 0.1, 1.7976931348623157e308]" JSONValue]
+	    isEqual: [OFArray arrayWithObjects:
+	    [OFNumber numberWithDouble: 1000],
+	    [OFNumber numberWithDouble: -2.5E-3],
+	    [OFNumber numberWithDouble: 0.1],
+	    [OFNumber numberWithDouble: 1.7976931348623157e308], nil]])
+
+	TEST(@"+[OFJSONDocument documentWithData:]",
+	    (document = [OFJSONDocument documentWithData:
+	    [@"{\"a\": {\"b\": [1, \"x\", {\"c\": \"\\u00e4\\n\"}]},"
+	    @" \"d\": [true, null, -2.5e1], \"e\": \"äöü\"}"
+	    dataWithEncoding: OF_STRING_ENCODING_UTF_8]]))
+
+	TEST(@"-[OFJSONDocument valueForKeyPath:]",
+	    [[document valueForKeyPath: @"a.b.1"] isEqual: @"x"] &&
+	    [[document valueForKeyPath: @"a.b.2.c"] isEqual: @"ä\n"] &&
+	    [[document valueForKeyPath: @"d.0"] isEqual:
+	    [OFNumber numberWithBool: true]] &&
+	    [[document valueForKeyPath: @"d.1"] isEqual: [OFNull null]] &&
+	    [[document valueForKeyPath: @"d.2"] isEqual:
+	    [OFNumber numberWithDouble: -25]] &&
+	    [[document valueForKeyPath: @"e"] isEqual: @"äöü"] &&
+	    [[document valueForKeyPath: @"e"] length] == 3 &&
+	    [[document valueForKeyPath: @"e"] characterAtIndex: 1] == 0xF6 &&
+	    [document valueForKeyPath: @"a.x"] == nil &&
+	    [document valueForKeyPath: @"a.b.3"] == nil &&
+	    [document valueForKeyPath: @"e.0"] == nil)
+
+	TEST(@"-[OFJSONDocument rootValue]",
+	    [[[OFJSONDocument documentWithData: [[d JSONRepresentation]
+	    dataWithEncoding: OF_STRING_ENCODING_UTF_8]] rootValue]
+	    isEqual: d])
+
+	EXPECT_EXCEPTION(@"Detection of invalid JSON in OFJSONDocument",
+	    OFInvalidJSONException, [OFJSONDocument documentWithData:
+	    [@"{\"a\": [1, 2}" dataWithEncoding: OF_STRING_ENCODING_UTF_8]])
+
+	EXPECT_EXCEPTION(@"Rejection of JSON5 numbers in OFJSONDocument",
+	    OFInvalidJSONException, [OFJSONDocument documentWithData:
+	    [@"[0x1F]" dataWithEncoding: OF_STRING_ENCODING_UTF_8]])
+
+	EXPECT_EXCEPTION(@"Rejection of control characters in OFJSONDocument",
+	    OFInvalidJSONException, [OFJSONDocument documentWithData:
+	    [@"[\"a\tb\"]" dataWithEncoding: OF_STRING_ENCODING_UTF_8]])
+
+	EXPECT_EXCEPTION(@"Rejection of JSON5 escapes in OFJSONDocument",
+	    OFInvalidJSONException, [OFJSONDocument documentWithData:
+	    [@"[\"\\x41\"]" dataWithEncoding: OF_STRING_ENCODING_UTF_8]])
+
+	TEST(@"Duplicate keys in OFJSONDocument",
+	    (document = [OFJSONDocument documentWithData:
+	    [@"{\"a\": 1, \"a\": 2}"
+	    dataWithEncoding: OF_STRING_ENCODING_UTF_8]]) &&
+	    [[document valueForKeyPath: @"a"] isEqual:
+	    [OFNumber numberWithInt: 2]] &&
+	    [[[document rootValue] objectForKey: @"a"] isEqual:
+	    [OFNumber numberWithInt: 2]])
+
+	for (int options = 0; options < 8; options++) {
+		stream = [[[TestStream alloc] init] autorelease];
+		[[OFJSONWriter writerWithStream: stream
+					options: options] writeObject: d];
+
+		if (![[stream string] isEqual:
+		    [d JSONRepresentationWithOptions: options]])
+			break;
+
+		if (options == 7)
+			writerMatches = true;
+	}
+	TEST(@"-[OFJSONWriter writeObject:] matches -[JSONRepresentation]",
+	    writerMatches)
+
+	stream = [[[TestStream alloc] init] autorelease];
+	writer = [OFJSONWriter writerWithStream: stream
+					options: OF_JSON_REPRESENTATION_PRETTY];
+	TEST(@"-[OFJSONWriter startObject] and -[OFJSONWriter writeKey:]",
+	    R([writer startObject]) && R([writer writeKey: @"a"]) &&
+	    R([writer startArray]) && R([writer writeObject: @"x"]) &&
+	    R([writer writeObject: [OFNumber numberWithInt: 1]]) &&
+	    R([writer endArray]) && R([writer writeKey: @"b"]) &&
+	    R([writer startArray]) && R([writer endArray]) &&
+	    R([writer endObject]) && [[stream string] isEqual:
+	    @"{\n\t\"a\": [\n\t\t\"x\",\n\t\t1\n\t],\n\t\"b\": [\n\t]\n}"])
+
+	[writer startObject];
+	EXPECT_EXCEPTION(@"Detection of missing keys in OFJSONWriter",
+	    OFInvalidArgumentException, [writer writeObject: @"x"])
+
+	stream = [[[TestStream alloc] init] autorelease];
+	writer = [[OFJSONWriter alloc] initWithStream: stream
+					      options: 0];
+	[writer startArray];
+	[writer writeObject: @"x"];
+	TEST(@"-[OFJSONWriter flush]",
+	    [stream->_data count] == 0 && R([writer flush]) &&
+	    [[stream string] isEqual: @"[\"x\""])
+
+	[writer writeObject: [OFNumber numberWithInt: 1]];
+	TEST(@"-[OFJSONWriter dealloc] flushes", R([writer release]) &&
+	    [[stream string] isEqual: @"[\"x\",1"])
+
+	delegate = [[[JSONParserDelegate alloc] init] autorelease];
+	parser = [OFJSONParser parser];
+	[parser setDelegate: delegate];
+	str = [s UTF8String];
+	len = [s UTF8StringLength];
+
+	/* Feed the data in small pieces so that tokens are split */
+	for (size_t i = 0; i < len; i += 3)
+		[parser parseBuffer: str + i
+			     length: (len - i < 3 ? len - i : 3)];
+
+	TEST(@"-[OFJSONParser parseBuffer:length:]",
+	    [delegate->_events isEqual: @"{k(foo)s(b\na\r)k(x)[n(0.5)n(15)null"
+	    @"s(foo)n(false)]};"])
+
+	[delegate->_events setString: @""];
+	TEST(@"-[OFJSONParser parseString:] with multiple documents",
+	    R([parser parseString: @"{\"a\":1}\n[true]\n-2.5e1 'x'\n"
+	    @"{b: Infinity, c: 3}\n42"]) && R([parser finishParsing]) &&
+	    [delegate->_events isEqual: @"{k(a)n(1)};[n(true)];n(-25.0);s(x);"
+	    @"{k(b)n(inf)k(c)n(3)};n(42);"])
+
+	[delegate->_events setString: @""];
+	TEST(@"-[OFJSONParser parseString:] with comments after numbers",
+	    R([parser parseString: @"[1/**/, 2// x\n]\n3/* y */"]) &&
+	    R([parser finishParsing]) &&
+	    [delegate->_events isEqual: @"[n(1)n(2)];n(3);"])
+
+	parser = [OFJSONParser parser];
+	[parser parseString: @" /* x */ "];
+	EXPECT_EXCEPTION(@"Detection of empty documents",
+	    OFInvalidJSONException, [parser finishParsing])
+
+	parser = [OFJSONParser parser];
+	[parser parseString: @"[1, {}"];
+	EXPECT_EXCEPTION(@"Detection of unclosed containers",
+	    OFInvalidJSONException, [parser finishParsing])
+
+	EXPECT_EXCEPTION(@"Detection of mismatched containers",
+	    OFInvalidJSONException, [[OFJSONParser parser] parseString: @"[}"])
+
+	EXPECT_EXCEPTION(@"Detection of invalid literals",
+	    OFInvalidJSONException,
+	    [[OFJSONParser parser] parseString: @"[nul]"])
+
+	TEST(@"Unquoted keys with non-ASCII characters",
+	    [[@"{a\u00E4: 1}" JSONValue] isEqual: [OFDictionary
+	    dictionaryWithObject: [OFNumber numberWithInt: 1]
+			  forKey: @"a\u00E4"]] &&
+	    R([[OFJSONParser parser] parseString: @"{a\u00E4: 1}"]))
+
+	EXPECT_EXCEPTION(@"Rejection of unquoted keys starting with non-ASCII "
+	    @"characters in -[JSONValue]", OFInvalidJSONException,
+	    [@"{\u00E4: 1}" JSONValue])
+	EXPECT_EXCEPTION(@"Rejection of unquoted keys starting with non-ASCII "
+	    @"characters in OFJSONParser", OFInvalidJSONException,
+	    [[OFJSONParser parser] parseString: @"{\u00E4: 1}"])
+
+	EXPECT_EXCEPTION(@"Detection of exceeded depth limit",
+	    OFInvalidJSONException,
+	    [[OFJSONParser parser] parseString:
+	    @"[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[{}]]]]]]]]]]]]]]]]]]]]]]]]]]]]"
+	    @"]]]"])
+
+#ifdef OF_HAVE_SOCKETS
+	server = [OFTCPSocket socket];
+	client = [OFTCPSocket socket];
+	port = [server bindToHost: @"127.0.0.1"
+			     port: 0];
+	[server listen];
+	[client connectToHost: @"127.0.0.1"
+			 port: port];
+	accepted = [server accept];
+	[client writeString: @"[1, {\"a\": true}]\n\"b\""];
+	[client close];
+
+	delegate = [[[JSONParserDelegate alloc] init] autorelease];
+	parser = [OFJSONParser parser];
+	[parser setDelegate: delegate];
+	[parser asyncParseStream: accepted];
+
+	[[OFRunLoop mainRunLoop] runUntilDate:
+	    [OFDate dateWithTimeIntervalSinceNow: 2]];
+
+	TEST(@"-[OFJSONParser asyncParseStream:]",
+	    delegate->_finished && delegate->_exception == nil &&
+	    [delegate->_events isEqual: @"[n(1){k(a)n(true)}];s(b);"] &&
+	    [accepted delegate] == nil)
+
+	client = [OFTCPSocket socket];
+	[client connectToHost: @"127.0.0.1"
+			 port: port];
+	accepted = [server accept];
+	[client writeString: @"[1, }"];
+	[client close];
+
+	parser = [OFJSONParser parser];
+	[parser asyncParseStream: accepted];
+
+	EXPECT_EXCEPTION(@"-[OFJSONParser asyncParseStream:] throws without a "
+	    @"delegate", OFInvalidJSONException,
+	    [[OFRunLoop mainRunLoop] runUntilDate:
+	    [OFDate dateWithTimeIntervalSinceNow: 2]])
+
+	[accepted cancelAsyncRequests];
+#endif
+
 	[pool drain];
 }
 @end
@@ -17,18 +17,32 @@
 
 #include "config.h"
 
+#include <limits.h>
+
+#include "unistd_wrapper.h"
+
 #import "OFKernelEventObserver.h"
 #import "OFString.h"
+#import "OFData.h"
 #import "OFDate.h"
+#import "OFFile.h"
+#import "OFFileManager.h"
+#import "OFRunLoop.h"
 #import "OFTCPSocket.h"
+#import "OFTimer.h"
 #import "OFAutoreleasePool.h"
 
+#import "OFObserveFailedException.h"
+
 #ifdef HAVE_KQUEUE
 # import "OFKernelEventObserver_kqueue.h"
 #endif
 #ifdef HAVE_EPOLL
 # import "OFKernelEventObserver_epoll.h"
 #endif
+#ifdef HAVE_IO_URING
+# import "OFKernelEventObserver_io_uring.h"
+#endif
 #ifdef HAVE_POLL
 # import "OFKernelEventObserver_poll.h"
 #endif
@@ -39,6 +53,7 @@
 #import "TestsAppDelegate.h"
 
 #define EXPECTED_EVENTS 3
+#define STARVATION_TEST_SIZE 4096
 
 static OFString *module;
 
@@ -152,6 +167,7 @@ static OFString *module;
 		}
 
 		_accepted = [[object accept] retain];
+		[_accepted setBlocking: [object isBlocking]];
 		[_observer addObjectForReading: _accepted];
 
 		[_testsAppDelegate
@@ -201,19 +217,272 @@ static OFString *module;
 }
 @end
 
+#ifdef HAVE_EPOLL
+@interface InvalidFileDescriptor: OFObject <OFReadyForReadingObserving>
+@end
+
+@implementation InvalidFileDescriptor
+- (int)fileDescriptorForReading
+{
+	return INT_MAX;
+}
+@end
+
+@interface ReadyForReadingRecorder: OFObject <OFKernelEventObserverDelegate>
+{
+@public
+	id _object;
+}
+@end
+
+@implementation ReadyForReadingRecorder
+- (void)objectIsReadyForReading: (id)object
+{
+	_object = object;
+}
+@end
+#endif
+
+#if defined(HAVE_EPOLL) || defined(HAVE_IO_URING)
+@interface EdgeTriggeredReadTest: OFObject <OFStreamDelegate>
+{
+@public
+	OFTCPSocket *_client;
+	OFMutableData *_data;
+	bool _done, _unexpected;
+	char _buffer[2];
+}
+@end
+
+@implementation EdgeTriggeredReadTest
+- (instancetype)init
+{
+	self = [super init];
+
+	@try {
+		_data = [[OFMutableData alloc] init];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_client release];
+	[_data release];
+
+	[super dealloc];
+}
+
+-      (bool)stream: (OFStream *)stream
+  didReadIntoBuffer: (void *)buffer
+	     length: (size_t)length
+	  exception: (id)exception
+{
+	/*
+	 * Running out of data must only end the drain loop and never be
+	 * reported, neither as an exception nor as an empty read.
+	 */
+	if (exception != nil || (length == 0 && ![stream isAtEndOfStream])) {
+		_unexpected = true;
+		[[OFRunLoop mainRunLoop] stop];
+		return false;
+	}
+
+	if ([stream isAtEndOfStream]) {
+		_done = true;
+		[[OFRunLoop mainRunLoop] stop];
+		return false;
+	}
+
+	[_data addItems: buffer
+		  count: length];
+
+	/*
+	 * Close the connection only a little later, so that the drain loop
+	 * first runs out of data.
+	 */
+	if ([_data count] == 10)
+		[OFTimer scheduledTimerWithTimeInterval: 0.1
+						 target: _client
+					       selector: @selector(close)
+						repeats: false];
+
+	return true;
+}
+@end
+
+@interface StarvationTest: OFObject <OFStreamDelegate>
+{
+@public
+	size_t _count, _countWhenTimerFired;
+	bool _timerFired, _done;
+	char _buffer;
+}
+
+- (void)timerFired;
+@end
+
+@implementation StarvationTest
+-      (bool)stream: (OFStream *)stream
+  didReadIntoBuffer: (void *)buffer
+	     length: (size_t)length
+	  exception: (id)exception
+{
+	if (exception != nil || length == 0) {
+		[[OFRunLoop mainRunLoop] stop];
+		return false;
+	}
+
+	/* Due immediately, but only fires if the reads yield. */
+	if (_count++ == 0)
+		[OFTimer scheduledTimerWithTimeInterval: 0
+						 target: self
+					       selector: @selector(timerFired)
+						repeats: false];
+
+	if (_count == STARVATION_TEST_SIZE) {
+		_done = true;
+		[[OFRunLoop mainRunLoop] stop];
+		return false;
+	}
+
+	return true;
+}
+
+- (void)timerFired
+{
+	_timerFired = true;
+	_countWhenTimerFired = _count;
+}
+@end
+#endif
+
+#if defined(HAVE_IO_URING) && defined(OF_HAVE_FILES)
+@interface FileReadTest: OFObject <OFStreamDelegate>
+{
+@public
+	OFMutableData *_data;
+	id _exception;
+	bool _done;
+	char _buffer[7];
+}
+@end
+
+@implementation FileReadTest
+- (instancetype)init
+{
+	self = [super init];
+
+	@try {
+		_data = [[OFMutableData alloc] init];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_data release];
+	[_exception release];
+
+	[super dealloc];
+}
+
+-      (bool)stream: (OFStream *)stream
+  didReadIntoBuffer: (void *)buffer
+	     length: (size_t)length
+	  exception: (id)exception
+{
+	if (exception != nil) {
+		_exception = [exception retain];
+		[[OFRunLoop mainRunLoop] stop];
+		return false;
+	}
+
+	[_data addItems: buffer
+		  count: length];
+
+	if ([stream isAtEndOfStream]) {
+		_done = true;
+		[[OFRunLoop mainRunLoop] stop];
+		return false;
+	}
+
+	return true;
+}
+@end
+
+@interface FileWriteTest: OFObject <OFStreamDelegate>
+{
+@public
+	size_t _writes, _bytesWritten;
+	id _exception;
+}
+@end
+
+@implementation FileWriteTest
+- (void)dealloc
+{
+	[_exception release];
+
+	[super dealloc];
+}
+
+- (OFData *)stream: (OFStream *)stream
+      didWriteData: (OFData *)data
+      bytesWritten: (size_t)bytesWritten
+	 exception: (id)exception
+{
+	_bytesWritten += bytesWritten;
+
+	if (exception != nil) {
+		_exception = [exception retain];
+		[[OFRunLoop mainRunLoop] stop];
+		return nil;
+	}
+
+	/* Write the data twice to check that the second write appends. */
+	if (++_writes == 2) {
+		[[OFRunLoop mainRunLoop] stop];
+		return nil;
+	}
+
+	return data;
+}
+@end
+#endif
+
 @implementation TestsAppDelegate (OFKernelEventObserverTests)
 - (void)kernelEventObserverTestsWithClass: (Class)class
+			    edgeTriggered: (bool)edgeTriggered
 {
 	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
 	ObserverTest *test;
 
 	module = [class className];
+	if (edgeTriggered)
+		module = [module stringByAppendingString: @" (edge-triggered)"];
+
 	test = [[[ObserverTest alloc]
 	    initWithTestsAppDelegate: self] autorelease];
 
 	TEST(@"+[observer]", (test->_observer = [class observer]))
 	[test->_observer setDelegate: test];
 
+	if (edgeTriggered) {
+		[test->_server setBlocking: false];
+
+		TEST(@"-[setEdgeTriggered:]",
+		    R([test->_observer setEdgeTriggered: true]))
+	}
+
 	TEST(@"-[addObjectForReading:]",
 	    R([test->_observer addObjectForReading: test->_server]))
 
@@ -223,6 +492,214 @@ static OFString *module;
 	[pool drain];
 }
 
+- (void)kernelEventObserverTestsWithClass: (Class)class
+{
+	[self kernelEventObserverTestsWithClass: class
+				  edgeTriggered: false];
+}
+
+#ifdef HAVE_EPOLL
+- (void)kernelEventObserverEpollBatchTests
+{
+	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
+	OFKernelEventObserver *observer =
+	    [OFKernelEventObserver_epoll observer];
+	ReadyForReadingRecorder *recorder =
+	    [[[ReadyForReadingRecorder alloc] init] autorelease];
+	InvalidFileDescriptor *invalid =
+	    [[[InvalidFileDescriptor alloc] init] autorelease];
+	OFTCPSocket *server = [OFTCPSocket socket];
+	OFTCPSocket *client = [OFTCPSocket socket];
+	OFTCPSocket *accepted;
+	uint16_t port;
+
+	module = @"OFKernelEventObserver_epoll";
+
+	port = [server bindToHost: @"127.0.0.1"
+			     port: 0];
+	[server listen];
+	[client connectToHost: @"127.0.0.1"
+			 port: port];
+	accepted = [server accept];
+	[client writeBuffer: "0"
+		     length: 1];
+
+	[observer setDelegate: recorder];
+
+	/* The invalid file descriptor is applied first and fails. */
+	[observer addObjectForReading: invalid];
+	[observer addObjectForReading: accepted];
+
+	EXPECT_EXCEPTION(@"Detection of invalid file descriptors",
+	    OFObserveFailedException, [observer observeForTimeInterval: 0])
+
+	[observer removeObjectForReading: invalid];
+
+	TEST(@"Applying the rest of a batch after a failed change",
+	    R([observer observeForTimeInterval: 1]) &&
+	    recorder->_object == accepted)
+
+	[pool drain];
+}
+#endif
+
+#if defined(HAVE_EPOLL) || defined(HAVE_IO_URING)
+- (void)kernelEventObserverEdgeTriggeredRunLoopTests
+{
+	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
+	OFRunLoop *runLoop = [OFRunLoop mainRunLoop];
+	EdgeTriggeredReadTest *test =
+	    [[[EdgeTriggeredReadTest alloc] init] autorelease];
+	StarvationTest *starvationTest;
+	OFTCPSocket *server = [OFTCPSocket socket];
+	OFTCPSocket *client, *accepted;
+	OFMutableData *data;
+	uint16_t port;
+
+	module = @"OFRunLoop";
+
+	port = [server bindToHost: @"127.0.0.1"
+			     port: 0];
+	[server listen];
+
+	test->_client = [[OFTCPSocket alloc] init];
+	[test->_client connectToHost: @"127.0.0.1"
+				port: port];
+	accepted = [server accept];
+	[accepted setBlocking: false];
+
+	TEST(@"-[setEdgeTriggered:]", R([runLoop setEdgeTriggered: true]))
+
+	/* More than a single read, so that the run loop needs to drain it. */
+	[test->_client writeBuffer: "0123456789"
+			    length: 10];
+
+	[accepted setDelegate: test];
+	[accepted asyncReadIntoBuffer: test->_buffer
+			       length: sizeof(test->_buffer)];
+
+	[runLoop runUntilDate: [OFDate dateWithTimeIntervalSinceNow: 2]];
+
+	TEST(@"Draining non-blocking streams until they would block",
+	    test->_done && !test->_unexpected && [test->_data isEqual:
+	    [OFData dataWithItems: "0123456789"
+			    count: 10]])
+
+	/*
+	 * Many small reads of data that is available all at once must not
+	 * starve timers.
+	 */
+	starvationTest = [[[StarvationTest alloc] init] autorelease];
+	data = [OFMutableData dataWithCapacity: STARVATION_TEST_SIZE];
+	[data increaseCountBy: STARVATION_TEST_SIZE];
+
+	client = [OFTCPSocket socket];
+	[client connectToHost: @"127.0.0.1"
+			 port: port];
+	accepted = [server accept];
+	[accepted setBlocking: false];
+	[client writeData: data];
+
+	[accepted setDelegate: starvationTest];
+	[accepted asyncReadIntoBuffer: &starvationTest->_buffer
+			       length: 1];
+
+	[runLoop runUntilDate: [OFDate dateWithTimeIntervalSinceNow: 2]];
+	[runLoop setEdgeTriggered: false];
+
+	TEST(@"Limiting the requests handled at once",
+	    starvationTest->_done && starvationTest->_timerFired &&
+	    starvationTest->_countWhenTimerFired < STARVATION_TEST_SIZE)
+
+	[pool drain];
+}
+#endif
+
+#if defined(HAVE_IO_URING) && defined(OF_HAVE_FILES)
+- (void)kernelEventObserverFileTests
+{
+	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
+	OFData *expected = [OFData dataWithContentsOfFile: @"testfile.bin"];
+	FileReadTest *test = [[[FileReadTest alloc] init] autorelease];
+	OFFile *file = [OFFile fileWithPath: @"testfile.bin"
+				       mode: @"r"];
+	FileWriteTest *writeTest;
+	OFMutableData *written;
+	char buffer[3];
+	int fds[2];
+
+	module = @"OFKernelEventObserver_io_uring";
+
+	/*
+	 * A small read buffer needs several reads from io_uring. Reading
+	 * synchronously first leaves data in the read buffer and moves the
+	 * file offset, both of which the asynchronous reads need to continue
+	 * from.
+	 */
+	[file setReadBufferSize: 100];
+	[file readIntoBuffer: buffer
+		 exactLength: sizeof(buffer)];
+	[test->_data addItems: buffer
+			count: sizeof(buffer)];
+
+	[file setDelegate: test];
+	[file asyncReadIntoBuffer: test->_buffer
+			   length: sizeof(test->_buffer)];
+
+	[[OFRunLoop mainRunLoop] runUntilDate:
+	    [OFDate dateWithTimeIntervalSinceNow: 2]];
+
+	TEST(@"-[asyncReadIntoBuffer:length:] with a file",
+	    test->_done && test->_exception == nil &&
+	    [test->_data isEqual: expected])
+
+	/* Files that are not regular files fall back to polling. */
+	OF_ENSURE(pipe(fds) == 0);
+	OF_ENSURE(write(fds[1], [expected items], [expected count]) ==
+	    (ssize_t)[expected count]);
+	close(fds[1]);
+
+	test = [[[FileReadTest alloc] init] autorelease];
+	file = [OFFile fileWithHandle: fds[0]];
+	[file setDelegate: test];
+	[file asyncReadIntoBuffer: test->_buffer
+			   length: sizeof(test->_buffer)];
+
+	[[OFRunLoop mainRunLoop] runUntilDate:
+	    [OFDate dateWithTimeIntervalSinceNow: 2]];
+
+	TEST(@"-[asyncReadIntoBuffer:length:] with a pipe",
+	    test->_done && test->_exception == nil &&
+	    [test->_data isEqual: expected])
+
+	writeTest = [[[FileWriteTest alloc] init] autorelease];
+	file = [OFFile fileWithPath: @"io_uring_write_test"
+			       mode: @"w"];
+	[file setDelegate: writeTest];
+	[file asyncWriteData: expected];
+
+	[[OFRunLoop mainRunLoop] runUntilDate:
+	    [OFDate dateWithTimeIntervalSinceNow: 2]];
+	[file close];
+
+	written = [OFMutableData dataWithItems: [expected items]
+					 count: [expected count]];
+	[written addItems: [expected items]
+		    count: [expected count]];
+
+	TEST(@"-[asyncWriteData:] with a file",
+	    writeTest->_writes == 2 && writeTest->_exception == nil &&
+	    writeTest->_bytesWritten == 2 * [expected count] &&
+	    [[OFData dataWithContentsOfFile: @"io_uring_write_test"]
+	    isEqual: written])
+
+	[[OFFileManager defaultManager]
+	    removeItemAtPath: @"io_uring_write_test"];
+
+	[pool drain];
+}
+#endif
+
 - (void)kernelEventObserverTests
 {
 #ifdef HAVE_SELECT
@@ -238,11 +715,32 @@ static OFString *module;
 #ifdef HAVE_EPOLL
 	[self kernelEventObserverTestsWithClass:
 	    [OFKernelEventObserver_epoll class]];
+	[self kernelEventObserverTestsWithClass:
+	    [OFKernelEventObserver_epoll class]
+				  edgeTriggered: true];
+	[self kernelEventObserverEpollBatchTests];
+#endif
+
+#ifdef HAVE_IO_URING
+	if ([OFKernelEventObserver_io_uring of_isAvailable]) {
+		[self kernelEventObserverTestsWithClass:
+		    [OFKernelEventObserver_io_uring class]];
+		[self kernelEventObserverTestsWithClass:
+		    [OFKernelEventObserver_io_uring class]
+					  edgeTriggered: true];
+# ifdef OF_HAVE_FILES
+		[self kernelEventObserverFileTests];
+# endif
+	}
 #endif
 
 #ifdef HAVE_KQUEUE
 	[self kernelEventObserverTestsWithClass:
 	    [OFKernelEventObserver_kqueue class]];
 #endif
+
+#if defined(HAVE_EPOLL) || defined(HAVE_IO_URING)
+	[self kernelEventObserverEdgeTriggeredRunLoopTests];
+#endif
 }
 @end
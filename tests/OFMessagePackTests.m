@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "OFArray.h"
+#import "OFData.h"
+#import "OFDate.h"
+#import "OFDictionary.h"
+#import "OFMessagePackExtension.h"
+#import "OFMessagePackReader.h"
+#import "OFMessagePackWriter.h"
+#import "OFNull.h"
+#import "OFNumber.h"
+#import "OFRunLoop.h"
+#import "OFStream.h"
+#import "OFString.h"
+#ifdef OF_HAVE_SOCKETS
+# import "OFTCPSocket.h"
+#endif
+#import "OFAutoreleasePool.h"
+
+#import "OFTruncatedDataException.h"
+
+#import "TestsAppDelegate.h"
+#import "TestStream.h"
+
+static OFString *module = @"OFMessagePack";
+
+#ifdef OF_HAVE_SOCKETS
+@interface MessagePackReaderDelegate: OFObject <OFMessagePackReaderDelegate>
+{
+@public
+	OFMutableArray *_objects;
+	bool _finished;
+	id _exception;
+}
+@end
+#endif
+
+#ifdef OF_HAVE_SOCKETS
+@implementation MessagePackReaderDelegate
+- (instancetype)init
+{
+	self = [super init];
+
+	@try {
+		_objects = [[OFMutableArray alloc] init];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_objects release];
+	[_exception release];
+
+	[super dealloc];
+}
+
+- (bool)reader: (OFMessagePackReader *)reader
+  didReadObject: (id)object
+      exception: (id)exception
+{
+	if (object != nil)
+		[_objects addObject: object];
+
+	if (object == nil || exception != nil) {
+		_finished = true;
+		_exception = [exception retain];
+
+		[[OFRunLoop mainRunLoop] stop];
+	}
+
+	return true;
+}
+@end
+#endif
+
+@implementation TestsAppDelegate (OFMessagePackTests)
+- (void)messagePackTests
+{
+	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
+	OFMutableString *longString = [OFMutableString string];
+	OFMutableData *largeData = [OFMutableData data];
+	OFArray *objects;
+	TestStream *stream;
+	OFMessagePackWriter *writer;
+	OFMessagePackReader *reader;
+	OFData *data;
+	id object;
+	bool matches;
+#ifdef OF_HAVE_SOCKETS
+	OFTCPSocket *server, *client, *accepted;
+	uint16_t port;
+	MessagePackReaderDelegate *delegate;
+#endif
+
+	for (size_t i = 0; i < 300; i++)
+		[longString appendString: @"x"];
+	[longString makeImmutable];
+
+	for (size_t i = 0; i < 3000; i++)
+		[largeData addItem: "a"];
+	[largeData makeImmutable];
+
+	objects = [OFArray arrayWithObjects:
+	    [OFNull null],
+	    [OFNumber numberWithBool: true],
+	    [OFNumber numberWithBool: false],
+	    [OFNumber numberWithInt: 5],
+	    [OFNumber numberWithInt: -5],
+	    [OFNumber numberWithInt: 200],
+	    [OFNumber numberWithInt: -200],
+	    [OFNumber numberWithInt: 70000],
+	    [OFNumber numberWithLongLong: 5000000000LL],
+	    [OFNumber numberWithLongLong: -5000000000LL],
+	    [OFNumber numberWithFloat: 0.5f],
+	    [OFNumber numberWithDouble: 0.1],
+	    @"foo",
+	    longString,
+	    [OFData dataWithItems: "\x01\x02"
+			    count: 2],
+	    largeData,
+	    [OFMessagePackExtension
+	    extensionWithType: 1
+			 data: [OFData dataWithItems: "abcd"
+					       count: 4]],
+	    [OFArray arrayWithObjects: @"a", [OFArray array], nil],
+	    [OFDictionary dictionaryWithKeysAndObjects:
+	    @"a", [OFNumber numberWithInt: 1],
+	    @"b", [OFDictionary dictionary], nil],
+	    nil];
+
+	stream = [[[TestStream alloc] init] autorelease];
+	writer = [OFMessagePackWriter writerWithStream: stream];
+	matches = true;
+	for (id <OFMessagePackRepresentation> object_ in objects) {
+		size_t count = [stream->_data count];
+		OFData *representation = [object_ messagePackRepresentation];
+
+		[writer writeObject: object_];
+
+		if ([stream->_data count] - count != [representation count] ||
+		    memcmp((char *)[stream->_data items] + count,
+		    [representation items], [representation count]) != 0)
+			matches = false;
+	}
+	TEST(@"-[OFMessagePackWriter writeObject:]", matches)
+
+	/* Read one byte at a time so that all headers are split */
+	stream->_chunkSize = 1;
+	reader = [OFMessagePackReader readerWithStream: stream];
+	matches = true;
+	for (id object_ in objects)
+		if (![[reader readObject] isEqual: object_])
+			matches = false;
+	TEST(@"-[OFMessagePackReader readObject] with split headers",
+	    matches && [reader readObject] == nil)
+
+	stream = [[[TestStream alloc] init] autorelease];
+	writer = [OFMessagePackWriter writerWithStream: stream];
+	[writer startArrayWithCount: 2];
+	[writer writeObject: [OFNumber numberWithInt: 1]];
+	TEST(@"-[OFMessagePackWriter flush]",
+	    [stream->_data count] == 0 && R([writer flush]) &&
+	    [stream->_data count] == 2 &&
+	    memcmp([stream->_data items], "\x92\x01", 2) == 0)
+
+	writer = [[OFMessagePackWriter alloc] initWithStream: stream];
+	[writer startArrayWithCount: 2];
+	[writer writeObject: [OFNumber numberWithInt: 2]];
+	TEST(@"-[OFMessagePackWriter dealloc] flushes",
+	    R([writer release]) && [stream->_data count] == 4 &&
+	    memcmp([stream->_data items], "\x92\x01\x92\x02", 4) == 0)
+
+	/*
+	 * The bin payload is returned as subdata of the read buffer. Reading
+	 * on needs to refill the buffer, which must not overwrite it.
+	 */
+	stream = [[[TestStream alloc] init] autorelease];
+	writer = [OFMessagePackWriter writerWithStream: stream];
+	[writer writeObject: largeData];
+	for (size_t i = 0; i < 8; i++)
+		[writer writeObject: longString];
+	stream->_chunkSize = 1000;
+	reader = [OFMessagePackReader readerWithStream: stream];
+	TEST(@"-[OFMessagePackReader readObject] returns bin as subdata",
+	    (data = [reader readObject]) && [data isEqual: largeData] &&
+	    [[reader readObject] isEqual: longString])
+
+	matches = true;
+	while ((object = [reader readObject]) != nil)
+		if (![object isEqual: longString])
+			matches = false;
+	TEST(@"Subdata is not overwritten by further reads",
+	    matches && [data isEqual: largeData])
+
+	stream = [[[TestStream alloc] init] autorelease];
+	[stream writeBuffer: "\x92\x01"
+		     length: 2];
+	EXPECT_EXCEPTION(@"Detection of truncated objects",
+	    OFTruncatedDataException,
+	    [[OFMessagePackReader readerWithStream: stream] readObject])
+
+#ifdef OF_HAVE_SOCKETS
+	server = [OFTCPSocket socket];
+	client = [OFTCPSocket socket];
+	port = [server bindToHost: @"127.0.0.1"
+			     port: 0];
+	[server listen];
+	[client connectToHost: @"127.0.0.1"
+			 port: port];
+	accepted = [server accept];
+
+	writer = [OFMessagePackWriter writerWithStream: client];
+	for (id <OFMessagePackRepresentation> object_ in objects)
+		[writer writeObject: object_];
+	[client close];
+
+	delegate = [[[MessagePackReaderDelegate alloc] init] autorelease];
+	reader = [OFMessagePackReader readerWithStream: accepted];
+	[reader setDelegate: delegate];
+	[reader asyncReadObject];
+
+	[[OFRunLoop mainRunLoop] runUntilDate:
+	    [OFDate dateWithTimeIntervalSinceNow: 2]];
+
+	TEST(@"-[OFMessagePackReader asyncReadObject]",
+	    delegate->_finished && delegate->_exception == nil &&
+	    [delegate->_objects isEqual: objects] &&
+	    [accepted delegate] == nil)
+#endif
+
+	[pool drain];
+}
+@end
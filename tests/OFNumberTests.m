@@ -24,12 +24,18 @@
 #import "TestsAppDelegate.h"
 
 static OFString *module = @"OFNumber";
+static const double doubles[] = {
+	0.3, 1.0 / 3, 2.0 / 3, 123.456, 1e23, 9007199254740993.0,
+	1.7976931348623157e308, 2.2250738585072014e-308,
+	2.2250738585072009e-308, 4.9406564584124654e-324, -8.41e21
+};
 
 @implementation TestsAppDelegate (OFNumberTests)
 - (void)numberTests
 {
 	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
 	OFNumber *num;
+	bool ok;
 
 	TEST(@"+[numberWithIntMax:]",
 	    (num = [OFNumber numberWithIntMax: 123456789]))
@@ -43,6 +49,29 @@ static OFString *module = @"OFNumber";
 
 	TEST(@"-[doubleValue]", [num doubleValue] == 123456789.L)
 
+	TEST(@"-[description]",
+	    [[num description] isEqual: @"123456789"] &&
+	    [[[OFNumber numberWithDouble: 0.1] description] isEqual: @"0.1"] &&
+	    [[[OFNumber numberWithDouble: -100] description]
+	    isEqual: @"-100.0"] &&
+	    [[[OFNumber numberWithDouble: 1e21] description]
+	    isEqual: @"1e+21"] &&
+	    [[[OFNumber numberWithDouble: 0.00001] description]
+	    isEqual: @"1e-05"] &&
+	    [[[OFNumber numberWithDouble: 5e-324] description]
+	    isEqual: @"5e-324"] &&
+	    [[[OFNumber numberWithFloat: 0.1f] description] isEqual: @"0.1"])
+
+	ok = true;
+	for (size_t i = 0; i < sizeof(doubles) / sizeof(*doubles); i++) {
+		OFString *description =
+		    [[OFNumber numberWithDouble: doubles[i]] description];
+
+		if ([description doubleValue] != doubles[i])
+			ok = false;
+	}
+	TEST(@"-[description] round trip", ok)
+
 	[pool drain];
 }
 @end
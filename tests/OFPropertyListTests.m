@@ -19,10 +19,12 @@
 
 #import "OFString.h"
 #import "OFArray.h"
+#import "OFBinaryPropertyList.h"
 #import "OFData.h"
 #import "OFDate.h"
 #import "OFDictionary.h"
 #import "OFNumber.h"
+#import "OFNull.h"
 #import "OFAutoreleasePool.h"
 
 #import "OFInvalidFormatException.h"
@@ -65,6 +67,15 @@ static OFString *PLIST3 = PLIST(
     @" <key>foo</key>"
     @" <string>bar</string>"
     @"</dict>");
+static const unsigned char BPLIST1[] = {
+	'b', 'p', 'l', 'i', 's', 't', '0', '0',
+	0x55, 'H', 'e', 'l', 'l', 'o',
+	0x08,
+	0, 0, 0, 0, 0, 0, 1, 1,
+	0, 0, 0, 0, 0, 0, 0, 1,
+	0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 14
+};
 
 @implementation TestsAppDelegate (OFPLISTParser)
 - (void)propertyListTests
@@ -80,6 +91,13 @@ static OFString *PLIST3 = PLIST(
 	    [OFNumber numberWithFloat: 12.25],
 	    [OFNumber numberWithInt: -10],
 	    nil];
+	OFDictionary *dictionary = [OFDictionary dictionaryWithKeysAndObjects:
+	    @"array", array,
+	    @"foo", @"bar",
+	    @"utf16", @"Blåbærsyltetøy",
+	    nil];
+	OFData *data;
+	OFBinaryPropertyList *propertyList;
 
 	TEST(@"-[propertyListValue:] #1",
 	    [[PLIST1 propertyListValue] isEqual: @"Hello"])
@@ -125,6 +143,57 @@ static OFString *PLIST3 = PLIST(
 	    OFInvalidFormatException,
 	    [PLIST(@"<dict><key x='x'/><string/></dict>") propertyListValue])
 
+	TEST(@"-[OFData propertyListValue] #1",
+	    [[[OFData dataWithItems: BPLIST1
+			      count: sizeof(BPLIST1)] propertyListValue]
+	    isEqual: @"Hello"])
+
+	TEST(@"-[OFData propertyListValue] #2",
+	    [[[OFData dataWithItems: [PLIST1 UTF8String]
+			      count: [PLIST1 UTF8StringLength]]
+	    propertyListValue] isEqual: @"Hello"])
+
+	module = @"OFBinaryPropertyList";
+
+	TEST(@"+[dataWithRootValue:]",
+	    (data = [OFBinaryPropertyList dataWithRootValue: dictionary]) &&
+	    [[data propertyListValue] isEqual: dictionary])
+
+	TEST(@"+[propertyListWithData:]",
+	    (propertyList = [OFBinaryPropertyList propertyListWithData: data]))
+
+	TEST(@"-[valueForKeyPath:]",
+	    [[propertyList valueForKeyPath: @"array.1"] isEqual:
+	    [OFData dataWithItems: "World!"
+			    count: 6]] &&
+	    [[propertyList valueForKeyPath: @"utf16"]
+	    isEqual: @"Blåbærsyltetøy"] &&
+	    [propertyList valueForKeyPath: @"array.7"] == nil &&
+	    [propertyList valueForKeyPath: @"foo.bar"] == nil)
+
+	TEST(@"-[rootValue]", [[propertyList rootValue] isEqual: dictionary])
+
+	TEST(@"+[dataWithRootValue:] with OFNull",
+	    [[[OFBinaryPropertyList propertyListWithData:
+	    [OFBinaryPropertyList dataWithRootValue:
+	    [OFArray arrayWithObjects: @"a", [OFNull null], nil]]] rootValue]
+	    isEqual: [OFArray arrayWithObjects: @"a", [OFNull null], nil]])
+
+	EXPECT_EXCEPTION(@"Detecting truncated data", OFInvalidFormatException,
+	    [OFBinaryPropertyList propertyListWithData:
+	    [OFData dataWithItems: BPLIST1
+			    count: sizeof(BPLIST1) - 1]])
+
+	EXPECT_EXCEPTION(@"Detecting invalid references",
+	    OFInvalidFormatException,
+	    [[OFBinaryPropertyList propertyListWithData:
+	    [OFData dataWithItems: "bplist00\xA1\x01\x08"
+				   "\0\0\0\0\0\0\1\1"
+				   "\0\0\0\0\0\0\0\1"
+				   "\0\0\0\0\0\0\0\0"
+				   "\0\0\0\0\0\0\0\x0A"
+			    count: 43]] rootValue])
+
 	[pool drain];
 }
 @end
@@ -17,6 +17,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #import "OFSerialization.h"
 #import "OFString.h"
 #import "OFArray.h"
@@ -29,9 +31,11 @@
 #import "OFURL.h"
 #import "OFData.h"
 #import "OFAutoreleasePool.h"
+#import "OFStream.h"
 #import "OFXMLElement.h"
 
 #import "TestsAppDelegate.h"
+#import "TestStream.h"
 
 static OFString *module = @"OFSerialization";
 
@@ -42,8 +46,9 @@ static OFString *module = @"OFSerialization";
 	OFMutableDictionary *d = [OFMutableDictionary dictionary];
 	OFMutableArray *a = [OFMutableArray array];
 	OFList *l = [OFList list];
-	OFData *data;
+	OFData *data, *serialized;
 	OFString *s;
+	TestStream *stream;
 
 	[a addObject: @"Qu\"xbar\ntest"];
 	[a addObject: [OFNumber numberWithInt: 1234]];
@@ -80,6 +85,23 @@ static OFString *module = @"OFSerialization";
 	TEST(@"-[objectByDeserializing]",
 	    [[s objectByDeserializing] isEqual: d])
 
+	TEST(@"-[dataBySerializing]", (serialized = [d dataBySerializing]) &&
+	    [serialized count] < [s UTF8StringLength])
+
+	TEST(@"-[OFData objectByDeserializing]",
+	    [[serialized objectByDeserializing] isEqual: d])
+
+	stream = [[[TestStream alloc] init] autorelease];
+
+	TEST(@"-[writeBinarySerializationToStream:]",
+	    R([d writeBinarySerializationToStream: stream]) &&
+	    R([a writeBinarySerializationToStream: stream]))
+
+	TEST(@"-[OFStream readSerializedObject]",
+	    [[stream readSerializedObject] isEqual: d] &&
+	    [[stream readSerializedObject] isEqual: a] &&
+	    [stream isAtEndOfStream])
+
 	[pool drain];
 }
 @end
@@ -19,12 +19,22 @@
 
 #include <string.h>
 
+#import "OFArray.h"
+#import "OFData.h"
+#import "OFMemoryStream.h"
 #import "OFStream.h"
 #import "OFString.h"
 #import "OFSystemInfo.h"
+#ifdef OF_HAVE_SOCKETS
+# import "OFTCPSocket.h"
+#endif
 #import "OFAutoreleasePool.h"
 
+#import "OFInvalidFormatException.h"
+#import "OFSeekFailedException.h"
+
 #import "TestsAppDelegate.h"
+#import "TestStream.h"
 
 static OFString *module = @"OFStream";
 
@@ -69,14 +79,89 @@ static OFString *module = @"OFStream";
 }
 @end
 
+/* A stream that never ends */
+@interface EndlessStreamTester: OFStream
+@end
+
+@implementation EndlessStreamTester
+- (bool)lowlevelIsAtEndOfStream
+{
+	return false;
+}
+
+- (size_t)lowlevelReadIntoBuffer: (void *)buffer
+			  length: (size_t)size
+{
+	memset(buffer, 'x', size);
+
+	return size;
+}
+@end
+
+/* A non-blocking stream that has no more data until more is provided */
+@interface NonBlockingStreamTester: OFStream
+{
+@public
+	const char *_string;
+	bool _closed;
+}
+
+- (instancetype)initWithString: (const char *)string;
+@end
+
+@implementation NonBlockingStreamTester
+- (instancetype)initWithString: (const char *)string
+{
+	self = [super init];
+
+	_string = string;
+	_blocking = false;
+
+	return self;
+}
+
+- (bool)lowlevelIsAtEndOfStream
+{
+	return (_closed && *_string == '\0');
+}
+
+- (size_t)lowlevelReadIntoBuffer: (void *)buffer
+			  length: (size_t)size
+{
+	size_t length = strlen(_string);
+
+	if (length > size)
+		length = size;
+
+	memcpy(buffer, _string, length);
+	_string += length;
+
+	return length;
+}
+@end
+
 @implementation TestsAppDelegate (OFStreamTests)
 - (void)streamTests
 {
 	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
 	size_t pageSize = [OFSystemInfo pageSize];
 	StreamTester *t = [[[StreamTester alloc] init] autorelease];
+	TestStream *ct, *wt;
+	OFMemoryStream *ms;
+	OFMutableData *mutableData;
+	of_stream_buffer_t buffers[3];
+	OFData *large;
+	OFMutableData *mutableLarge;
+	char *largeItems;
+	char buffer[2];
 	OFString *str;
 	char *cstr;
+#ifdef OF_HAVE_SOCKETS
+	OFTCPSocket *server, *client, *accepted;
+	uint16_t port;
+	EndlessStreamTester *es;
+	size_t written;
+#endif
 
 	cstr = [t allocMemoryWithSize: pageSize - 2];
 	memset(cstr, 'X', pageSize - 3);
@@ -86,6 +171,225 @@ static OFString *module = @"OFStream";
 	    [(str = [t readLine]) length] == pageSize - 3 &&
 	    !strcmp([str UTF8String], cstr))
 
+	ct = [[[TestStream alloc]
+	    initWithString: "first line\r\nsecond::third::x"
+		 chunkSize: 3] autorelease];
+
+	TEST(@"-[setReadBufferSize:]", R([ct setReadBufferSize: 4]) &&
+	    [ct readBufferSize] == 4)
+
+	TEST(@"-[readLine] with lines longer than the read buffer",
+	    [[ct readLine] isEqual: @"first line"])
+
+	TEST(@"-[readTillDelimiter:] with delimiter spanning reads",
+	    [[ct readTillDelimiter: @"::"] isEqual: @"second"] &&
+	    [[ct readTillDelimiter: @"::"] isEqual: @"third"])
+
+	TEST(@"-[unreadFromBuffer:length:]",
+	    [ct readIntoBuffer: buffer
+			length: 1] == 1 && buffer[0] == 'x' &&
+	    R([ct unreadFromBuffer: "ab"
+			    length: 2]) &&
+	    [ct readIntoBuffer: buffer
+			length: 2] == 2 && memcmp(buffer, "ab", 2) == 0 &&
+	    [ct isAtEndOfStream])
+
+	ct = [[[TestStream alloc]
+	    initWithString: "abc\r\n\r\ndef\r\nghi"
+		 chunkSize: 3] autorelease];
+
+	TEST(@"-[readDataUntilDelimiter:]",
+	    [[ct readDataUntilDelimiter: [OFData dataWithItems: "\r\n\r\n"
+							 count: 4]]
+	    isEqual: [OFData dataWithItems: "abc"
+				     count: 3]] &&
+	    [[ct readDataUntilDelimiter: [OFData dataWithItems: "\r\n"
+							 count: 2]]
+	    isEqual: [OFData dataWithItems: "def"
+				     count: 3]] &&
+	    [[ct readDataUntilDelimiter: [OFData dataWithItems: "\r\n"
+							 count: 2]]
+	    isEqual: [OFData dataWithItems: "ghi"
+				     count: 3]] &&
+	    [ct readDataUntilDelimiter: [OFData dataWithItems: "\r\n"
+							count: 2]] == nil)
+
+	wt = [[[TestStream alloc] init] autorelease];
+	buffers[0].buffer = "foo";
+	buffers[0].length = 3;
+	buffers[1].buffer = "";
+	buffers[1].length = 0;
+	buffers[2].buffer = "bar";
+	buffers[2].length = 3;
+
+	TEST(@"-[writeBuffers:count:]",
+	    [wt writeBuffers: buffers
+		       count: 3] == 6 &&
+	    [wt->_data isEqual: [OFData dataWithItems: "foobar"
+						count: 6]])
+
+	wt = [[[TestStream alloc] init] autorelease];
+	largeItems = [wt allocMemoryWithSize: 8192];
+	memset(largeItems, 'x', 8192);
+	large = [OFData dataWithItemsNoCopy: largeItems
+				      count: 8192
+			       freeWhenDone: false];
+
+	TEST(@"Referencing large data in the write buffer",
+	    R([wt setWriteBuffered: true]) && R([wt writeString: @"a"]) &&
+	    R([wt writeData: large]) && R([wt writeString: @"b"]) &&
+	    wt->_writesCount == 0 && R([wt flushWriteBuffer]) &&
+	    wt->_writesCount == 3 && wt->_lastBuffers[1] == largeItems &&
+	    [wt->_data count] == 8194 &&
+	    *(char *)[wt->_data firstItem] == 'a' &&
+	    *(char *)[wt->_data itemAtIndex: 8192] == 'x' &&
+	    *(char *)[wt->_data lastItem] == 'b')
+
+	wt = [[[TestStream alloc] init] autorelease];
+	mutableLarge = [OFMutableData data];
+	[mutableLarge increaseCountBy: 8192];
+	memset([mutableLarge items], 'x', 8192);
+
+	TEST(@"Copying large mutable data in the write buffer",
+	    R([wt setWriteBuffered: true]) && R([wt writeString: @"a"]) &&
+	    R([wt writeData: mutableLarge]) && R([wt writeString: @"b"]) &&
+	    R([mutableLarge addItem: "y"]) && wt->_writesCount == 0 &&
+	    R([wt flushWriteBuffer]) && wt->_writesCount == 3 &&
+	    wt->_lastBuffers[1] != [mutableLarge items] &&
+	    [wt->_data count] == 8194 &&
+	    *(char *)[wt->_data firstItem] == 'a' &&
+	    *(char *)[wt->_data itemAtIndex: 8192] == 'x' &&
+	    *(char *)[wt->_data lastItem] == 'b')
+
+	wt = [[[TestStream alloc] init] autorelease];
+	EXPECT_EXCEPTION(@"-[writeFormat:] with invalid format",
+	    OFInvalidFormatException, ([wt writeFormat: @"%d %", 1]))
+	TEST(@"-[writeFormat:] writes nothing for short invalid output",
+	    [wt->_data count] == 0)
+
+	cstr = [t allocMemoryWithSize: 1025];
+	memset(cstr, 'x', 1024);
+	cstr[1024] = '\0';
+	EXPECT_EXCEPTION(@"-[writeFormat:] with invalid format after 1 KiB",
+	    OFInvalidFormatException, ([wt writeFormat: @"%s %", cstr]))
+	TEST(@"-[writeFormat:] writes nothing for long invalid output",
+	    [wt->_data count] == 0)
+
+	TEST(@"-[writeFormat:] with long output",
+	    [wt writeFormat: @"%s!", cstr] == 1025 &&
+	    [wt->_data count] == 1025 &&
+	    memcmp([wt->_data items], cstr, 1024) == 0 &&
+	    *(char *)[wt->_data itemAtIndex: 1024] == '!')
+
+	ct = [[[TestStream alloc]
+	    initWithString: "skip\nabcdefgh"
+		 chunkSize: 3] autorelease];
+	wt = [[[TestStream alloc] init] autorelease];
+
+	TEST(@"-[writeFromStream:length:]",
+	    [[ct readLine] isEqual: @"skip"] &&
+	    [wt writeFromStream: ct
+			 length: 5] == 5 &&
+	    [wt writeFromStream: ct
+			 length: 10] == 3 &&
+	    [wt->_data isEqual: [OFData dataWithItems: "abcdefgh"
+						count: 8]] &&
+	    [ct isAtEndOfStream])
+
+#ifdef OF_HAVE_SOCKETS
+	server = [OFTCPSocket socket];
+	client = [OFTCPSocket socket];
+	port = [server bindToHost: @"127.0.0.1"
+			     port: 0];
+	[server listen];
+	[client connectToHost: @"127.0.0.1"
+			 port: port];
+	accepted = [server accept];
+	[client setBlocking: false];
+	es = [[[EndlessStreamTester alloc] init] autorelease];
+
+	/* Nothing is read from accepted, so client fills up eventually */
+	TEST(@"-[writeFromStream:length:] on a full non-blocking stream",
+	    (written = [client writeFromStream: es
+					length: 256 * 1024 * 1024]) > 0 &&
+	    written < 256 * 1024 * 1024 &&
+	    [accepted readIntoBuffer: buffer
+			      length: 1] == 1 && buffer[0] == 'x')
+#endif
+
+#ifdef OF_HAVE_BLOCKS
+	ct = [[[TestStream alloc]
+	    initWithString: "one\r\n\ntwo\nthree\nfour"
+		 chunkSize: 3] autorelease];
+
+	{
+		OFMutableArray *lines = [OFMutableArray array];
+
+		TEST(@"-[enumerateLinesUsingBlock:]",
+		    ![ct enumerateLinesUsingBlock: ^ (const char *line,
+		    size_t length, bool *stop) {
+			[lines addObject:
+			    [OFString stringWithUTF8String: line
+						    length: length]];
+
+			if (length == 3 && memcmp(line, "two", 3) == 0)
+				*stop = true;
+		    }] && [lines isEqual: [OFArray arrayWithObjects:
+		    @"one", @"", @"two", nil]] &&
+		    [[ct readLine] isEqual: @"three"] &&
+		    [[ct readLine] isEqual: @"four"])
+	}
+
+	{
+		NonBlockingStreamTester *nt = [[[NonBlockingStreamTester alloc]
+		    initWithString: "a\nb"] autorelease];
+		OFMutableArray *lines = [OFMutableArray array];
+		of_stream_line_enumeration_block_t block =
+		    ^ (const char *line, size_t length, bool *stop) {
+			[lines addObject:
+			    [OFString stringWithUTF8String: line
+						    length: length]];
+		};
+
+		TEST(@"-[enumerateLinesUsingBlock:] on non-blocking streams",
+		    ![nt enumerateLinesUsingBlock: block] &&
+		    [lines isEqual: [OFArray arrayWithObject: @"a"]] &&
+		    ![nt isAtEndOfStream])
+
+		nt->_string = "c\nd";
+		nt->_closed = true;
+		TEST(@"-[enumerateLinesUsingBlock:] keeps incomplete lines",
+		    [nt enumerateLinesUsingBlock: block] &&
+		    [lines isEqual: [OFArray arrayWithObjects:
+		    @"a", @"bc", @"d", nil]] && [nt isAtEndOfStream])
+	}
+#endif
+
+	TEST(@"+[OFMemoryStream streamWithData:]",
+	    (ms = [OFMemoryStream streamWithData:
+	    [OFData dataWithItems: "foo\nbar\nbaz"
+			    count: 11]]) &&
+	    [[ms readLine] isEqual: @"foo"])
+
+	TEST(@"-[OFMemoryStream seekToOffset:whence:]",
+	    [ms seekToOffset: -3
+		      whence: SEEK_END] == 8 &&
+	    [[ms readLine] isEqual: @"baz"] && [ms isAtEndOfStream] &&
+	    [ms seekToOffset: 4
+		      whence: SEEK_SET] == 4 &&
+	    [[ms readLine] isEqual: @"bar"])
+
+	EXPECT_EXCEPTION(@"Detect seeking beyond the end of OFMemoryStream",
+	    OFSeekFailedException, [ms seekToOffset: 1
+					     whence: SEEK_END])
+
+	mutableData = [OFMutableData dataWithItems: "foo\n"
+					     count: 4];
+	ms = [OFMemoryStream streamWithData: mutableData];
+	[mutableData increaseCountBy: 1024 * 1024];
+	TEST(@"OFMemoryStream does not change with mutable data",
+	    [[ms readLine] isEqual: @"foo"] && [ms isAtEndOfStream])
+
 	[pool drain];
 }
 @end
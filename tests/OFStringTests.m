@@ -48,6 +48,9 @@ static of_unichar_t sucstr[] = {
 	0xFFFE0000, 0x66000000, 0xF6000000, 0xF6000000, 0x62000000, 0xE4000000,
 	0x72000000, 0x3AF00100, 0
 };
+static of_unichar_t surrogateucstr[] = {
+	'a', 'b', 0xD800, 'c', 'd', 0
+};
 static uint16_t utf16str[] = {
 	0xFEFF, 'f', 0xF6, 0xF6, 'b', 0xE4, 'r', 0xD83C, 0xDC3A, 0
 };
@@ -272,6 +275,14 @@ static uint16_t sutf16str[] = {
 	    [C(@"abc") compare: @"abd"])
 #endif
 
+	TEST(@"-[caseInsensitiveCompare:] with long ASCII strings",
+	    [C(@"The Quick Brown Fox Jumps") caseInsensitiveCompare:
+	    @"the quick brown fox jumps"] == OF_ORDERED_SAME &&
+	    [C(@"The Quick Brown Fox Jumps") caseInsensitiveCompare:
+	    @"the quick brown fox jumpz"] == OF_ORDERED_ASCENDING &&
+	    [C(@"The Quick Brown Fox Jumps") caseInsensitiveCompare:
+	    @"the quick brown fox"] == OF_ORDERED_DESCENDING)
+
 	TEST(@"-[hash] is the same if -[isEqual:] is true",
 	    [s[0] hash] == [s[2] hash])
 
@@ -337,6 +348,13 @@ static uint16_t sutf16str[] = {
 	    isEqual: @"ǆbla Tǆst TǄst"])
 #endif
 
+	TEST(@"-[uppercaseString] and -[lowercaseString] with long ASCII "
+	    @"strings",
+	    [[C(@"The Quick Brown Fox @ [09] `az` {AZ}") uppercaseString]
+	    isEqual: @"THE QUICK BROWN FOX @ [09] `AZ` {AZ}"] &&
+	    [[C(@"The Quick Brown Fox @ [09] `az` {AZ}") lowercaseString]
+	    isEqual: @"the quick brown fox @ [09] `az` {az}"])
+
 	TEST(@"+[stringWithUTF8String:length:]",
 	    (s[0] = [mutableStringClass stringWithUTF8String: "\xEF\xBB\xBF"
 							      "foobar"
@@ -383,11 +401,22 @@ static uint16_t sutf16str[] = {
 				   encoding: OF_STRING_ENCODING_ISO_8859_1]
 	    isEqual: @"äöü"])
 
+	TEST(@"Conversion of ISO 8859-1 with long ASCII runs to Unicode",
+	    [[stringClass stringWithCString: "This is \xE4 rather long test "
+					     "str\xEEng with ASCII in between"
+				   encoding: OF_STRING_ENCODING_ISO_8859_1]
+	    isEqual: @"This is ä rather long test strîng with ASCII in between"])
+
 #ifdef HAVE_ISO_8859_15
 	TEST(@"Conversion of ISO 8859-15 to Unicode",
 	    [[stringClass stringWithCString: "\xA4\xA6\xA8\xB4\xB8\xBC\xBD\xBE"
 				   encoding: OF_STRING_ENCODING_ISO_8859_15]
 	    isEqual: @"€ŠšŽžŒœŸ"])
+
+	TEST(@"Conversion of ISO 8859-15 C1 controls to Unicode",
+	    [[stringClass stringWithCString: "a\x85"
+				   encoding: OF_STRING_ENCODING_ISO_8859_15]
+	    isEqual: [OFString stringWithUTF8String: "a\xC2\x85"]])
 #endif
 
 #ifdef HAVE_WINDOWS_1252
@@ -491,6 +520,14 @@ static uint16_t sutf16str[] = {
 	    R(([s[0] appendFormat: @"%02X", 15])) &&
 	    [s[0] isEqual: @"test:1230F"])
 
+	TEST(@"+[stringWithFormat:] with flags, width and precision",
+	    [[OFString stringWithFormat:
+	    @"%5d|%-5d|%05d|%+d|%.3d|%#x|%#o|%*d|%.2s|%6@|%-4C|%jd",
+	    42, 42, -42, 42, 7, 255, 8, 4, 3, "abc", @"xyz",
+	    (of_unichar_t)0xE4, INTMAX_MIN] isEqual:
+	    @"   42|42   |-0042|+42|007|0xff|010|   3|ab|   xyz|ä  |"
+	    @"-9223372036854775808"])
+
 	TEST(@"-[rangeOfString:]",
 	    [C(@"𝄞öö") rangeOfString: @"öö"].location == 1 &&
 	    [C(@"𝄞öö") rangeOfString: @"ö"].location == 1 &&
@@ -1019,6 +1056,13 @@ static uint16_t sutf16str[] = {
 #undef INPUT
 #undef EXPECTED
 
+	TEST(@"-[doubleValue] with correct rounding",
+	    [C(@"9007199254740993") doubleValue] == 9007199254740992.0 &&
+	    [C(@"2.2250738585072011e-308") doubleValue] ==
+	    2.2250738585072011e-308 &&
+	    [C(@"-1e400") doubleValue] == -INFINITY &&
+	    [C(@"1e-400") doubleValue] == 0)
+
 	EXPECT_EXCEPTION(@"Detect invalid characters in -[decimalValue] #1",
 	    OFInvalidFormatException, [C(@"abc") decimalValue])
 	EXPECT_EXCEPTION(@"Detect invalid characters in -[decimalValue] #2",
@@ -1094,8 +1138,32 @@ static uint16_t sutf16str[] = {
 	    (ua = [C(@"fööbär🀺") UTF32StringWithByteOrder:
 	    SWAPPED_BYTE_ORDER]) &&
 	    !memcmp(ua, sucstr + 1, of_string_utf32_length(sucstr) * 4))
+
+	is = C(@"The quick brown fox ä jumps over the lazy dog 🀺 again");
+	TEST(@"UTF-16 round trip with long ASCII runs",
+	    [[stringClass stringWithUTF16String: [is UTF16String]
+					 length: [is UTF16StringLength]]
+	    isEqual: is] &&
+	    [[stringClass stringWithUTF16String:
+	    [is UTF16StringWithByteOrder: SWAPPED_BYTE_ORDER]
+					 length: [is UTF16StringLength]
+				      byteOrder: SWAPPED_BYTE_ORDER]
+	    isEqual: is])
+
+	TEST(@"UTF-32 round trip with long ASCII runs",
+	    [[stringClass stringWithUTF32String: [is UTF32String]
+					 length: [is length]] isEqual: is] &&
+	    [[stringClass stringWithUTF32String:
+	    [is UTF32StringWithByteOrder: SWAPPED_BYTE_ORDER]
+					 length: [is length]
+				      byteOrder: SWAPPED_BYTE_ORDER]
+	    isEqual: is])
 #undef SWAPPED_BYTE_ORDER
 
+	EXPECT_EXCEPTION(@"Detect surrogates in +[stringWithUTF32String:]",
+	    OFInvalidEncodingException,
+	    [stringClass stringWithUTF32String: surrogateucstr])
+
 	TEST(@"-[MD5Hash]", [[C(@"asdfoobar") MD5Hash]
 	    isEqual: @"184dce2ec49b5422c7cfd8728864db4c"])
 
@@ -20,6 +20,7 @@
 #import "OFXMLElement.h"
 #import "OFXMLParser.h"
 #import "OFXMLElementBuilder.h"
+#import "OFArray.h"
 #import "OFAutoreleasePool.h"
 
 #import "TestsAppDelegate.h"
@@ -28,6 +29,43 @@ static OFString *module = @"OFXMLElementBuilder";
 static OFXMLNode *nodes[2];
 static size_t i = 0;
 
+@interface ElementCollector: OFObject <OFXMLElementBuilderDelegate>
+{
+@public
+	OFMutableArray *_elements;
+}
+@end
+
+@implementation ElementCollector
+- (instancetype)init
+{
+	self = [super init];
+
+	_elements = [[OFMutableArray alloc] init];
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_elements release];
+
+	[super dealloc];
+}
+
+- (void)elementBuilder: (OFXMLElementBuilder *)builder
+       didBuildElement: (OFXMLElement *)element
+{
+	[_elements addObject: element];
+}
+
+-   (void)elementBuilder: (OFXMLElementBuilder *)builder
+  didBuildParentlessNode: (OFXMLNode *)node
+{
+	[_elements addObject: node];
+}
+@end
+
 @implementation TestsAppDelegate (OFXMLElementBuilderTests)
 - (void)elementBuilder: (OFXMLElementBuilder *)builder
        didBuildElement: (OFXMLElement *)element
@@ -48,6 +86,7 @@ static size_t i = 0;
 	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
 	OFXMLParser *p = [OFXMLParser parser];
 	OFXMLElementBuilder *builder = [OFXMLElementBuilder elementBuilder];
+	ElementCollector *collector;
 	OFString *str = @"<foo>bar<![CDATA[f<oo]]>baz<qux/>"
 	    " <qux xmlns:qux='urn:qux'><?asd?><qux:bar/><x qux:y='z'/></qux>"
 	    "</foo>";
@@ -62,6 +101,23 @@ static size_t i = 0;
 	    nodes[1] != nil && [[nodes[1] XMLString] isEqual: @"<!--foo-->"] &&
 	    i == 2)
 
+	p = [OFXMLParser parser];
+	builder = [OFXMLElementBuilder elementBuilder];
+	collector = [[[ElementCollector alloc] init] autorelease];
+	[p setDelegate: builder];
+	[builder setDelegate: collector];
+	[builder setFilterPath:
+	    [OFArray arrayWithObjects: @"rss", @"channel", @"item", nil]];
+
+	TEST(@"-[setFilterPath:]",
+	    R([p parseString: @"<!--x--><rss><channel><title>t</title>"
+	    @"<item><title>a</title></item> <item/><x><item/></x></channel>"
+	    @"<item/></rss>"]) && [collector->_elements count] == 2 &&
+	    [[[collector->_elements objectAtIndex: 0] XMLString]
+	    isEqual: @"<item><title>a</title></item>"] &&
+	    [[[collector->_elements objectAtIndex: 1] XMLString]
+	    isEqual: @"<item/>"])
+
 	[nodes[0] release];
 	[nodes[1] release];
 	[pool drain];
@@ -23,9 +23,12 @@
 #import "OFXMLComment.h"
 #import "OFString.h"
 #import "OFArray.h"
+#import "OFData.h"
+#import "OFStream.h"
 #import "OFAutoreleasePool.h"
 
 #import "TestsAppDelegate.h"
+#import "TestStream.h"
 
 static OFString *module = @"OFXMLNode";
 
@@ -35,6 +38,9 @@ static OFString *module = @"OFXMLNode";
 	OFAutoreleasePool *pool = [[OFAutoreleasePool alloc] init];
 	id nodes[4];
 	OFArray *a;
+	OFXMLElement *element;
+	OFMutableString *characters;
+	TestStream *stream;
 
 	TEST(@"+[elementWithName:]",
 	    (nodes[0] = [OFXMLElement elementWithName: @"foo"]) &&
@@ -146,6 +152,26 @@ static OFString *module = @"OFXMLNode";
 	    @"<!-- foo --></y></x>"] XMLStringWithIndentation: 2] isEqual:
 	    @"<x>\n  <y>\n    <z>a\nb</z>\n    <!-- foo -->\n  </y>\n</x>"])
 
+	element = [OFXMLElement elementWithXMLString:
+	    @"<x xmlns='urn:x' xmlns:y='urn:y'><y:a y:b='&lt;&apos;'><c/>"
+	    @"<![CDATA[<z>]]><!-- d --></y:a><e>f</e></x>"];
+	characters = [OFMutableString string];
+	for (size_t i = 0; i < 1000; i++)
+		[characters appendString: @"a<b>&\"c'\r"];
+	[[element elementForName: @"e"
+		       namespace: @"urn:x"] addChild:
+	    [OFXMLCharacters charactersWithString: characters]];
+	stream = [[[TestStream alloc] init] autorelease];
+	TEST(@"-[writeToStream:]",
+	    R([element writeToStream: stream]) &&
+	    [[stream string] isEqual: [element XMLString]])
+
+	stream = [[[TestStream alloc] init] autorelease];
+	TEST(@"-[writeToStream:indentation:]",
+	    R([element writeToStream: stream
+			 indentation: 2]) &&
+	    [[stream string] isEqual: [element XMLStringWithIndentation: 2]])
+
 	[pool drain];
 }
 @end
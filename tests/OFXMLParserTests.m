@@ -400,6 +400,24 @@ enum event_type {
 	    OFMalformedXMLException,
 	    [parser parseString: @"<x><?xml?></x>"])
 
+	parser = [OFXMLParser parser];
+	TEST(@"Counting lines in skipped character data",
+	    R([parser parseString: @"<x a='long attribute value\r\nwith lines'>"
+	    @"some longer character data\r\n more data\n<![CDATA[long "
+	    @"]CDATA]\r]]><!-- a - long comment\n --></x>"]) &&
+	    [parser lineNumber] == 6 && [parser hasFinishedParsing])
+
+	parser = [OFXMLParser parser];
+	TEST(@"Parsing processing instructions followed by an element",
+	    R([parser parseString: @"<?xml version='1.0'?><?pi some longer "
+	    @"content ]?><x/>"]) && [parser hasFinishedParsing])
+
+#ifdef OF_HAVE_FILES
+	parser = [OFXMLParser parser];
+	TEST(@"-[parseFile:]", R([parser parseFile: @"serialization.xml"]) &&
+	    [parser hasFinishedParsing])
+#endif
+
 	[pool drain];
 }
 @end
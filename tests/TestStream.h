@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFStream.h"
+#import "OFData.h"
+
+/*
+ * An in-memory stream for tests. Writes are appended to _data and reads return
+ * the data from _position on, at most _chunkSize bytes at a time.
+ */
+@interface TestStream: OFStream
+{
+@public
+	OFMutableData *_data;
+	size_t _position, _chunkSize;
+	size_t _writesCount;
+	const void *_lastBuffers[3];
+}
+
+- (instancetype)initWithString: (const char *)string
+		     chunkSize: (size_t)chunkSize;
+- (OFString *)string;
+@end
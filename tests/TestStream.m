@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018
+ *   Jonathan Schleifer <js@heap.zone>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "TestStream.h"
+#import "OFString.h"
+
+@implementation TestStream
+- (instancetype)init
+{
+	self = [super init];
+
+	@try {
+		_data = [[OFMutableData alloc] init];
+		_chunkSize = SIZE_MAX;
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (instancetype)initWithString: (const char *)string
+		     chunkSize: (size_t)chunkSize
+{
+	self = [self init];
+
+	@try {
+		[_data addItems: string
+			  count: strlen(string)];
+		_chunkSize = chunkSize;
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_data release];
+
+	[super dealloc];
+}
+
+- (bool)lowlevelIsAtEndOfStream
+{
+	return (_position >= [_data count]);
+}
+
+- (size_t)lowlevelReadIntoBuffer: (void *)buffer
+			  length: (size_t)length
+{
+	size_t available = [_data count] - _position;
+
+	if (length > _chunkSize)
+		length = _chunkSize;
+	if (length > available)
+		length = available;
+
+	memcpy(buffer, (char *)[_data items] + _position, length);
+	_position += length;
+
+	return length;
+}
+
+- (size_t)lowlevelWriteBuffer: (const void *)buffer
+		       length: (size_t)length
+{
+	[_data addItems: buffer
+		  count: length];
+
+	if (_writesCount < 3)
+		_lastBuffers[_writesCount] = buffer;
+	_writesCount++;
+
+	return length;
+}
+
+- (OFString *)string
+{
+	return [OFString stringWithUTF8String: [_data items]
+				       length: [_data count]];
+}
+@end
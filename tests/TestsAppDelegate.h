@@ -87,6 +87,10 @@ enum {
 	     inModule: (OFString *)module;
 @end
 
+@interface TestsAppDelegate (OFASN1DERElementTests)
+- (void)ASN1DERElementTests;
+@end
+
 @interface TestsAppDelegate (OFASN1DERValueTests)
 - (void)ASN1DERValueTests;
 @end
@@ -159,6 +163,10 @@ enum {
 - (void)localeTests;
 @end
 
+@interface TestsAppDelegate (OFMessagePackTests)
+- (void)messagePackTests;
+@end
+
 @interface TestsAppDelegate (OFMD5HashTests)
 - (void)MD5HashTests;
 @end
@@ -227,6 +235,10 @@ enum {
 - (void)systemInfoTests;
 @end
 
+@interface TestsAppDelegate (OFFileManagerTests)
+- (void)fileManagerTests;
+@end
+
 @interface TestsAppDelegate (OFHMACTests)
 - (void)HMACTests;
 @end
@@ -407,6 +407,7 @@ main(int argc, char *argv[])
 	[self SHA384HashTests];
 	[self SHA512HashTests];
 	[self HMACTests];
+	[self fileManagerTests];
 #endif
 	[self PBKDF2Tests];
 	[self scryptTests];
@@ -437,8 +438,10 @@ main(int argc, char *argv[])
 	[self serializationTests];
 #endif
 	[self JSONTests];
+	[self messagePackTests];
 	[self propertyListTests];
 	[self ASN1DERValueTests];
+	[self ASN1DERElementTests];
 #if defined(OF_HAVE_PLUGINS)
 	[self pluginTests];
 #endif